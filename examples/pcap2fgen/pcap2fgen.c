@@ -0,0 +1,740 @@
+/* SPDX-License-Identifier: BSD-3-Clause
+ * Copyright (c) 2024 Intel Corporation
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <errno.h>
+#include <getopt.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <net/ethernet.h>
+#include <pcap.h>
+
+#include <fgen_common.h>
+#include <fgen_log.h>
+#include <fgen.h>
+
+/*
+ * Compile a pcap capture into a fgen frame library.
+ *
+ * The main thread reads the capture in chunks of frames and hands them to the worker threads.
+ * Each worker decodes the frames in round-trip mode, verifies the text encodes back to the same
+ * bytes and counts the unique frame strings in a private table. The tables are merged at the end
+ * and written in the order the frames were first seen in the capture.
+ *
+ * With a fingerprint mask the workers only dedup the raw frames ignoring the masked fields, the
+ * decode and verify is done once for each unique frame after the dedup tables are merged.
+ */
+
+#define DEFAULT_THREADS    4
+#define DEFAULT_CHUNK_SIZE 1024
+#define DEFAULT_PREFIX     "frame"
+#define MAX_THREADS        64
+#define QUEUE_DEPTH        (2 * MAX_THREADS)
+#define VERIFY_RECYCLE     256 /**< Number of frames verified before recreating the fgen_t */
+
+typedef struct chunk_s {
+    uint64_t first;                 /**< Capture index of the first frame in the chunk */
+    uint32_t cnt;                   /**< Number of frames in the chunk */
+    uint16_t *lens;                 /**< Length of each frame */
+    uint8_t (*frames)[ETH_FRAME_LEN]; /**< Frame data, padded to ETH_ZLEN */
+} chunk_t;
+
+typedef struct entry_s {
+    char *text;     /**< Frame string or NULL if the entry is free */
+    uint64_t hash;  /**< Hash of the frame string */
+    uint64_t count; /**< Number of frames with the same string */
+    uint64_t first; /**< Capture index of the first frame */
+} entry_t;
+
+typedef struct table_s {
+    entry_t *entries; /**< Open addressing hash table */
+    uint64_t size;    /**< Number of entries, always a power of 2 */
+    uint64_t used;    /**< Number of entries in use */
+} table_t;
+
+typedef struct worker_s {
+    pthread_t tid;       /**< Worker thread id */
+    table_t table;       /**< Unique frame strings seen by this worker */
+    fgen_dedup_t *dd;    /**< Unique frames seen by this worker when a mask is given */
+    fgen_decode_t *dc;   /**< Round-trip decoder */
+    fgen_t *fg;          /**< Encoder verifying the decoded text */
+    uint64_t nb;         /**< Number of frames verified with fg */
+    uint64_t frames;     /**< Number of frames processed */
+    uint64_t fallback;   /**< Number of frames emitted as raw data after verification failed */
+    int err;             /**< Non-zero if the worker failed */
+} worker_t;
+
+static struct {
+    const char *infile;
+    const char *outfile;
+    const char *prefix;
+    int nb_threads;
+    int chunk_size;
+    int verbose;
+    bool dedup;    /**< Dedup the raw frames with the fingerprint mask */
+    uint32_t mask; /**< FGEN_FP_* fields ignored by the dedup */
+
+    pthread_mutex_t lock;
+    pthread_cond_t not_empty;
+    pthread_cond_t not_full;
+    chunk_t *queue[QUEUE_DEPTH];
+    int head, tail, count;
+    bool done;
+
+    uint64_t skipped; /**< Truncated or oversized frames */
+    worker_t workers[MAX_THREADS];
+} info = {
+    .prefix     = DEFAULT_PREFIX,
+    .nb_threads = DEFAULT_THREADS,
+    .chunk_size = DEFAULT_CHUNK_SIZE,
+    .lock       = PTHREAD_MUTEX_INITIALIZER,
+    .not_empty  = PTHREAD_COND_INITIALIZER,
+    .not_full   = PTHREAD_COND_INITIALIZER,
+};
+
+static chunk_t *
+chunk_alloc(int size)
+{
+    chunk_t *c;
+
+    c = calloc(1, sizeof(chunk_t));
+    if (!c)
+        return NULL;
+
+    c->lens   = calloc(size, sizeof(uint16_t));
+    c->frames = calloc(size, ETH_FRAME_LEN);
+    if (!c->lens || !c->frames) {
+        free(c->lens);
+        free(c->frames);
+        free(c);
+        return NULL;
+    }
+    return c;
+}
+
+static void
+chunk_free(chunk_t *c)
+{
+    if (c) {
+        free(c->lens);
+        free(c->frames);
+        free(c);
+    }
+}
+
+static void
+queue_put(chunk_t *c)
+{
+    pthread_mutex_lock(&info.lock);
+    while (info.count == QUEUE_DEPTH)
+        pthread_cond_wait(&info.not_full, &info.lock);
+
+    info.queue[info.tail] = c;
+    info.tail             = (info.tail + 1) % QUEUE_DEPTH;
+    info.count++;
+
+    pthread_cond_signal(&info.not_empty);
+    pthread_mutex_unlock(&info.lock);
+}
+
+/* Return the next chunk or NULL when the capture has been read completely */
+static chunk_t *
+queue_get(void)
+{
+    chunk_t *c = NULL;
+
+    pthread_mutex_lock(&info.lock);
+    while (info.count == 0 && !info.done)
+        pthread_cond_wait(&info.not_empty, &info.lock);
+
+    if (info.count) {
+        c         = info.queue[info.head];
+        info.head = (info.head + 1) % QUEUE_DEPTH;
+        info.count--;
+        pthread_cond_signal(&info.not_full);
+    }
+    pthread_mutex_unlock(&info.lock);
+
+    return c;
+}
+
+/* FNV-1a 64 bit hash */
+static uint64_t
+text_hash(const char *s)
+{
+    uint64_t h = 0xcbf29ce484222325ULL;
+
+    while (*s) {
+        h ^= (uint8_t)*s++;
+        h *= 0x100000001b3ULL;
+    }
+    return h;
+}
+
+static int
+table_grow(table_t *t)
+{
+    entry_t *old   = t->entries;
+    uint64_t osize = t->size;
+    uint64_t nsize = (osize) ? osize * 2 : 1024;
+
+    t->entries = calloc(nsize, sizeof(entry_t));
+    if (!t->entries) {
+        t->entries = old;
+        return -1;
+    }
+    t->size = nsize;
+
+    for (uint64_t i = 0; i < osize; i++) {
+        entry_t *e = &old[i];
+        uint64_t idx;
+
+        if (!e->text)
+            continue;
+        for (idx = e->hash & (nsize - 1); t->entries[idx].text; idx = (idx + 1) & (nsize - 1))
+            ;
+        t->entries[idx] = *e;
+    }
+    free(old);
+
+    return 0;
+}
+
+/* Count one or more frames with the given text, the text is copied on first use */
+static int
+table_add(table_t *t, const char *text, uint64_t count, uint64_t first)
+{
+    uint64_t hash = text_hash(text), idx;
+    entry_t *e;
+
+    if ((t->used + 1) * 2 > t->size && table_grow(t) < 0)
+        return -1;
+
+    for (idx = hash & (t->size - 1);; idx = (idx + 1) & (t->size - 1)) {
+        e = &t->entries[idx];
+
+        if (!e->text) {
+            e->text = strdup(text);
+            if (!e->text)
+                return -1;
+            e->hash  = hash;
+            e->count = count;
+            e->first = first;
+            t->used++;
+            return 0;
+        }
+        if (e->hash == hash && !strcmp(e->text, text)) {
+            e->count += count;
+            if (first < e->first)
+                e->first = first;
+            return 0;
+        }
+    }
+}
+
+static void
+table_free(table_t *t)
+{
+    for (uint64_t i = 0; i < t->size; i++)
+        free(t->entries[i].text);
+    free(t->entries);
+    memset(t, 0, sizeof(table_t));
+}
+
+/* Build the text for a frame the decoder could not reproduce, used only if verification fails */
+static char *
+raw_text(const uint8_t *d, uint16_t len)
+{
+    static const char hex[] = "0123456789abcdef";
+    char *s, *p;
+
+    s = malloc(128 + (2 * len));
+    if (!s)
+        return NULL;
+
+    p = s + sprintf(s, "Ether(dst=%02x:%02x:%02x:%02x:%02x:%02x,src=%02x:%02x:%02x:%02x:%02x:%02x,"
+                       "type=%#06x)/Raw(hex=",
+                    d[0], d[1], d[2], d[3], d[4], d[5], d[6], d[7], d[8], d[9], d[10], d[11],
+                    (d[12] << 8) | d[13]);
+    for (int i = ETHER_HDR_LEN; i < len; i++) {
+        *p++ = hex[d[i] >> 4];
+        *p++ = hex[d[i] & 0xF];
+    }
+    strcpy(p, ")");
+
+    return s;
+}
+
+/* Encode the text and compare it to the original frame, returns true if the bytes are the same */
+static bool
+verify_frame(fgen_t **fg, uint64_t *nb, const char *text, const uint8_t *data, uint16_t len)
+{
+    char name[FGEN_FRAME_NAME_LENGTH];
+    frame_t *f;
+
+    if (*nb >= VERIFY_RECYCLE) {
+        fgen_destroy(*fg);
+        *fg = fgen_create(0);
+        *nb = 0;
+    }
+    if (!*fg)
+        return false;
+
+    snprintf(name, sizeof(name), "v%lu", (*nb)++);
+    if (fgen_add_frame(*fg, name, text) < 0)
+        return false;
+
+    f = fgen_find_frame(*fg, name);
+
+    return f && fbuf_data_len(f) == len && !memcmp(fbuf_mtod(f, void *), data, len);
+}
+
+/* Return the text of a frame, the raw text is used if the decoded text does not verify */
+static char *
+frame_text(fgen_decode_t *dc, fgen_t **fg, uint64_t *nb, const uint8_t *data, uint16_t len,
+           uint64_t *fallback)
+{
+    const char *text = NULL;
+
+    if (fgen_decode(dc, (void *)(uintptr_t)data, len, FGEN_ETHER_TYPE) > 0)
+        text = fgen_decode_text(dc);
+
+    if (!text || !verify_frame(fg, nb, text, data, len)) {
+        (*fallback)++;
+        return raw_text(data, len);
+    }
+    return strdup(text);
+}
+
+static int
+worker_setup(worker_t *w)
+{
+    w->dc = fgen_decode_create();
+    w->fg = fgen_create(0);
+    if (info.dedup)
+        w->dd = fgen_dedup_create(info.mask);
+    if (!w->dc || !w->fg || fgen_decode_set_flags(w->dc, FGEN_DECODE_ROUNDTRIP) < 0 ||
+        (info.dedup && !w->dd)) {
+        w->err = 1;
+        return -1;
+    }
+    return 0;
+}
+
+static void
+worker_cleanup(worker_t *w)
+{
+    fgen_decode_destroy(w->dc);
+    fgen_destroy(w->fg);
+    w->dc = NULL;
+    w->fg = NULL;
+}
+
+/* Add the frames of a chunk to the tables of the worker and free the chunk */
+static void
+worker_chunk(worker_t *w, chunk_t *c)
+{
+    for (uint32_t i = 0; i < c->cnt && !w->err; i++) {
+        uint8_t *data = c->frames[i];
+        uint16_t len  = c->lens[i];
+        char *text;
+
+        w->frames++;
+        if (info.dedup) {
+            if (fgen_dedup_add(w->dd, data, len, 1, c->first + i) < 0)
+                w->err = 1;
+            continue;
+        }
+
+        text = frame_text(w->dc, &w->fg, &w->nb, data, len, &w->fallback);
+        if (!text || table_add(&w->table, text, 1, c->first + i) < 0)
+            w->err = 1;
+        free(text);
+    }
+    chunk_free(c);
+}
+
+static void *
+worker_main(void *arg)
+{
+    worker_t *w = arg;
+    chunk_t *c;
+
+    if (worker_setup(w) == 0) {
+        while ((c = queue_get()) != NULL)
+            worker_chunk(w, c);
+    }
+    worker_cleanup(w);
+
+    /* Drain the queue if we failed so the reader does not block forever */
+    if (w->err) {
+        while ((c = queue_get()) != NULL)
+            chunk_free(c);
+    }
+    return NULL;
+}
+
+/* Hand a full chunk to the workers, or process it here when no worker thread was started */
+static void
+chunk_ready(chunk_t *c)
+{
+    if (info.nb_threads)
+        queue_put(c);
+    else
+        worker_chunk(&info.workers[0], c);
+}
+
+static int
+read_capture(pcap_t *pcap)
+{
+    struct pcap_pkthdr *hdr;
+    const u_char *pkt;
+    chunk_t *c  = NULL;
+    uint64_t idx = 0;
+    int ret;
+
+    while ((ret = pcap_next_ex(pcap, &hdr, &pkt)) >= 0) {
+        if (ret == 0)
+            continue;
+
+        /* A frame must be complete and fit in a standard Ethernet frame without the FCS */
+        if (hdr->caplen < hdr->len || hdr->len > ETH_FRAME_LEN) {
+            info.skipped++;
+            continue;
+        }
+
+        if (!c) {
+            c = chunk_alloc(info.chunk_size);
+            if (!c)
+                FGEN_ERR_RET("Unable to allocate a chunk of %d frames\n", info.chunk_size);
+            c->first = idx;
+        }
+
+        /* Short frames are padded with zeros as the NIC does on transmit */
+        memcpy(c->frames[c->cnt], pkt, hdr->len);
+        c->lens[c->cnt] = (hdr->len < ETH_ZLEN) ? ETH_ZLEN : hdr->len;
+        idx++;
+
+        if (++c->cnt == (uint32_t)info.chunk_size) {
+            chunk_ready(c);
+            c = NULL;
+        }
+    }
+    if (c)
+        chunk_ready(c);
+
+    if (ret == PCAP_ERROR)
+        FGEN_ERR_RET("Reading '%s' failed: %s\n", info.infile, pcap_geterr(pcap));
+
+    return 0;
+}
+
+static int
+cmp_first(const void *a, const void *b)
+{
+    const entry_t *x = a, *y = b;
+
+    return (x->first > y->first) - (x->first < y->first);
+}
+
+static int
+write_library(table_t *t)
+{
+    entry_t *list;
+    uint64_t n = 0;
+    FILE *f;
+
+    list = calloc(t->used ? t->used : 1, sizeof(entry_t));
+    if (!list)
+        FGEN_ERR_RET("Unable to allocate the frame list\n");
+
+    for (uint64_t i = 0; i < t->size; i++)
+        if (t->entries[i].text)
+            list[n++] = t->entries[i];
+    qsort(list, n, sizeof(entry_t), cmp_first);
+
+    f = (info.outfile) ? fopen(info.outfile, "w") : stdout;
+    if (!f) {
+        free(list);
+        FGEN_ERR_RET("Unable to open '%s': %s\n", info.outfile, strerror(errno));
+    }
+
+    fprintf(f, "// Generated by pcap2fgen from %s, %lu unique frames\n", info.infile, n);
+    for (uint64_t i = 0; i < n; i++) {
+        fprintf(f, "// count=%lu first=%lu\n", list[i].count, list[i].first);
+        fprintf(f, "%s-%lu := %s\n", info.prefix, i, list[i].text);
+    }
+
+    if (f != stdout)
+        fclose(f);
+    free(list);
+
+    return 0;
+}
+
+/* Merge the dedup tables of the workers, then decode and verify each unique frame once */
+static int
+dedup_merge(table_t *merged, uint64_t *fallback)
+{
+    fgen_dedup_t *dd  = NULL;
+    fgen_decode_t *dc = NULL;
+    fgen_t *fg        = NULL;
+    fgen_dedup_entry_t e;
+    uint64_t nb = 0;
+    int ret     = -1;
+
+    dd = fgen_dedup_create(info.mask);
+    dc = fgen_decode_create();
+    fg = fgen_create(0);
+    if (!dd || !dc || !fg || fgen_decode_set_flags(dc, FGEN_DECODE_ROUNDTRIP) < 0)
+        FGEN_ERR_GOTO(leave, "Unable to create the dedup merge objects\n");
+
+    for (int i = 0; i < MAX_THREADS; i++) {
+        for (int j = 0; j < fgen_dedup_count(info.workers[i].dd); j++) {
+            if (fgen_dedup_entry(info.workers[i].dd, j, &e) < 0 ||
+                fgen_dedup_add(dd, e.data, e.len, e.count, e.first) < 0)
+                FGEN_ERR_GOTO(leave, "Unable to merge dedup tables\n");
+        }
+    }
+
+    for (int i = 0; i < fgen_dedup_count(dd); i++) {
+        char *text;
+
+        if (fgen_dedup_entry(dd, i, &e) < 0)
+            goto leave;
+        text = frame_text(dc, &fg, &nb, e.data, e.len, fallback);
+        if (!text || table_add(merged, text, e.count, e.first) < 0) {
+            free(text);
+            FGEN_ERR_GOTO(leave, "Unable to add frame %lu\n", e.first);
+        }
+        free(text);
+    }
+    ret = 0;
+
+leave:
+    fgen_dedup_destroy(dd);
+    fgen_decode_destroy(dc);
+    fgen_destroy(fg);
+    return ret;
+}
+
+/* Parse a comma separated list of fields to ignore in the dedup */
+static int
+parse_mask(const char *arg)
+{
+    // clang-format off
+    static const struct {
+        const char *name;
+        uint32_t mask;
+    } fields[] = {
+        {"default", FGEN_FP_DEFAULT},
+        {"id",      FGEN_FP_IP_ID},
+        {"ttl",     FGEN_FP_TTL},
+        {"cksum",   FGEN_FP_CKSUM},
+        {"seq",     FGEN_FP_TCP_SEQ},
+        {"tsc",     FGEN_FP_TSC},
+        {"payload", FGEN_FP_PAYLOAD},
+        {"none",    0},
+    };
+    // clang-format on
+    char buf[128], *tok, *save = NULL;
+
+    if (snprintf(buf, sizeof(buf), "%s", arg) >= (int)sizeof(buf))
+        return -1;
+
+    info.mask = 0;
+    for (tok = strtok_r(buf, ",", &save); tok; tok = strtok_r(NULL, ",", &save)) {
+        int i;
+
+        for (i = 0; i < (int)fgen_countof(fields); i++) {
+            if (!strcmp(tok, fields[i].name))
+                break;
+        }
+        if (i == (int)fgen_countof(fields))
+            return -1;
+        info.mask |= fields[i].mask;
+    }
+    info.dedup = true;
+
+    return 0;
+}
+
+static void
+usage(int err)
+{
+    printf("pcap2fgen -i <in.pcap> [-o <out.fgen>] [-t threads] [-c chunk] [-p prefix] [-m mask] "
+           "[-v] [-h]\n"
+           "\t-i|--input <file>   Capture file to read, must be Ethernet frames\n"
+           "\t-o|--output <file>  FGEN file to write (default stdout)\n"
+           "\t-t|--threads <num>  Number of decode threads (default %d, max %d)\n"
+           "\t-c|--chunk <num>    Number of frames handed to a thread at a time (default %d)\n"
+           "\t-p|--prefix <name>  Frame name prefix (default '%s')\n"
+           "\t-m|--mask <fields>  Dedup frames ignoring the fields in the list of\n"
+           "\t                    id,ttl,cksum,seq,tsc,payload, default or none\n"
+           "\t-v|--verbose        Print statistics\n"
+           "\t-h|--help           Print this help\n",
+           DEFAULT_THREADS, MAX_THREADS, DEFAULT_CHUNK_SIZE, DEFAULT_PREFIX);
+
+    exit(err);
+}
+
+static int
+parse_args(int argc, char **argv)
+{
+    // clang-format off
+    struct option lgopts[] = {
+        {"input",   required_argument, NULL, 'i'},
+        {"output",  required_argument, NULL, 'o'},
+        {"threads", required_argument, NULL, 't'},
+        {"chunk",   required_argument, NULL, 'c'},
+        {"prefix",  required_argument, NULL, 'p'},
+        {"mask",    required_argument, NULL, 'm'},
+        {"verbose", no_argument,       NULL, 'v'},
+        {"help",    no_argument,       NULL, 'h'},
+        {NULL, 0, 0, 0}
+    };
+    // clang-format on
+    int opt, option_index;
+
+    while ((opt = getopt_long(argc, argv, "i:o:t:c:p:m:vh", lgopts, &option_index)) != EOF) {
+        switch (opt) {
+        case 'i':
+            info.infile = optarg;
+            break;
+        case 'o':
+            info.outfile = optarg;
+            break;
+        case 't':
+            info.nb_threads = strtol(optarg, NULL, 0);
+            if (info.nb_threads <= 0 || info.nb_threads > MAX_THREADS)
+                FGEN_ERR_RET("Invalid number of threads '%s'\n", optarg);
+            break;
+        case 'c':
+            info.chunk_size = strtol(optarg, NULL, 0);
+            if (info.chunk_size <= 0)
+                FGEN_ERR_RET("Invalid chunk size '%s'\n", optarg);
+            break;
+        case 'p':
+            info.prefix = optarg;
+            /* Leave room for the '-<index>' suffix in the frame name */
+            if (strlen(info.prefix) > (FGEN_FRAME_NAME_LENGTH / 2))
+                FGEN_ERR_RET("Prefix '%s' is too long\n", optarg);
+            break;
+        case 'm':
+            if (parse_mask(optarg) < 0)
+                FGEN_ERR_RET("Invalid fingerprint mask '%s'\n", optarg);
+            break;
+        case 'v':
+            info.verbose++;
+            break;
+        case 'h':
+            usage(EXIT_SUCCESS);
+            break;
+        default:
+            usage(EXIT_FAILURE);
+            break;
+        }
+    }
+
+    if (!info.infile)
+        FGEN_ERR_RET("Input capture file is required\n");
+
+    return 0;
+}
+
+int
+main(int argc, char **argv)
+{
+    char errbuf[PCAP_ERRBUF_SIZE];
+    table_t merged = {0};
+    uint64_t frames = 0, fallback = 0;
+    pcap_t *pcap;
+    int ret = EXIT_FAILURE, rd = 0;
+
+    if (parse_args(argc, argv) < 0)
+        usage(EXIT_FAILURE);
+
+    pcap = pcap_open_offline(info.infile, errbuf);
+    if (!pcap)
+        FGEN_ERR_RET("Unable to open '%s': %s\n", info.infile, errbuf);
+
+    if (pcap_datalink(pcap) != DLT_EN10MB) {
+        pcap_close(pcap);
+        FGEN_ERR_RET("Capture '%s' does not contain Ethernet frames\n", info.infile);
+    }
+
+    /*
+     * The workers share the queue, so the chunks of a worker not started go to the others. With
+     * no worker thread at all the frames are processed by this thread as they are read.
+     */
+    for (int i = 0; i < info.nb_threads; i++) {
+        int err = pthread_create(&info.workers[i].tid, NULL, worker_main, &info.workers[i]);
+
+        if (err) {
+            FGEN_WARN("Started %d of %d worker threads: %s\n", i, info.nb_threads,
+                      strerror(err));
+            info.nb_threads = i;
+            break;
+        }
+    }
+
+    if (info.nb_threads || worker_setup(&info.workers[0]) == 0)
+        rd = read_capture(pcap);
+    if (!info.nb_threads)
+        worker_cleanup(&info.workers[0]);
+    pcap_close(pcap);
+
+    pthread_mutex_lock(&info.lock);
+    info.done = true;
+    pthread_cond_broadcast(&info.not_empty);
+    pthread_mutex_unlock(&info.lock);
+
+    for (int i = 0; i < info.nb_threads; i++)
+        pthread_join(info.workers[i].tid, NULL);
+
+    if (rd < 0)
+        goto leave;
+
+    /* Merge the per thread tables, keeping the earliest capture index of each frame */
+    for (int i = 0; i < MAX_THREADS; i++) {
+        worker_t *w = &info.workers[i];
+
+        if (w->err)
+            FGEN_ERR_GOTO(leave, "Worker %d failed\n", i);
+
+        for (uint64_t j = 0; j < w->table.size; j++) {
+            entry_t *e = &w->table.entries[j];
+
+            if (e->text && table_add(&merged, e->text, e->count, e->first) < 0)
+                FGEN_ERR_GOTO(leave, "Unable to merge frame tables\n");
+        }
+        frames += w->frames;
+        fallback += w->fallback;
+    }
+
+    if (info.dedup && dedup_merge(&merged, &fallback) < 0)
+        goto leave;
+
+    if (write_library(&merged) < 0)
+        goto leave;
+
+    if (info.verbose)
+        fprintf(stderr,
+                "pcap2fgen: %lu frames, %lu unique, %lu raw after failed verify, %lu skipped\n",
+                frames, merged.used, fallback, info.skipped);
+
+    ret = EXIT_SUCCESS;
+leave:
+    for (int i = 0; i < MAX_THREADS; i++) {
+        table_free(&info.workers[i].table);
+        fgen_dedup_destroy(info.workers[i].dd);
+    }
+    table_free(&merged);
+
+    return ret;
+}
@@ -32,6 +32,17 @@
 #define MBUF_COUNT_OPT  "mbuf-count"
 #define FGEN_STRING_OPT "fgen"
 #define FGEN_FILE_OPT   "fgen-file"
+#define WEIGHTS_OPT     "weights"
+#define VERIFY_OPT      "verify"
+#define CKSUM_OPT       "cksum"
+#define LATENCY_OPT     "latency"
+#define SEQ_OPT         "seq"
+#define RFC2544_OPT     "rfc2544"
+#define DURATION_OPT    "duration"
+#define OUTPUT_OPT      "output"
+#define PCAP_OPT        "pcap"
+#define SPEED_OPT       "speed"
+#define LOOPS_OPT       "loops"
 #define VERBOSE_OPT     "verbose"
 #define TCP_OPT         "tcp"
 #define UDP_OPT         "udp"
@@ -47,8 +58,19 @@ static const struct option lgopts[] = {
 	{TIMEOUT_OPT,		    1, 0, 'T'},
     {MBUF_COUNT_OPT,        1, 0, 'M'},
 	{PROMISCUOUS_OPT,       0, 0, 'P'},
-	{FGEN_STRING_OPT,       0, 0, 'f'},
-	{FGEN_FILE_OPT,         0, 0, 'F'},
+	{FGEN_STRING_OPT,       1, 0, 'f'},
+	{FGEN_FILE_OPT,         1, 0, 'F'},
+    {WEIGHTS_OPT,           1, 0, 'w'},
+    {VERIFY_OPT,            0, 0, 'V'},
+    {CKSUM_OPT,             0, 0, 'C'},
+    {LATENCY_OPT,           0, 0, 'L'},
+    {SEQ_OPT,               0, 0, 'S'},
+    {RFC2544_OPT,           1, 0, 'R'},
+    {DURATION_OPT,          1, 0, 'D'},
+    {OUTPUT_OPT,            1, 0, 'o'},
+    {PCAP_OPT,              1, 0, 'p'},
+    {SPEED_OPT,             1, 0, 'x'},
+    {LOOPS_OPT,             1, 0, 'N'},
     {VERBOSE_OPT,           0, 0, 'v'},
     {TCP_OPT,               0, 0, 't'},
     {UDP_OPT,               0, 0, 'u'},
@@ -57,7 +79,7 @@ static const struct option lgopts[] = {
 };
 // clang-format on
 
-static const char *short_options = "t:b:s:r:d:m:T:M:F:f:Pvhtu";
+static const char *short_options = "t:b:s:r:d:m:T:M:F:f:w:R:D:o:p:x:N:PVCLSvhtu";
 
 /* display usage */
 void
@@ -65,10 +87,12 @@ usage(int err)
 {
     printf(
         "pktperf [EAL options] -- [-b burst] [-s size] [-r rate] [-d rxd/txd] [-m map] [-T secs] "
-        "[-P] [-M mbufs] [-v] [-h]\n"
+        "[-P] [-M mbufs] [-f fgen] [-F file] [-w weights] [-V] [-C] [-L] [-S] [-R sizes] "
+        "[-D secs] [-o file] [-p pcap] [-x speed] [-N loops] [-v] [-h]\n"
         "\t-b|--burst-count <burst> Number of packets for Rx/Tx burst (default %d)\n"
         "\t-s|--pkt-size <size>     Packet size in bytes (default %'d) includes FCS bytes\n"
-        "\t-r|--rate <rate>         Packet TX rate percentage 0=off (default %'d)\n"
+        "\t-r|--rate <rate>         Packet TX rate percentage 0=off (default %'d) or pps or\n"
+        "\t                         wire bps with a k, m or g multiplier, e.g. 10kpps, 9.5Gbps\n"
         "\t-d|--descriptors <Rx/Tx> Number of RX/TX descriptors (default %'d/%'d)\n"
         "\t-m|--map <map>           Core to Port/queue mapping '[Rx-Cores:Tx-Cores].port'\n"
         "\t-T|--timeout <secs>      Timeout period in seconds (default %d second)\n"
@@ -78,10 +102,25 @@ usage(int err)
         "\t-u|--udp                 Use UDP (default UDP)\n"
         "\t-f|--fgen <string>       FGEN string to load\n"
         "\t-F|--fgen-file <file>    FGEN file to load\n"
+        "\t-w|--weights <w1,w2,..>  Weights of the FGEN frames sent, in load order (default 1)\n"
+        "\t-V|--verify              Verify Rx packets against the first FGEN frame\n"
+        "\t-C|--cksum               Verify the IPv4 and L4 checksums of Rx packets\n"
+        "\t-L|--latency             Measure the latency of the FGEN frames with a TSC() layer\n"
+        "\t-S|--seq                 Track loss, reorder and duplicates of the Seq() frames\n"
+        "\t-R|--rfc2544 <sizes>     Run the RFC 2544 throughput, latency and loss tests for the\n"
+        "\t                         frame sizes '64,128,..', 'std' sizes or the 'fgen' frames\n"
+        "\t-D|--duration <secs>     Duration of a RFC 2544 trial (default %d seconds)\n"
+        "\t-o|--output <file>       Write the RFC 2544 results as JSON to a file (default stdout)\n"
+        "\t-p|--pcap <file>         Replay the Ethernet frames of a pcap file, by flow over the\n"
+        "\t                         Tx queues\n"
+        "\t-x|--speed <factor>      Replay speed of the capture, 'max' or 0 to send at the rate\n"
+        "\t                         of -r (default %d, max %d)\n"
+        "\t-N|--loops <count>       Times the capture is replayed, 0 for ever (default 0)\n"
         "\t-v|--verbose             Verbose output\n"
         "\t-h|--help                Print this help\n",
         DEFAULT_BURST_COUNT, DEFAULT_PKT_SIZE, DEFAULT_TX_RATE, DEFAULT_RX_DESC, DEFAULT_TX_DESC,
-        DEFAULT_TIMEOUT_PERIOD, DEFAULT_MBUF_COUNT, MAX_MBUF_COUNT);
+        DEFAULT_TIMEOUT_PERIOD, DEFAULT_MBUF_COUNT, MAX_MBUF_COUNT, DEFAULT_TRIAL_SECS,
+        DEFAULT_REPLAY_SPEED, MAX_REPLAY_SPEED);
 
     exit(err);
 }
@@ -149,18 +188,25 @@ parse_cores(l2p_port_t *port, const char *cores, int mode)
         num_cores++;
         lport->port = port;
         lport->mode = mode;
+        if ((mode & LCORE_MODE_RX && port->num_rx_qids >= MAX_QUEUES_PER_PORT) ||
+            (mode & LCORE_MODE_TX && port->num_tx_qids >= MAX_QUEUES_PER_PORT))
+            ERR_RET("More than %d queues on port %u\n", MAX_QUEUES_PER_PORT, port->pid);
         switch (mode) {
         case LCORE_MODE_RX:
-            lport->rx_qid = port->num_rx_qids++;
+            lport->rx_qid                  = port->num_rx_qids++;
+            port->rx_lports[lport->rx_qid] = lport;
             DBG_PRINT("lcore %u is in RX mode\n", l);
             break;
         case LCORE_MODE_TX:
-            lport->tx_qid = port->num_tx_qids++;
+            lport->tx_qid                  = port->num_tx_qids++;
+            port->tx_lports[lport->tx_qid] = lport;
             DBG_PRINT("lcore %u is in TX mode\n", l);
             break;
         case LCORE_MODE_BOTH:
-            lport->rx_qid = port->num_rx_qids++;
-            lport->tx_qid = port->num_tx_qids++;
+            lport->rx_qid                  = port->num_rx_qids++;
+            lport->tx_qid                  = port->num_tx_qids++;
+            port->rx_lports[lport->rx_qid] = lport;
+            port->tx_lports[lport->tx_qid] = lport;
             DBG_PRINT("lcore %u is in RX/TX mode\n", l);
             break;
         default:
@@ -242,6 +288,108 @@ parse_mapping(const char *map)
     return EXIT_SUCCESS;
 }
 
+/*
+ * Parse a Tx rate of a percentage of the link speed, or of packets or wire bits per second with a
+ * k, m or g multiplier, e.g. 50, 12.5%, 100kpps or 9.5Gbps. A percentage above MAX_TX_RATE is the
+ * default rate.
+ */
+static int
+parse_rate(const char *str)
+{
+    char *end;
+    double val = strtod(str, &end);
+    double mult;
+
+    if (end == str || val < 0)
+        return -1;
+
+    switch (tolower(*end)) {
+    case 'k':
+        mult = 1e3;
+        end++;
+        break;
+    case 'm':
+        mult = 1e6;
+        end++;
+        break;
+    case 'g':
+        mult = 1e9;
+        end++;
+        break;
+    default:
+        mult = 1;
+        break;
+    }
+
+    if (mult == 1 && (*end == '\0' || !strcmp(end, "%"))) {
+        info->tx_rate_unit = TX_RATE_PCT;
+        info->tx_rate      = (val > MAX_TX_RATE) ? DEFAULT_TX_RATE : val;
+        return 0;
+    }
+    if (strcasecmp(end, "pps") && strcasecmp(end, "bps"))
+        return -1;
+
+    info->tx_rate_unit = strcasecmp(end, "pps") ? TX_RATE_BPS : TX_RATE_PPS;
+    info->tx_rate_abs  = (uint64_t)(val * mult + 0.5);
+
+    return 0;
+}
+
+/*
+ * Parse the frame sizes of the RFC 2544 tests, a list of sizes with FCS, 'std' for the Ethernet
+ * sizes of RFC 2544 or 'fgen' for one test of the loaded FGEN frames.
+ */
+static int
+parse_rfc2544_sizes(const char *str)
+{
+    static const uint16_t std[] = {64, 128, 256, 512, 1024, 1280, 1518};
+    char buf[256], *sizes[MAX_RFC2544_SIZES + 1];
+    int n;
+
+    info->nb_rfc_sizes = 0;
+    if (!strcmp(str, "fgen"))
+        return 0;
+    if (!strcmp(str, "std")) {
+        memcpy(info->rfc_sizes, std, sizeof(std));
+        info->nb_rfc_sizes = RTE_DIM(std);
+        return 0;
+    }
+
+    snprintf(buf, sizeof(buf), "%s", str);
+    n = rte_strsplit(buf, strlen(buf), sizes, RTE_DIM(sizes), ',');
+    if (n <= 0 || n > MAX_RFC2544_SIZES)
+        return -1;
+    for (int i = 0; i < n; i++) {
+        char *end;
+        unsigned long size = strtoul(sizes[i], &end, 10);
+
+        if (*end != '\0' || size < DEFAULT_PKT_SIZE || size > MAX_PKT_SIZE)
+            return -1;
+        info->rfc_sizes[info->nb_rfc_sizes++] = (uint16_t)size;
+    }
+
+    return 0;
+}
+
+/* Parse a replay speed factor, e.g. 10 or 0.5x, 'max' or 0 sends the capture at the -r rate */
+static int
+parse_speed(const char *str)
+{
+    char *end;
+    double val;
+
+    if (!strcasecmp(str, "max")) {
+        info->speed = 0;
+        return 0;
+    }
+    val = strtod(str, &end);
+    if (end == str || (*end != '\0' && strcasecmp(end, "x")) || val < 0 || val > MAX_REPLAY_SPEED)
+        return -1;
+    info->speed = val;
+
+    return 0;
+}
+
 /* Parse the argument given on the command line of the application */
 static int
 parse_args(int argc, char **argv)
@@ -251,6 +399,7 @@ parse_args(int argc, char **argv)
     int option_index;
     char rxtx_desc[64];
     char *descs[3];
+    char rate[32];
 
     argvopt = argv;
 
@@ -262,6 +411,8 @@ parse_args(int argc, char **argv)
     info->mbuf_count     = DEFAULT_MBUF_COUNT;
     info->pkt_size       = DEFAULT_PKT_SIZE;
     info->tx_rate        = DEFAULT_TX_RATE;
+    info->trial_secs     = DEFAULT_TRIAL_SECS;
+    info->speed          = DEFAULT_REPLAY_SPEED;
     info->ip_proto       = IPPROTO_UDP;
     info->force_quit     = false;
     info->verbose        = false;
@@ -287,10 +438,11 @@ parse_args(int argc, char **argv)
             break;
 
         case 'r': /* Tx Rate option */
-            info->tx_rate = strtoul(optarg, NULL, 10);
-            if (info->tx_rate > MAX_TX_RATE)
-                info->tx_rate = DEFAULT_TX_RATE;
-            DBG_PRINT("Packet Tx rate: %'u\n", info->tx_rate);
+            if (parse_rate(optarg) < 0) {
+                ERR_PRINT("Invalid Tx rate '%s'\n", optarg);
+                usage(EXIT_FAILURE);
+            }
+            DBG_PRINT("Packet Tx rate: %s\n", tx_rate_str(rate, sizeof(rate)));
             break;
 
         case 'd': /* Number of Rx/Tx descriptors */
@@ -356,6 +508,10 @@ parse_args(int argc, char **argv)
             }
             break;
 
+        case 'w': /* FGEN frame weights */
+            info->weights = optarg;
+            break;
+
         case 't': /* TCP */
             info->ip_proto = IPPROTO_TCP;
             break;
@@ -364,6 +520,59 @@ parse_args(int argc, char **argv)
             info->ip_proto = IPPROTO_UDP;
             break;
 
+        case 'V': /* Verify Rx packets */
+            info->verify = true;
+            break;
+
+        case 'C': /* Verify Rx checksums */
+            info->cksum = true;
+            break;
+
+        case 'L': /* Measure the Rx latency */
+            info->latency = true;
+            break;
+
+        case 'S': /* Track the Rx sequence numbers */
+            info->seq = true;
+            break;
+
+        case 'R': /* RFC 2544 tests */
+            if (parse_rfc2544_sizes(optarg) < 0) {
+                ERR_PRINT("Invalid RFC 2544 frame sizes '%s'\n", optarg);
+                usage(EXIT_FAILURE);
+            }
+            info->rfc2544 = true;
+            break;
+
+        case 'D': /* RFC 2544 trial duration */
+            info->trial_secs = strtol(optarg, NULL, 0);
+            if (info->trial_secs <= 0 || info->trial_secs > MAX_TRIAL_SECS) {
+                ERR_PRINT("invalid trial duration 1 <= %'u <= %'d (default %d)\n",
+                          info->trial_secs, MAX_TRIAL_SECS, DEFAULT_TRIAL_SECS);
+                usage(EXIT_FAILURE);
+            }
+            break;
+
+        case 'o': /* RFC 2544 results file */
+            info->rfc_output = optarg;
+            break;
+
+        case 'p': /* pcap file to replay */
+            info->pcap_file = optarg;
+            break;
+
+        case 'x': /* Replay speed */
+            if (parse_speed(optarg) < 0) {
+                ERR_PRINT("Invalid replay speed '%s' 0 <= speed <= %d or 'max'\n", optarg,
+                          MAX_REPLAY_SPEED);
+                usage(EXIT_FAILURE);
+            }
+            break;
+
+        case 'N': /* Replay loops */
+            info->loops = strtoul(optarg, NULL, 0);
+            break;
+
         case 'v': /* Verbose option */
             info->verbose = true;
             break;
@@ -387,8 +596,8 @@ parse_args(int argc, char **argv)
                                            (rte_lcore_count() * MEMPOOL_CACHE_SIZE));
     info->mbuf_count = RTE_MAX(info->mbuf_count, DEFAULT_MBUF_COUNT);
 
-    DBG_PRINT("TX packet application started, Burst size %'u, Packet size %'u, Rate %u%%\n",
-              info->burst_count, info->pkt_size, info->tx_rate);
+    DBG_PRINT("TX packet application started, Burst size %'u, Packet size %'u, Rate %s\n",
+              info->burst_count, info->pkt_size, tx_rate_str(rate, sizeof(rate)));
 
     if (info->num_mappings == 0) {
         ERR_PRINT("No port mappings specified, use '-m' option\n");
@@ -401,20 +610,92 @@ parse_args(int argc, char **argv)
 int
 parse_configuration(int argc, char **argv)
 {
+    /* The FGEN strings and files are loaded while parsing the arguments */
+    if ((info->fgen = fgen_create(0)) == NULL)
+        ERR_RET("FGEN creation failed\n");
+
     /* parse application arguments (after the EAL ones) */
     if (parse_args(argc, argv) < 0)
         ERR_RET("Invalid PKTPERF arguments\n");
 
+    if (info->verify) {
+        frame_t *f = fgen_next_frame(info->fgen, NULL);
+
+        if (!f)
+            ERR_RET("Verify needs a FGEN frame, use the '-f' or '-F' option\n");
+
+        /* Forwarding devices change the TTL and checksums, the TSC and Seq differ per packet */
+        info->cmp = fgen_compare_create(fbuf_mtod(f, void *), fbuf_data_len(f),
+                                        FGEN_FP_TTL | FGEN_FP_CKSUM | FGEN_FP_TSC | FGEN_FP_SEQ);
+        if (!info->cmp)
+            ERR_RET("Unable to create the verify template\n");
+    }
+
+    /* The loaded FGEN frames are sent in place of the built packets */
+    if (tx_schedule_create() < 0)
+        ERR_RET("Unable to create the FGEN Tx frame schedule\n");
+    /* Each Tx queue has a ring of its own, a port has at most a Tx queue per lcore */
+    if (info->nb_tx_sched)
+        info->mbuf_count += tx_ring_size() * rte_lcore_count();
+    if (info->latency && info->nb_tsc_offs == 0)
+        ERR_RET("Latency needs a FGEN frame with a TSC() layer in the Tx frame schedule\n");
+    if (info->seq && info->nb_seq_streams == 0)
+        ERR_RET("Sequence tracking needs a FGEN frame with a Seq() layer in the schedule\n");
+    if (info->rfc2544 && info->nb_tx_sched && info->nb_rfc_sizes)
+        ERR_RET("RFC 2544 frame sizes are of the built packets, use '-R fgen' for FGEN frames\n");
+    if (info->rfc2544 && !info->nb_tx_sched && !info->nb_rfc_sizes)
+        ERR_RET("RFC 2544 '-R fgen' needs a FGEN frame, use the '-f' or '-F' option\n");
+    if (info->pcap_file) {
+        if (info->nb_tx_sched || info->rfc2544)
+            ERR_RET("A pcap file is replayed in place of the FGEN frames and RFC 2544 tests\n");
+        if (replay_load() < 0)
+            ERR_RET("Unable to load the pcap file to replay\n");
+        info->mbuf_count += info->nb_rp_pkts;
+    }
+
+    /* The descriptors, Tx rings and replay frames are added to the '-M' count after its check */
+    if (info->mbuf_count > MAX_MBUF_COUNT)
+        ERR_RET("Need %'u mbufs per port for the descriptors, Tx frames and replay frames, more "
+                "than the max of %'d, use fewer frames, descriptors or lcores\n",
+                info->mbuf_count, MAX_MBUF_COUNT);
+
     for (int i = 0; i < info->num_mappings; i++)
         parse_mapping(info->mappings[i]);
 
+    /*
+     * Each Rx lcore records the latency of its packets in a histogram of its own and tracks the
+     * streams of every Tx queue, the Tx queue is part of the stream ID sent.
+     */
+    for (int l = 0; l < RTE_MAX_LCORE; l++) {
+        l2p_lport_t *lport = info->lports[l];
+
+        if (!lport)
+            continue;
+        if (info->latency && (lport->mode & LCORE_MODE_RX) && !lport->lat) {
+            lport->lat = hdrhist_create(0);
+            if (!lport->lat)
+                ERR_RET("Unable to allocate the latency histogram of lcore %d\n", l);
+        }
+        if (info->seq && (lport->mode & LCORE_MODE_RX) && !lport->seqt) {
+            lport->seqt = seqtrack_create(MAX_QUEUES_PER_PORT * info->nb_seq_streams, 0);
+            if (!lport->seqt)
+                ERR_RET("Unable to allocate the sequence tracker of lcore %d\n", l);
+        }
+        if (info->seq && (lport->mode & LCORE_MODE_TX) && !lport->tx_seq) {
+            lport->tx_seq = calloc(info->nb_seq_streams, sizeof(uint64_t));
+            if (!lport->tx_seq)
+                ERR_RET("Unable to allocate the Tx streams of lcore %d\n", l);
+            memcpy(lport->tx_seq, info->seq_first, info->nb_seq_streams * sizeof(uint64_t));
+        }
+    }
+
     for (int pid = 0; pid < info->num_ports; pid++) {
         if (port_setup(&info->ports[pid]) < 0)
             ERR_RET("Port setup failed\n");
     }
 
-    if ((info->fgen = fgen_create(0)) == NULL)
-        ERR_RET("FGEN creation failed\n");
+    if (info->nb_rp_pkts && replay_create() < 0)
+        ERR_RET("Unable to load the replay frames into the Tx queues\n");
 
     return 0;
 }
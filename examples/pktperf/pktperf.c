@@ -45,59 +45,497 @@ mbuf_iterate_cb(struct rte_mempool *mp, void *opaque, void *obj, unsigned obj_id
     m->ol_flags = 0;
 }
 
+/* Count the checksums the NIC verified, the other packets are verified in software */
+static __inline__ void
+do_rx_cksum(l2p_port_t *port, struct rte_mbuf **mbufs, uint16_t nb_pkts, qstats_t *c)
+{
+    const void *frames[nb_pkts];
+    uint16_t lens[nb_pkts];
+    fgen_cksum_status_t st[nb_pkts];
+    uint64_t good = 0, bad = 0;
+    uint16_t n = 0;
+
+    for (uint16_t i = 0; i < nb_pkts; i++) {
+        struct rte_mbuf *m = mbufs[i];
+
+        if (port->rx_cksum_hw) {
+            uint64_t ip = m->ol_flags & RTE_MBUF_F_RX_IP_CKSUM_MASK;
+            uint64_t l4 = m->ol_flags & RTE_MBUF_F_RX_L4_CKSUM_MASK;
+
+            if (l4 != RTE_MBUF_F_RX_L4_CKSUM_UNKNOWN) {
+                good += (ip == RTE_MBUF_F_RX_IP_CKSUM_GOOD) + (l4 == RTE_MBUF_F_RX_L4_CKSUM_GOOD);
+                bad += (ip == RTE_MBUF_F_RX_IP_CKSUM_BAD) + (l4 == RTE_MBUF_F_RX_L4_CKSUM_BAD);
+                continue;
+            }
+        }
+        frames[n] = rte_pktmbuf_mtod(m, void *);
+        lens[n++] = rte_pktmbuf_data_len(m);
+    }
+
+    if (n && fgen_cksum_verify_burst(frames, lens, n, st) >= 0) {
+        for (uint16_t i = 0; i < n; i++) {
+            good += (st[i].ip == FGEN_CKSUM_GOOD) + (st[i].l4 == FGEN_CKSUM_GOOD);
+            bad += (st[i].ip == FGEN_CKSUM_BAD) + (st[i].l4 == FGEN_CKSUM_BAD);
+        }
+    }
+
+    c->q_rx_ck_good += good;
+    c->q_rx_ck_bad += bad;
+}
+
+/* Record the latency of the packets with a TSC() stamp, the marker is checked at each offset */
+static __inline__ void
+do_rx_latency(l2p_lport_t *lport, struct rte_mbuf **mbufs, uint16_t nb_pkts)
+{
+    uint64_t now = rte_rdtsc();
+
+    for (uint16_t i = 0; i < nb_pkts; i++) {
+        struct rte_mbuf *m = mbufs[i];
+
+        for (uint16_t k = 0; k < info->nb_tsc_offs; k++) {
+            uint16_t off = info->tsc_offs[k];
+            tsc_t *tsc;
+
+            if (off + sizeof(tsc_t) > rte_pktmbuf_data_len(m))
+                continue;
+            tsc = rte_pktmbuf_mtod_offset(m, tsc_t *, off);
+            if (tsc->tstmp != TIMESTAMP_ID)
+                continue;
+
+            /* The frames sent from the ring without a copy have a zero stamp */
+            if (tsc->tsc_val && tsc->tsc_val < now)
+                hdrhist_record(lport->lat, now - tsc->tsc_val);
+            break;
+        }
+    }
+}
+
+/* Track the sequence numbers of the packets with a Seq() layer, the marker is checked per offset */
+static __inline__ void
+do_rx_seq(l2p_lport_t *lport, struct rte_mbuf **mbufs, uint16_t nb_pkts)
+{
+    for (uint16_t i = 0; i < nb_pkts; i++) {
+        struct rte_mbuf *m = mbufs[i];
+
+        for (uint16_t k = 0; k < info->nb_seq_offs; k++) {
+            uint16_t off = info->seq_offs[k];
+            seq_t *seq;
+
+            if (off + sizeof(seq_t) > rte_pktmbuf_data_len(m))
+                continue;
+            seq = rte_pktmbuf_mtod_offset(m, seq_t *, off);
+            if (seq->seqid != SEQUENCE_ID)
+                continue;
+
+            seqtrack_check(lport->seqt, seq->stream, seq->seq);
+            break;
+        }
+    }
+}
+
 static __inline__ void
 do_rx_process(l2p_lport_t *lport, struct rte_mbuf **mbufs, uint32_t n_mbufs, uint64_t curr_tsc)
 {
     l2p_port_t *port = lport->port;
-    qstats_t *c;
-    uint16_t nb_pkts, rx_qid;
-
-    rx_qid = lport->rx_qid;
-    c      = &port->pq[rx_qid].curr;
+    lstats_t *s      = &lport->stats;
+    uint16_t nb_pkts;
 
     /* drain the RX queue */
-    nb_pkts = rte_eth_rx_burst(port->pid, rx_qid, mbufs, n_mbufs);
+    nb_pkts = rte_eth_rx_burst(port->pid, lport->rx_qid, mbufs, n_mbufs);
     if (nb_pkts) {
+        fgen_compare_result_t bad;
+        qstats_t c = {0};
+
         for (uint16_t i = 0; i < nb_pkts; i++)
-            c->q_ibytes[rx_qid] += rte_pktmbuf_pkt_len(mbufs[i]);
-        c->q_ipackets[rx_qid] += nb_pkts;
+            c.q_ibytes += rte_pktmbuf_pkt_len(mbufs[i]);
+
+        if (lport->lat)
+            do_rx_latency(lport, mbufs, nb_pkts);
+
+        if (lport->seqt)
+            do_rx_seq(lport, mbufs, nb_pkts);
+
+        if (info->cksum)
+            do_rx_cksum(port, mbufs, nb_pkts, &c);
+
+        if (info->cmp) {
+            for (uint16_t i = 0; i < nb_pkts; i++) {
+                struct rte_mbuf *m = mbufs[i];
+
+                if (fgen_compare(info->cmp, rte_pktmbuf_mtod(m, void *), rte_pktmbuf_data_len(m),
+                                 &bad) != 0)
+                    c.q_rx_bad++;
+            }
+        }
 
         rte_pktmbuf_free_bulk(mbufs, nb_pkts);
-        c->q_rx_time[rx_qid] = rte_rdtsc() - curr_tsc;
+
+        /* Counted in one update, the stats thread sees all or none of the burst */
+        lstats_begin(s);
+        s->c.q_ipackets += nb_pkts;
+        s->c.q_ibytes += c.q_ibytes;
+        s->c.q_rx_ck_good += c.q_rx_ck_good;
+        s->c.q_rx_ck_bad += c.q_rx_ck_bad;
+        if (c.q_rx_bad) {
+            s->c.q_rx_bad += c.q_rx_bad;
+            s->rx_bad = bad;
+        }
+        s->c.q_rx_time = rte_rdtsc() - curr_tsc;
+        lstats_end(s);
+    }
+}
+
+/*
+ * Put a copy of the frame of a Tx ring slot with a TSC() layer in the first mbuf of a burst. The
+ * ring mbuf may still be in flight in the driver, the stamp can only be written into an mbuf of
+ * our own. Returns the TSC() layer of the copy or NULL.
+ */
+static __inline__ tsc_t *
+tx_stamp_copy(l2p_lport_t *lport, struct rte_mbuf **mbuf, uint32_t idx)
+{
+    frame_t *f = info->tx_frames[info->tx_sched[idx % info->nb_tx_sched]];
+    struct rte_mbuf *m;
+
+    if (!f->tsc_off)
+        return NULL;
+
+    m = rte_pktmbuf_copy(lport->tx_ring[idx], lport->port->tx_mp, 0, UINT32_MAX);
+    if (!m)
+        return NULL;
+    *mbuf = m;
+
+    return rte_pktmbuf_mtod_offset(m, tsc_t *, f->tsc_off);
+}
+
+/*
+ * Number the Seq() layer of a frame in an mbuf of our own, the stream sent is the stream of the
+ * frame within the streams of the Tx queue. The stream is read from the frame, a ring mbuf may
+ * have been numbered in place by an earlier send.
+ */
+static __inline__ void
+tx_seq_write(l2p_lport_t *lport, frame_t *f, struct rte_mbuf *m)
+{
+    uint32_t stream = (fbuf_mtod_offset(f, seq_t *, f->seq_off))->stream;
+    seq_t *seq      = rte_pktmbuf_mtod_offset(m, seq_t *, f->seq_off);
+
+    seq->stream = (lport->tx_qid * info->nb_seq_streams) + stream;
+    seq->seq    = lport->tx_seq[stream]++;
+}
+
+/*
+ * Claim the mbuf of a Tx ring slot with a Seq() frame and number it. The ring mbuf is written in
+ * place when the driver no longer holds it, taking its refcnt from 1 to 2 keeps the reference of
+ * the ring, else it is copied. Only this lcore sends and frees the mbufs of its ring, a refcnt of
+ * 1 cannot change under us. Returns the mbuf to send or NULL.
+ */
+static __inline__ struct rte_mbuf *
+tx_seq_claim(l2p_lport_t *lport, frame_t *f, struct rte_mbuf *m)
+{
+    if (rte_mbuf_refcnt_read(m) == 1) {
+        rte_mbuf_refcnt_set(m, 2);
+    } else {
+        m = rte_pktmbuf_copy(m, lport->port->tx_mp, 0, UINT32_MAX);
+        if (!m)
+            return NULL;
     }
+    tx_seq_write(lport, f, m);
+
+    return m;
+}
+
+/* Give back the sequence numbers of the mbufs not sent, a partial send resumes at the first one */
+static __inline__ void
+tx_seq_unsend(l2p_lport_t *lport, uint32_t idx, uint16_t n)
+{
+    for (uint16_t i = 0; i < n; i++, idx++) {
+        frame_t *f = info->tx_frames[info->tx_sched[idx % info->nb_tx_sched]];
+
+        if (f->seq_off)
+            lport->tx_seq[(fbuf_mtod_offset(f, seq_t *, f->seq_off))->stream]--;
+    }
+}
+
+/*
+ * Refill the token bucket of a Tx queue and return how many of the next packets its credit covers,
+ * up to a burst. The credit is in tokens times the TSC hz, a packet costs tb_pkt plus tb_byte per
+ * wire byte of its frame in the replay or FGEN ring or of the built packets. The queue sends
+ * whenever the credit covers a packet, so the packets go out in sub-bursts as small as the loop
+ * allows and the depth of the bucket bounds the burst after an idle period.
+ */
+static __inline__ uint16_t
+tx_tb_count(l2p_lport_t *lport, uint16_t n_mbufs, uint64_t now)
+{
+    l2p_port_t *port       = lport->port;
+    uint64_t rate          = lport->tb_rate;
+    uint64_t elapsed       = now - lport->tb_last;
+    uint32_t plen          = info->pkt_size - RTE_ETHER_CRC_LEN;
+    uint32_t idx           = lport->rp_cnt ? lport->rp_next : lport->tx_next;
+    uint32_t sz            = lport->rp_cnt ? lport->rp_cnt : lport->tx_ring_sz;
+    struct rte_mbuf **ring = lport->rp_cnt ? lport->rp_ring : lport->tx_ring;
+    uint64_t credit;
+    uint16_t n;
+
+    if (rate == TX_RATE_UNPACED)
+        return n_mbufs;
+    lport->tb_last = now;
+    if (unlikely(rate == 0))
+        return 0;
+
+    if (elapsed >= lport->tb_fill)
+        credit = port->tb_depth;
+    else
+        credit = RTE_MIN(lport->tb_credit + (elapsed * rate), port->tb_depth);
+    lport->tb_credit = credit;
+
+    for (n = 0; n < n_mbufs; n++) {
+        uint32_t len  = sz ? rte_pktmbuf_pkt_len(ring[idx]) : plen;
+        uint64_t cost = port->tb_pkt + ((uint64_t)(len + PKT_OVERHEAD_SIZE) * port->tb_byte);
+
+        if (cost > credit)
+            break;
+        credit -= cost;
+        if (sz && ++idx == sz)
+            idx = 0;
+    }
+
+    return n;
+}
+
+/* Take the cost of the packets sent from the token bucket of a Tx queue */
+static __inline__ void
+tx_tb_spend(l2p_lport_t *lport, uint16_t nb_pkts, uint64_t bytes)
+{
+    l2p_port_t *port = lport->port;
+    uint64_t cost;
+
+    cost = ((uint64_t)nb_pkts * port->tb_pkt) +
+           ((bytes + ((uint64_t)nb_pkts * PKT_OVERHEAD_SIZE)) * port->tb_byte);
+    lport->tb_credit -= RTE_MIN(cost, lport->tb_credit);
+}
+
+/*
+ * Send the next burst of the prebuilt FGEN frame mbufs, a partial send resumes at the first
+ * mbuf not sent to keep the frame mix of the schedule. With latency on one frame of the burst
+ * is a stamped copy, the rest are sent with a zero stamp the Rx side does not count. With
+ * sequence tracking on the Seq() frames are numbered in an mbuf of our own.
+ */
+static __inline__ void
+do_tx_frames(l2p_lport_t *lport, struct rte_mbuf **mbufs, uint16_t n_mbufs, uint64_t curr_tsc)
+{
+    l2p_port_t *port = lport->port;
+    uint16_t tx_qid  = lport->tx_qid;
+    lstats_t *s      = &lport->stats;
+    uint32_t idx     = lport->tx_next;
+    uint32_t sz      = lport->tx_ring_sz;
+    uint64_t bytes   = 0;
+    tsc_t *tsc       = NULL;
+    uint16_t i       = 0;
+    uint16_t nb_pkts, nb_mbufs;
+
+    if (info->latency && (tsc = tx_stamp_copy(lport, &mbufs[0], idx)) != NULL) {
+        frame_t *f = info->tx_frames[info->tx_sched[idx % info->nb_tx_sched]];
+
+        if (lport->tx_seq && f->seq_off)
+            tx_seq_write(lport, f, mbufs[0]);
+        i = 1;
+        if (++idx == sz)
+            idx = 0;
+    }
+    for (; i < n_mbufs; i++) {
+        struct rte_mbuf *m = lport->tx_ring[idx];
+        frame_t *f         = info->tx_frames[info->tx_sched[idx % info->nb_tx_sched]];
+
+        if (lport->tx_seq && f->seq_off) {
+            m = tx_seq_claim(lport, f, m);
+            if (unlikely(!m))
+                break;
+        } else /* the ring is ours alone, a refcnt of 1 takes the non-atomic path */
+            rte_mbuf_refcnt_update(m, 1);
+        mbufs[i] = m;
+        if (++idx == sz)
+            idx = 0;
+    }
+    nb_mbufs = i;
+
+    if (tsc)
+        tsc->tsc_val = rte_rdtsc();
+    nb_pkts = rte_eth_tx_burst(port->pid, tx_qid, mbufs, nb_mbufs);
+    if (unlikely(nb_pkts != nb_mbufs)) {
+        if (lport->tx_seq)
+            tx_seq_unsend(lport, lport->tx_next + nb_pkts, nb_mbufs - nb_pkts);
+        rte_pktmbuf_free_bulk(&mbufs[nb_pkts], nb_mbufs - nb_pkts);
+    }
+
+    for (i = 0; i < nb_pkts; i++)
+        bytes += rte_pktmbuf_pkt_len(mbufs[i]);
+    lport->tx_next = (lport->tx_next + nb_pkts) % sz;
+    tx_tb_spend(lport, nb_pkts, bytes);
+
+    lstats_begin(s);
+    s->c.q_tx_drops += n_mbufs - nb_pkts;
+    s->c.q_opackets += nb_pkts;
+    s->c.q_obytes += bytes; /* does not include FCS */
+    s->c.q_tx_time = rte_rdtsc() - curr_tsc;
+    lstats_end(s);
+}
+
+/*
+ * Send the replay frames of a Tx queue that are due, up to a burst. A frame is due at the start of
+ * the loop plus its scaled capture time, a queue behind the capture sends the frames due back to
+ * back until it catches up. Only this queue sends its replay mbufs, a partial send resumes at the
+ * first frame not sent.
+ */
+static __inline__ void
+do_tx_replay(l2p_lport_t *lport, struct rte_mbuf **mbufs, uint16_t n_mbufs, uint64_t curr_tsc)
+{
+    l2p_port_t *port = lport->port;
+    lstats_t *s      = &lport->stats;
+    uint32_t idx     = lport->rp_next;
+    uint64_t base    = lport->rp_base;
+    uint64_t bytes   = 0;
+    uint16_t i, nb_pkts;
+
+    for (i = 0; i < n_mbufs; i++) {
+        if (base + lport->rp_tsc[idx] > curr_tsc)
+            break;
+        mbufs[i] = lport->rp_ring[idx];
+        rte_mbuf_refcnt_update(mbufs[i], 1);
+        if (++idx == lport->rp_cnt) {
+            idx = 0;
+            base += lport->rp_period;
+        }
+    }
+    if (i == 0)
+        return;
+
+    nb_pkts = rte_eth_tx_burst(port->pid, lport->tx_qid, mbufs, i);
+    if (unlikely(nb_pkts != i))
+        rte_pktmbuf_free_bulk(&mbufs[nb_pkts], i - nb_pkts);
+
+    for (uint16_t k = 0; k < nb_pkts; k++) {
+        bytes += rte_pktmbuf_pkt_len(mbufs[k]);
+        if (++lport->rp_next == lport->rp_cnt) {
+            lport->rp_next = 0;
+            lport->rp_base += lport->rp_period;
+        }
+    }
+    if (lport->rp_left != UINT64_MAX)
+        lport->rp_left -= nb_pkts;
+    tx_tb_spend(lport, nb_pkts, bytes);
+
+    lstats_begin(s);
+    s->c.q_tx_drops += i - nb_pkts;
+    s->c.q_opackets += nb_pkts;
+    s->c.q_obytes += bytes; /* does not include FCS */
+    s->c.q_tx_time = rte_rdtsc() - curr_tsc;
+    lstats_end(s);
 }
 
 static __inline__ void
 do_tx_process(l2p_lport_t *lport, struct rte_mbuf **mbufs, uint16_t n_mbufs, uint64_t curr_tsc)
 {
     l2p_port_t *port = lport->port;
+    lstats_t *s      = &lport->stats;
     struct rte_mempool *mp;
-    qstats_t *c;
     uint16_t nb_pkts, pid, tx_qid;
 
     pid    = port->pid;
     tx_qid = lport->tx_qid;
-    c      = &port->pq[tx_qid].curr;
     mp     = lport->port->tx_mp;
 
+    /* A replay queue stops after its loops, a queue given no frames of the capture never sends */
+    if (info->nb_rp_pkts)
+        n_mbufs = (uint16_t)RTE_MIN((uint64_t)n_mbufs, lport->rp_left);
+
+    n_mbufs = tx_tb_count(lport, n_mbufs, curr_tsc);
+    if (n_mbufs == 0)
+        return;
+
+    if (info->nb_rp_pkts) {
+        do_tx_replay(lport, mbufs, n_mbufs, curr_tsc);
+        return;
+    }
+    if (lport->tx_ring_sz) {
+        do_tx_frames(lport, mbufs, n_mbufs, curr_tsc);
+        return;
+    }
+
     /* Use mempool routines instead of pktmbuf to make sure the mbufs is not altered */
     if (rte_mempool_get_bulk(mp, (void **)mbufs, n_mbufs) == 0) {
         uint16_t plen = info->pkt_size - RTE_ETHER_CRC_LEN;
 
         nb_pkts = rte_eth_tx_burst(pid, tx_qid, mbufs, n_mbufs);
+        tx_tb_spend(lport, nb_pkts, (uint64_t)nb_pkts * plen);
         if (unlikely(nb_pkts != n_mbufs)) {
             uint32_t n = n_mbufs - nb_pkts;
 
             rte_mempool_put_bulk(mp, (void **)&mbufs[nb_pkts], n);
-            c->q_tx_drops[tx_qid] += n;
+            lstats_begin(s);
+            s->c.q_tx_drops += n;
+            lstats_end(s);
             return;
         }
-        c->q_opackets[tx_qid] += nb_pkts;
-        c->q_obytes[tx_qid] += (nb_pkts * plen); /* does not include FCS */
+        lstats_begin(s);
+        s->c.q_opackets += nb_pkts;
+        s->c.q_obytes += (nb_pkts * plen); /* does not include FCS */
+        s->c.q_tx_time = rte_rdtsc() - curr_tsc;
+        lstats_end(s);
+    } else {
+        lstats_begin(s);
+        s->c.q_no_txmbufs++;
+        lstats_end(s);
+    }
+}
+
+/* Rebuild the Tx packets of a port at the packet size, only called while its Tx queues are idle */
+void
+tx_pkts_rebuild(l2p_port_t *port)
+{
+    l2p_lport_t *lport = NULL;
+
+    for (uint16_t q = 0; q < port->num_tx_qids && !lport; q++)
+        lport = port->tx_lports[q];
+    if (!lport)
+        return;
+
+    /* A port not set up yet builds its packets at the packet size in tx_setup() */
+    pthread_spin_lock(&port->tx_lock);
+    if (port->tx_inited && !info->nb_tx_sched)
+        rte_mempool_obj_iter(port->tx_mp, mbuf_iterate_cb, (void *)lport);
+    pthread_spin_unlock(&port->tx_lock);
+}
+
+/* Setup the Tx packets of the port, the FGEN frames or the replay start of the Tx queue */
+static int
+tx_setup(l2p_lport_t *lport)
+{
+    l2p_port_t *port = lport->port;
+
+    pthread_spin_lock(&port->tx_lock);
+    if (port->tx_inited == 0) {
+        port->tx_inited = 1;
+        if (info->nb_rp_pkts) /* The replay frames are loaded by replay_create() */
+            port->rp_start = rte_rdtsc();
+        else if (!info->nb_tx_sched) /* setup the packet data of all buffers in the pool */
+            rte_mempool_obj_iter(port->tx_mp, mbuf_iterate_cb, (void *)lport);
+    }
+    pthread_spin_unlock(&port->tx_lock);
 
-        c->q_tx_time[tx_qid] = rte_rdtsc() - curr_tsc;
-    } else
-        c->q_no_txmbufs[tx_qid]++;
+    if (info->nb_tx_sched) {
+        /* Each Tx queue builds a ring of its own, no lock needed */
+        if (tx_ring_create(lport) < 0)
+            return -1;
+
+        /* Spread the Tx queues of the port over the schedule */
+        lport->tx_next = (uint32_t)(((uint64_t)lport->tx_ring_sz * lport->tx_qid) /
+                                    port->num_tx_qids);
+    }
+    /* The Tx queues of a port replay the capture from the same start */
+    if (info->nb_rp_pkts)
+        lport->rp_base = port->rp_start;
+    lport->tb_last = rte_rdtsc();
+
+    return 0;
 }
 
 /* main processing loop */
@@ -125,7 +563,6 @@ tx_loop(void)
 {
     l2p_lport_t *lport;
     l2p_port_t *port;
-    uint64_t curr_tsc, burst_tsc;
     uint16_t tx_burst = info->burst_count;
     struct rte_mbuf *mbufs[tx_burst];
 
@@ -135,26 +572,16 @@ tx_loop(void)
     DBG_PRINT("Starting loop for lcore:port:queue %3u:%2u:%2u\n", rte_lcore_id(), port->pid,
               lport->tx_qid);
 
-    pthread_spin_lock(&port->tx_lock);
-    if (port->tx_inited == 0) {
-        port->tx_inited = 1;
-        /* iterate over all buffers in the pktmbuf pool and setup the packet data */
-        rte_mempool_obj_iter(port->tx_mp, mbuf_iterate_cb, (void *)lport);
+    if (tx_setup(lport) < 0) {
+        ERR_PRINT("Tx setup failed for lcore:port:queue %3u:%2u:%2u\n", rte_lcore_id(), port->pid,
+                  lport->tx_qid);
+        return;
     }
-    pthread_spin_unlock(&port->tx_lock);
-
-    burst_tsc = rte_rdtsc() + port->tx_cycles;
-
-    while (!info->force_quit) {
-        curr_tsc = rte_rdtsc();
 
-        if (unlikely(curr_tsc >= burst_tsc)) {
-            burst_tsc = curr_tsc + port->tx_cycles;
+    /* The token bucket of the queue paces the bursts */
+    while (!info->force_quit)
+        do_tx_process(lport, mbufs, tx_burst, rte_rdtsc());
 
-            if (likely(port->tx_cycles))
-                do_tx_process(lport, mbufs, tx_burst, curr_tsc);
-        }
-    }
     DBG_PRINT("Exiting loop for lcore:port:queue %3u:%2u:%2u\n", rte_lcore_id(), port->pid,
               lport->tx_qid);
 }
@@ -164,7 +591,7 @@ rxtx_loop(void)
 {
     l2p_lport_t *lport;
     l2p_port_t *port;
-    uint64_t curr_tsc, burst_tsc;
+    uint64_t curr_tsc;
     uint16_t rx_burst = info->burst_count * 2;
     uint16_t tx_burst = info->burst_count;
     struct rte_mbuf *mbufs[rx_burst];
@@ -175,27 +602,17 @@ rxtx_loop(void)
     DBG_PRINT("Starting loop for lcore:port:queue %3u:%2u:%2u.%2u\n", rte_lcore_id(), port->pid,
               lport->rx_qid, lport->tx_qid);
 
-    pthread_spin_lock(&port->tx_lock);
-    if (port->tx_inited == 0) {
-        port->tx_inited = 1;
-        /* iterate over all buffers in the pktmbuf pool and setup the packet data */
-        rte_mempool_obj_iter(port->tx_mp, mbuf_iterate_cb, (void *)lport);
+    if (tx_setup(lport) < 0) {
+        ERR_PRINT("Tx setup failed for lcore:port:queue %3u:%2u:%2u\n", rte_lcore_id(), port->pid,
+                  lport->tx_qid);
+        return;
     }
-    pthread_spin_unlock(&port->tx_lock);
-
-    burst_tsc = rte_rdtsc() + port->tx_cycles;
 
     while (!info->force_quit) {
         curr_tsc = rte_rdtsc();
 
         do_rx_process(lport, mbufs, rx_burst, curr_tsc);
-
-        if (unlikely(curr_tsc >= burst_tsc)) {
-            burst_tsc = curr_tsc + port->tx_cycles;
-
-            if (likely(port->tx_cycles))
-                do_tx_process(lport, mbufs, tx_burst, curr_tsc);
-        }
+        do_tx_process(lport, mbufs, tx_burst, curr_tsc);
     }
     DBG_PRINT("Exiting loop for lcore:port:queue %3u:%2u:%2u.%u\n", rte_lcore_id(), port->pid,
               lport->rx_qid, lport->tx_qid);
@@ -264,7 +681,7 @@ initialize_dpdk(int argc, char **argv)
 static int
 launch_lcore_threads(void)
 {
-    int lid;
+    int lid, ret = 0;
 
     /* Scroll the screen to keep console output for debugging */
     for (int i = 0; i < 10; i++)
@@ -274,11 +691,15 @@ launch_lcore_threads(void)
     if (rte_eal_mp_remote_launch(txpkts_launch_one_lcore, NULL, SKIP_MAIN) != 0)
         ERR_RET("Failed to launch lcore threads\n");
 
-    /* Display the statistics  */
-    do {
+    /* Run the RFC 2544 tests or display the statistics */
+    if (info->rfc2544) {
+        ret = rfc2544_run();
+        info->force_quit = true;
+    }
+    while (!info->force_quit) {
         print_stats();
         rte_delay_us_sleep(info->timeout_secs * Million);
-    } while (!info->force_quit);
+    }
 
     RTE_LCORE_FOREACH_WORKER(lid)
     {
@@ -294,7 +715,10 @@ launch_lcore_threads(void)
         DBG_PRINT("\n");
     }
 
-    return rte_eal_cleanup();
+    if (rte_eal_cleanup() < 0)
+        return -1;
+
+    return ret;
 }
 
 static txpkts_info_t *
@@ -26,9 +26,14 @@ extern "C" {
 #include <rte_mempool.h>
 #include <rte_mbuf.h>
 #include <rte_string_fns.h>
+#include <rte_atomic.h>
+#include <rte_pause.h>
 
 #include <fgen_common.h>
 #include <fgen.h>
+#include <cksum.h>
+#include <hdrhist.h>
+#include <seqtrack.h>
 
 #define PRINT(format, args...)  \
     do {                        \
@@ -102,6 +107,16 @@ enum {
     MAX_ALLOCA_SIZE          = 1024,         /* Maximum size of an allocation */
     MAX_BURST_COUNT          = 512,          /* max burst count */
     MAX_CHECK_TIME           = 40,           /* (40 * CHECK_INTERVAL) is 10s */
+    MAX_TX_SCHED             = (64 * 1024),  /* Max slots in the FGEN Tx frame schedule */
+    MAX_TSC_OFFS             = 4,            /* Max TSC() layer offsets checked at Rx */
+    MAX_SEQ_OFFS             = 4,            /* Max Seq() layer offsets checked at Rx */
+    MAX_SEQ_STREAMS          = 4096,         /* Max Seq() streams of a Tx queue */
+    MAX_RFC2544_SIZES        = 16,           /* Max frame sizes of the RFC 2544 tests */
+    DEFAULT_TRIAL_SECS       = 10,           /* Default RFC 2544 trial duration */
+    MAX_TRIAL_SECS           = 3600,         /* Max RFC 2544 trial duration */
+    MAX_REPLAY_PKTS          = (256 * 1024), /* Max frames of a replayed pcap file */
+    DEFAULT_REPLAY_SPEED     = 1,            /* Replay at the speed of the capture */
+    MAX_REPLAY_SPEED         = 1000,         /* Max replay speed factor */
 
     RANDOM_SEED           = 0x19560630,                     /* Random seed */
     MEMPOOL_CACHE_SIZE    = RTE_MEMPOOL_CACHE_MAX_SIZE / 2, /* Size of mempool cache */
@@ -119,23 +134,41 @@ enum {
 
 enum { LCORE_MODE_UNKNOWN = 0, LCORE_MODE_RX = 1, LCORE_MODE_TX = 2, LCORE_MODE_BOTH = 3 };
 
+enum { TX_RATE_PCT, TX_RATE_PPS, TX_RATE_BPS }; /* Unit of the -r Tx rate */
+#define TX_RATE_UNPACED UINT64_MAX /* Tx token rate of a queue sending as fast as it can */
+
 typedef struct qstats_s {
-    uint64_t q_ipackets[MAX_QUEUES_PER_PORT]; /** queue Rx packets. */
-    uint64_t q_ibytes[MAX_QUEUES_PER_PORT];   /** successfully received queue bytes */
-
-    uint64_t q_opackets[MAX_QUEUES_PER_PORT]; /** queue Tx packets */
-    uint64_t q_obytes[MAX_QUEUES_PER_PORT];   /** successfully transmitted queue bytes */
-
-    uint64_t q_rx_time[MAX_QUEUES_PER_PORT];    /* Cycles to receive a burst of packets */
-    uint64_t q_tx_drops[MAX_QUEUES_PER_PORT];   /* Tx dropped packets per queue */
-    uint64_t q_tx_time[MAX_QUEUES_PER_PORT];    /* Cycles to transmit a burst of packets */
-    uint64_t q_no_txmbufs[MAX_QUEUES_PER_PORT]; /* Number of times no mbufs were allocated */
-} qstats_t __rte_cache_aligned;
-
-typedef struct pq_s { /* Port/Queue structure */
-    qstats_t curr;    /* Current statistics */
-    qstats_t prev;    /* Previous statistics */
-    qstats_t rate;    /* Rate statistics */
+    uint64_t q_ipackets; /* Rx packets of the queue */
+    uint64_t q_ibytes;   /* Rx bytes of the queue */
+
+    uint64_t q_opackets; /* Tx packets of the queue */
+    uint64_t q_obytes;   /* Tx bytes of the queue */
+
+    uint64_t q_rx_time;    /* Cycles to receive a burst of packets */
+    uint64_t q_tx_drops;   /* Tx dropped packets */
+    uint64_t q_tx_time;    /* Cycles to transmit a burst of packets */
+    uint64_t q_no_txmbufs; /* Number of times no mbufs were allocated */
+    uint64_t q_rx_bad;     /* Rx packets not matching the verify frame */
+    uint64_t q_rx_ck_good; /* Rx IPv4 and L4 checksums found good */
+    uint64_t q_rx_ck_bad;  /* Rx IPv4 and L4 checksums found bad */
+} qstats_t;
+
+/*
+ * The counters of one lcore, written only by the lcore. The seq count is odd while the lcore
+ * updates the counters, print_stats() copies them and tries again if seq was odd or changed, so
+ * it sees the packet and byte counts of the same bursts without a lock in the datapath.
+ */
+typedef struct lstats_s {
+    uint32_t seq;                 /* Update sequence count, odd during an update */
+    qstats_t c;                   /* Counters of the Rx and Tx queues of the lcore */
+    fgen_compare_result_t rx_bad; /* Last difference found in a Rx packet */
+} lstats_t __rte_cache_aligned;
+
+typedef struct pq_s {             /* Port/Queue statistics, only used by print_stats() */
+    qstats_t curr;                /* Current statistics */
+    qstats_t prev;                /* Previous statistics */
+    qstats_t rate;                /* Rate statistics */
+    fgen_compare_result_t rx_bad; /* Last difference found in a Rx packet */
 } pq_t;
 
 typedef struct l2p_port_s {
@@ -147,9 +180,13 @@ typedef struct l2p_port_s {
     uint16_t num_tx_qids;           /* Number of Tx queues */
     uint16_t mtu_size;              /* MTU size */
     uint16_t max_pkt_size;          /* Max packet size */
-    uint64_t tx_cycles;             /* Tx cycles */
-    uint64_t wire_size;             /* Port wire size */
-    uint64_t pps;                   /* Packets per second */
+    bool rx_cksum_hw;               /* Rx checksums are verified by the NIC */
+    uint64_t tx_rate;               /* Tx tokens per second of the port, 0 is off */
+    uint64_t tb_pkt;                /* Token bucket cost of a packet, TSC hz or 0 */
+    uint64_t tb_byte;               /* Token bucket cost of a wire byte, 8 * TSC hz or 0 */
+    uint64_t tb_depth;              /* Token bucket depth, a burst of the largest frame */
+    uint64_t pps;                   /* Packets per second of the link at the packet size */
+    uint64_t rp_start;              /* TSC the replay of the port started at */
     struct rte_mempool *rx_mp;      /* Rx pktmbuf mempool per queue */
     struct rte_mempool *tx_mp;      /* Tx pktmbuf mempool per queue */
     struct rte_eth_link link;       /* Port link status */
@@ -157,16 +194,72 @@ typedef struct l2p_port_s {
     struct rte_eth_stats stats;     /* Port statistics */
     struct rte_eth_stats pstats;    /* Previous port statistics */
     pq_t pq[MAX_QUEUES_PER_PORT];   /* port/queue information */
+    /* lcore of each Rx and Tx queue, the lcore holds the counters of the queue */
+    struct l2p_lport_s *rx_lports[MAX_QUEUES_PER_PORT];
+    struct l2p_lport_s *tx_lports[MAX_QUEUES_PER_PORT];
 } l2p_port_t;
 
-typedef struct l2p_lport_s { /* Each lcore has one port/queue attached */
-    uint16_t mode;           /* TXPKTS_MODE_RX or TXPKTS_MODE_TX or BOTH */
-    uint16_t lid;            /* Lcore ID */
-    uint16_t rx_qid;         /* Queue ID attached to Rx lcore */
-    uint16_t tx_qid;         /* Queue ID attached to Tx lcore */
-    l2p_port_t *port;        /* Port structure */
+typedef struct l2p_lport_s {   /* Each lcore has one port/queue attached */
+    uint16_t mode;             /* TXPKTS_MODE_RX or TXPKTS_MODE_TX or BOTH */
+    uint16_t lid;              /* Lcore ID */
+    uint16_t rx_qid;           /* Queue ID attached to Rx lcore */
+    uint16_t tx_qid;           /* Queue ID attached to Tx lcore */
+    struct rte_mbuf **tx_ring; /* Prebuilt FGEN frame mbufs of the Tx queue in schedule order */
+    uint32_t tx_ring_sz;       /* Number of mbufs in tx_ring */
+    uint32_t tx_next;          /* Index of the next mbuf of tx_ring to send */
+    uint64_t tb_rate;          /* Tx tokens per second of the queue, 0 is off */
+    uint64_t tb_credit;        /* Token bucket credit in tokens times the TSC hz */
+    uint64_t tb_last;          /* TSC of the last token bucket refill */
+    uint64_t tb_fill;          /* TSC cycles to fill the token bucket from empty */
+    l2p_port_t *port;          /* Port structure */
+    hdrhist_t *lat;            /* Rx latency in TSC cycles, NULL if latency is off */
+    seqtrack_t *seqt;          /* Rx sequence tracker, NULL if sequence tracking is off */
+    uint64_t *tx_seq;          /* Next sequence number of each stream of the Tx queue */
+    struct rte_mbuf **rp_ring; /* Replay frame mbufs of the Tx queue in capture order */
+    uint64_t *rp_tsc;          /* TSC of each replay frame from the start of a loop */
+    uint32_t rp_cnt;           /* Number of mbufs in rp_ring */
+    uint32_t rp_next;          /* Index of the next replay frame to send */
+    uint64_t rp_base;          /* TSC of the start of the current loop */
+    uint64_t rp_period;        /* TSC cycles of a loop of the capture */
+    uint64_t rp_left;          /* Replay frames left to send, UINT64_MAX for ever */
+    lstats_t stats;            /* Counters of this lcore in a cache line of their own */
 } l2p_lport_t;
 
+/* Start an update of the counters of an lcore, only called by the lcore */
+static __rte_always_inline void
+lstats_begin(lstats_t *s)
+{
+    __atomic_store_n(&s->seq, s->seq + 1, __ATOMIC_RELAXED);
+    rte_smp_wmb();
+}
+
+/* End an update of the counters of an lcore */
+static __rte_always_inline void
+lstats_end(lstats_t *s)
+{
+    rte_smp_wmb();
+    __atomic_store_n(&s->seq, s->seq + 1, __ATOMIC_RELAXED);
+}
+
+/* Copy the counters of an lcore, retry while the lcore is in the middle of an update */
+static inline void
+lstats_read(const lstats_t *s, lstats_t *copy)
+{
+    uint32_t seq;
+
+    for (;;) {
+        seq = __atomic_load_n(&s->seq, __ATOMIC_ACQUIRE);
+        if (seq & 1) {
+            rte_pause();
+            continue;
+        }
+        memcpy(copy, s, sizeof(*copy));
+        rte_smp_rmb();
+        if (__atomic_load_n(&s->seq, __ATOMIC_RELAXED) == seq)
+            break;
+    }
+}
+
 typedef struct {
     volatile bool force_quit; /* force quit flag */
     bool verbose;             /* verbose flag */
@@ -181,7 +274,9 @@ typedef struct {
 
     /* Configuration values from command line options */
     uint32_t mbuf_count;     /* Number of mbufs to allocate per port. */
-    uint16_t tx_rate;        /* packet TX rate percentage */
+    double tx_rate;          /* packet TX rate percentage */
+    uint16_t tx_rate_unit;   /* TX_RATE_PCT, TX_RATE_PPS or TX_RATE_BPS */
+    uint64_t tx_rate_abs;    /* Tx rate of a port in packets or wire bits per second */
     uint16_t promiscuous_on; /* Ports set in promiscuous mode off by default. */
     uint16_t burst_count;    /* Burst size for RX and TX */
     uint16_t pkt_size;       /* Packet size with FCS */
@@ -190,16 +285,49 @@ typedef struct {
     uint16_t timeout_secs;   /* Statistics print timeout */
     uint16_t ip_proto;       /* IP protocol type */
     fgen_t *fgen;            /* Packet generator */
-    const char *fgen_file;   /* File to use for packet generator */
+    char *weights;           /* Weights of the FGEN frames in the Tx frame schedule */
+    frame_t **tx_frames;     /* FGEN frames in the order they were loaded */
+    uint32_t *tx_sched;      /* Index of the frame sent in each slot of the schedule */
+    uint32_t nb_tx_sched;    /* Number of slots in the schedule, 0 to send built packets */
+    bool verify;             /* Verify Rx packets against the first FGEN frame */
+    fgen_compare_t *cmp;     /* Compare template of the verify frame */
+    bool cksum;              /* Verify the IPv4 and L4 checksums of Rx packets */
+    bool latency;            /* Stamp a frame of each Tx burst and record its latency at Rx */
+    uint16_t nb_tsc_offs;    /* Number of TSC() layer offsets of the scheduled frames */
+    uint16_t tsc_offs[MAX_TSC_OFFS]; /* Offsets of the TSC() layers of the scheduled frames */
+    bool seq;                        /* Number the Seq() frames per stream and track them at Rx */
+    uint16_t nb_seq_offs;            /* Number of Seq() layer offsets of the scheduled frames */
+    uint16_t seq_offs[MAX_SEQ_OFFS]; /* Offsets of the Seq() layers of the scheduled frames */
+    uint32_t nb_seq_streams;         /* Number of Seq() streams, the largest stream ID + 1 */
+    uint64_t *seq_first;             /* First sequence number of each stream, Seq(seq=N) */
+    bool rfc2544;                    /* Run the RFC 2544 tests in place of the statistics */
+    uint16_t nb_rfc_sizes;           /* Number of RFC 2544 frame sizes, 0 for the FGEN frames */
+    uint16_t rfc_sizes[MAX_RFC2544_SIZES]; /* RFC 2544 frame sizes with FCS */
+    uint16_t trial_secs;             /* Duration of a RFC 2544 trial in seconds */
+    char *rfc_output;                /* RFC 2544 JSON results file, NULL for stdout */
+    char *pcap_file;                 /* pcap file replayed in place of the built packets */
+    double speed;                    /* Replay speed of the capture gaps, 0 for the Tx rate */
+    uint32_t loops;                  /* Times the capture is replayed, 0 for ever */
+    uint32_t nb_rp_pkts;             /* Number of frames of the capture replayed */
+    uint32_t rp_max_len;             /* Largest frame of the capture without FCS */
+    uint64_t rp_period_ns;           /* Loop period of the capture in ns */
 } txpkts_info_t;
 
 extern txpkts_info_t *info;
 
 int parse_configuration(int argc, char **argv);
 void packet_rate(l2p_port_t *port);
+char *tx_rate_str(char *buf, size_t sz);
 void print_stats(void);
 int port_setup(l2p_port_t *port);
 void packet_constructor(l2p_lport_t *lport, uint8_t *pkt, uint16_t proto);
+int tx_schedule_create(void);
+uint32_t tx_ring_size(void);
+int tx_ring_create(l2p_lport_t *lport);
+void tx_pkts_rebuild(l2p_port_t *port);
+int rfc2544_run(void);
+int replay_load(void);
+int replay_create(void);
 
 void usage(int err);
 
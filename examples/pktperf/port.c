@@ -73,9 +73,21 @@ port_setup(l2p_port_t *port)
             ERR_RET("Error during getting device (port %u) info: %s\n", pid, strerror(-ret));
         DBG_PRINT("Driver: %s\n", dev_info.driver_name);
 
-        if (dev_info.tx_offload_capa & RTE_ETH_TX_OFFLOAD_MBUF_FAST_FREE)
+        /*
+         * The prebuilt FGEN frame mbufs are sent with a reference count above 1. The scheduled
+         * and the replayed frames are sent from mbufs which stay in a ring, with a reference
+         * taken for each send, so fast free is only enabled when neither is used.
+         */
+        if ((dev_info.tx_offload_capa & RTE_ETH_TX_OFFLOAD_MBUF_FAST_FREE) &&
+            !info->nb_tx_sched && !info->pcap_file)
             local_port_conf.txmode.offloads |= RTE_ETH_TX_OFFLOAD_MBUF_FAST_FREE;
 
+        /* Checksums the NIC can not verify are verified in software when enabled */
+        local_port_conf.rxmode.offloads &= dev_info.rx_offload_capa;
+        port->rx_cksum_hw = (local_port_conf.rxmode.offloads & RTE_ETH_RX_OFFLOAD_CHECKSUM) ==
+                            RTE_ETH_RX_OFFLOAD_CHECKSUM;
+        DBG_PRINT("Port %u Rx checksum offload %s\n", pid, port->rx_cksum_hw ? "on" : "off");
+
         DBG_PRINT("Port %u configure with %u:%u queues\n", pid, port->num_rx_qids,
                   port->num_tx_qids);
 
@@ -0,0 +1,338 @@
+/* SPDX-License-Identifier: BSD-3-Clause
+ * Copyright(c) 2025 Intel Corporation
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <inttypes.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <byteswap.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <pcap.h>
+
+#include <rte_ip.h>
+
+#include <pktperf.h>
+#include <crc32.h>
+
+/*
+ * Replay of the Ethernet frames of a pcap file in place of the built packets.
+ *
+ * The file is mapped read only and indexed once, then each frame is copied into an mbuf of the
+ * Tx mempool of every port and given to the Tx queue picked by the hash of its flow, so the
+ * packets of a flow leave one queue in capture order. The mbufs are never freed, a queue sends
+ * them with an extra reference like the FGEN Tx ring and the file is unmapped once they are
+ * loaded. A frame is due at the start of its loop plus its capture time divided by the speed and
+ * a loop starts the average gap of the capture after the last frame of the loop before. With a
+ * speed of 0 the gaps are not kept and the token bucket of -r paces the queues.
+ */
+
+#define PCAP_MAGIC_US 0xa1b2c3d4 /* Microsecond timestamps */
+#define PCAP_MAGIC_NS 0xa1b23c4d /* Nanosecond timestamps */
+
+typedef struct {
+    uint32_t ts_sec;  /* Capture time in seconds */
+    uint32_t ts_frac; /* Microseconds or nanoseconds of the capture time */
+    uint32_t caplen;  /* Bytes of the frame in the file */
+    uint32_t len;     /* Length of the frame on the wire */
+} rp_rec_t;
+
+typedef struct {
+    const uint8_t *data; /* Frame in the mapped file */
+    uint64_t ns;         /* Capture time since the first frame in ns */
+    uint32_t hash;       /* Flow hash of the frame */
+    uint16_t len;        /* Frame length without FCS */
+} rp_pkt_t;
+
+/* The mapped file and its index, from replay_load() until the frames are loaded */
+static struct {
+    uint8_t *map;     /* pcap file mapped read only */
+    size_t size;      /* Size of the pcap file */
+    rp_pkt_t *pkts;   /* Frames of the file in capture order */
+    uint32_t nb_pkts; /* Number of frames */
+} rp;
+
+static void
+rp_free(void)
+{
+    if (rp.map && rp.map != MAP_FAILED)
+        munmap(rp.map, rp.size);
+    free(rp.pkts);
+    memset(&rp, 0, sizeof(rp));
+}
+
+/* Hash of an address and L4 port, the hashes of both ends are combined in either order */
+static inline uint32_t
+rp_hash_end(const uint8_t *addr, uint32_t len, const uint8_t *port)
+{
+    uint32_t crc = fgen_crc32_update(0, addr, len);
+
+    return port ? fgen_crc32_update(crc, port, sizeof(uint16_t)) : crc;
+}
+
+/*
+ * Symmetric hash of the IPv4 or IPv6 addresses and the TCP, UDP or SCTP ports of a frame, both
+ * directions of a flow are sent by the same queue. Fragments hash their addresses only and other
+ * frames their MAC addresses.
+ */
+static uint32_t
+rp_hash(const uint8_t *pkt, uint32_t len)
+{
+    uint32_t off = 2 * RTE_ETHER_ADDR_LEN, alen, l4;
+    const uint8_t *src, *dst;
+    uint16_t type;
+    uint8_t proto;
+
+    type = (pkt[off] << 8) | pkt[off + 1];
+    off += sizeof(uint16_t);
+    while ((type == RTE_ETHER_TYPE_VLAN || type == RTE_ETHER_TYPE_QINQ) && off + 4 <= len) {
+        type = (pkt[off + 2] << 8) | pkt[off + 3];
+        off += 4;
+    }
+
+    if (type == RTE_ETHER_TYPE_IPV4 && off + sizeof(struct rte_ipv4_hdr) <= len) {
+        const struct rte_ipv4_hdr *ip = (const struct rte_ipv4_hdr *)(pkt + off);
+
+        alen  = sizeof(ip->src_addr);
+        src   = (const uint8_t *)&ip->src_addr;
+        dst   = (const uint8_t *)&ip->dst_addr;
+        proto = ip->next_proto_id;
+        l4    = off + rte_ipv4_hdr_len(ip);
+        if (ip->fragment_offset &
+            rte_cpu_to_be_16(RTE_IPV4_HDR_MF_FLAG | RTE_IPV4_HDR_OFFSET_MASK))
+            proto = 0;
+    } else if (type == RTE_ETHER_TYPE_IPV6 && off + sizeof(struct rte_ipv6_hdr) <= len) {
+        const struct rte_ipv6_hdr *ip = (const struct rte_ipv6_hdr *)(pkt + off);
+
+        alen  = sizeof(ip->src_addr);
+        src   = (const uint8_t *)&ip->src_addr;
+        dst   = (const uint8_t *)&ip->dst_addr;
+        proto = ip->proto;
+        l4    = off + sizeof(struct rte_ipv6_hdr);
+    } else
+        return rp_hash_end(pkt, RTE_ETHER_ADDR_LEN, NULL) ^
+               rp_hash_end(pkt + RTE_ETHER_ADDR_LEN, RTE_ETHER_ADDR_LEN, NULL);
+
+    if ((proto == IPPROTO_TCP || proto == IPPROTO_UDP || proto == IPPROTO_SCTP) && l4 + 4 <= len)
+        return rp_hash_end(src, alen, pkt + l4) ^ rp_hash_end(dst, alen, pkt + l4 + 2) ^ proto;
+
+    return rp_hash_end(src, alen, NULL) ^ rp_hash_end(dst, alen, NULL) ^ proto;
+}
+
+/*
+ * Map the pcap file and index its Ethernet frames, before the mempools are sized. Frames shorter
+ * than an Ethernet header or longer than the max packet size are skipped, frames captured short
+ * of their length are sent as captured.
+ */
+int
+replay_load(void)
+{
+    const struct pcap_file_header *fh;
+    uint64_t first = 0, last = 0, bytes = 0, gap;
+    uint32_t skipped = 0, max_len = 0, nb_alloc = 0;
+    uint32_t magic, link;
+    bool swap, nsec;
+    struct stat st;
+    size_t off;
+    int fd;
+
+    fd = open(info->pcap_file, O_RDONLY);
+    if (fd < 0) {
+        ERR_PRINT("Unable to open pcap file '%s': %s\n", info->pcap_file, strerror(errno));
+        return -1;
+    }
+    if (fstat(fd, &st) < 0 || (size_t)st.st_size < sizeof(*fh)) {
+        close(fd);
+        ERR_PRINT("pcap file '%s' is too short\n", info->pcap_file);
+        return -1;
+    }
+    rp.size = st.st_size;
+    rp.map  = mmap(NULL, rp.size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (rp.map == MAP_FAILED) {
+        ERR_PRINT("Unable to map pcap file '%s': %s\n", info->pcap_file, strerror(errno));
+        goto err;
+    }
+    madvise(rp.map, rp.size, MADV_SEQUENTIAL);
+
+    fh    = (const struct pcap_file_header *)rp.map;
+    magic = fh->magic;
+    swap  = (magic == bswap_32(PCAP_MAGIC_US) || magic == bswap_32(PCAP_MAGIC_NS));
+    if (swap)
+        magic = bswap_32(magic);
+    if (magic != PCAP_MAGIC_US && magic != PCAP_MAGIC_NS) {
+        ERR_PRINT("'%s' is not a pcap file, magic 0x%08x\n", info->pcap_file, fh->magic);
+        goto err;
+    }
+    nsec = (magic == PCAP_MAGIC_NS);
+    link = swap ? bswap_32(fh->linktype) : fh->linktype;
+    if ((link & 0xffff) != DLT_EN10MB) {
+        ERR_PRINT("pcap file '%s' link type %u is not Ethernet\n", info->pcap_file, link & 0xffff);
+        goto err;
+    }
+
+    for (off = sizeof(*fh); off + sizeof(rp_rec_t) <= rp.size;) {
+        const rp_rec_t *rec = (const rp_rec_t *)(rp.map + off);
+        uint32_t caplen     = swap ? bswap_32(rec->caplen) : rec->caplen;
+        uint64_t ns;
+        rp_pkt_t *p;
+
+        off += sizeof(rp_rec_t);
+        if (caplen > rp.size - off) {
+            INFO_PRINT("pcap file '%s' is truncated at offset %'zu\n", info->pcap_file, off);
+            break;
+        }
+        if (caplen < RTE_ETHER_HDR_LEN || caplen > (MAX_PKT_SIZE - RTE_ETHER_CRC_LEN)) {
+            skipped++;
+            off += caplen;
+            continue;
+        }
+        if (rp.nb_pkts == MAX_REPLAY_PKTS) {
+            ERR_PRINT("pcap file '%s' has more than %'d frames\n", info->pcap_file,
+                      MAX_REPLAY_PKTS);
+            goto err;
+        }
+        if (rp.nb_pkts == nb_alloc) {
+            nb_alloc = nb_alloc ? nb_alloc * 2 : 1024;
+            p        = realloc(rp.pkts, nb_alloc * sizeof(rp_pkt_t));
+            if (!p) {
+                ERR_PRINT("Unable to allocate the index of %'u frames\n", nb_alloc);
+                goto err;
+            }
+            rp.pkts = p;
+        }
+
+        ns = (uint64_t)(swap ? bswap_32(rec->ts_sec) : rec->ts_sec) * Billion;
+        ns += (uint64_t)(swap ? bswap_32(rec->ts_frac) : rec->ts_frac) * (nsec ? 1 : 1000);
+        if (rp.nb_pkts == 0)
+            first = ns;
+
+        /* A capture time going back is sent with no gap */
+        p       = &rp.pkts[rp.nb_pkts++];
+        p->data = rp.map + off;
+        p->len  = caplen;
+        p->ns   = RTE_MAX(ns - RTE_MIN(ns, first), last);
+        p->hash = rp_hash(p->data, caplen);
+        last    = p->ns;
+        bytes += caplen;
+        max_len = RTE_MAX(max_len, caplen);
+        off += caplen;
+    }
+    if (rp.nb_pkts == 0) {
+        ERR_PRINT("pcap file '%s' has no Ethernet frames to send\n", info->pcap_file);
+        goto err;
+    }
+
+    gap                = (rp.nb_pkts > 1) ? last / (rp.nb_pkts - 1) : 0;
+    info->nb_rp_pkts   = rp.nb_pkts;
+    info->rp_max_len   = max_len;
+    info->rp_period_ns = last + gap;
+
+    /* The Tx rate is paced on the average frame size of the capture */
+    info->pkt_size = (bytes / rp.nb_pkts) + RTE_ETHER_CRC_LEN;
+
+    printf("Replay: %'u frames of '%s', %'u skipped, %'.3f seconds, average size %'u with FCS\n",
+           rp.nb_pkts, info->pcap_file, skipped, (double)last / Billion, info->pkt_size);
+
+    return 0;
+
+err:
+    rp_free();
+    return -1;
+}
+
+/* Load the frames of the Tx queues of a port into mbufs of its Tx mempool */
+static int
+rp_port_create(l2p_port_t *port, double scale)
+{
+    int sid = rte_eth_dev_socket_id(port->pid);
+    l2p_lport_t *txq[MAX_QUEUES_PER_PORT];
+    uint32_t cnt[MAX_QUEUES_PER_PORT] = {0};
+    uint16_t nb_txq                   = 0;
+
+    /* The flows are spread over the Tx queues with a core, a queue without one sends nothing */
+    for (uint16_t q = 0; q < port->num_tx_qids; q++)
+        if (port->tx_lports[q])
+            txq[nb_txq++] = port->tx_lports[q];
+    if (nb_txq == 0) {
+        PRINT("Port %u has no Tx queue with a core, %'u replay frames not sent\n", port->pid,
+              rp.nb_pkts);
+        return 0;
+    }
+
+    for (uint32_t i = 0; i < rp.nb_pkts; i++)
+        cnt[rp.pkts[i].hash % nb_txq]++;
+
+    for (uint16_t q = 0; q < nb_txq; q++) {
+        l2p_lport_t *lport = txq[q];
+
+        if (cnt[q] == 0) {
+            DBG_PRINT("Port %u Tx queue %u has no replay frames\n", port->pid, lport->tx_qid);
+            continue;
+        }
+        lport->rp_ring = rte_zmalloc_socket("rp_ring", cnt[q] * sizeof(struct rte_mbuf *),
+                                            RTE_CACHE_LINE_SIZE, sid);
+        lport->rp_tsc  = rte_zmalloc_socket("rp_tsc", cnt[q] * sizeof(uint64_t),
+                                            RTE_CACHE_LINE_SIZE, sid);
+        if (!lport->rp_ring || !lport->rp_tsc)
+            ERR_RET("Unable to allocate the %'u replay frames of port %u queue %u\n", cnt[q],
+                    port->pid, lport->tx_qid);
+    }
+
+    for (uint32_t i = 0; i < rp.nb_pkts; i++) {
+        rp_pkt_t *p        = &rp.pkts[i];
+        l2p_lport_t *lport = txq[p->hash % nb_txq];
+        struct rte_mbuf *m;
+
+        m = rte_pktmbuf_alloc(port->tx_mp);
+        if (!m)
+            ERR_RET("Unable to allocate mbuf %'u of %'u for the replay frames\n", i, rp.nb_pkts);
+
+        rte_memcpy(rte_pktmbuf_mtod(m, void *), p->data, p->len);
+        m->data_len = p->len;
+        m->pkt_len  = p->len;
+
+        lport->rp_tsc[lport->rp_cnt]    = (uint64_t)((double)p->ns * scale);
+        lport->rp_ring[lport->rp_cnt++] = m;
+    }
+
+    for (uint16_t q = 0; q < nb_txq; q++) {
+        l2p_lport_t *lport = txq[q];
+
+        if (!lport->rp_cnt)
+            continue;
+        lport->rp_period = (uint64_t)((double)info->rp_period_ns * scale);
+        lport->rp_left   = info->loops ? (uint64_t)info->loops * lport->rp_cnt : UINT64_MAX;
+        DBG_PRINT("Port %u Tx queue %u replays %'u frames\n", port->pid, lport->tx_qid,
+                  lport->rp_cnt);
+    }
+
+    return 0;
+}
+
+/* Load the frames of the pcap file into the Tx queues of every port and unmap the file */
+int
+replay_create(void)
+{
+    double scale = 0.0;
+    int ret      = 0;
+
+    /* TSC cycles per ns of the capture, all the frames are due at once at a speed of 0 */
+    if (info->speed > 0)
+        scale = (double)rte_get_tsc_hz() / ((double)Billion * info->speed);
+
+    for (uint16_t pid = 0; pid < info->num_ports && ret == 0; pid++) {
+        l2p_port_t *port = &info->ports[pid];
+
+        if (port->num_tx_qids && port->tx_mp)
+            ret = (rp_port_create(port, scale) == 0) ? 0 : -1;
+    }
+    rp_free();
+
+    return ret;
+}
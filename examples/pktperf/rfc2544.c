@@ -0,0 +1,329 @@
+/* SPDX-License-Identifier: BSD-3-Clause
+ * Copyright(c) 2025 Intel Corporation
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <inttypes.h>
+#include <locale.h>
+
+#include <pktperf.h>
+
+/*
+ * RFC 2544 throughput, latency and frame loss rate tests of the ports in the mappings.
+ *
+ * A trial offers a percentage of the line rate on every port for the trial duration, stops the
+ * Tx queues and waits for the packets in flight before it compares the packets sent and received
+ * by all the ports. A trial passes when every packet sent was received and, with -S, no sequence
+ * number was lost. The throughput is the highest rate passing a binary search from the line rate
+ * down to RFC2544_RESOLUTION percent. With -L the latency is measured in a trial at the throughput
+ * rate, and the frame loss rate is measured from the line rate down in 10% steps until two trials
+ * in a row pass. Each frame size is tested in turn, the built packets are rebuilt for the size.
+ */
+
+enum {
+    RFC2544_SETTLE_MS   = 2000, /* Wait for the packets in flight after a trial */
+    RFC2544_MAX_SEARCH  = 20,   /* Max trials of a binary search */
+    RFC2544_LOSS_STEP   = 10,   /* Frame loss rate steps in percent of the line rate */
+    RFC2544_LOSS_TRIALS = (100 / RFC2544_LOSS_STEP),
+};
+#define RFC2544_RESOLUTION 0.1 /* The binary search stops at this percent of the line rate */
+
+typedef struct {
+    uint64_t tx;       /* Packets sent by all the Tx queues */
+    uint64_t rx;       /* Packets received by all the Rx queues */
+    uint64_t seq_lost; /* Sequence numbers lost by all the Rx queues */
+} rfc_counts_t;
+
+typedef struct {
+    double pct;    /* Rate offered in percent of the line rate */
+    uint64_t tx;   /* Packets sent */
+    uint64_t rx;   /* Packets received */
+    uint64_t lost; /* Packets lost, the larger of tx - rx and the sequence numbers lost */
+} rfc_trial_t;
+
+typedef struct {
+    uint16_t size;                          /* Frame size with FCS */
+    uint16_t nb_loss;                       /* Number of frame loss rate trials */
+    rfc_trial_t tput;                       /* Highest trial without loss, pct 0 if none */
+    hdrhist_summary_t lat;                  /* Latency at the throughput rate in TSC cycles */
+    rfc_trial_t loss[RFC2544_LOSS_TRIALS];  /* Frame loss rate trials */
+} rfc_result_t;
+
+static void
+rfc_counts(rfc_counts_t *c)
+{
+    lstats_t snap;
+
+    memset(c, 0, sizeof(*c));
+    for (uint16_t pid = 0; pid < info->num_ports; pid++) {
+        l2p_port_t *port = &info->ports[pid];
+
+        for (uint16_t q = 0; q < port->num_rx_qids; q++) {
+            l2p_lport_t *lport = port->rx_lports[q];
+            seqtrack_counts_t sc;
+
+            if (!lport)
+                continue;
+            lstats_read(&lport->stats, &snap);
+            c->rx += snap.c.q_ipackets;
+            if (lport->seqt && seqtrack_counts(lport->seqt, &sc) == 0)
+                c->seq_lost += sc.lost;
+        }
+        for (uint16_t q = 0; q < port->num_tx_qids; q++) {
+            if (port->tx_lports[q]) {
+                lstats_read(&port->tx_lports[q]->stats, &snap);
+                c->tx += snap.c.q_opackets;
+            }
+        }
+    }
+}
+
+/* Offer a percentage of the line rate on every port, 0 stops the Tx queues */
+static void
+rfc_rate(double pct)
+{
+    info->tx_rate_unit = TX_RATE_PCT;
+    info->tx_rate      = pct;
+
+    for (uint16_t pid = 0; pid < info->num_ports; pid++) {
+        l2p_port_t *port = &info->ports[pid];
+
+        if (rte_atomic16_read(&port->inited) == 0)
+            continue;
+        memset(&port->link, 0, sizeof(port->link));
+        if (rte_eth_link_get_nowait(port->pid, &port->link) == 0)
+            packet_rate(port);
+    }
+}
+
+static void
+rfc_trial(double pct, rfc_trial_t *t)
+{
+    rfc_counts_t a, b;
+
+    rfc_counts(&a);
+    rfc_rate(pct);
+    rte_delay_us_sleep(info->trial_secs * Million);
+    rfc_rate(0);
+    rte_delay_us_sleep(RFC2544_SETTLE_MS * 1000);
+    rfc_counts(&b);
+
+    t->pct  = pct;
+    t->tx   = b.tx - a.tx;
+    t->rx   = b.rx - a.rx;
+    t->lost = (t->tx > t->rx) ? t->tx - t->rx : 0;
+    if (b.seq_lost > a.seq_lost)
+        t->lost = RTE_MAX(t->lost, b.seq_lost - a.seq_lost);
+
+    PRINT("  Trial %7.3f%%: Tx %'" PRIu64 ", Rx %'" PRIu64 ", Lost %'" PRIu64 "\n", pct, t->tx,
+          t->rx, t->lost);
+}
+
+static inline bool
+rfc_passed(const rfc_trial_t *t)
+{
+    return t->tx && t->lost == 0;
+}
+
+/* Binary search for the highest rate without loss, starting at the line rate */
+static void
+rfc_throughput(rfc_result_t *r)
+{
+    double lo = 0.0, hi = 100.0, pct = 100.0;
+    rfc_trial_t t;
+
+    for (int n = 0; n < RFC2544_MAX_SEARCH && !info->force_quit; n++) {
+        rfc_trial(pct, &t);
+        if (rfc_passed(&t)) {
+            r->tput = t;
+            lo      = pct;
+        } else
+            hi = pct;
+        if ((hi - lo) <= RFC2544_RESOLUTION)
+            break;
+        pct = (lo + hi) / 2.0;
+    }
+}
+
+/* The Rx queues are idle between trials, the histograms are reset with no packets recorded */
+static void
+rfc_latency(rfc_result_t *r)
+{
+    hdrhist_t *all = hdrhist_create(0);
+    rfc_trial_t t;
+
+    if (!all)
+        return;
+
+    for (uint16_t pid = 0; pid < info->num_ports; pid++) {
+        l2p_port_t *port = &info->ports[pid];
+
+        for (uint16_t q = 0; q < port->num_rx_qids; q++)
+            if (port->rx_lports[q])
+                hdrhist_reset(port->rx_lports[q]->lat);
+    }
+
+    rfc_trial(r->tput.pct, &t);
+
+    for (uint16_t pid = 0; pid < info->num_ports; pid++) {
+        l2p_port_t *port = &info->ports[pid];
+
+        for (uint16_t q = 0; q < port->num_rx_qids; q++)
+            if (port->rx_lports[q] && port->rx_lports[q]->lat)
+                hdrhist_merge(all, port->rx_lports[q]->lat);
+    }
+    hdrhist_summary(all, &r->lat);
+    hdrhist_destroy(all);
+}
+
+/* Frame loss rate from the line rate down until two trials in a row pass */
+static void
+rfc_loss(rfc_result_t *r)
+{
+    int passed = 0;
+
+    for (int pct = 100; pct > 0 && passed < 2 && !info->force_quit; pct -= RFC2544_LOSS_STEP) {
+        rfc_trial_t *t = &r->loss[r->nb_loss++];
+
+        rfc_trial(pct, t);
+        passed = rfc_passed(t) ? passed + 1 : 0;
+    }
+}
+
+/* Wire bits per second of a packet rate, with the preamble, FCS and inter-frame gap */
+static double
+rfc_bps(const rfc_trial_t *t, uint16_t size)
+{
+    uint64_t bits = ((uint64_t)size - RTE_ETHER_CRC_LEN + PKT_OVERHEAD_SIZE) * 8;
+
+    return ((double)t->tx * bits) / info->trial_secs;
+}
+
+static void
+rfc_json(FILE *f, const rfc_result_t *res, uint16_t nb)
+{
+    double us = (double)Million / rte_get_tsc_hz();
+
+    fprintf(f, "{\n  \"trial_secs\": %u,\n  \"frames\": \"%s\",\n  \"throughput\": [\n",
+            info->trial_secs, info->nb_tx_sched ? "fgen" : "built");
+    for (uint16_t i = 0; i < nb; i++) {
+        const rfc_result_t *r = &res[i];
+
+        fprintf(f,
+                "    {\"size\": %u, \"rate_pct\": %.3f, \"pps\": %.0f, \"bps\": %.0f, "
+                "\"tx\": %" PRIu64 ", \"rx\": %" PRIu64 "}%s\n",
+                r->size, r->tput.pct, (double)r->tput.tx / info->trial_secs,
+                rfc_bps(&r->tput, r->size), r->tput.tx, r->tput.rx, (i + 1 < nb) ? "," : "");
+    }
+    fprintf(f, "  ],\n  \"latency\": [\n");
+    for (uint16_t i = 0; info->latency && i < nb; i++) {
+        const hdrhist_summary_t *s = &res[i].lat;
+
+        fprintf(f,
+                "    {\"size\": %u, \"rate_pct\": %.3f, \"count\": %" PRIu64 ", \"min_us\": %.3f, "
+                "\"avg_us\": %.3f, \"p50_us\": %.3f, \"p99_us\": %.3f, \"p999_us\": %.3f, "
+                "\"max_us\": %.3f}%s\n",
+                res[i].size, res[i].tput.pct, s->count, s->min * us, s->avg * us, s->p50 * us,
+                s->p99 * us, s->p999 * us, s->max * us, (i + 1 < nb) ? "," : "");
+    }
+    fprintf(f, "  ],\n  \"loss\": [\n");
+    for (uint16_t i = 0; i < nb; i++) {
+        for (uint16_t k = 0; k < res[i].nb_loss; k++) {
+            const rfc_trial_t *t = &res[i].loss[k];
+            bool last            = (i + 1 == nb) && (k + 1 == res[i].nb_loss);
+
+            fprintf(f,
+                    "    {\"size\": %u, \"rate_pct\": %.3f, \"tx\": %" PRIu64 ", \"rx\": %" PRIu64
+                    ", \"loss_pct\": %.6f}%s\n",
+                    res[i].size, t->pct, t->tx, t->rx,
+                    t->tx ? ((double)t->lost * 100.0) / t->tx : 0.0, last ? "" : ",");
+        }
+    }
+    fprintf(f, "  ]\n}\n");
+}
+
+/* Write the results in the C locale, a decimal comma is not JSON */
+static int
+rfc_output(const rfc_result_t *res, uint16_t nb)
+{
+    char *numeric = strdup(setlocale(LC_NUMERIC, NULL));
+    FILE *f       = stdout;
+    int ret       = 0;
+
+    if (info->rfc_output && (f = fopen(info->rfc_output, "w")) == NULL) {
+        ERR_PRINT("Unable to open RFC 2544 results file '%s'\n", info->rfc_output);
+        free(numeric);
+        return -1;
+    }
+
+    setlocale(LC_NUMERIC, "C");
+    rfc_json(f, res, nb);
+    if (numeric)
+        setlocale(LC_NUMERIC, numeric);
+    free(numeric);
+
+    if (f != stdout && fclose(f) != 0) {
+        ERR_PRINT("Unable to write RFC 2544 results file '%s'\n", info->rfc_output);
+        ret = -1;
+    }
+    fflush(stdout);
+
+    return ret;
+}
+
+int
+rfc2544_run(void)
+{
+    uint16_t nb = info->nb_rfc_sizes ? info->nb_rfc_sizes : 1;
+    rfc_result_t *res;
+    int ret;
+
+    /* The rate is a percentage of the link speed, wait for the links to come up */
+    for (uint16_t pid = 0; pid < info->num_ports; pid++) {
+        l2p_port_t *port = &info->ports[pid];
+
+        if (rte_atomic16_read(&port->inited) == 0)
+            continue;
+        memset(&port->link, 0, sizeof(port->link));
+        if (rte_eth_link_get(port->pid, &port->link) < 0 || !port->link.link_status ||
+            port->link.link_speed == 0 || port->link.link_speed == RTE_ETH_SPEED_NUM_UNKNOWN) {
+            ERR_PRINT("RFC 2544 needs port %u up with a link speed\n", port->pid);
+            return -1;
+        }
+    }
+
+    res = calloc(nb, sizeof(rfc_result_t));
+    if (!res) {
+        ERR_PRINT("Unable to allocate the RFC 2544 results\n");
+        return -1;
+    }
+
+    for (uint16_t i = 0; i < nb && !info->force_quit; i++) {
+        rfc_result_t *r = &res[i];
+
+        if (info->nb_rfc_sizes) {
+            info->pkt_size = info->rfc_sizes[i];
+            for (uint16_t pid = 0; pid < info->num_ports; pid++)
+                if (rte_atomic16_read(&info->ports[pid].inited))
+                    tx_pkts_rebuild(&info->ports[pid]);
+        }
+        r->size = info->pkt_size;
+
+        PRINT("RFC 2544 throughput of %u byte frames\n", r->size);
+        rfc_throughput(r);
+        if (info->latency && r->tput.pct > 0 && !info->force_quit) {
+            PRINT("RFC 2544 latency of %u byte frames at %.3f%%\n", r->size, r->tput.pct);
+            rfc_latency(r);
+        }
+        PRINT("RFC 2544 frame loss rate of %u byte frames\n", r->size);
+        rfc_loss(r);
+    }
+
+    ret = rfc_output(res, nb);
+    free(res);
+
+    return ret;
+}
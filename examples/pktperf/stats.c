@@ -21,29 +21,154 @@
 
 #include <pktperf.h>
 
-#define sprint(name, cntr, nl)                                         \
-    do {                                                               \
-        qstats_t *r;                                                   \
-        uint64_t total = 0;                                            \
-        printf("  %-8s", name);                                        \
-        for (uint16_t q = 0; q < port->num_rx_qids; q++) {             \
-            r = &port->pq[q].rate;                                     \
-            total += r->cntr[q];                                       \
-            printf("|%'12" PRIu64, (r->cntr[q] / info->timeout_secs)); \
-        }                                                              \
-        printf("|%'14" PRIu64 "|", (total / info->timeout_secs));      \
-        if (nl)                                                        \
-            printf("\n");                                              \
-        fflush(stdout);                                                \
+#define sprint(name, cntr, nl)                                      \
+    do {                                                            \
+        qstats_t *r;                                                \
+        uint64_t total = 0;                                         \
+        printf("  %-8s", name);                                     \
+        for (uint16_t q = 0; q < nb_qids; q++) {                    \
+            r = &port->pq[q].rate;                                  \
+            total += r->cntr;                                       \
+            printf("|%'12" PRIu64, (r->cntr / info->timeout_secs)); \
+        }                                                           \
+        printf("|%'14" PRIu64 "|", (total / info->timeout_secs));   \
+        if (nl)                                                     \
+            printf("\n");                                           \
+        fflush(stdout);                                             \
     } while (0)
 
+/*
+ * Copy the counters of a queue from the lcores owning them, the Rx counters from the lcore of
+ * the Rx queue and the Tx counters from the lcore of the Tx queue. The lcores are never written
+ * to, the only cost to the datapath is the cache lines of the counters read once per period.
+ */
+static void
+queue_stats(l2p_port_t *port, uint16_t q, pq_t *pq)
+{
+    qstats_t *c = &pq->curr;
+    lstats_t snap;
+
+    if (q < port->num_rx_qids && port->rx_lports[q]) {
+        lstats_read(&port->rx_lports[q]->stats, &snap);
+        c->q_ipackets   = snap.c.q_ipackets;
+        c->q_ibytes     = snap.c.q_ibytes;
+        c->q_rx_time    = snap.c.q_rx_time;
+        c->q_rx_bad     = snap.c.q_rx_bad;
+        c->q_rx_ck_good = snap.c.q_rx_ck_good;
+        c->q_rx_ck_bad  = snap.c.q_rx_ck_bad;
+        pq->rx_bad      = snap.rx_bad;
+    }
+    if (q < port->num_tx_qids && port->tx_lports[q]) {
+        lstats_read(&port->tx_lports[q]->stats, &snap);
+        c->q_opackets   = snap.c.q_opackets;
+        c->q_obytes     = snap.c.q_obytes;
+        c->q_tx_drops   = snap.c.q_tx_drops;
+        c->q_tx_time    = snap.c.q_tx_time;
+        c->q_no_txmbufs = snap.c.q_no_txmbufs;
+    }
+}
+
+/*
+ * Print the latency of the Rx queues of a port in microseconds since the start, the total column
+ * is of the histograms of all the queues merged. The histograms are read while the Rx lcores
+ * update them, a summary may miss the last few packets recorded.
+ */
+static void
+print_latency(l2p_port_t *port, uint16_t nb_qids)
+{
+    const char *names[] = {"LatMin", "LatAvg", "LatP50", "LatP99", "LatP99.9", "LatMax"};
+    double us           = (double)Million / rte_get_tsc_hz();
+    hdrhist_t *all;
+    hdrhist_summary_t sum[MAX_QUEUES_PER_PORT + 1] = {0};
+
+    all = hdrhist_create(0);
+    for (uint16_t q = 0; q < nb_qids; q++) {
+        l2p_lport_t *lport = (q < port->num_rx_qids) ? port->rx_lports[q] : NULL;
+
+        if (!lport || !lport->lat)
+            continue;
+        hdrhist_summary(lport->lat, &sum[q]);
+        if (all)
+            hdrhist_merge(all, lport->lat);
+    }
+    if (all)
+        hdrhist_summary(all, &sum[nb_qids]);
+    hdrhist_destroy(all);
+
+    for (unsigned int k = 0; k < RTE_DIM(names); k++) {
+        printf("  %-8s", names[k]);
+        for (uint16_t q = 0; q <= nb_qids; q++) {
+            const hdrhist_summary_t *s = &sum[q];
+            uint64_t vals[]            = {s->min, s->avg, s->p50, s->p99, s->p999, s->max};
+
+            printf((q < nb_qids) ? "|%'12.2f" : "|%'14.2f| us\n", vals[k] * us);
+        }
+    }
+    printf("  %-8s", "LatCount");
+    for (uint16_t q = 0; q <= nb_qids; q++)
+        printf((q < nb_qids) ? "|%'12" PRIu64 : "|%'14" PRIu64 "|\n", sum[q].count);
+}
+
+/*
+ * Print the sequence counts of the Rx queues of a port since the start and the stream of the port
+ * with the most packets lost. A stream ID is the Tx queue times the number of Seq() streams plus
+ * the stream of the frame.
+ */
+static void
+print_seq(l2p_port_t *port, uint16_t nb_qids)
+{
+    const char *names[] = {"SeqOK", "SeqLost", "SeqLate", "SeqDup"};
+    uint64_t worst_lost = 0;
+    uint32_t worst      = 0;
+    seqtrack_counts_t *all;
+    seqtrack_counts_t cnt[MAX_QUEUES_PER_PORT + 1] = {0};
+
+    all = &cnt[nb_qids];
+
+    for (uint16_t q = 0; q < nb_qids; q++) {
+        l2p_lport_t *lport = (q < port->num_rx_qids) ? port->rx_lports[q] : NULL;
+        seqtrack_counts_t c;
+
+        if (!lport || !lport->seqt)
+            continue;
+        seqtrack_counts(lport->seqt, &cnt[q]);
+        all->in_order += cnt[q].in_order;
+        all->lost += cnt[q].lost;
+        all->late += cnt[q].late;
+        all->dup += cnt[q].dup;
+
+        for (uint32_t id = 0; cnt[q].lost && id < seqtrack_streams(lport->seqt); id++) {
+            if (seqtrack_stream_counts(lport->seqt, id, &c) == 0 && c.lost > worst_lost) {
+                worst_lost = c.lost;
+                worst      = id;
+            }
+        }
+    }
+
+    for (unsigned int k = 0; k < RTE_DIM(names); k++) {
+        printf("  %-8s", names[k]);
+        for (uint16_t q = 0; q <= nb_qids; q++) {
+            const seqtrack_counts_t *c = &cnt[q];
+            uint64_t vals[]            = {c->in_order, c->lost, c->late, c->dup};
+
+            printf((q < nb_qids) ? "|%'12" PRIu64 : "|%'14" PRIu64 "|", vals[k]);
+        }
+        if (k == 1 && worst_lost)
+            printf(" Worst: TxQ %u stream %u lost %'" PRIu64, worst / info->nb_seq_streams,
+                   worst % info->nb_seq_streams, worst_lost);
+        printf("\n");
+    }
+}
+
 /* Print out statistics on packets dropped */
 void
 print_stats(void)
 {
     struct rte_eth_link link;
     struct rte_eth_stats rate;
+    fgen_mem_stats_t mem;
     char link_status_text[RTE_ETH_LINK_MAX_STR_LEN];
+    char rate_str[32];
     char twirl[]   = "|/-\\";
     static int cnt = 0;
 
@@ -57,6 +182,7 @@ print_stats(void)
 
     for (uint16_t pid = 0; pid < info->num_ports; pid++) {
         l2p_port_t *port = &info->ports[pid];
+        uint16_t nb_qids = RTE_MAX(port->num_rx_qids, port->num_tx_qids);
 
         if (rte_atomic16_read(&port->inited) == 0) {
             printf("Port %u is not initialized\n", pid);
@@ -76,23 +202,28 @@ print_stats(void)
         rate.rx_nombuf = port->stats.rx_nombuf - port->pstats.rx_nombuf;
         memcpy(&port->pstats, &port->stats, sizeof(struct rte_eth_stats));
 
-        for (uint16_t q = 0; q < port->num_rx_qids; q++) {
+        for (uint16_t q = 0; q < nb_qids; q++) {
             qstats_t *c, *p, *r;
 
+            queue_stats(port, q, &port->pq[q]);
+
             c = &port->pq[q].curr;
             p = &port->pq[q].prev;
             r = &port->pq[q].rate;
 
-            r->q_opackets[q] = c->q_opackets[q] - p->q_opackets[q];
-            r->q_obytes[q]   = c->q_obytes[q] - p->q_obytes[q];
+            r->q_opackets = c->q_opackets - p->q_opackets;
+            r->q_obytes   = c->q_obytes - p->q_obytes;
 
-            r->q_ipackets[q] = c->q_ipackets[q] - p->q_ipackets[q];
-            r->q_ibytes[q]   = c->q_ibytes[q] - p->q_ibytes[q];
+            r->q_ipackets = c->q_ipackets - p->q_ipackets;
+            r->q_ibytes   = c->q_ibytes - p->q_ibytes;
 
-            r->q_no_txmbufs[q] = c->q_no_txmbufs[q] - p->q_no_txmbufs[q];
-            r->q_tx_drops[q]   = c->q_tx_drops[q] - p->q_tx_drops[q];
-            r->q_tx_time[q]    = c->q_tx_time[q];
-            r->q_rx_time[q]    = c->q_rx_time[q];
+            r->q_rx_bad     = c->q_rx_bad - p->q_rx_bad;
+            r->q_rx_ck_good = c->q_rx_ck_good - p->q_rx_ck_good;
+            r->q_rx_ck_bad  = c->q_rx_ck_bad - p->q_rx_ck_bad;
+            r->q_no_txmbufs = c->q_no_txmbufs - p->q_no_txmbufs;
+            r->q_tx_drops   = c->q_tx_drops - p->q_tx_drops;
+            r->q_tx_time    = c->q_tx_time;
+            r->q_rx_time    = c->q_rx_time;
 
             memcpy(p, c, sizeof(qstats_t));
         }
@@ -105,10 +236,15 @@ print_stats(void)
         printf("%2u >> %s, ", pid, link_status_text);
 
         packet_rate(port);
-        printf("MaxPPS: %'" PRIu64 ", TxCPB: %'" PRIu64 "\n", port->pps, port->tx_cycles);
+        printf("MaxPPS: %'" PRIu64 ", ", port->pps);
+        if (port->tx_rate == TX_RATE_UNPACED)
+            printf("TxRate: unpaced\n");
+        else
+            printf("TxRate: %'" PRIu64 " %s\n", port->tx_rate,
+                   (info->tx_rate_unit == TX_RATE_PPS) ? "pps" : "bps");
 
         printf("  Queue ID");
-        for (uint16_t q = 0; q < port->num_rx_qids; q++)
+        for (uint16_t q = 0; q < nb_qids; q++)
             printf("|%8u    ", q);
         printf("|  %8s    |\n", "Total");
         printf("  --------+------------+------------+------------+--------------+\n");
@@ -123,6 +259,27 @@ print_stats(void)
         if (rate.oerrors)
             printf(" Err : %'12" PRIu64, rate.oerrors);
         printf("\n");
+        if (info->cmp) {
+            fgen_compare_result_t *bad = NULL;
+
+            sprint("RxBad", q_rx_bad, 0);
+            for (uint16_t q = 0; q < nb_qids; q++) {
+                if (port->pq[q].rate.q_rx_bad)
+                    bad = &port->pq[q].rx_bad;
+            }
+            if (bad)
+                printf(" Last: %s.%s at %d", bad->layer, bad->field, bad->offset);
+            printf("\n");
+        }
+        if (info->cksum) {
+            sprint("CkGood", q_rx_ck_good, 0);
+            printf(" %s\n", port->rx_cksum_hw ? "HW" : "SW");
+            sprint("CkBad", q_rx_ck_bad, 1);
+        }
+        if (info->latency)
+            print_latency(port, nb_qids);
+        if (info->seq)
+            print_seq(port, nb_qids);
         sprint("TxDrop", q_tx_drops, 1);
         sprint("NoTxMBUF", q_no_txmbufs, 1);
         sprint("RxTime", q_rx_time, 1);
@@ -130,13 +287,44 @@ print_stats(void)
         printf("\n");
     }
     printf("Pktperf: Burst: %'u, MBUFs/port: %'" PRIu32 ", PktSize:%'" PRIu32
-           ", Rx/Tx %'d/%'d, TxRate %u%%, PID: %d\n",
+           ", Rx/Tx %'d/%'d, TxRate %s, PID: %d\n",
            info->burst_count, info->mbuf_count, info->pkt_size, info->nb_rxd, info->nb_txd,
-           info->tx_rate, getpid());
+           tx_rate_str(rate_str, sizeof(rate_str)), getpid());
     printf("         Port mapping: ");
     for (int i = 0; i < info->num_mappings; i++)
         printf("%s ", info->mappings[i]);
     printf("\n");
+    if (info->nb_rp_pkts) {
+        printf("         Replay: %s, Frames: %'u, Speed: ", info->pcap_file, info->nb_rp_pkts);
+        if (info->speed > 0)
+            printf("%gx", info->speed);
+        else
+            printf("max");
+        if (info->loops)
+            printf(", Loops: %'u\n", info->loops);
+        else
+            printf(", Loops: for ever\n");
+    }
+
+    if (info->fgen && fgen_mem_stats(info->fgen, &mem) == 0) {
+        printf("         Frames: %'u, Data: %'" PRIu64 " of %'" PRIu64 " bytes (%u%% unused)"
+               ", Meta: %'" PRIu64 " bytes, mmap:",
+               mem.nb_frames, mem.frame_bytes, mem.block_bytes, mem.frag_pct, mem.meta_bytes);
+        for (int t = MMAP_HUGEPAGE_4KB; t < MMAP_HUGEPAGE_CNT; t++)
+            printf(" %s %'" PRIu64, mmap_name_by_type(t),
+                   mem.mmap.sizes[t].allocated - mem.mmap.sizes[t].freed);
+        printf("\n");
+
+        /* Allocated/freed bytes of each NUMA node that has had memory placed on it */
+        printf("         NUMA allocated/freed:");
+        for (int n = 0; n < MMAP_MAX_NODES; n++) {
+            mmap_node_stats_t *ns = &mem.mmap.nodes[n];
+
+            if (ns->num_allocated)
+                printf(" node%d %'" PRIu64 "/%'" PRIu64, n, ns->allocated, ns->freed);
+        }
+        printf("\n");
+    }
 
     fflush(stdout);
 }
@@ -23,12 +23,34 @@
 
 enum { DEFAULT_WND_SIZE = 8192 };
 
+/* The largest frame sent by the port, of the capture, the FGEN frames or the built packets */
+static uint32_t
+tx_max_frame(void)
+{
+    uint32_t len = info->pkt_size - RTE_ETHER_CRC_LEN;
+
+    if (info->nb_rp_pkts)
+        len = info->rp_max_len;
+    else if (info->nb_tx_sched) {
+        len = 0;
+        for (uint32_t i = 0; i < info->nb_tx_sched; i++)
+            len = RTE_MAX(len, (uint32_t)fbuf_data_len(info->tx_frames[info->tx_sched[i]]));
+    }
+
+    return len;
+}
+
 /**
  *
  * packet_rate - Calculate the transmit rate.
  *
  * DESCRIPTION
- * Calculate the number of cycles to wait between sending bursts of traffic.
+ * Set the token bucket of the port and the token rate of each Tx queue. A percentage of the link
+ * speed and a bps rate are in wire bits, a packet costs the bits of its frame, preamble, FCS and
+ * inter-frame gap, so frames of mixed sizes are paced at the bit rate. A pps rate costs one token
+ * per packet and needs no link speed. The rate of the port is split over its Tx queues and the
+ * bucket holds a burst of the largest frame. A percentage waits for the link to come up and is
+ * unpaced when the link has no speed.
  *
  * RETURNS: N/A
  *
@@ -37,27 +59,58 @@ enum { DEFAULT_WND_SIZE = 8192 };
 void
 packet_rate(l2p_port_t *port)
 {
-    uint64_t link_speed, wire_size, pps, cpb;
-
-    wire_size       = ((((uint64_t)info->pkt_size - RTE_ETHER_CRC_LEN) + PKT_OVERHEAD_SIZE) * 8);
-    port->wire_size = wire_size;
-    if (port->link.link_speed == 0) {
-        port->tx_cycles = 0;
-        port->pps       = 0;
-        return;
-    }
+    uint64_t link_speed, wire_size, hz = rte_get_tsc_hz();
+    uint16_t nb_qids = RTE_MAX(port->num_tx_qids, 1);
 
+    wire_size  = ((((uint64_t)info->pkt_size - RTE_ETHER_CRC_LEN) + PKT_OVERHEAD_SIZE) * 8);
     link_speed = (uint64_t)port->link.link_speed * Million; /* convert to bit rate */
-    pps        = (((link_speed / wire_size) * ((info->tx_rate == 0) ? 1 : info->tx_rate)) / 100);
-    pps        = ((pps > 0) ? pps : 1);
-    cpb        = (rte_get_timer_hz() / pps) * (uint64_t)info->burst_count; /* Cycles per Burst */
+    if (port->link.link_speed == RTE_ETH_SPEED_NUM_UNKNOWN)
+        link_speed = 0;
+    port->pps = link_speed / wire_size;
+
+    if (info->tx_rate_unit != TX_RATE_PCT)
+        port->tx_rate = info->tx_rate_abs;
+    else if (info->tx_rate == 0 || port->link.link_status == RTE_ETH_LINK_DOWN)
+        port->tx_rate = 0;
+    else if (link_speed == 0)
+        port->tx_rate = TX_RATE_UNPACED;
+    else
+        port->tx_rate = (uint64_t)(((double)link_speed * info->tx_rate) / 100.0);
 
-    port->tx_cycles = (info->tx_rate == 0) ? 0 : (uint64_t)port->num_tx_qids * cpb;
-    port->pps       = pps;
+    port->tb_pkt   = (info->tx_rate_unit == TX_RATE_PPS) ? hz : 0;
+    port->tb_byte  = (info->tx_rate_unit == TX_RATE_PPS) ? 0 : 8 * hz;
+    port->tb_depth = (uint64_t)info->burst_count *
+                     (port->tb_pkt + ((tx_max_frame() + PKT_OVERHEAD_SIZE) * port->tb_byte));
+
+    /* The remainder of the split goes to the first queues */
+    for (uint16_t q = 0; q < port->num_tx_qids; q++) {
+        l2p_lport_t *lport = port->tx_lports[q];
+
+        if (!lport)
+            continue;
+        if (port->tx_rate == TX_RATE_UNPACED)
+            lport->tb_rate = TX_RATE_UNPACED;
+        else
+            lport->tb_rate = (port->tx_rate / nb_qids) + (q < (port->tx_rate % nb_qids));
+        lport->tb_fill = lport->tb_rate ? (port->tb_depth / lport->tb_rate) + 1 : 0;
+    }
 
     DBG_PRINT("      Speed:%'4" PRIu64 " Gbit, Bits: %'6" PRIu64 ", PPS: %'12" PRIu64
-              ", CPB: %'" PRIu64 "\n",
-              link_speed / Billion, wire_size, pps, port->tx_cycles);
+              ", Rate: %'" PRIu64 "\n",
+              link_speed / Billion, wire_size, port->pps, port->tx_rate);
+}
+
+/* Format the -r Tx rate */
+char *
+tx_rate_str(char *buf, size_t sz)
+{
+    if (info->tx_rate_unit == TX_RATE_PCT)
+        snprintf(buf, sz, "%g%%", info->tx_rate);
+    else
+        snprintf(buf, sz, "%'" PRIu64 " %s", info->tx_rate_abs,
+                 (info->tx_rate_unit == TX_RATE_PPS) ? "pps" : "bps");
+
+    return buf;
 }
 
 static __inline__ long
@@ -66,6 +119,228 @@ get_rand(long range)
     return (random() >> 8) % range;
 }
 
+typedef struct {
+    double key;   /* Position of the slot in the run of the schedule */
+    uint32_t idx; /* Index of the frame */
+} tx_slot_t;
+
+static int
+tx_slot_cmp(const void *a, const void *b)
+{
+    const tx_slot_t *x = a, *y = b;
+
+    if (x->key != y->key)
+        return (x->key < y->key) ? -1 : 1;
+    return (x->idx < y->idx) ? -1 : (x->idx > y->idx);
+}
+
+/* Add the offset of a layer to the offsets checked at Rx, if not already there */
+static int
+tx_add_offset(uint16_t *offs, uint16_t *nb, uint16_t max, uint16_t off)
+{
+    uint16_t k;
+
+    for (k = 0; k < *nb && offs[k] != off; k++)
+        ;
+    if (k == *nb) {
+        if (k == max) {
+            ERR_PRINT("Frames have more than %u offsets of a layer\n", max);
+            return -1;
+        }
+        offs[(*nb)++] = off;
+    }
+
+    return 0;
+}
+
+/*
+ * Build the Tx frame schedule from the FGEN frames and the -w weights, a frame without a weight
+ * has a weight of 1 and a weight of 0 leaves the frame out. The k-th of the w slots of a frame
+ * is placed at (k + 0.5) / w of the run, every run of nb_tx_sched slots holds each frame weight
+ * times and the slots of a frame are spread out, so a burst carries the mix of the frames.
+ */
+int
+tx_schedule_create(void)
+{
+    uint32_t nb_frames = fgen_fcnt(info->fgen);
+    uint32_t *weights  = NULL;
+    tx_slot_t *slots   = NULL;
+    uint64_t total = 0, bytes = 0;
+    frame_t *f = NULL;
+    uint32_t n = 0;
+    int ret    = -1;
+
+    if (nb_frames == 0)
+        return 0;
+
+    info->tx_frames = calloc(nb_frames, sizeof(frame_t *));
+    weights         = calloc(nb_frames, sizeof(uint32_t));
+    if (!info->tx_frames || !weights) {
+        ERR_PRINT("Unable to allocate the Tx frame table\n");
+        goto leave;
+    }
+
+    for (uint32_t i = 0; i < nb_frames; i++) {
+        info->tx_frames[i] = f = fgen_next_frame(info->fgen, f);
+        weights[i]             = 1;
+    }
+
+    if (info->weights) {
+        char *w = info->weights;
+
+        for (uint32_t i = 0; *w != '\0'; i++) {
+            if (i >= nb_frames) {
+                ERR_PRINT("More weights than the %u frames in '%s'\n", nb_frames, info->weights);
+                goto leave;
+            }
+            weights[i] = strtoul(w, &w, 10);
+            if (*w == ',')
+                w++;
+            else if (*w != '\0') {
+                ERR_PRINT("Invalid weights '%s'\n", info->weights);
+                goto leave;
+            }
+        }
+    }
+
+    for (uint32_t i = 0; i < nb_frames; i++) {
+        frame_t *tf = info->tx_frames[i];
+
+        total += weights[i];
+        bytes += (uint64_t)weights[i] * fbuf_data_len(tf);
+
+        /* Rx looks for the layers at the offsets of the frames sent, an offset of 0 is none */
+        if (!weights[i])
+            continue;
+        if (info->latency && tf->tsc_off &&
+            tx_add_offset(info->tsc_offs, &info->nb_tsc_offs, MAX_TSC_OFFS, tf->tsc_off) < 0)
+            goto leave;
+        if (info->seq && tf->seq_off) {
+            seq_t *seq = fbuf_mtod_offset(tf, seq_t *, tf->seq_off);
+
+            if (tx_add_offset(info->seq_offs, &info->nb_seq_offs, MAX_SEQ_OFFS, tf->seq_off) < 0)
+                goto leave;
+            if (seq->stream >= MAX_SEQ_STREAMS) {
+                ERR_PRINT("Frame %s stream %u is not below %d\n", tf->name, seq->stream,
+                          MAX_SEQ_STREAMS);
+                goto leave;
+            }
+            info->nb_seq_streams = RTE_MAX(info->nb_seq_streams, seq->stream + 1);
+        }
+    }
+
+    /* A stream starts at the Seq(seq=N) of the first frame of the stream */
+    if (info->nb_seq_streams) {
+        info->seq_first = calloc(info->nb_seq_streams, sizeof(uint64_t));
+        if (!info->seq_first) {
+            ERR_PRINT("Unable to allocate the Seq() streams\n");
+            goto leave;
+        }
+        for (uint32_t i = nb_frames; i-- > 0;) {
+            frame_t *tf = info->tx_frames[i];
+            seq_t *seq  = fbuf_mtod_offset(tf, seq_t *, tf->seq_off);
+
+            if (weights[i] && tf->seq_off)
+                info->seq_first[seq->stream] = seq->seq;
+        }
+    }
+    if (total == 0 || total > MAX_TX_SCHED) {
+        ERR_PRINT("Sum of the frame weights %'" PRIu64 " must be 1 to %'d\n", total, MAX_TX_SCHED);
+        goto leave;
+    }
+
+    slots          = calloc(total, sizeof(tx_slot_t));
+    info->tx_sched = calloc(total, sizeof(uint32_t));
+    if (!slots || !info->tx_sched) {
+        ERR_PRINT("Unable to allocate the Tx frame schedule\n");
+        goto leave;
+    }
+
+    for (uint32_t i = 0; i < nb_frames; i++) {
+        for (uint32_t k = 0; k < weights[i]; k++) {
+            slots[n].key   = (k + 0.5) / weights[i];
+            slots[n++].idx = i;
+        }
+    }
+    qsort(slots, total, sizeof(tx_slot_t), tx_slot_cmp);
+    for (uint32_t i = 0; i < total; i++)
+        info->tx_sched[i] = slots[i].idx;
+    info->nb_tx_sched = total;
+
+    /* The Tx rate is paced on the average frame size of the schedule */
+    info->pkt_size = (bytes / total) + RTE_ETHER_CRC_LEN;
+
+    printf("FGEN Tx: %'u frames, schedule of %'u slots, average size %'u with FCS\n", nb_frames,
+           info->nb_tx_sched, info->pkt_size);
+    ret = 0;
+
+leave:
+    free(slots);
+    free(weights);
+    return ret;
+}
+
+/* Number of mbufs of the Tx ring of a queue, whole runs of the schedule and at least one burst */
+uint32_t
+tx_ring_size(void)
+{
+    return info->nb_tx_sched * ((info->burst_count + info->nb_tx_sched - 1) / info->nb_tx_sched);
+}
+
+/*
+ * Stamp the FGEN frames into mbufs of the Tx mempool of the port in schedule order, one ring per
+ * Tx queue on the socket of its lcore. The mbufs are never freed, the queue sends an mbuf with an
+ * extra reference the driver drops when it is done with it, a Tx burst has no per packet
+ * construction. Only the lcore of the queue touches the mbufs of its ring.
+ */
+int
+tx_ring_create(l2p_lport_t *lport)
+{
+    l2p_port_t *port = lport->port;
+    uint32_t sz      = tx_ring_size();
+    uint32_t i;
+
+    lport->tx_ring = rte_zmalloc_socket("tx_ring", sz * sizeof(struct rte_mbuf *),
+                                        RTE_CACHE_LINE_SIZE, rte_lcore_to_socket_id(lport->lid));
+    if (!lport->tx_ring) {
+        ERR_PRINT("Unable to allocate the Tx ring of %'u mbufs\n", sz);
+        return -1;
+    }
+
+    for (i = 0; i < sz; i++) {
+        frame_t *f = info->tx_frames[info->tx_sched[i % info->nb_tx_sched]];
+        struct rte_mbuf *m;
+
+        m = rte_pktmbuf_alloc(port->tx_mp);
+        if (!m) {
+            ERR_PRINT("Unable to allocate mbuf %'u of %'u for the Tx ring\n", i, sz);
+            goto err;
+        }
+        if (fbuf_data_len(f) > rte_pktmbuf_tailroom(m)) {
+            rte_pktmbuf_free(m);
+            ERR_PRINT("Frame %s of %u bytes is larger than a mbuf\n", f->name, fbuf_data_len(f));
+            goto err;
+        }
+
+        rte_memcpy(rte_pktmbuf_mtod(m, void *), fbuf_mtod(f, void *), fbuf_data_len(f));
+        m->data_len = fbuf_data_len(f);
+        m->pkt_len  = fbuf_data_len(f);
+
+        lport->tx_ring[i] = m;
+    }
+    lport->tx_ring_sz = sz;
+
+    return 0;
+
+err:
+    /* Give the mbufs back to the mempool, the queue then sends nothing */
+    if (i)
+        rte_pktmbuf_free_bulk(lport->tx_ring, i);
+    rte_free(lport->tx_ring);
+    lport->tx_ring = NULL;
+    return -1;
+}
+
 /*
  * IPv4/UDP packet
  * Port Src/Dest       :           1234/ 5678
@@ -87,11 +362,6 @@ packet_constructor(l2p_lport_t *lport, uint8_t *pkt, uint16_t proto)
     struct rte_tcp_hdr *tcp;
     uint16_t tx_qid;
 
-    if (info->fgen_file) {
-        // Get next frame for buffer.
-        return;
-    }
-
     tx_qid = lport->tx_qid;
 
     eth  = (struct rte_ether_hdr *)pkt;
@@ -0,0 +1,212 @@
+/* SPDX-License-Identifier: BSD-3-Clause
+ * Copyright(c) 2023-2025 Intel Corporation
+ */
+
+#include <stdint.h>        // for uint16_t, uint8_t, uint32_t
+#include <stdlib.h>        // for calloc, free
+#include <string.h>        // for memcpy, memset
+
+#include <fgen_common.h>
+#include <fgen_log.h>
+#include <maskcmp.h>
+
+#include "fgen.h"
+#include "decode.h"
+
+/*
+ * Compare received frames to a template frame. The template headers are found once by the
+ * decoder and the volatile fields are cleared in a byte mask, each frame is then checked with a
+ * vector masked XOR. A difference is mapped back to the template layer and field holding it.
+ */
+
+typedef struct compare_field_s {
+    uint8_t off;      /**< Offset of the field in the header */
+    uint8_t len;      /**< Length of the field */
+    const char *name; /**< Name of the field, same as the emit keys */
+} compare_field_t;
+
+typedef struct compare_s {
+    uint16_t len;                             /**< Length of the template frame */
+    int nb_layers;                            /**< Number of headers in the template */
+    decode_layer_t layers[DECODE_MAX_LAYERS]; /**< Headers found in the template */
+    uint8_t data[FGEN_MAX_FRAME_SIZE];        /**< Template frame data */
+    uint8_t bytes[FGEN_MAX_FRAME_SIZE];       /**< Byte mask, 0x00 for the bytes to ignore */
+} compare_t;
+
+// clang-format off
+static const compare_field_t ether_fields[] = {
+    {0, 6, "dst"}, {6, 6, "src"}, {12, 2, "ethertype"}, {0, 0, NULL}
+};
+static const compare_field_t vlan_fields[] = {
+    {0, 2, "vlan"}, {2, 2, "ethertype"}, {0, 0, NULL}
+};
+static const compare_field_t ipv4_fields[] = {
+    {0, 1, "ihl"}, {1, 1, "tos"}, {2, 2, "len"}, {4, 2, "id"}, {6, 2, "frag"}, {8, 1, "ttl"},
+    {9, 1, "proto"}, {10, 2, "cksum"}, {12, 4, "src"}, {16, 4, "dst"}, {0, 0, NULL}
+};
+static const compare_field_t ipv6_fields[] = {
+    {0, 4, "flow"}, {4, 2, "len"}, {6, 1, "proto"}, {7, 1, "hops"}, {8, 16, "src"},
+    {24, 16, "dst"}, {0, 0, NULL}
+};
+static const compare_field_t udp_fields[] = {
+    {0, 2, "sport"}, {2, 2, "dport"}, {4, 2, "len"}, {6, 2, "cksum"}, {0, 0, NULL}
+};
+static const compare_field_t tcp_fields[] = {
+    {0, 2, "sport"}, {2, 2, "dport"}, {4, 4, "seq"}, {8, 4, "ack"}, {12, 1, "doff"},
+    {13, 1, "flags"}, {14, 2, "win"}, {16, 2, "cksum"}, {18, 2, "urp"}, {0, 0, NULL}
+};
+static const compare_field_t vxlan_fields[] = {
+    {0, 4, "flags"}, {4, 4, "vni"}, {0, 0, NULL}
+};
+static const compare_field_t vxlan_gpe_fields[] = {
+    {0, 1, "flags"}, {3, 1, "proto"}, {4, 4, "vni"}, {0, 0, NULL}
+};
+static const compare_field_t gre_fields[] = {
+    {0, 2, "flags"}, {2, 2, "proto"}, {0, 0, NULL}
+};
+static const compare_field_t gtpu_fields[] = {
+    {0, 1, "flags"}, {1, 1, "msg"}, {2, 2, "len"}, {4, 4, "teid"}, {0, 0, NULL}
+};
+static const compare_field_t mpls_fields[] = {
+    {0, 4, "label"}, {0, 0, NULL}
+};
+static const compare_field_t tsc_fields[] = {
+    {0, 4, "id"}, {8, 8, "tsc"}, {0, 0, NULL}
+};
+static const compare_field_t seq_fields[] = {
+    {0, 4, "id"}, {4, 4, "stream"}, {8, 8, "seq"}, {0, 0, NULL}
+};
+
+static const compare_field_t *layer_fields[] = {
+    [DECODE_ETHER]     = ether_fields,
+    [DECODE_DOT1Q]     = vlan_fields,
+    [DECODE_DOT1AD]    = vlan_fields,
+    [DECODE_IPV4]      = ipv4_fields,
+    [DECODE_IPV6]      = ipv6_fields,
+    [DECODE_UDP]       = udp_fields,
+    [DECODE_TCP]       = tcp_fields,
+    [DECODE_VXLAN]     = vxlan_fields,
+    [DECODE_VXLAN_GPE] = vxlan_gpe_fields,
+    [DECODE_GRE]       = gre_fields,
+    [DECODE_GTPU]      = gtpu_fields,
+    [DECODE_MPLS]      = mpls_fields,
+    [DECODE_TSC]       = tsc_fields,
+    [DECODE_SEQ]       = seq_fields,
+};
+// clang-format on
+
+/* Fill in the layer and field of the template holding the byte at offset */
+static void
+_compare_locate(compare_t *cmp, int offset, fgen_compare_result_t *res)
+{
+    res->offset = offset;
+    res->level  = 0;
+    res->layer  = "Unknown";
+    res->field  = "data";
+
+    for (int i = 0; i < cmp->nb_layers; i++) {
+        decode_layer_t *l = &cmp->layers[i];
+        const compare_field_t *f;
+        int off;
+
+        if (offset < l->off || offset >= (l->off + l->len))
+            continue;
+
+        off        = offset - l->off;
+        res->level = l->level;
+        res->layer = decode_layer_name(l->type);
+
+        f = (l->type < fgen_countof(layer_fields)) ? layer_fields[l->type] : NULL;
+        if (!f)
+            return;
+        for (; f->name; f++) {
+            if (off >= f->off && off < (f->off + f->len)) {
+                res->field = f->name;
+                return;
+            }
+        }
+        res->field = "options";
+        return;
+    }
+}
+
+fgen_compare_t *
+fgen_compare_create(const void *data, uint16_t len, uint32_t mask)
+{
+    decode_t *dc   = NULL;
+    compare_t *cmp = NULL;
+
+    if (!data || len == 0 || len > FGEN_MAX_FRAME_SIZE)
+        FGEN_NULL_RET("Invalid template frame of %u bytes\n", len);
+
+    cmp = calloc(1, sizeof(compare_t));
+    dc  = fgen_decode_create();
+    if (!cmp || !dc)
+        FGEN_ERR_GOTO(err, "Unable to allocate the compare template\n");
+
+    memcpy(cmp->data, data, len);
+    cmp->len = len;
+
+    if (decode_headers(dc, cmp->data, len, FGEN_ETHER_TYPE) < 0 ||
+        decode_mask(dc, mask, cmp->bytes) < 0)
+        FGEN_ERR_GOTO(err, "Unable to decode the template frame\n");
+
+    cmp->nb_layers = dc->nb_layers;
+    memcpy(cmp->layers, dc->layers, dc->nb_layers * sizeof(decode_layer_t));
+    fgen_decode_destroy(dc);
+
+    return cmp;
+
+err:
+    fgen_decode_destroy(dc);
+    free(cmp);
+    return NULL;
+}
+
+int
+fgen_compare_ignore(fgen_compare_t *_cmp, uint16_t off, uint16_t len)
+{
+    compare_t *cmp = _cmp;
+
+    if (!cmp || (off + len) > cmp->len)
+        return -1;
+
+    memset(&cmp->bytes[off], 0, len);
+
+    return 0;
+}
+
+int
+fgen_compare(fgen_compare_t *_cmp, const void *data, uint16_t len, fgen_compare_result_t *res)
+{
+    compare_t *cmp = _cmp;
+    fgen_compare_result_t r;
+    int n, offset;
+
+    if (!cmp || !data)
+        return -1;
+
+    n      = (len < cmp->len) ? len : cmp->len;
+    offset = fgen_mask_cmp(data, cmp->data, cmp->bytes, n);
+
+    /* A frame with a different length differs at the end of the shorter frame */
+    if (offset < 0 && len != cmp->len)
+        offset = n;
+    if (offset < 0)
+        return 0;
+
+    if (res) {
+        _compare_locate(cmp, offset, &r);
+        if (offset == n && len != cmp->len)
+            r.field = "len";
+        *res = r;
+    }
+
+    return 1;
+}
+
+void
+fgen_compare_destroy(fgen_compare_t *cmp)
+{
+    free(cmp);
+}
@@ -8,19 +8,109 @@
 #include <net/ethernet.h>
 #include <arpa/inet.h>
 #include <ctype.h>
+#include <errno.h>
+#include <unistd.h>
 
 #include <fgen_common.h>
 #include <fgen_log.h>
+#include <hexparse.h>
 #include <net/fgen_ether.h>
 #include <net/fgen_ip.h>
 #include <net/fgen_udp.h>
 #include <net/fgen_tcp.h>
 #include <net/fgen_vxlan.h>
+#include <net/fgen_gre.h>
+#include <net/fgen_gtp.h>
+#include <net/fgen_mpls.h>
 
 #include "fgen.h"
 #include "decode.h"
 
+#define DECODE_GTP_OPT_FLAGS 0x07 /**< GTP E, S and PN flags */
+#define DECODE_GTP_MSG_GPDU  0xFF /**< GTP G-PDU message type */
+#define DECODE_MPLS_UDP_PORT 6635 /**< MPLS in UDP destination port, RFC 7510 */
+
+typedef int (*decode_fn_t)(decode_t *dc);
+
+typedef struct decode_tbl_s {
+    uint16_t key;   /**< Ethertype, IP protocol or UDP port value */
+    decode_fn_t fn; /**< Decode function for the next header */
+} decode_tbl_t;
+
 static int _decode_vlan(decode_t *dc, bool is_dot1ad);
+static int _decode_dot1q(decode_t *dc);
+static int _decode_dot1ad(decode_t *dc);
+static int _decode_ether(decode_t *dc);
+static int _decode_ipv4(decode_t *dc);
+static int _decode_ipv6(decode_t *dc);
+static int _decode_ipip(decode_t *dc);
+static int _decode_ip6ip(decode_t *dc);
+static int _decode_udp(decode_t *dc);
+static int _decode_tcp(decode_t *dc);
+static int _decode_gre(decode_t *dc);
+static int _decode_vxlan(decode_t *dc);
+static int _decode_vxlan_gpe(decode_t *dc);
+static int _decode_gtpu(decode_t *dc);
+static int _decode_mpls(decode_t *dc);
+
+// clang-format off
+/* Next header after an Ethernet or VLAN header */
+static const decode_tbl_t ether_tbl[] = {
+    {FGEN_ETHER_TYPE_VLAN,  _decode_dot1q},
+    {FGEN_ETHER_TYPE_QINQ,  _decode_dot1ad},
+    {FGEN_ETHER_TYPE_IPV4,  _decode_ipv4},
+    {FGEN_ETHER_TYPE_IPV6,  _decode_ipv6},
+    {FGEN_ETHER_TYPE_MPLS,  _decode_mpls},
+    {FGEN_ETHER_TYPE_MPLSM, _decode_mpls},
+};
+
+/* Next header after an IPv4 or IPv6 header */
+static const decode_tbl_t ip_tbl[] = {
+    {IPPROTO_UDP,  _decode_udp},
+    {IPPROTO_TCP,  _decode_tcp},
+    {IPPROTO_GRE,  _decode_gre},
+    {IPPROTO_IPIP, _decode_ipip},
+    {IPPROTO_IPV6, _decode_ip6ip},
+};
+
+/* Tunnels carried in UDP by well known port */
+static const decode_tbl_t udp_tbl[] = {
+    {FGEN_VXLAN_DEFAULT_PORT,     _decode_vxlan},
+    {FGEN_VXLAN_GPE_DEFAULT_PORT, _decode_vxlan_gpe},
+    {FGEN_GTPU_UDP_PORT,          _decode_gtpu},
+    {DECODE_MPLS_UDP_PORT,        _decode_mpls},
+};
+
+/* Inner header after a GRE header */
+static const decode_tbl_t gre_tbl[] = {
+    {FGEN_ETHER_TYPE_TEB,   _decode_ether},
+    {FGEN_ETHER_TYPE_IPV4,  _decode_ipv4},
+    {FGEN_ETHER_TYPE_IPV6,  _decode_ipv6},
+    {FGEN_ETHER_TYPE_MPLS,  _decode_mpls},
+};
+// clang-format on
+
+static inline bool
+_decode_have(decode_t *dc, int len)
+{
+    return (decode_offset(dc) + len) <= decode_len(dc);
+}
+
+/* Record a header at the current offset for the emitters */
+static inline void
+_decode_layer(decode_t *dc, uint8_t type, uint16_t len)
+{
+    decode_layer_t *l;
+
+    if (dc->nb_layers >= DECODE_MAX_LAYERS)
+        return;
+
+    l        = &dc->layers[dc->nb_layers++];
+    l->type  = type;
+    l->level = dc->level;
+    l->off   = decode_offset(dc);
+    l->len   = len;
+}
 
 static __attribute__((__format__(__printf__, 2, 0))) int
 _append(decode_t *dc, const char *format, ...)
@@ -29,6 +119,9 @@ _append(decode_t *dc, const char *format, ...)
     char str[FGEN_MAX_STRING_LENGTH] = {0};
     int ret, nbytes;
 
+    if (dc->quiet)
+        return 0;
+
     va_start(ap, format);
     ret = vsnprintf(str, sizeof(str) - 1, format, ap);
     va_end(ap);
@@ -73,6 +166,9 @@ _append(decode_t *dc, const char *format, ...)
 static int
 _decode_raw(decode_t *dc)
 {
+    if (dc->quiet)
+        decode_offset(dc) = decode_len(dc);
+
     if (decode_len(dc) > decode_offset(dc)) {
         uint8_t *p = decode_mtod_offset(dc, uint8_t *, decode_offset(dc));
         int len    = decode_len(dc) - decode_offset(dc);
@@ -91,9 +187,25 @@ _decode_raw(decode_t *dc)
     return 0;
 }
 
+/* Append an address, skipped when only walking the headers */
+static void
+_decode_addr(decode_t *dc, int af, const void *addr, const char *key)
+{
+    char buf[INET6_ADDRSTRLEN];
+
+    if (dc->quiet)
+        return;
+
+    inet_ntop(af, addr, buf, sizeof(buf));
+    _append(dc, "%s%s", key, buf);
+}
+
 static int
 _decode_payload(decode_t *dc)
 {
+    if (decode_len(dc) > decode_offset(dc))
+        _decode_layer(dc, DECODE_PAYLOAD, decode_len(dc) - decode_offset(dc));
+
     _decode_raw(dc);
     _append(dc, FGEN_PAYLOAD_STR "(len=%d", decode_len(dc) + ETHER_CRC_LEN);
     _append(dc, ")");
@@ -101,48 +213,124 @@ _decode_payload(decode_t *dc)
     return 0;
 }
 
+/* A Seq() layer is found by its marker before or after the TSC() layer */
+static void
+_decode_seq(decode_t *dc)
+{
+    seq_t *seq;
+
+    seq = decode_mtod_offset(dc, seq_t *, decode_offset(dc));
+
+    if (_decode_have(dc, sizeof(seq_t)) && seq->seqid == SEQUENCE_ID) {
+        _append(dc, FGEN_SEQ_STR "(");
+        _append(dc, "stream=%u,seq=%lu", seq->stream, seq->seq);
+        _append(dc, ")/");
+        _decode_layer(dc, DECODE_SEQ, sizeof(seq_t));
+        decode_offset(dc) += sizeof(seq_t);
+    }
+}
+
 static int
 _decode_tsc(decode_t *dc)
 {
     tsc_t *tsc;
 
+    _decode_seq(dc);
+
     tsc = decode_mtod_offset(dc, tsc_t *, decode_offset(dc));
 
-    if (tsc->tstmp == TIMESTAMP_ID) {
+    if (_decode_have(dc, sizeof(tsc_t)) && tsc->tstmp == TIMESTAMP_ID) {
         _append(dc, FGEN_TSC_STR "(");
         _append(dc, "0x%016lx", tsc->tsc_val);
         _append(dc, ")/");
+        _decode_layer(dc, DECODE_TSC, sizeof(tsc_t));
         decode_offset(dc) += sizeof(tsc_t);
+
+        _decode_seq(dc);
     }
 
     return _decode_payload(dc);
 }
 
+/* Return the decode function of key in the table, NULL if the key is not in it */
+static decode_fn_t
+_decode_find(const decode_tbl_t *tbl, int cnt, uint16_t key)
+{
+    for (int i = 0; i < cnt; i++) {
+        if (tbl[i].key == key)
+            return tbl[i].fn;
+    }
+    return NULL;
+}
+
+/* Call the decode function for the key in the table or decode the rest as payload */
+static int
+_decode_next(decode_t *dc, const decode_tbl_t *tbl, int cnt, uint16_t key)
+{
+    decode_fn_t fn = _decode_find(tbl, cnt, key);
+
+    return fn ? fn(dc) : _decode_payload(dc);
+}
+
+/* Start the next encapsulation level for the header at the current offset */
+static int
+_decode_inner(decode_t *dc, decode_fn_t fn)
+{
+    if ((dc->level + 1) >= dc->max_depth)
+        return _decode_payload(dc);
+
+    dc->level++;
+    return fn(dc);
+}
+
 static int
 _decode_udp(decode_t *dc)
 {
     struct fgen_udp_hdr *udp;
+    uint16_t dport, sport;
+    decode_fn_t fn;
+
+    if (!_decode_have(dc, sizeof(struct fgen_udp_hdr)))
+        return _decode_payload(dc);
 
     udp = decode_mtod_offset(dc, struct fgen_udp_hdr *, decode_offset(dc));
+    dc->offs[dc->level].l4 = decode_offset(dc);
+    _decode_layer(dc, DECODE_UDP, sizeof(struct fgen_udp_hdr));
     decode_offset(dc) += sizeof(struct fgen_udp_hdr);
 
+    dport = ntohs(udp->dst_port);
+    sport = ntohs(udp->src_port);
+
     _append(dc, FGEN_UDP_STR "(");
-    _append(dc, "dport=%u,sport=%u,len=%u,cksum=0x%x", ntohs(udp->dst_port), ntohs(udp->src_port),
-            ntohs(udp->dgram_len), udp->dgram_cksum);
+    _append(dc, "dport=%u,sport=%u,len=%u,cksum=0x%x", dport, sport, ntohs(udp->dgram_len),
+            udp->dgram_cksum);
     _append(dc, ")/");
 
-    return _decode_tsc(dc);
+    /* Tunnels are found by the well known destination port, then the source port */
+    fn = _decode_find(udp_tbl, fgen_countof(udp_tbl), dport);
+    if (!fn)
+        fn = _decode_find(udp_tbl, fgen_countof(udp_tbl), sport);
+
+    return fn ? fn(dc) : _decode_tsc(dc);
 }
 
 static int
 _decode_tcp(decode_t *dc)
 {
     struct fgen_tcp_hdr *tcp;
+    int hlen;
 
-    tcp = decode_mtod_offset(dc, struct fgen_tcp_hdr *, decode_offset(dc));
-    decode_offset(dc) += sizeof(struct fgen_tcp_hdr);
+    if (!_decode_have(dc, sizeof(struct fgen_tcp_hdr)))
+        return _decode_payload(dc);
+
+    tcp  = decode_mtod_offset(dc, struct fgen_tcp_hdr *, decode_offset(dc));
+    hlen = (tcp->data_off >> 4) * 4;
+    if (hlen < (int)sizeof(struct fgen_tcp_hdr) || !_decode_have(dc, hlen))
+        hlen = sizeof(struct fgen_tcp_hdr);
 
-    (void)tcp;
+    dc->offs[dc->level].l4 = decode_offset(dc);
+    _decode_layer(dc, DECODE_TCP, hlen);
+    decode_offset(dc) += hlen;
 
     _append(dc, FGEN_TCP_STR "(");
     _append(dc, "sport=%d", ntohs(tcp->src_port));
@@ -153,61 +341,82 @@ _decode_tcp(decode_t *dc)
     _append(dc, ",flags=%#x", tcp->tcp_flags);
     _append(dc, ",win=%#x", ntohs(tcp->rx_win));
     _append(dc, ",cksum=%#x", ntohs(tcp->cksum));
-    _append(dc, ",urp=%%x", ntohs(tcp->tcp_urp));
+    _append(dc, ",urp=%#x", ntohs(tcp->tcp_urp));
     _append(dc, ")/");
 
     return _decode_tsc(dc);
 }
 
+static int
+_decode_ip_proto(decode_t *dc, uint8_t proto)
+{
+    switch (proto) {
+    case IPPROTO_UDP:
+        _append(dc, ",proto=udp)/");
+        break;
+    case IPPROTO_TCP:
+        _append(dc, ",proto=tcp)/");
+        break;
+    default:
+        _append(dc, ",proto=%d)/", proto);
+        break;
+    }
+
+    return _decode_next(dc, ip_tbl, fgen_countof(ip_tbl), proto);
+}
+
 static int
 _decode_ipv4(decode_t *dc)
 {
     struct fgen_ipv4_hdr *ip;
-    char buf[64];
+    int hlen;
 
-    ip = decode_mtod_offset(dc, struct fgen_ipv4_hdr *, decode_offset(dc));
+    if (!_decode_have(dc, sizeof(struct fgen_ipv4_hdr)))
+        return _decode_payload(dc);
 
-    decode_offset(dc) += sizeof(struct fgen_ipv4_hdr);
+    ip   = decode_mtod_offset(dc, struct fgen_ipv4_hdr *, decode_offset(dc));
+    hlen = (ip->version_ihl & 0xF) * 4;
+    if (hlen < (int)sizeof(struct fgen_ipv4_hdr) || !_decode_have(dc, hlen))
+        hlen = sizeof(struct fgen_ipv4_hdr);
+
+    dc->offs[dc->level].l3 = decode_offset(dc);
+    _decode_layer(dc, DECODE_IPV4, hlen);
+    decode_offset(dc) += hlen;
 
     _append(dc, FGEN_IPv4_STR "(");
 
     _append(dc, "version_ihl=%#x", ip->version_ihl);
     _append(dc, ",tos=%#x", ip->type_of_service);
     _append(dc, ",len=%d", ntohs(ip->total_length));
-    _append(dc, ",id=%#x", ntohs(ip->total_length));
+    _append(dc, ",id=%#x", ntohs(ip->packet_id));
     _append(dc, ",fragoff=%d", ntohs(ip->fragment_offset));
-    _append(dc, ",ttl=%d", ntohs(ip->time_to_live));
+    _append(dc, ",ttl=%d", ip->time_to_live);
     _append(dc, ",cksum=%d", ntohs(ip->hdr_checksum));
 
-    inet_ntop(AF_INET, &ip->dst_addr, buf, sizeof(buf));
-    _append(dc, "dst=%s", buf);
-
-    inet_ntop(AF_INET, &ip->src_addr, buf, sizeof(buf));
-    _append(dc, ",src=%s", buf);
+    _decode_addr(dc, AF_INET, &ip->dst_addr, ",dst=");
+    _decode_addr(dc, AF_INET, &ip->src_addr, ",src=");
 
-    switch (ip->next_proto_id) {
-    case IPPROTO_UDP:
-        _append(dc, ",proto=udp)/");
-        return _decode_udp(dc);
-    case IPPROTO_TCP:
-        _append(dc, ",proto=tcp)/");
-        return _decode_tcp(dc);
-    default:
+    /* Only the first fragment has the next header */
+    if (ntohs(ip->fragment_offset) & FGEN_IPV4_HDR_OFFSET_MASK) {
         _append(dc, ",proto=%d)/", ip->next_proto_id);
-        break;
+        return _decode_payload(dc);
     }
 
-    return _decode_tsc(dc);
+    return _decode_ip_proto(dc, ip->next_proto_id);
 }
 
 static int
 _decode_ipv6(decode_t *dc)
 {
     struct fgen_ipv6_hdr *ip;
-    char buf[64];
+
+    if (!_decode_have(dc, sizeof(struct fgen_ipv6_hdr)))
+        return _decode_payload(dc);
 
     ip = decode_mtod_offset(dc, struct fgen_ipv6_hdr *, decode_offset(dc));
 
+    dc->offs[dc->level].l3 = decode_offset(dc);
+    _decode_layer(dc, DECODE_IPV6, sizeof(struct fgen_ipv6_hdr));
     decode_offset(dc) += sizeof(struct fgen_ipv6_hdr);
 
     _append(dc, FGEN_IPv6_STR "(");
@@ -216,25 +425,199 @@ _decode_ipv6(decode_t *dc)
     _append(dc, ",len=%#x", ntohs(ip->payload_len));
     _append(dc, ",hops=%d", ip->hop_limits);
 
-    inet_ntop(AF_INET6, &ip->dst_addr, buf, sizeof(buf));
-    _append(dc, "dst=%s", buf);
+    _decode_addr(dc, AF_INET6, &ip->dst_addr, ",dst=");
+    _decode_addr(dc, AF_INET6, &ip->src_addr, ",src=");
 
-    inet_ntop(AF_INET6, &ip->src_addr, buf, sizeof(buf));
-    _append(dc, ",src=%s", buf);
+    return _decode_ip_proto(dc, ip->proto);
+}
 
-    switch (ip->proto) {
-    case IPPROTO_UDP:
-        _append(dc, ",proto=udp)/");
-        return _decode_udp(dc);
-    case IPPROTO_TCP:
-        _append(dc, ",proto=tcp)/");
-        return _decode_tcp(dc);
+static int
+_decode_ipip(decode_t *dc)
+{
+    dc->offs[dc->level].tunnel = decode_offset(dc);
+    return _decode_inner(dc, _decode_ipv4);
+}
+
+static int
+_decode_ip6ip(decode_t *dc)
+{
+    dc->offs[dc->level].tunnel = decode_offset(dc);
+    return _decode_inner(dc, _decode_ipv6);
+}
+
+/* Find the inner IP version from the first nibble, used by tunnels without a next protocol */
+static int
+_decode_ip_version(decode_t *dc)
+{
+    uint8_t *p = decode_mtod_offset(dc, uint8_t *, decode_offset(dc));
+
+    if (!_decode_have(dc, 1))
+        return _decode_payload(dc);
+
+    switch (*p >> 4) {
+    case 4:
+        return _decode_inner(dc, _decode_ipv4);
+    case 6:
+        return _decode_inner(dc, _decode_ipv6);
     default:
-        _append(dc, ",proto=%d)/", ip->proto);
-        break;
+        return _decode_payload(dc);
     }
+}
 
-    return _decode_tsc(dc);
+static int
+_decode_vxlan(decode_t *dc)
+{
+    struct fgen_vxlan_hdr *vx;
+
+    if (!_decode_have(dc, sizeof(struct fgen_vxlan_hdr)))
+        return _decode_payload(dc);
+
+    vx = decode_mtod_offset(dc, struct fgen_vxlan_hdr *, decode_offset(dc));
+
+    dc->offs[dc->level].tunnel = decode_offset(dc);
+    _decode_layer(dc, DECODE_VXLAN, sizeof(struct fgen_vxlan_hdr));
+    decode_offset(dc) += sizeof(struct fgen_vxlan_hdr);
+
+    _append(dc, FGEN_VxLAN_STR "(flags=%#x,vni=%u)/", ntohl(vx->vx_flags) >> 24,
+            ntohl(vx->vx_vni) >> 8);
+
+    return _decode_inner(dc, _decode_ether);
+}
+
+static int
+_decode_vxlan_gpe(decode_t *dc)
+{
+    struct fgen_vxlan_gpe_hdr *vx;
+
+    if (!_decode_have(dc, sizeof(struct fgen_vxlan_gpe_hdr)))
+        return _decode_payload(dc);
+
+    vx = decode_mtod_offset(dc, struct fgen_vxlan_gpe_hdr *, decode_offset(dc));
+
+    dc->offs[dc->level].tunnel = decode_offset(dc);
+    _decode_layer(dc, DECODE_VXLAN_GPE, sizeof(struct fgen_vxlan_gpe_hdr));
+    decode_offset(dc) += sizeof(struct fgen_vxlan_gpe_hdr);
+
+    _append(dc, DECODE_VXLAN_GPE_STR "(flags=%#x,proto=%u,vni=%u)/", vx->vx_flags, vx->proto,
+            ntohl(vx->vx_vni) >> 8);
+
+    switch (vx->proto) {
+    case FGEN_VXLAN_GPE_TYPE_ETH:
+        return _decode_inner(dc, _decode_ether);
+    case FGEN_VXLAN_GPE_TYPE_IPV4:
+        return _decode_inner(dc, _decode_ipv4);
+    case FGEN_VXLAN_GPE_TYPE_IPV6:
+        return _decode_inner(dc, _decode_ipv6);
+    case FGEN_VXLAN_GPE_TYPE_MPLS:
+        return _decode_inner(dc, _decode_mpls);
+    default:
+        return _decode_payload(dc);
+    }
+}
+
+static int
+_decode_gre(decode_t *dc)
+{
+    struct fgen_gre_hdr *gre;
+    decode_fn_t fn;
+    uint32_t *opt;
+    int hlen;
+
+    if (!_decode_have(dc, sizeof(struct fgen_gre_hdr)))
+        return _decode_payload(dc);
+
+    gre = decode_mtod_offset(dc, struct fgen_gre_hdr *, decode_offset(dc));
+    opt = (uint32_t *)(gre + 1);
+
+    /* Checksum, key and sequence number are each 4 bytes when present */
+    hlen = sizeof(struct fgen_gre_hdr) + ((gre->c + gre->k + gre->s) * 4);
+    if (!_decode_have(dc, hlen))
+        return _decode_payload(dc);
+
+    dc->offs[dc->level].tunnel = decode_offset(dc);
+    _decode_layer(dc, DECODE_GRE, hlen);
+    decode_offset(dc) += hlen;
+
+    _append(dc, DECODE_GRE_STR "(proto=%#06x", ntohs(gre->proto));
+    if (gre->c)
+        opt++;
+    if (gre->k)
+        _append(dc, ",key=%u", ntohl(*opt++));
+    if (gre->s)
+        _append(dc, ",seq=%u", ntohl(*opt));
+    _append(dc, ")/");
+
+    /* An unknown protocol is payload of this level, not an inner level */
+    fn = _decode_find(gre_tbl, fgen_countof(gre_tbl), ntohs(gre->proto));
+
+    return fn ? _decode_inner(dc, fn) : _decode_payload(dc);
+}
+
+static int
+_decode_gtpu(decode_t *dc)
+{
+    struct fgen_gtp_hdr *gtp;
+    uint8_t *p, next;
+    int hlen;
+
+    if (!_decode_have(dc, sizeof(struct fgen_gtp_hdr)))
+        return _decode_payload(dc);
+
+    gtp  = decode_mtod_offset(dc, struct fgen_gtp_hdr *, decode_offset(dc));
+    hlen = sizeof(struct fgen_gtp_hdr);
+
+    /* Any of the E, S or PN flags adds the sequence number, N-PDU and next extension type */
+    if (gtp->gtp_hdr_info & DECODE_GTP_OPT_FLAGS) {
+        if (!_decode_have(dc, hlen + 4))
+            return _decode_payload(dc);
+        p    = decode_mtod_offset(dc, uint8_t *, decode_offset(dc) + hlen);
+        next = p[3];
+        hlen += 4;
+
+        /* Extension headers are a length in 4 byte units with the next type in the last byte */
+        while (next) {
+            p = decode_mtod_offset(dc, uint8_t *, decode_offset(dc) + hlen);
+            if (!_decode_have(dc, hlen + 1) || p[0] == 0 || !_decode_have(dc, hlen + (p[0] * 4)))
+                return _decode_payload(dc);
+            hlen += p[0] * 4;
+            next = p[(p[0] * 4) - 1];
+        }
+    }
+
+    dc->offs[dc->level].tunnel = decode_offset(dc);
+    _decode_layer(dc, DECODE_GTPU, hlen);
+    decode_offset(dc) += hlen;
+
+    _append(dc, DECODE_GTPU_STR "(type=%#x,teid=%u)/", gtp->msg_type, ntohl(gtp->teid));
+
+    /* Only a G-PDU message carries a user frame */
+    if (gtp->msg_type != DECODE_GTP_MSG_GPDU)
+        return _decode_payload(dc);
+
+    return _decode_ip_version(dc);
+}
+
+static int
+_decode_mpls(decode_t *dc)
+{
+    uint32_t lse;
+
+    dc->offs[dc->level].tunnel = decode_offset(dc);
+
+    /* Walk the label stack to the bottom of stack entry */
+    do {
+        if (!_decode_have(dc, sizeof(struct fgen_mpls_hdr)))
+            return _decode_payload(dc);
+
+        lse = ntohl(*decode_mtod_offset(dc, uint32_t *, decode_offset(dc)));
+        _decode_layer(dc, DECODE_MPLS, sizeof(struct fgen_mpls_hdr));
+        decode_offset(dc) += sizeof(struct fgen_mpls_hdr);
+
+        _append(dc, DECODE_MPLS_STR "(label=%u,tc=%u,s=%u,ttl=%u)/", lse >> 12, (lse >> 9) & 7,
+                (lse >> 8) & 1, lse & 0xFF);
+    } while (!(lse & (1 << 8)));
+
+    return _decode_ip_version(dc);
 }
 
 static int
@@ -253,9 +636,13 @@ static int
 _decode_vlan(decode_t *dc, bool is_dot1ad)
 {
     struct fgen_vlan_hdr *vlan;
-    uint16_t vid, prio, cfi, tci, proto;
+    uint16_t vid, prio, cfi, tci;
+
+    if (!_decode_have(dc, sizeof(struct fgen_vlan_hdr)))
+        return _decode_payload(dc);
 
     vlan = decode_mtod_offset(dc, struct fgen_vlan_hdr *, decode_offset(dc));
+    _decode_layer(dc, is_dot1ad ? DECODE_DOT1AD : DECODE_DOT1Q, sizeof(struct fgen_vlan_hdr));
     decode_offset(dc) += sizeof(struct fgen_vlan_hdr);
 
     tci  = ntohs(vlan->vlan_tci);
@@ -263,21 +650,11 @@ _decode_vlan(decode_t *dc, bool is_dot1ad)
     prio = (tci >> 13) & 7;
     cfi  = (tci >> 12) & 1;
 
-    _append(dc, "Dot1%s(", is_dot1ad ? "AD" : "Q");
-    _append(dc, "vid=%u,prio=%u,cfi=%u", vid, prio, cfi);
+    _append(dc, "%s(", is_dot1ad ? FGEN_DOT1AD_STR : FGEN_DOT1Q_STR);
+    _append(dc, "vlan=%u,prio=%u,cfi=%u", vid, prio, cfi);
     _append(dc, ")/");
 
-    proto = ntohs(vlan->eth_proto);
-    if (is_dot1ad && proto == FGEN_ETHER_TYPE_VLAN)
-        return _decode_dot1q(dc);
-    else if (proto == FGEN_ETHER_TYPE_QINQ)
-        return _decode_dot1ad(dc);
-    else if (proto == FGEN_ETHER_TYPE_IPV4)
-        return _decode_ipv4(dc);
-    else if (proto == FGEN_ETHER_TYPE_IPV6)
-        return _decode_ipv6(dc);
-
-    return -1;
+    return _decode_next(dc, ether_tbl, fgen_countof(ether_tbl), ntohs(vlan->eth_proto));
 }
 
 static int
@@ -286,7 +663,10 @@ _decode_ether(decode_t *dc)
     struct ether_header *eth;
     struct ether_addr *addr;
 
-    eth = decode_mtod(dc, struct ether_header *);
+    if (!_decode_have(dc, sizeof(struct ether_header)))
+        return _decode_payload(dc);
+
+    eth = decode_mtod_offset(dc, struct ether_header *, decode_offset(dc));
 
     _append(dc, "Ether(");
     addr = (struct ether_addr *)&eth->ether_dhost;
@@ -299,45 +679,376 @@ _decode_ether(decode_t *dc)
             addr->ether_addr_octet[4], addr->ether_addr_octet[5]);
     _append(dc, ")/");
 
+    dc->offs[dc->level].l2 = decode_offset(dc);
+    _decode_layer(dc, DECODE_ETHER, sizeof(struct ether_header));
     decode_offset(dc) += sizeof(struct ether_header);
 
-    switch (ntohs(eth->ether_type)) {
+    return _decode_next(dc, ether_tbl, fgen_countof(ether_tbl), ntohs(eth->ether_type));
+}
+
+/*
+ * Round-trip decode mode
+ *
+ * The text produced here is accepted by fgen_add_frame() and encodes back to the same bytes.
+ * Only fields the encoder can set are emitted, lengths and checksums are left for the encoder
+ * to regenerate. A layer the encoder cannot reproduce exactly is removed from the text again
+ * and the remaining bytes are emitted as a Raw(hex=...) layer.
+ */
+enum { RT_DONE = 0, RT_UNREPRESENTABLE = 1 };
+
+#define RT_MIN_FILL_RUN 16 /**< Shortest run of one byte value emitted as a Payload layer */
+
+static inline int
+_rt_left(decode_t *dc)
+{
+    return decode_len(dc) - decode_offset(dc);
+}
+
+static inline void
+_rt_truncate(decode_t *dc, int mark)
+{
+    if (dc->buffer) {
+        dc->buffer[mark] = '\0';
+        dc->used         = mark;
+    }
+}
+
+/* Emit the rest of the frame as Raw(hex=...) followed by a Payload layer for a trailing fill run */
+static int
+_rt_tail(decode_t *dc)
+{
+    static const char hex[] = "0123456789abcdef";
+    char str[(ETH_FRAME_LEN * 2) + 1];
+    uint8_t *p = decode_mtod_offset(dc, uint8_t *, decode_offset(dc));
+    int len    = _rt_left(dc);
+    int run    = 0;
+
+    if (len <= 0)
+        return 0;
+
+    /* Length of the run of the last byte value at the end of the frame */
+    while (run < len && p[len - run - 1] == p[len - 1])
+        run++;
+
+    /* The Payload layer can only set the frame size to ETHER_MIN_LEN or larger */
+    if (run < RT_MIN_FILL_RUN || (decode_len(dc) + ETHER_CRC_LEN) < ETHER_MIN_LEN)
+        run = 0;
+
+    if (len > run) {
+        int n = len - run;
+
+        for (int i = 0; i < n; i++) {
+            str[i * 2]       = hex[p[i] >> 4];
+            str[(i * 2) + 1] = hex[p[i] & 0xF];
+        }
+        str[n * 2] = '\0';
+        if (_append(dc, FGEN_RAW_STR "(hex=%s)/", str) < 0)
+            return -1;
+    }
+
+    if (run && _append(dc, FGEN_PAYLOAD_STR "(size=%d,fill=%#x)/", decode_len(dc) + ETHER_CRC_LEN,
+                       p[len - 1]) < 0)
+        return -1;
+
+    decode_offset(dc) += len;
+
+    return 0;
+}
+
+static int
+_rt_udp(decode_t *dc, struct fgen_ipv4_hdr *ip4, struct fgen_ipv6_hdr *ip6)
+{
+    struct fgen_udp_hdr *udp;
+    uint32_t sum;
+
+    if (_rt_left(dc) < (int)sizeof(struct fgen_udp_hdr))
+        return RT_UNREPRESENTABLE;
+
+    udp = decode_mtod_offset(dc, struct fgen_udp_hdr *, decode_offset(dc));
+
+    /* The encoder always fills in the length and a checksum */
+    if (ntohs(udp->dgram_len) != _rt_left(dc) || udp->dgram_cksum == 0)
+        return RT_UNREPRESENTABLE;
+    if (ip4) {
+        if (fgen_ipv4_udptcp_cksum_verify(ip4, udp))
+            return RT_UNREPRESENTABLE;
+    } else {
+        sum = fgen_raw_cksum(udp, _rt_left(dc)) + fgen_ipv6_phdr_cksum(ip6, 0);
+        if (__fgen_raw_cksum_reduce(sum) != 0xffff)
+            return RT_UNREPRESENTABLE;
+    }
+
+    if (_append(dc, FGEN_UDP_STR "(dport=%u,sport=%u)/", ntohs(udp->dst_port),
+                ntohs(udp->src_port)) < 0)
+        return -1;
+    decode_offset(dc) += sizeof(struct fgen_udp_hdr);
+
+    return _rt_tail(dc);
+}
+
+static int
+_rt_tcp(decode_t *dc, struct fgen_ipv4_hdr *ip4, struct fgen_ipv6_hdr *ip6)
+{
+    struct fgen_tcp_hdr *tcp;
+    uint32_t sum;
+    int off;
+
+    if (_rt_left(dc) < (int)sizeof(struct fgen_tcp_hdr))
+        return RT_UNREPRESENTABLE;
+
+    tcp = decode_mtod_offset(dc, struct fgen_tcp_hdr *, decode_offset(dc));
+    off = tcp->data_off >> 4;
+
+    /* Options are kept as Raw data after the header, the reserved bits must be clear */
+    if (off < 5 || (off * 4) > _rt_left(dc) || (tcp->data_off & 0x0F))
+        return RT_UNREPRESENTABLE;
+    if (ip4) {
+        if (fgen_ipv4_udptcp_cksum_verify(ip4, tcp))
+            return RT_UNREPRESENTABLE;
+    } else {
+        sum = fgen_raw_cksum(tcp, _rt_left(dc)) + fgen_ipv6_phdr_cksum(ip6, 0);
+        if (__fgen_raw_cksum_reduce(sum) != 0xffff)
+            return RT_UNREPRESENTABLE;
+    }
+
+    if (_append(dc, FGEN_TCP_STR "(dport=%u,sport=%u,seq=%u,ack=%u,flags=%#x,win=%u,urp=%u",
+                ntohs(tcp->dst_port), ntohs(tcp->src_port), ntohl(tcp->sent_seq),
+                ntohl(tcp->recv_ack), tcp->tcp_flags, ntohs(tcp->rx_win),
+                ntohs(tcp->tcp_urp)) < 0)
+        return -1;
+    if (off != 5 && _append(dc, ",off=%d", off) < 0)
+        return -1;
+    if (_append(dc, ")/") < 0)
+        return -1;
+    decode_offset(dc) += sizeof(struct fgen_tcp_hdr);
+
+    return _rt_tail(dc);
+}
+
+/* Decode the L4 layer, or fall back to an explicit protocol number and Raw data */
+static int
+_rt_l4(decode_t *dc, uint8_t proto, struct fgen_ipv4_hdr *ip4, struct fgen_ipv6_hdr *ip6)
+{
+    int mark = dc->used, off = decode_offset(dc);
+    int ret  = RT_UNREPRESENTABLE;
+
+    if (proto == IPPROTO_UDP || proto == IPPROTO_TCP) {
+        if (_append(dc, ")/") < 0)
+            return -1;
+        ret = (proto == IPPROTO_UDP) ? _rt_udp(dc, ip4, ip6) : _rt_tcp(dc, ip4, ip6);
+        if (ret != RT_UNREPRESENTABLE)
+            return ret;
+        _rt_truncate(dc, mark);
+        decode_offset(dc) = off;
+    }
+
+    if (_append(dc, ",proto=%u)/", proto) < 0)
+        return -1;
+
+    return _rt_tail(dc);
+}
+
+static int
+_rt_ipv4(decode_t *dc)
+{
+    struct fgen_ipv4_hdr *ip;
+    char dst[INET_ADDRSTRLEN], src[INET_ADDRSTRLEN];
+    uint16_t frag;
+
+    if (_rt_left(dc) < (int)sizeof(struct fgen_ipv4_hdr))
+        return RT_UNREPRESENTABLE;
+
+    ip = decode_mtod_offset(dc, struct fgen_ipv4_hdr *, decode_offset(dc));
+
+    /* The encoder has no IP options and the total length always covers the rest of the frame */
+    if (ip->version_ihl != ((IPVERSION << 4) | (sizeof(struct fgen_ipv4_hdr) / 4)))
+        return RT_UNREPRESENTABLE;
+    if (ntohs(ip->total_length) != _rt_left(dc))
+        return RT_UNREPRESENTABLE;
+    if (fgen_raw_cksum(ip, sizeof(struct fgen_ipv4_hdr)) != 0xffff)
+        return RT_UNREPRESENTABLE;
+
+    inet_ntop(AF_INET, &ip->dst_addr, dst, sizeof(dst));
+    inet_ntop(AF_INET, &ip->src_addr, src, sizeof(src));
+    frag = ntohs(ip->fragment_offset);
+
+    if (_append(dc, FGEN_IPv4_STR "(dst=%s,src=%s,tos=%#x,id=%u,ttl=%u,frag=%#x", dst, src,
+                ip->type_of_service, ntohs(ip->packet_id), ip->time_to_live, frag) < 0)
+        return -1;
+    decode_offset(dc) += sizeof(struct fgen_ipv4_hdr);
+
+    /* A fragment only carries the L4 header in the first fragment, keep the data as is */
+    if (frag & (FGEN_IPV4_HDR_MF_FLAG | FGEN_IPV4_HDR_OFFSET_MASK)) {
+        if (_append(dc, ",proto=%u)/", ip->next_proto_id) < 0)
+            return -1;
+        return _rt_tail(dc);
+    }
+
+    return _rt_l4(dc, ip->next_proto_id, ip, NULL);
+}
+
+static int
+_rt_ipv6(decode_t *dc)
+{
+    struct fgen_ipv6_hdr *ip;
+    char dst[INET6_ADDRSTRLEN], src[INET6_ADDRSTRLEN];
+    uint32_t vtc;
+
+    if (_rt_left(dc) < (int)sizeof(struct fgen_ipv6_hdr))
+        return RT_UNREPRESENTABLE;
+
+    ip  = decode_mtod_offset(dc, struct fgen_ipv6_hdr *, decode_offset(dc));
+    vtc = ntohl(ip->vtc_flow);
+
+    if ((vtc >> 28) != 6)
+        return RT_UNREPRESENTABLE;
+    if (ntohs(ip->payload_len) != (_rt_left(dc) - (int)sizeof(struct fgen_ipv6_hdr)))
+        return RT_UNREPRESENTABLE;
+
+    inet_ntop(AF_INET6, ip->dst_addr, dst, sizeof(dst));
+    inet_ntop(AF_INET6, ip->src_addr, src, sizeof(src));
+
+    if (_append(dc, FGEN_IPv6_STR "(dst=%s,src=%s,hops=%u,tc=%#x,flow=%#x", dst, src,
+                ip->hop_limits, (vtc & FGEN_IPV6_HDR_TC_MASK) >> FGEN_IPV6_HDR_TC_SHIFT,
+                vtc & FGEN_IPV6_HDR_FL_MASK) < 0)
+        return -1;
+    decode_offset(dc) += sizeof(struct fgen_ipv6_hdr);
+
+    return _rt_l4(dc, ip->proto, NULL, ip);
+}
+
+static int
+_rt_vlan(decode_t *dc, bool is_dot1ad)
+{
+    struct fgen_vlan_hdr *vlan;
+    uint16_t tci;
+
+    if (_rt_left(dc) < (int)sizeof(struct fgen_vlan_hdr))
+        return RT_UNREPRESENTABLE;
+
+    vlan = decode_mtod_offset(dc, struct fgen_vlan_hdr *, decode_offset(dc));
+    tci  = ntohs(vlan->vlan_tci);
+
+    if (_append(dc, "%s(vlan=%u,prio=%u,cfi=%u)/", is_dot1ad ? FGEN_DOT1AD_STR : FGEN_DOT1Q_STR,
+                tci & 0xFFF, (tci >> 13) & 7, (tci >> 12) & 1) < 0)
+        return -1;
+    decode_offset(dc) += sizeof(struct fgen_vlan_hdr);
+
+    switch (ntohs(vlan->eth_proto)) {
     case FGEN_ETHER_TYPE_VLAN:
-        return _decode_dot1ad(dc);
+        /* The encoder only allows a Dot1q tag inside a Dot1ad tag */
+        return is_dot1ad ? _rt_vlan(dc, false) : RT_UNREPRESENTABLE;
     case FGEN_ETHER_TYPE_QINQ:
-        return _decode_dot1q(dc);
+        return _rt_vlan(dc, true);
     case FGEN_ETHER_TYPE_IPV4:
-        return _decode_ipv4(dc);
+        return _rt_ipv4(dc);
+    case FGEN_ETHER_TYPE_IPV6:
+        return _rt_ipv6(dc);
     default:
         break;
     }
-    return -1;
+    return RT_UNREPRESENTABLE;
 }
 
-fgen_decode_t *
-fgen_decode_create(void)
+static int
+_rt_ether(decode_t *dc)
 {
-    return (fgen_decode_t *)calloc(1, sizeof(decode_t));
+    struct ether_header *eth;
+    uint8_t *d, *s;
+    int mark, ret;
+
+    /* The FCS is appended again by an encoder created with FGEN_ADD_FCS */
+    if (dc->flags & FGEN_DECODE_FCS) {
+        if (decode_len(dc) < ETHER_CRC_LEN)
+            FGEN_ERR_RET("Frame length %d is shorter than the FCS\n", decode_len(dc));
+        decode_len(dc) -= ETHER_CRC_LEN;
+    }
+
+    /* The encoder pads short frames and rejects or truncates long ones */
+    if (decode_len(dc) < ETH_ZLEN || decode_len(dc) > ETH_FRAME_LEN)
+        FGEN_ERR_RET("Frame length %d not in range %d-%d without the FCS\n", decode_len(dc),
+                     ETH_ZLEN, ETH_FRAME_LEN);
+
+    eth = decode_mtod(dc, struct ether_header *);
+    d   = eth->ether_dhost;
+    s   = eth->ether_shost;
+
+    if (_append(dc, FGEN_ETHER_STR "(dst=%02x:%02x:%02x:%02x:%02x:%02x", d[0], d[1], d[2], d[3],
+                d[4], d[5]) < 0 ||
+        _append(dc, ",src=%02x:%02x:%02x:%02x:%02x:%02x", s[0], s[1], s[2], s[3], s[4], s[5]) < 0)
+        return -1;
+    mark = dc->used;
+
+    decode_offset(dc) += sizeof(struct ether_header);
+
+    if (_append(dc, ")/") < 0)
+        return -1;
+
+    switch (ntohs(eth->ether_type)) {
+    case FGEN_ETHER_TYPE_VLAN:
+        ret = _rt_vlan(dc, false);
+        break;
+    case FGEN_ETHER_TYPE_QINQ:
+        ret = _rt_vlan(dc, true);
+        break;
+    case FGEN_ETHER_TYPE_IPV4:
+        ret = _rt_ipv4(dc);
+        break;
+    case FGEN_ETHER_TYPE_IPV6:
+        ret = _rt_ipv6(dc);
+        break;
+    default:
+        ret = RT_UNREPRESENTABLE;
+        break;
+    }
+
+    if (ret == RT_UNREPRESENTABLE) {
+        _rt_truncate(dc, mark);
+        decode_offset(dc) = sizeof(struct ether_header);
+
+        if (_append(dc, ",type=%#06x)/", ntohs(eth->ether_type)) < 0)
+            return -1;
+        ret = _rt_tail(dc);
+    }
+    if (ret < 0)
+        return -1;
+
+    /* Remove the trailing layer separator */
+    if (dc->used > 0 && dc->buffer[dc->used - 1] == '/')
+        _rt_truncate(dc, dc->used - 1);
+
+    return 0;
 }
 
-int
-fgen_decode(fgen_decode_t *_dc, void *data, uint16_t len, opt_type_t opt)
+fgen_decode_t *
+fgen_decode_create(void)
 {
-    decode_t *dc = _dc;
-    int ret;
+    decode_t *dc;
 
-    if (!dc || !data || len == 0)
-        return -1;
+    dc = calloc(1, sizeof(decode_t));
+    if (dc) {
+        dc->max_depth = FGEN_DECODE_MAX_LEVELS;
+        dc->out.fd    = -1;
+    }
 
-    if (dc->buffer)
-        free(dc->buffer);
+    return (fgen_decode_t *)dc;
+}
 
-    dc->buffer   = NULL;
-    dc->buf_len  = 0;
-    dc->used     = 0;
+static void
+_decode_setup(decode_t *dc, void *data, uint16_t len)
+{
     dc->data_len = len;
     dc->data_off = 0;
     dc->data     = data;
+    dc->level     = 0;
+    dc->nb_layers = 0;
+    memset(dc->offs, 0xFF, sizeof(dc->offs));
+}
+
+static int
+_decode_start(decode_t *dc, opt_type_t opt)
+{
+    int ret;
 
     switch (opt) {
     default:
@@ -358,7 +1069,194 @@ fgen_decode(fgen_decode_t *_dc, void *data, uint16_t len, opt_type_t opt)
         break;
     }
 
-    return (ret >= 0) ? dc->buf_len : -1;
+    return ret;
+}
+
+int
+fgen_decode(fgen_decode_t *_dc, void *data, uint16_t len, opt_type_t opt)
+{
+    decode_t *dc = _dc;
+    int ret;
+
+    if (!dc || !data || len == 0)
+        return -1;
+
+    if (dc->buffer)
+        free(dc->buffer);
+
+    dc->buffer  = NULL;
+    dc->buf_len = 0;
+    dc->used    = 0;
+    _decode_setup(dc, data, len);
+
+    if (dc->flags & FGEN_DECODE_ROUNDTRIP) {
+        if (opt != FGEN_ETHER_TYPE)
+            FGEN_ERR_RET("Round-trip decode must start at the Ether layer\n");
+        ret = _rt_ether(dc);
+        return (ret >= 0) ? dc->used : -1;
+    }
+
+    ret = _decode_start(dc, opt);
+
+    return (ret >= 0) ? dc->used : -1;
+}
+
+const char *
+decode_layer_name(uint8_t type)
+{
+    // clang-format off
+    static const char *names[] = {
+        [DECODE_ETHER]     = FGEN_ETHER_STR,
+        [DECODE_DOT1Q]     = FGEN_DOT1Q_STR,
+        [DECODE_DOT1AD]    = FGEN_DOT1AD_STR,
+        [DECODE_IPV4]      = FGEN_IPv4_STR,
+        [DECODE_IPV6]      = FGEN_IPv6_STR,
+        [DECODE_UDP]       = FGEN_UDP_STR,
+        [DECODE_TCP]       = FGEN_TCP_STR,
+        [DECODE_VXLAN]     = FGEN_VxLAN_STR,
+        [DECODE_VXLAN_GPE] = DECODE_VXLAN_GPE_STR,
+        [DECODE_GRE]       = DECODE_GRE_STR,
+        [DECODE_GTPU]      = DECODE_GTPU_STR,
+        [DECODE_MPLS]      = DECODE_MPLS_STR,
+        [DECODE_TSC]       = FGEN_TSC_STR,
+        [DECODE_SEQ]       = FGEN_SEQ_STR,
+        [DECODE_PAYLOAD]   = FGEN_PAYLOAD_STR,
+    };
+    // clang-format on
+
+    return (type < fgen_countof(names) && names[type]) ? names[type] : "Unknown";
+}
+
+int
+decode_headers(decode_t *dc, void *data, uint16_t len, opt_type_t opt)
+{
+    int ret;
+
+    _decode_setup(dc, data, len);
+
+    dc->quiet = true;
+    ret       = _decode_start(dc, opt);
+    dc->quiet = false;
+
+    return ret;
+}
+
+int
+decode_out_open(decode_t *dc, int fd, uint32_t size)
+{
+    decode_out_t *out = &dc->out;
+    char *buf;
+
+    if (fd < 0)
+        FGEN_ERR_RET("Invalid output file descriptor %d\n", fd);
+    if (size == 0)
+        size = FGEN_DECODE_OUT_BUF_SIZE;
+
+    decode_out_close(dc);
+
+    buf = malloc(size);
+    if (!buf)
+        FGEN_ERR_RET("Unable to allocate output buffer of %u bytes\n", size);
+
+    out->fd   = fd;
+    out->size = size;
+    out->used = 0;
+    out->buf  = buf;
+
+    return 0;
+}
+
+int
+decode_out_flush(decode_out_t *out)
+{
+    uint32_t off = 0;
+    ssize_t n;
+
+    while (off < out->used) {
+        n = write(out->fd, &out->buf[off], out->used - off);
+        if (n < 0) {
+            if (errno == EINTR)
+                continue;
+            out->used = 0;
+            FGEN_ERR_RET("Output write failed: %s\n", strerror(errno));
+        }
+        off += n;
+    }
+    out->used = 0;
+
+    return 0;
+}
+
+void
+decode_out_close(decode_t *dc)
+{
+    if (dc->out.buf) {
+        decode_out_flush(&dc->out);
+        free(dc->out.buf);
+    }
+    memset(&dc->out, 0, sizeof(dc->out));
+    dc->out.fd = -1;
+}
+
+int
+fgen_decode_flush(fgen_decode_t *_dc)
+{
+    decode_t *dc = _dc;
+
+    if (!dc || !dc->out.buf)
+        return -1;
+
+    return decode_out_flush(&dc->out);
+}
+
+int
+fgen_decode_set_flags(fgen_decode_t *_dc, uint32_t flags)
+{
+    decode_t *dc = _dc;
+
+    if (!dc)
+        return -1;
+
+    dc->flags = flags;
+
+    return 0;
+}
+
+int
+fgen_decode_set_depth(fgen_decode_t *_dc, int depth)
+{
+    decode_t *dc = _dc;
+
+    if (!dc || depth < 1 || depth > FGEN_DECODE_MAX_LEVELS)
+        return -1;
+
+    dc->max_depth = depth;
+
+    return 0;
+}
+
+int
+fgen_decode_levels(fgen_decode_t *_dc)
+{
+    decode_t *dc = _dc;
+
+    if (!dc || !dc->data)
+        return -1;
+
+    return dc->level + 1;
+}
+
+int
+fgen_decode_offsets(fgen_decode_t *_dc, int level, fgen_decode_offsets_t *off)
+{
+    decode_t *dc = _dc;
+
+    if (!dc || !dc->data || !off || level < 0 || level > dc->level)
+        return -1;
+
+    *off = dc->offs[level];
+
+    return 0;
 }
 
 void
@@ -367,6 +1265,9 @@ fgen_decode_destroy(fgen_decode_t *_dc)
     decode_t *dc = _dc;
 
     if (dc) {
+        decode_out_close(dc);
+        decode_summary_free(dc);
+        decode_emit_free(dc);
         free(dc->buffer);
         free(dc);
     }
@@ -383,30 +1284,14 @@ fgen_decode_text(fgen_decode_t *_dc)
 int
 fgen_decode_string(const char *text, uint8_t *buffer, int len)
 {
-    int cnt = 0;
+    int cnt, pos = -1;
 
     if (!text || !buffer || !len)
         return -1;
 
-    while (*text) {
-        if (cnt >= len)
-            return -1;
-        if (isspace(*text)) {
-            text++;
-            continue;
-        }
-        if (isxdigit(text[0]) && isxdigit(text[1])) {
-            char hex[4] = {0};
-            long v      = 0;
-
-            hex[0] = text[0];
-            hex[1] = text[1];
-            v      = strtol(hex, NULL, 16);
-            if (errno == ERANGE)
-                return -1;
-            buffer[cnt++] = (uint8_t)v;
-        }
-    }
+    cnt = fgen_hex_parse(text, buffer, len, &pos);
+    if (cnt < 0)
+        FGEN_ERR_RET("Invalid hex data or buffer too short at offset %d\n", pos);
 
     return cnt;
 }
@@ -6,18 +6,55 @@
 #define __FGEN_DECODE_H
 
 #include <stdint.h>
+#include <stdbool.h>
+
+#include "fgen.h"
 
 #ifdef __cplusplus
 extern "C" {
 #endif
 
 #define FGEN_INVALID_PID 0xFFFF /**< Invalid PID */
-#define TIMESTAMP_ID     (('t' << 24) || ('s' << 16) || ('c' << 8) || '=')
 
-typedef struct tsc_s {
-    uint32_t tstmp;
-    uint64_t tsc_val;
-} tsc_t;
+#define DECODE_GRE_STR       "GRE"
+#define DECODE_GTPU_STR      "GTPU"
+#define DECODE_MPLS_STR      "MPLS"
+#define DECODE_VXLAN_GPE_STR "VxlanGPE"
+
+#define DECODE_MAX_LAYERS 32 /**< Max number of headers recorded for a frame */
+
+/* Header types recorded by the decoder */
+enum {
+    DECODE_ETHER,
+    DECODE_DOT1Q,
+    DECODE_DOT1AD,
+    DECODE_IPV4,
+    DECODE_IPV6,
+    DECODE_UDP,
+    DECODE_TCP,
+    DECODE_VXLAN,
+    DECODE_VXLAN_GPE,
+    DECODE_GRE,
+    DECODE_GTPU,
+    DECODE_MPLS,
+    DECODE_TSC,
+    DECODE_SEQ,
+    DECODE_PAYLOAD,
+};
+
+typedef struct decode_layer_s {
+    uint8_t type;  /**< DECODE_* header type */
+    uint8_t level; /**< Encapsulation level of the header */
+    uint16_t off;  /**< Offset of the header in the frame */
+    uint16_t len;  /**< Length of the header */
+} decode_layer_t;
+
+typedef struct decode_out_s {
+    int fd;        /**< File descriptor to write the output */
+    uint32_t size; /**< Size of the output buffer */
+    uint32_t used; /**< Number of bytes in the output buffer */
+    char *buf;     /**< Output buffer */
+} decode_out_t;
 
 typedef struct decode_s {
     void *data;        /**< Frame data */
@@ -26,7 +63,16 @@ typedef struct decode_s {
     char *buffer;      /**< Output buffers pointer */
     int buf_len;       /**< length of buffer data */
     int used;          /**< Amount of used data in buffer */
-
+    uint32_t flags;    /**< FGEN_DECODE_* flags */
+    int level;         /**< Current encapsulation level */
+    int max_depth;     /**< Max number of encapsulation levels to decode */
+    bool quiet;        /**< Only walk the headers, no text is created */
+    int nb_layers;     /**< Number of headers recorded */
+    decode_out_t out;  /**< Output buffer of the summary and emit modes */
+    struct decode_summary_s *sum;                       /**< Compiled summary line format */
+    struct decode_emit_s *emit;                         /**< JSON or CBOR emitter state */
+    fgen_decode_offsets_t offs[FGEN_DECODE_MAX_LEVELS]; /**< Header offsets of each level */
+    decode_layer_t layers[DECODE_MAX_LAYERS];           /**< Headers found in the frame */
 } decode_t;
 
 /**
@@ -75,6 +121,114 @@ typedef struct decode_s {
  */
 #define decode_mtod(f, t) decode_mtod_offset(f, t, 0)
 
+/**
+ * Walk the headers of a frame without creating the text, only the header offsets are found.
+ *
+ * @param dc
+ *   The decode_t structure pointer.
+ * @param data
+ *   The frame data pointer.
+ * @param len
+ *   The length of the frame data.
+ * @param opt
+ *   The starting protocol of the frame data.
+ * @return
+ *   -1 on error or 0 on success.
+ */
+int decode_headers(decode_t *dc, void *data, uint16_t len, opt_type_t opt);
+
+/**
+ * Return the name of a header type.
+ *
+ * @param type
+ *   The DECODE_* header type.
+ * @return
+ *   The name of the header or "Unknown".
+ */
+const char *decode_layer_name(uint8_t type);
+
+/**
+ * Build the byte mask of the frame walked by decode_headers(), 0xFF for the bytes to compare
+ * and 0x00 for the volatile fields to ignore.
+ *
+ * @param dc
+ *   The decode_t structure pointer.
+ * @param mask
+ *   The FGEN_FP_* fields to ignore.
+ * @param bytes
+ *   The byte mask, at least decode_len(dc) bytes.
+ * @return
+ *   -1 on error or 0 on success.
+ */
+int decode_mask(decode_t *dc, uint32_t mask, uint8_t *bytes);
+
+/**
+ * Free the summary format of a decoder.
+ *
+ * @param dc
+ *   The decode_t structure pointer.
+ */
+void decode_summary_free(decode_t *dc);
+
+/**
+ * Free the emitter state of a decoder.
+ *
+ * @param dc
+ *   The decode_t structure pointer.
+ */
+void decode_emit_free(decode_t *dc);
+
+/**
+ * Setup the output buffer used by the summary and emit modes, any old output is flushed.
+ *
+ * @param dc
+ *   The decode_t structure pointer.
+ * @param fd
+ *   The file descriptor to write the output.
+ * @param size
+ *   The size of the output buffer or zero for FGEN_DECODE_OUT_BUF_SIZE.
+ * @return
+ *   -1 on error or 0 on success.
+ */
+int decode_out_open(decode_t *dc, int fd, uint32_t size);
+
+/**
+ * Write the data in the output buffer to the file descriptor.
+ *
+ * @param out
+ *   The decode_out_t structure pointer.
+ * @return
+ *   -1 on error or 0 on success.
+ */
+int decode_out_flush(decode_out_t *out);
+
+/**
+ * Flush and free the output buffer.
+ *
+ * @param dc
+ *   The decode_t structure pointer.
+ */
+void decode_out_close(decode_t *dc);
+
+/**
+ * Return a pointer to space for len bytes in the output buffer, flushing the buffer if needed.
+ *
+ * @param out
+ *   The decode_out_t structure pointer.
+ * @param len
+ *   The number of bytes needed, must be less than the buffer size.
+ * @return
+ *   NULL on error or pointer to the space in the output buffer.
+ */
+static inline char *
+decode_out_reserve(decode_out_t *out, uint32_t len)
+{
+    if ((out->size - out->used) < len && decode_out_flush(out) < 0)
+        return NULL;
+
+    return &out->buf[out->used];
+}
+
 #ifdef __cplusplus
 }
 #endif
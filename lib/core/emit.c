@@ -0,0 +1,563 @@
+/* SPDX-License-Identifier: BSD-3-Clause
+ * Copyright(c) 2023-2025 Intel Corporation
+ */
+
+#include <stdint.h>        // for uint32_t, uint16_t, uint8_t, uint64_t
+#include <stdbool.h>
+#include <stdlib.h>        // for calloc, free
+#include <string.h>        // for memcpy, strlen
+#include <netinet/in.h>        // for ntohs, ntohl
+#include <net/ethernet.h>      // for ether_header
+#include <arpa/inet.h>         // for inet_ntop
+
+#include <fgen_common.h>
+#include <fgen_log.h>
+#include <net/fgen_ether.h>
+#include <net/fgen_ip.h>
+#include <net/fgen_udp.h>
+#include <net/fgen_tcp.h>
+#include <net/fgen_vxlan.h>
+#include <net/fgen_gre.h>
+#include <net/fgen_gtp.h>
+
+#include "fgen.h"
+#include "decode.h"
+
+/*
+ * JSON Lines and CBOR emitters. The headers recorded by the header walk are written field by
+ * field straight into the decoder output buffer, which is flushed whenever the next item does
+ * not fit, so a record is never built in memory. The layer code is shared and calls the format
+ * through a small table of functions.
+ */
+
+#define EMIT_MAX_DEPTH 4   /**< Max nesting of maps and arrays */
+#define EMIT_MAX_ITEM  128 /**< Max bytes written for one key and value */
+
+/* CBOR major types and simple values, RFC 8949 */
+#define CBOR_UINT        0
+#define CBOR_BYTES       2
+#define CBOR_TEXT        3
+#define CBOR_ARRAY_INDEF 0x9F
+#define CBOR_MAP_INDEF   0xBF
+#define CBOR_BREAK       0xFF
+
+enum {
+    EMIT_ADDR_MAC,  /**< 6 byte MAC address */
+    EMIT_ADDR_IPV4, /**< 4 byte IPv4 address */
+    EMIT_ADDR_IPV6, /**< 16 byte IPv6 address */
+};
+
+struct decode_emit_s;
+
+typedef struct emit_ops_s {
+    void (*map)(struct decode_emit_s *em, char *p, const char *key);
+    void (*array)(struct decode_emit_s *em, char *p, const char *key);
+    void (*end)(struct decode_emit_s *em, char *p);
+    void (*uint)(struct decode_emit_s *em, char *p, const char *key, uint64_t v);
+    void (*str)(struct decode_emit_s *em, char *p, const char *key, const char *str);
+    void (*addr)(struct decode_emit_s *em, char *p, const char *key, const void *a, int type);
+    void (*record)(struct decode_emit_s *em, char *p);
+} emit_ops_t;
+
+typedef struct decode_emit_s {
+    decode_out_t *out;           /**< Decoder output buffer */
+    const emit_ops_t *ops;       /**< Format functions */
+    int depth;                   /**< Current nesting depth */
+    bool first[EMIT_MAX_DEPTH];  /**< No item written yet at this depth, for JSON */
+    char closer[EMIT_MAX_DEPTH]; /**< JSON closing character at this depth */
+} decode_emit_t;
+
+static const int addr_len[] = {[EMIT_ADDR_MAC] = 6, [EMIT_ADDR_IPV4] = 4, [EMIT_ADDR_IPV6] = 16};
+
+static char *
+_emit_u64(char *p, uint64_t v)
+{
+    char tmp[24];
+    int n = 0;
+
+    do {
+        tmp[n++] = '0' + (v % 10);
+        v /= 10;
+    } while (v);
+
+    while (n)
+        *p++ = tmp[--n];
+
+    return p;
+}
+
+static inline void
+_emit_done(decode_emit_t *em, char *p)
+{
+    em->out->used = p - em->out->buf;
+}
+
+/* JSON format */
+
+static char *
+_json_key(decode_emit_t *em, char *p, const char *key)
+{
+    int n;
+
+    if (!em->first[em->depth])
+        *p++ = ',';
+    em->first[em->depth] = false;
+
+    if (key) {
+        n    = strlen(key);
+        *p++ = '"';
+        memcpy(p, key, n);
+        p += n;
+        *p++ = '"';
+        *p++ = ':';
+    }
+
+    return p;
+}
+
+static void
+_json_open(decode_emit_t *em, char *p, const char *key, char open, char close)
+{
+    p    = _json_key(em, p, key);
+    *p++ = open;
+
+    em->depth++;
+    em->first[em->depth]  = true;
+    em->closer[em->depth] = close;
+
+    _emit_done(em, p);
+}
+
+static void
+_json_map(decode_emit_t *em, char *p, const char *key)
+{
+    _json_open(em, p, key, '{', '}');
+}
+
+static void
+_json_array(decode_emit_t *em, char *p, const char *key)
+{
+    _json_open(em, p, key, '[', ']');
+}
+
+static void
+_json_end(decode_emit_t *em, char *p)
+{
+    *p++ = em->closer[em->depth--];
+    _emit_done(em, p);
+}
+
+static void
+_json_uint(decode_emit_t *em, char *p, const char *key, uint64_t v)
+{
+    p = _json_key(em, p, key);
+    p = _emit_u64(p, v);
+    _emit_done(em, p);
+}
+
+static void
+_json_str(decode_emit_t *em, char *p, const char *key, const char *str)
+{
+    int n = strlen(str);
+
+    /* Only header type names are written, no escapes are needed */
+    p    = _json_key(em, p, key);
+    *p++ = '"';
+    memcpy(p, str, n);
+    p += n;
+    *p++ = '"';
+    _emit_done(em, p);
+}
+
+static void
+_json_addr(decode_emit_t *em, char *p, const char *key, const void *addr, int type)
+{
+    const uint8_t *a = addr;
+
+    p    = _json_key(em, p, key);
+    *p++ = '"';
+    switch (type) {
+    case EMIT_ADDR_MAC:
+        for (int i = 0; i < 6; i++) {
+            if (i)
+                *p++ = ':';
+            *p++ = "0123456789abcdef"[a[i] >> 4];
+            *p++ = "0123456789abcdef"[a[i] & 0xF];
+        }
+        break;
+    case EMIT_ADDR_IPV4:
+        for (int i = 0; i < 4; i++) {
+            if (i)
+                *p++ = '.';
+            p = _emit_u64(p, a[i]);
+        }
+        break;
+    default:
+        inet_ntop(AF_INET6, addr, p, INET6_ADDRSTRLEN);
+        p += strlen(p);
+        break;
+    }
+    *p++ = '"';
+    _emit_done(em, p);
+}
+
+static void
+_json_record(decode_emit_t *em, char *p)
+{
+    *p++ = '\n';
+    _emit_done(em, p);
+}
+
+// clang-format off
+static const emit_ops_t json_ops = {
+    .map    = _json_map,
+    .array  = _json_array,
+    .end    = _json_end,
+    .uint   = _json_uint,
+    .str    = _json_str,
+    .addr   = _json_addr,
+    .record = _json_record,
+};
+// clang-format on
+
+/* CBOR format */
+
+static char *
+_cbor_head(char *p, uint8_t major, uint64_t v)
+{
+    uint8_t *b = (uint8_t *)p;
+    int n;
+
+    major <<= 5;
+    if (v < 24) {
+        *b++ = major | v;
+        return (char *)b;
+    } else if (v <= UINT8_MAX) {
+        *b++ = major | 24;
+        n    = 1;
+    } else if (v <= UINT16_MAX) {
+        *b++ = major | 25;
+        n    = 2;
+    } else if (v <= UINT32_MAX) {
+        *b++ = major | 26;
+        n    = 4;
+    } else {
+        *b++ = major | 27;
+        n    = 8;
+    }
+
+    /* Big endian value */
+    for (int i = n - 1; i >= 0; i--)
+        *b++ = v >> (i * 8);
+
+    return (char *)b;
+}
+
+static char *
+_cbor_text(char *p, const char *str)
+{
+    int n = strlen(str);
+
+    p = _cbor_head(p, CBOR_TEXT, n);
+    memcpy(p, str, n);
+
+    return p + n;
+}
+
+static char *
+_cbor_key(char *p, const char *key)
+{
+    return key ? _cbor_text(p, key) : p;
+}
+
+static void
+_cbor_map(decode_emit_t *em, char *p, const char *key)
+{
+    p    = _cbor_key(p, key);
+    *p++ = (char)CBOR_MAP_INDEF;
+    em->depth++;
+    _emit_done(em, p);
+}
+
+static void
+_cbor_array(decode_emit_t *em, char *p, const char *key)
+{
+    p    = _cbor_key(p, key);
+    *p++ = (char)CBOR_ARRAY_INDEF;
+    em->depth++;
+    _emit_done(em, p);
+}
+
+static void
+_cbor_end(decode_emit_t *em, char *p)
+{
+    *p++ = (char)CBOR_BREAK;
+    em->depth--;
+    _emit_done(em, p);
+}
+
+static void
+_cbor_uint(decode_emit_t *em, char *p, const char *key, uint64_t v)
+{
+    p = _cbor_key(p, key);
+    p = _cbor_head(p, CBOR_UINT, v);
+    _emit_done(em, p);
+}
+
+static void
+_cbor_str(decode_emit_t *em, char *p, const char *key, const char *str)
+{
+    p = _cbor_key(p, key);
+    p = _cbor_text(p, str);
+    _emit_done(em, p);
+}
+
+static void
+_cbor_addr(decode_emit_t *em, char *p, const char *key, const void *addr, int type)
+{
+    p = _cbor_key(p, key);
+    p = _cbor_head(p, CBOR_BYTES, addr_len[type]);
+    memcpy(p, addr, addr_len[type]);
+    p += addr_len[type];
+    _emit_done(em, p);
+}
+
+static void
+_cbor_record(decode_emit_t *em, char *p)
+{
+    _emit_done(em, p);
+}
+
+// clang-format off
+static const emit_ops_t cbor_ops = {
+    .map    = _cbor_map,
+    .array  = _cbor_array,
+    .end    = _cbor_end,
+    .uint   = _cbor_uint,
+    .str    = _cbor_str,
+    .addr   = _cbor_addr,
+    .record = _cbor_record,
+};
+// clang-format on
+
+/*
+ * Each item reserves space in the output buffer first, the buffer is flushed when the item
+ * does not fit.
+ */
+#define EMIT(em, fn, ...)                                        \
+    do {                                                         \
+        char *_p = decode_out_reserve((em)->out, EMIT_MAX_ITEM); \
+        if (!_p)                                                 \
+            return -1;                                           \
+        (em)->ops->fn((em), _p, ##__VA_ARGS__);                  \
+    } while (0)
+
+/* Emit the fields of one header */
+static int
+_emit_fields(decode_emit_t *em, decode_t *dc, decode_layer_t *l)
+{
+    void *h = decode_mtod_offset(dc, void *, l->off);
+
+    switch (l->type) {
+    case DECODE_ETHER: {
+        struct ether_header *eth = h;
+
+        EMIT(em, addr, "dst", eth->ether_dhost, EMIT_ADDR_MAC);
+        EMIT(em, addr, "src", eth->ether_shost, EMIT_ADDR_MAC);
+        EMIT(em, uint, "ethertype", ntohs(eth->ether_type));
+    } break;
+    case DECODE_DOT1Q:
+    case DECODE_DOT1AD: {
+        struct fgen_vlan_hdr *vlan = h;
+        uint16_t tci               = ntohs(vlan->vlan_tci);
+
+        EMIT(em, uint, "vlan", tci & 0xFFF);
+        EMIT(em, uint, "prio", tci >> 13);
+        EMIT(em, uint, "cfi", (tci >> 12) & 1);
+        EMIT(em, uint, "ethertype", ntohs(vlan->eth_proto));
+    } break;
+    case DECODE_IPV4: {
+        struct fgen_ipv4_hdr *ip = h;
+
+        EMIT(em, addr, "src", &ip->src_addr, EMIT_ADDR_IPV4);
+        EMIT(em, addr, "dst", &ip->dst_addr, EMIT_ADDR_IPV4);
+        EMIT(em, uint, "ihl", ip->version_ihl & 0xF);
+        EMIT(em, uint, "tos", ip->type_of_service);
+        EMIT(em, uint, "len", ntohs(ip->total_length));
+        EMIT(em, uint, "id", ntohs(ip->packet_id));
+        EMIT(em, uint, "frag", ntohs(ip->fragment_offset));
+        EMIT(em, uint, "ttl", ip->time_to_live);
+        EMIT(em, uint, "proto", ip->next_proto_id);
+        EMIT(em, uint, "cksum", ntohs(ip->hdr_checksum));
+    } break;
+    case DECODE_IPV6: {
+        struct fgen_ipv6_hdr *ip = h;
+        uint32_t vtc             = ntohl(ip->vtc_flow);
+
+        EMIT(em, addr, "src", ip->src_addr, EMIT_ADDR_IPV6);
+        EMIT(em, addr, "dst", ip->dst_addr, EMIT_ADDR_IPV6);
+        EMIT(em, uint, "tc", (vtc >> 20) & 0xFF);
+        EMIT(em, uint, "flow", vtc & 0xFFFFF);
+        EMIT(em, uint, "len", ntohs(ip->payload_len));
+        EMIT(em, uint, "proto", ip->proto);
+        EMIT(em, uint, "hops", ip->hop_limits);
+    } break;
+    case DECODE_UDP: {
+        struct fgen_udp_hdr *udp = h;
+
+        EMIT(em, uint, "sport", ntohs(udp->src_port));
+        EMIT(em, uint, "dport", ntohs(udp->dst_port));
+        EMIT(em, uint, "len", ntohs(udp->dgram_len));
+        EMIT(em, uint, "cksum", ntohs(udp->dgram_cksum));
+    } break;
+    case DECODE_TCP: {
+        struct fgen_tcp_hdr *tcp = h;
+
+        EMIT(em, uint, "sport", ntohs(tcp->src_port));
+        EMIT(em, uint, "dport", ntohs(tcp->dst_port));
+        EMIT(em, uint, "seq", ntohl(tcp->sent_seq));
+        EMIT(em, uint, "ack", ntohl(tcp->recv_ack));
+        EMIT(em, uint, "doff", tcp->data_off >> 4);
+        EMIT(em, uint, "flags", tcp->tcp_flags);
+        EMIT(em, uint, "win", ntohs(tcp->rx_win));
+        EMIT(em, uint, "cksum", ntohs(tcp->cksum));
+        EMIT(em, uint, "urp", ntohs(tcp->tcp_urp));
+    } break;
+    case DECODE_VXLAN: {
+        struct fgen_vxlan_hdr *vx = h;
+
+        EMIT(em, uint, "flags", ntohl(vx->vx_flags) >> 24);
+        EMIT(em, uint, "vni", ntohl(vx->vx_vni) >> 8);
+    } break;
+    case DECODE_VXLAN_GPE: {
+        struct fgen_vxlan_gpe_hdr *vx = h;
+
+        EMIT(em, uint, "flags", vx->vx_flags);
+        EMIT(em, uint, "proto", vx->proto);
+        EMIT(em, uint, "vni", ntohl(vx->vx_vni) >> 8);
+    } break;
+    case DECODE_GRE: {
+        struct fgen_gre_hdr *gre = h;
+        uint32_t *opt            = (uint32_t *)(gre + 1) + gre->c;
+
+        EMIT(em, uint, "proto", ntohs(gre->proto));
+        if (gre->k)
+            EMIT(em, uint, "key", ntohl(*opt++));
+        if (gre->s)
+            EMIT(em, uint, "seq", ntohl(*opt));
+    } break;
+    case DECODE_GTPU: {
+        struct fgen_gtp_hdr *gtp = h;
+
+        EMIT(em, uint, "flags", gtp->gtp_hdr_info);
+        EMIT(em, uint, "msg", gtp->msg_type);
+        EMIT(em, uint, "teid", ntohl(gtp->teid));
+    } break;
+    case DECODE_MPLS: {
+        uint32_t lse = ntohl(*(uint32_t *)h);
+
+        EMIT(em, uint, "label", lse >> 12);
+        EMIT(em, uint, "tc", (lse >> 9) & 7);
+        EMIT(em, uint, "s", (lse >> 8) & 1);
+        EMIT(em, uint, "ttl", lse & 0xFF);
+    } break;
+    case DECODE_TSC: {
+        tsc_t *tsc = h;
+
+        EMIT(em, uint, "tsc", tsc->tsc_val);
+    } break;
+    case DECODE_SEQ: {
+        seq_t *seq = h;
+
+        EMIT(em, uint, "stream", seq->stream);
+        EMIT(em, uint, "seq", seq->seq);
+    } break;
+    default:
+        break;
+    }
+
+    return 0;
+}
+
+static int
+_emit_record(decode_emit_t *em, decode_t *dc, uint64_t ts)
+{
+    em->depth    = 0;
+    em->first[0] = true;
+
+    EMIT(em, map, NULL);
+    EMIT(em, uint, "ts", ts);
+    EMIT(em, uint, "len", decode_len(dc));
+    EMIT(em, uint, "levels", dc->level + 1);
+    EMIT(em, array, "layers");
+
+    for (int i = 0; i < dc->nb_layers; i++) {
+        decode_layer_t *l = &dc->layers[i];
+
+        EMIT(em, map, NULL);
+        EMIT(em, str, "type", decode_layer_name(l->type));
+        EMIT(em, uint, "level", l->level);
+        EMIT(em, uint, "off", l->off);
+        EMIT(em, uint, "hlen", l->len);
+        if (_emit_fields(em, dc, l) < 0)
+            return -1;
+        EMIT(em, end);
+    }
+
+    EMIT(em, end);
+    EMIT(em, end);
+    EMIT(em, record);
+
+    return 0;
+}
+
+void
+decode_emit_free(decode_t *dc)
+{
+    free(dc->emit);
+    dc->emit = NULL;
+}
+
+int
+fgen_decode_set_emit(fgen_decode_t *_dc, fgen_emit_t type, int fd, uint32_t buf_size)
+{
+    decode_t *dc = _dc;
+    decode_emit_t *em;
+
+    if (!dc)
+        return -1;
+
+    decode_emit_free(dc);
+
+    if (type != FGEN_EMIT_JSON && type != FGEN_EMIT_CBOR)
+        FGEN_ERR_RET("Invalid emit type %d\n", type);
+
+    em = calloc(1, sizeof(decode_emit_t));
+    if (!em)
+        FGEN_ERR_RET("Unable to allocate emitter\n");
+
+    if (decode_out_open(dc, fd, buf_size) < 0 || dc->out.size < EMIT_MAX_ITEM) {
+        free(em);
+        FGEN_ERR_RET("Unable to setup emit output\n");
+    }
+
+    em->out = &dc->out;
+    em->ops = (type == FGEN_EMIT_JSON) ? &json_ops : &cbor_ops;
+    dc->emit = em;
+
+    return 0;
+}
+
+int
+fgen_decode_emit(fgen_decode_t *_dc, void *data, uint16_t len, uint64_t ts)
+{
+    decode_t *dc = _dc;
+
+    if (!dc || !dc->emit || !dc->out.buf || !data || len == 0)
+        return -1;
+
+    if (decode_headers(dc, data, len, FGEN_ETHER_TYPE) < 0)
+        return -1;
+
+    return _emit_record(dc->emit, dc, ts);
+}
@@ -14,6 +14,8 @@
 #include <net/fgen_udp.h>
 #include <net/fgen_tcp.h>
 #include <net/fgen_vxlan.h>
+#include <cksum.h>
+#include <crc32.h>
 
 #include "fgen.h"
 #include "decode.h"
@@ -115,11 +117,11 @@ _encode_ether(frame_t *f, int lidx)
     struct ether_header *eth;
     fopt_t *opt = FGEN_LOPT(fg, lidx);
 
-    int num;
-    const char *kvps[] = {"dst", "src"};
+    int num, type = -1;
+    const char *kvps[] = {"dst", "src", "type"};
     char *val;
 
-    eth = fbuf_mtod(f, struct ether_header *);
+    eth = fbuf_mtod_offset(f, struct ether_header *, fbuf_data_len(f));
     ether_unformat_addr("FFFF:FFFF:FFFF", (struct ether_addr *)eth->ether_dhost);
     ether_unformat_addr("0000:0000:0000", (struct ether_addr *)eth->ether_shost);
 
@@ -141,6 +143,9 @@ _encode_ether(frame_t *f, int lidx)
         case 1:
             ether_unformat_addr(val, (struct ether_addr *)eth->ether_shost);
             break;
+        case 2:
+            type = STRTOL(val) & 0xFFFF;
+            break;
         default:
             FGEN_ERR_RET("Ether: Invalid key '%s'\n", val);
         }
@@ -156,6 +161,9 @@ _encode_ether(frame_t *f, int lidx)
     case FGEN_IPV4_TYPE:
         eth->ether_type = htons(FGEN_ETHER_TYPE_IPV4);
         break;
+    case FGEN_IPV6_TYPE:
+        eth->ether_type = htons(FGEN_ETHER_TYPE_IPV6);
+        break;
     case FGEN_ERROR_TYPE:
         FGEN_ERR_RET("Next layer return error\n");
     default:
@@ -163,6 +171,10 @@ _encode_ether(frame_t *f, int lidx)
         break;
     }
 
+    /* An explicit type is used for layers the encoder does not know, e.g. ARP in a Raw layer */
+    if (type >= 0)
+        eth->ether_type = htons(type);
+
     if (fg->flags & FGEN_VERBOSE)
         FGEN_INFO("[magenta]Return '[orange]%s[]'\n", parser_type(opt->typ));
 
@@ -175,7 +187,7 @@ _encode_vlan(frame_t *f, int lidx, bool is_dot1ad)
     fgen_t *fg = f->fg;
     fopt_t *opt = FGEN_LOPT(fg, lidx);
     struct fgen_vlan_hdr *vlan;
-    uint16_t vid = 1, prio = 7, cfi = 0;
+    uint16_t vid = 1, prio = (7 << 13), cfi = 0;
     const char *kvps[] = {"vlan", "prio", "cfi"};
     char *val;
     int num;
@@ -225,6 +237,9 @@ _encode_vlan(frame_t *f, int lidx, bool is_dot1ad)
     case FGEN_IPV4_TYPE:
         vlan->eth_proto = htons(FGEN_ETHER_TYPE_IPV4);
         break;
+    case FGEN_IPV6_TYPE:
+        vlan->eth_proto = htons(FGEN_ETHER_TYPE_IPV6);
+        break;
     case FGEN_DOT1AD_TYPE:
         vlan->eth_proto = htons(FGEN_ETHER_TYPE_QINQ);
         break;
@@ -260,10 +275,10 @@ _encode_ipv4(frame_t *f, int lidx)
     struct fgen_ipv4_hdr *hdr;
     struct fgen_udp_hdr *udp;
     struct fgen_tcp_hdr *tcp;
-    const char *kvps[] = {"dst", "src"};
+    const char *kvps[] = {"dst", "src", "tos", "id", "ttl", "frag", "proto"};
     char *val;
     uint16_t offset, total_length;
-    int num;
+    int num, proto = -1;
 
     offset = fbuf_data_len(f);
     hdr    = fbuf_mtod_offset(f, struct fgen_ipv4_hdr *, offset);
@@ -290,6 +305,21 @@ _encode_ipv4(frame_t *f, int lidx)
         case 1:
             inet_pton(AF_INET, val, &hdr->src_addr);
             break;
+        case 2:
+            hdr->type_of_service = STRTOL(val) & 0xFF;
+            break;
+        case 3:
+            hdr->packet_id = htons(STRTOL(val) & 0xFFFF);
+            break;
+        case 4:
+            hdr->time_to_live = STRTOL(val) & 0xFF;
+            break;
+        case 5: /* Flags and fragment offset as the 16-bit field value */
+            hdr->fragment_offset = htons(STRTOL(val) & 0xFFFF);
+            break;
+        case 6:
+            proto = STRTOL(val) & 0xFF;
+            break;
         default:
             FGEN_ERR_RET("IPv4: Invalid key '%s'\n", val);
         }
@@ -297,7 +327,7 @@ _encode_ipv4(frame_t *f, int lidx)
 
     fbuf_data_len(f) += sizeof(struct fgen_ipv4_hdr);
 
-    hdr->next_proto_id = 0;
+    hdr->next_proto_id = (proto >= 0) ? proto : 0;
     int nxt            = next_layer(f, ++lidx);
 
     /* Will calculate the checksum when we return from the reset of the layers */
@@ -311,13 +341,13 @@ _encode_ipv4(frame_t *f, int lidx)
 
         udp              = (struct fgen_udp_hdr *)((char *)hdr + (hdr->version_ihl & 0xf) * 4);
         udp->dgram_cksum = 0;
-        udp->dgram_cksum = fgen_ipv4_udptcp_cksum(hdr, udp);
+        udp->dgram_cksum = fgen_cksum_ipv4_udptcp(hdr, udp);
         break;
     case FGEN_TCP_TYPE:
         hdr->next_proto_id = IPPROTO_TCP;
 
         tcp        = (struct fgen_tcp_hdr *)((char *)hdr + (hdr->version_ihl & 0xf) * 4);
-        tcp->cksum = fgen_ipv4_udptcp_cksum(hdr, tcp);
+        tcp->cksum = fgen_cksum_ipv4_udptcp(hdr, tcp);
         break;
     case FGEN_ERROR_TYPE:
         FGEN_ERR_RET("Next layer return error\n");
@@ -337,14 +367,81 @@ _encode_ipv6(frame_t *f, int lidx)
 {
     fgen_t *fg = f->fg;
     fopt_t *opt = FGEN_LOPT(fg, lidx);
+    struct fgen_ipv6_hdr *hdr;
+    struct fgen_udp_hdr *udp;
+    struct fgen_tcp_hdr *tcp;
+    const char *kvps[] = {"dst", "src", "hops", "tc", "flow", "proto"};
+    char *val;
+    uint32_t tc = 0, flow = 0;
+    uint16_t offset;
+    int num, proto = -1;
+
+    offset = fbuf_data_len(f);
+    hdr    = fbuf_mtod_offset(f, struct fgen_ipv6_hdr *, offset);
+    memset(hdr, 0, sizeof(*hdr));
+
+    hdr->hop_limits = 64;
+    inet_pton(AF_INET6, "fd00::2", hdr->dst_addr);
+    inet_pton(AF_INET6, "fd00::1", hdr->src_addr);
 
     if (fg->flags & FGEN_VERBOSE)
         FGEN_INFO("[magenta]params[]:'[orange]%s[]'\n", opt->param_str);
 
+    num = _encode_opts(opt->param_str, fg->params, fgen_countof(fg->params));
+    if (num < 0)
+        FGEN_ERR_RET("Parameters '%s' invalid\n", opt->param_str);
+
+    for (int i = 0; i < num; i++) {
+        switch (parser_kvp(fg->params[i], kvps, fgen_countof(kvps), &val)) {
+        case 0:
+            if (inet_pton(AF_INET6, val, hdr->dst_addr) != 1)
+                FGEN_ERR_RET("IPv6: Invalid address '%s'\n", val);
+            break;
+        case 1:
+            if (inet_pton(AF_INET6, val, hdr->src_addr) != 1)
+                FGEN_ERR_RET("IPv6: Invalid address '%s'\n", val);
+            break;
+        case 2:
+            hdr->hop_limits = STRTOL(val) & 0xFF;
+            break;
+        case 3:
+            tc = STRTOL(val) & 0xFF;
+            break;
+        case 4:
+            flow = STRTOL(val) & FGEN_IPV6_HDR_FL_MASK;
+            break;
+        case 5:
+            proto = STRTOL(val) & 0xFF;
+            break;
+        default:
+            FGEN_ERR_RET("IPv6: Invalid key '%s'\n", val);
+        }
+    }
+    hdr->vtc_flow = htonl((6u << 28) | (tc << FGEN_IPV6_HDR_TC_SHIFT) | flow);
+    hdr->proto    = (proto >= 0) ? proto : IPPROTO_NONE;
+
     opt->length = sizeof(struct fgen_ipv6_hdr);
     fbuf_data_len(f) += opt->length;
 
-    switch (next_layer(f, ++lidx)) {
+    int nxt = next_layer(f, ++lidx);
+
+    hdr->payload_len = htons(fbuf_data_len(f) - offset - sizeof(struct fgen_ipv6_hdr));
+
+    switch (nxt) {
+    case FGEN_UDP_TYPE:
+        hdr->proto = IPPROTO_UDP;
+
+        udp              = (struct fgen_udp_hdr *)(hdr + 1);
+        udp->dgram_cksum = 0;
+        udp->dgram_cksum = fgen_cksum_ipv6_udptcp(hdr, udp);
+        break;
+    case FGEN_TCP_TYPE:
+        hdr->proto = IPPROTO_TCP;
+
+        tcp        = (struct fgen_tcp_hdr *)(hdr + 1);
+        tcp->cksum = 0;
+        tcp->cksum = fgen_cksum_ipv6_udptcp(hdr, tcp);
+        break;
     case FGEN_ERROR_TYPE:
         FGEN_ERR_RET("Next layer return error\n");
     default:
@@ -367,7 +464,7 @@ _encode_udp(frame_t *f, int lidx)
     const char *kvps[] = {"dport", "sport"};
     char *val;
     uint16_t offset;
-    int num;
+    int num, ports_set = 0;
 
     offset = fbuf_data_len(f);
     hdr    = fbuf_mtod_offset(f, struct fgen_udp_hdr *, offset);
@@ -387,9 +484,11 @@ _encode_udp(frame_t *f, int lidx)
         switch (parser_kvp(fg->params[i], kvps, fgen_countof(kvps), &val)) {
         case 0:
             dport = STRTOL(val);
+            ports_set++;
             break;
         case 1:
             sport = STRTOL(val);
+            ports_set++;
             break;
         default:
             FGEN_ERR_RET("UDP: Invalid key '%s'\n", val);
@@ -398,12 +497,15 @@ _encode_udp(frame_t *f, int lidx)
 
     fbuf_data_len(f) += sizeof(struct fgen_udp_hdr);
 
+    /* Well known ports are only the default when no port was given */
     switch (next_layer(f, ++lidx)) {
     case FGEN_ECHO_TYPE:
-        sport = dport = 7;
+        if (!ports_set)
+            sport = dport = 7;
         break;
     case FGEN_VXLAN_TYPE:
-        sport = dport = FGEN_VXLAN_DEFAULT_PORT;
+        if (!ports_set)
+            sport = dport = FGEN_VXLAN_DEFAULT_PORT;
         break;
     case FGEN_ERROR_TYPE:
         FGEN_ERR_RET("Next layer return error\n");
@@ -432,9 +534,12 @@ _encode_tcp(frame_t *f, int lidx)
     fgen_t *fg = f->fg;
     fopt_t *opt = FGEN_LOPT(fg, lidx);
     struct fgen_tcp_hdr *hdr;
-    uint16_t sport, dport;
-    const char *kvps[] = {"dport", "sport"};
+    uint16_t sport, dport, win = 8192, urp = 0;
+    uint32_t seq = 0, ack = 0;
+    uint8_t flags = TCP_SYN_FLAG, off = 5;
+    const char *kvps[] = {"dport", "sport", "seq", "ack", "flags", "win", "urp", "off"};
     char *val;
+    long v;
     int num;
 
     hdr = fbuf_mtod_offset(f, struct fgen_tcp_hdr *, fbuf_data_len(f));
@@ -458,8 +563,29 @@ _encode_tcp(frame_t *f, int lidx)
         case 1:
             sport = STRTOL(val);
             break;
+        case 2:
+            seq = strtoul(val, NULL, 0);
+            break;
+        case 3:
+            ack = strtoul(val, NULL, 0);
+            break;
+        case 4:
+            flags = STRTOL(val) & 0xFF;
+            break;
+        case 5:
+            win = STRTOL(val);
+            break;
+        case 6:
+            urp = STRTOL(val);
+            break;
+        case 7: /* Data offset in 32-bit words, options follow as a Raw layer */
+            v = STRTOL(val);
+            if (v < 5 || v > 15)
+                FGEN_ERR_RET("TCP: Invalid data offset '%s'\n", val);
+            off = v;
+            break;
         default:
-            FGEN_ERR_RET("UDP: Invalid key '%s'\n", val);
+            FGEN_ERR_RET("TCP: Invalid key '%s'\n", val);
         }
     }
 
@@ -476,12 +602,15 @@ _encode_tcp(frame_t *f, int lidx)
         break;
     }
 
-    opt->length    = 5 * 4;
-    hdr->data_off  = (5 << 4); /* Min TCP length is 5 */
-    hdr->rx_win    = htons(8192);
-    hdr->tcp_flags = TCP_SYN_FLAG;
+    opt->length    = off * 4;
+    hdr->data_off  = (off << 4); /* Min TCP length is 5 */
+    hdr->rx_win    = htons(win);
+    hdr->tcp_flags = flags;
     hdr->dst_port  = htons(dport);
     hdr->src_port  = htons(sport);
+    hdr->sent_seq  = htonl(seq);
+    hdr->recv_ack  = htonl(ack);
+    hdr->tcp_urp   = htons(urp);
 
     if (fg->flags & FGEN_VERBOSE)
         FGEN_INFO("[magenta]Return '[orange]%s[]'\n", parser_type(opt->typ));
@@ -499,7 +628,7 @@ _encode_vxlan(frame_t *f, int lidx)
     hdr = fbuf_mtod_offset(f, struct fgen_vxlan_hdr *, fbuf_data_len(f));
     memset(hdr, 0, sizeof(*hdr));
 
-    hdr->vx_vni = htonl(1000 & ((1 << 24) - 1));
+    hdr->vx_vni = htonl((1000 & ((1 << 24) - 1)) << 8);
 
     if (fg->flags & FGEN_VERBOSE)
         FGEN_INFO("[magenta]params[]:'[orange]%s[]'\n", opt->param_str);
@@ -586,16 +715,126 @@ _encode_tsc(frame_t *f, int lidx)
     return FGEN_TSC_TYPE;
 }
 
+static int
+_encode_seq(frame_t *f, int lidx)
+{
+    fgen_t *fg = f->fg;
+    fopt_t *opt = FGEN_LOPT(fg, lidx);
+    const char *kvps[] = {"stream", "seq"};
+    seq_t *seq;
+    char *val;
+    int num;
+
+    if (fg->flags & FGEN_VERBOSE)
+        FGEN_INFO("[magenta]params[]:'[orange]%s[]'\n", opt->param_str);
+
+    seq = fbuf_mtod_offset(f, seq_t *, fbuf_data_len(f));
+    memset(seq, 0, sizeof(seq_t));
+
+    f->seq_off = fbuf_data_len(f);
+    seq->seqid = SEQUENCE_ID;
+
+    num = _encode_opts(opt->param_str, fg->params, fgen_countof(fg->params));
+    if (num < 0)
+        FGEN_ERR_RET("Parameters '%s' invalid\n", opt->param_str);
+
+    for (int i = 0; i < num; i++) {
+        switch (parser_kvp(fg->params[i], kvps, fgen_countof(kvps), &val)) {
+        case 0: /* Stream of the frame, the sequence numbers are counted per stream */
+            seq->stream = STRTOL(val) & 0xFFFFFFFF;
+            break;
+        case 1: /* First sequence number sent */
+            errno    = 0;
+            seq->seq = strtoull(val, NULL, 0);
+            if (errno)
+                FGEN_ERR_RET("Unable to parse number '%s'\n", val);
+            break;
+        default:
+            FGEN_ERR_RET("Seq: Invalid key '%s'\n", val);
+        }
+    }
+
+    fbuf_data_len(f) += sizeof(seq_t);
+
+    switch (next_layer(f, ++lidx)) {
+    case FGEN_ERROR_TYPE:
+        FGEN_ERR_RET("Next layer return error\n");
+    default:
+        break;
+    }
+
+    if (fg->flags & FGEN_VERBOSE)
+        FGEN_INFO("[magenta]Return '[orange]%s[]'\n", parser_type(opt->typ));
+
+    return FGEN_SEQ_TYPE;
+}
+
+static inline int
+_hex_nibble(char c)
+{
+    if (c >= '0' && c <= '9')
+        return c - '0';
+    c |= 0x20;
+    if (c >= 'a' && c <= 'f')
+        return c - 'a' + 10;
+    return -1;
+}
+
+/* Copy a string of hex digit pairs into the frame, returns the number of bytes or -1 on error */
+static int
+_encode_hex(frame_t *f, const char *hex)
+{
+    uint8_t *p = fbuf_mtod_offset(f, uint8_t *, fbuf_data_len(f));
+    int len    = strlen(hex);
+    int hi, lo;
+
+    if (len & 1)
+        FGEN_ERR_RET("Raw: Odd number of hex digits\n");
+    if ((fbuf_data_len(f) + (len / 2)) > FGEN_MAX_FRAME_SIZE)
+        FGEN_ERR_RET("Raw: Data too long for frame\n");
+
+    for (int i = 0; i < len; i += 2) {
+        hi = _hex_nibble(hex[i]);
+        lo = _hex_nibble(hex[i + 1]);
+        if (hi < 0 || lo < 0)
+            FGEN_ERR_RET("Raw: Invalid hex digit at offset %d\n", i);
+        *p++ = (hi << 4) | lo;
+    }
+
+    return len / 2;
+}
+
 static int
 _encode_raw(frame_t *f, int lidx)
 {
     fgen_t *fg = f->fg;
     fopt_t *opt = FGEN_LOPT(fg, lidx);
+    const char *kvps[] = {"hex"};
+    char *val;
+    int num, len = -1;
 
     if (fg->flags & FGEN_VERBOSE)
         FGEN_INFO("[magenta]params[]:'[orange]%s[]'\n", opt->param_str);
 
-    fbuf_data_len(f) += sizeof(struct fgen_tcp_hdr);
+    num = _encode_opts(opt->param_str, fg->params, fgen_countof(fg->params));
+    if (num < 0)
+        FGEN_ERR_RET("Parameters '%s' invalid\n", opt->param_str);
+
+    for (int i = 0; i < num; i++) {
+        switch (parser_kvp(fg->params[i], kvps, fgen_countof(kvps), &val)) {
+        case 0: /* Exact bytes, used by the round-trip decoder for unknown headers */
+            len = _encode_hex(f, val);
+            if (len < 0)
+                return FGEN_ERROR_TYPE;
+            break;
+        default:
+            FGEN_ERR_RET("Raw: Invalid key '%s'\n", val);
+        }
+    }
+
+    /* Without any data a Raw layer is a place holder the size of a TCP header */
+    opt->length = (len < 0) ? (int)sizeof(struct fgen_tcp_hdr) : len;
+    fbuf_data_len(f) += opt->length;
 
     switch (next_layer(f, ++lidx)) {
     case FGEN_ERROR_TYPE:
@@ -701,6 +940,10 @@ _encode_done(frame_t *f, int lidx __fgen_unused)
     }
 
     if (fbuf_data_len(f) > ETH_FRAME_LEN) {
+        /* The FCS would cover a frame cut to size and missing the bytes of its last layers */
+        if (fg->flags & FGEN_ADD_FCS)
+            FGEN_ERR_RET("Frame of %d bytes is longer than %d bytes\n", fbuf_data_len(f),
+                         ETH_FRAME_LEN);
         if (fg->flags & FGEN_VERBOSE)
             FGEN_WARN("[magenta]Packet is to long [orange]%d[], [magenta]adjusting to [orange]%d "
                       "[magenta]bytes[]\n",
@@ -731,6 +974,7 @@ ftable_t fgen_tbl[] = {
     {.str = FGEN_VxLAN_STR"(",   .fn = _encode_vxlan,     .typ = FGEN_VXLAN_TYPE},
     {.str = FGEN_ECHO_STR"(",    .fn = _encode_echo,      .typ = FGEN_ECHO_TYPE},
     {.str = FGEN_TSC_STR"(",     .fn = _encode_tsc,       .typ = FGEN_TSC_TYPE},
+    {.str = FGEN_SEQ_STR"(",     .fn = _encode_seq,       .typ = FGEN_SEQ_TYPE},
     {.str = FGEN_RAW_STR"(",     .fn = _encode_raw,       .typ = FGEN_RAW_TYPE},
 
     {.str = FGEN_PAYLOAD_STR"(", .fn = _encode_payload,   .typ = FGEN_PAYLOAD_TYPE},
@@ -744,6 +988,7 @@ _encode_frame(frame_t *f)
     fgen_t *fg = f->fg;
     fopt_t *opt = NULL;
     char *fstr;
+    int ret = -1;
 
     if (!fg || !f || !f->fstr)
         FGEN_ERR_RET("fgen_t is NULL\n");
@@ -802,10 +1047,15 @@ _encode_frame(frame_t *f)
     if (next_layer(f, 0) < 0)
         goto leave;
 
+    /* Add the FCS after all layers, the payload layer fills the frame after the done layer */
+    if (fg->flags & FGEN_ADD_FCS)
+        fbuf_data_len(f) = fgen_crc32_fcs_append(fbuf_mtod(f, void *), fbuf_data_len(f));
+
     if (fg->flags & FGEN_DUMP_DATA)
         fgen_print_frame(NULL, f);
 
+    ret = 0;
 leave:
     free(fstr);
-    return 0;
+    return ret;
 }
@@ -7,6 +7,7 @@
 #include <netinet/in.h>        // for ntohs, htonl, htons
 #include <net/ethernet.h>
 #include <sys/queue.h>
+#include <malloc.h>        // for malloc_usable_size
 
 #include <fgen_common.h>
 #include <fgen_log.h>
@@ -62,6 +63,7 @@ static int
 _add_frame(fgen_t *fg, const char *name, const char *fstr)
 {
     frame_t *f;
+    offset_t off;
 
     if (!fg)
         FGEN_ERR_RET("fgen_t pointer is NULL\n");
@@ -80,9 +82,18 @@ _add_frame(fgen_t *fg, const char *name, const char *fstr)
     if (f == NULL)
         FGEN_ERR_RET("failed to allocate frame\n");
 
+    /* Encode the frame at the end of the used salloc space, then commit only the bytes used */
+    if (salloc_reserve(fg->salloc, FGEN_MAX_FRAME_SIZE) < 0)
+        FGEN_ERR_GOTO(leave, "Failed to reserve frame data space\n");
+    f->data_off = fg->salloc->used;
+    memset(fbuf_mtod(f, void *), 0, FGEN_MAX_FRAME_SIZE);
+
     if (_encode_frame(f) < 0)
         FGEN_ERR_GOTO(leave, "Failed to parse frame\n");
 
+    if (salloc(fg->salloc, fbuf_data_len(f), &off) < 0 || off != f->data_off)
+        FGEN_ERR_GOTO(leave, "Failed to allocate frame data\n");
+
     return 0;
 leave:
     frame_free(fg, f);
@@ -140,18 +151,44 @@ fgen_destroy(fgen_t *fg)
     }
 }
 
+int
+fgen_mem_stats(fgen_t *fg, fgen_mem_stats_t *st)
+{
+    frame_t *f;
+
+    if (!st)
+        FGEN_ERR_RET("fgen_mem_stats_t pointer is NULL\n");
+
+    memset(st, 0, sizeof(*st));
+    if (mmap_stats_get(&st->mmap) < 0)
+        return -1;
+    if (!fg)
+        return 0;
+
+    st->nb_frames   = fg->nb_frames;
+    st->frame_bytes = fg->salloc->used;
+    st->block_bytes = fg->salloc->size;
+    if (st->block_bytes)
+        st->frag_pct = ((st->block_bytes - st->frame_bytes) * 100) / st->block_bytes;
+
+    st->meta_bytes = malloc_usable_size(fg) + malloc_usable_size(fg->salloc);
+    TAILQ_FOREACH (f, &fg->head, next)
+        st->meta_bytes +=
+            malloc_usable_size(f) + malloc_usable_size(f->name) + malloc_usable_size(f->fstr);
+
+    return 0;
+}
+
 frame_t *
 fgen_find_frame(fgen_t *fg, const char *name)
 {
     frame_t *f;
-    size_t len;
 
-    if (!fg)
+    if (!fg || !name)
         return NULL;
 
-    len = strlen(name);
     TAILQ_FOREACH (f, &fg->head, next) {
-        if (!strncmp(f->name, name, len))
+        if (!strcmp(f->name, name))
             return f;
     }
 
@@ -331,7 +368,7 @@ fgen_load_strings(fgen_t *fg, char **fstr, int nb_frames)
             snprintf(name, sizeof(name), "frame-%d", cnt);
         else {
             *c = '\0';
-            strlcpy(name, s, sizeof(name));
+            strlcpy(name, strtrim(s), sizeof(name));
             s = c + 2;
             while ((*s == ' ' || *s == '\t' || *s == '\n') && *s != '\0')
                 s++;
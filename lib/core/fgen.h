@@ -15,6 +15,8 @@ extern "C" {
 #include <salloc.h>
 
 typedef void fgen_decode_t;
+typedef void fgen_dedup_t;
+typedef void fgen_compare_t;
 
 #include <fgen_mmap.h>
 
@@ -46,6 +48,7 @@ typedef enum {
     FGEN_VXLAN_TYPE,     /**< VxLan type layer */
     FGEN_ECHO_TYPE,      /**< ECHO type layer */
     FGEN_TSC_TYPE,       /**< Timestamp type layer */
+    FGEN_SEQ_TYPE,       /**< Sequence type layer */
     FGEN_RAW_TYPE,       /**< Raw type layer */
     FGEN_PAYLOAD_TYPE,   /**< Payload type layer */
     FGEN_TYPE_COUNT,     /**< Number of layers total */
@@ -63,6 +66,7 @@ typedef enum {
 #define FGEN_VxLAN_STR   "Vxlan"
 #define FGEN_ECHO_STR    "Echo"
 #define FGEN_TSC_STR     "TSC"
+#define FGEN_SEQ_STR     "Seq"
 #define FGEN_RAW_STR     "Raw"
 #define FGEN_PAYLOAD_STR "Payload"
 
@@ -79,6 +83,7 @@ typedef enum {
         FGEN_VxLAN_STR,   \
         FGEN_ECHO_STR,    \
         FGEN_TSC_STR,     \
+        FGEN_SEQ_STR,     \
         FGEN_RAW_STR,     \
         FGEN_PAYLOAD_STR, \
         NULL              \
@@ -108,6 +113,29 @@ typedef struct fopt_s {
     ftable_t *tbl;   /**< The table containing the layer parsing routine */
 } fopt_t;
 
+#define TIMESTAMP_ID (('t' << 24) | ('s' << 16) | ('c' << 8) | '=') /**< tsc_t.tstmp marker */
+
+/**
+ * The TSC() layer at frame_t.tsc_off, a generator writes the TSC into tsc_val as it sends the
+ * frame and the receiver finds the stamp by the TIMESTAMP_ID marker in host byte order.
+ */
+typedef struct tsc_s {
+    uint32_t tstmp;   /**< TIMESTAMP_ID */
+    uint64_t tsc_val; /**< TSC at transmit, 0 if the frame was not stamped */
+} tsc_t;
+
+#define SEQUENCE_ID (('s' << 24) | ('e' << 16) | ('q' << 8) | '=') /**< seq_t.seqid marker */
+
+/**
+ * The Seq() layer at frame_t.seq_off, a generator writes the next sequence number of the stream
+ * into seq as it sends the frame. The fields are in host byte order as in tsc_t.
+ */
+typedef struct seq_s {
+    uint32_t seqid;  /**< SEQUENCE_ID */
+    uint32_t stream; /**< Stream of the frame, Seq(stream=N) */
+    uint64_t seq;    /**< Sequence number in the stream, Seq(seq=N) is the first */
+} seq_t;
+
 typedef struct proto_s {
     uint16_t offset; /**< Offset to the protocol header in buffer */
     uint16_t length; /**< Length of the protocol header in buffer */
@@ -123,6 +151,7 @@ typedef struct frame_s {
     uint32_t data_off;         /**< Frame offset into buffer space */
     uint16_t data_len;         /**< Total length of frame */
     uint16_t tsc_off;          /**< Offset to the Timestamp */
+    uint16_t seq_off;          /**< Offset to the Sequence, 0 if the frame has none */
     uint16_t port;             /**< Port number */
     proto_t l2;                /**< Information about L2 header */
     proto_t l3;                /**< Information about L3 header */
@@ -143,8 +172,126 @@ typedef struct fgen_s {
 enum {
     FGEN_VERBOSE   = (1 << 0), /**< Debug flag to enable verbose output */
     FGEN_DUMP_DATA = (1 << 1), /**< Debug flag to hexdump the data */
+    FGEN_ADD_FCS   = (1 << 2), /**< Append the Ethernet FCS to each frame */
+};
+
+enum {
+    FGEN_DECODE_ROUNDTRIP = (1 << 0), /**< Decode into text that encodes back exactly */
+    FGEN_DECODE_FCS       = (1 << 1), /**< Frames end with the FCS, see FGEN_ADD_FCS */
+};
+
+enum {
+    FGEN_DECODE_MAX_LEVELS   = 8,            /**< Max encapsulation levels decoded */
+    FGEN_DECODE_OUT_BUF_SIZE = (256 * 1024), /**< Default summary and emit output buffer size */
 };
 
+typedef enum {
+    FGEN_EMIT_JSON, /**< JSON Lines, one object per frame */
+    FGEN_EMIT_CBOR, /**< CBOR sequence, one map per frame */
+} fgen_emit_t;
+
+/** Default summary line format, see fgen_decode_set_summary() */
+#define FGEN_DECODE_SUMMARY_FMT "ts proto src:sport > dst:dport len flags"
+
+/**
+ * Offsets of the headers found at one encapsulation level by fgen_decode(), level 0 is the
+ * outer frame and each tunnel starts a new level. An offset is -1 if the header was not found.
+ */
+typedef struct fgen_decode_offsets_s {
+    int16_t l2;     /**< Offset of the Ethernet header */
+    int16_t l3;     /**< Offset of the IPv4 or IPv6 header */
+    int16_t l4;     /**< Offset of the UDP or TCP header */
+    int16_t tunnel; /**< Offset of the tunnel header carrying the next level */
+} fgen_decode_offsets_t;
+
+enum {
+    FGEN_FP_IP_ID   = (1 << 0), /**< Mask the IPv4 packet ID */
+    FGEN_FP_TTL     = (1 << 1), /**< Mask the IPv4 TTL and IPv6 hop limit */
+    FGEN_FP_CKSUM   = (1 << 2), /**< Mask the IPv4, UDP and TCP checksums */
+    FGEN_FP_TCP_SEQ = (1 << 3), /**< Mask the TCP sequence and acknowledgment numbers */
+    FGEN_FP_TSC     = (1 << 4), /**< Mask the TSC value of a timestamp */
+    FGEN_FP_PAYLOAD = (1 << 5), /**< Mask the payload data */
+    FGEN_FP_SEQ     = (1 << 6), /**< Mask the sequence number of a Seq() layer */
+    FGEN_FP_DEFAULT =
+        (FGEN_FP_IP_ID | FGEN_FP_CKSUM | FGEN_FP_TCP_SEQ | FGEN_FP_TSC | FGEN_FP_SEQ),
+};
+
+/**
+ * A unique frame found by fgen_dedup_add(), the data is valid until the table is destroyed.
+ */
+typedef struct fgen_dedup_entry_s {
+    const uint8_t *data; /**< Exemplar frame data, the first frame seen */
+    uint16_t len;        /**< Length of the exemplar frame */
+    uint64_t fp;         /**< Fingerprint of the exemplar frame */
+    uint64_t count;      /**< Number of frames matching the exemplar */
+    uint64_t first;      /**< Index of the first matching frame */
+} fgen_dedup_entry_t;
+
+/**
+ * The first difference found by fgen_compare(), the layer and field are taken from the template.
+ */
+typedef struct fgen_compare_result_s {
+    int offset;        /**< Offset of the first differing byte */
+    int level;         /**< Encapsulation level of the layer */
+    const char *layer; /**< Name of the layer holding the byte, e.g. "IPv4" */
+    const char *field; /**< Name of the field holding the byte, e.g. "dst" or "len" */
+} fgen_compare_result_t;
+
+/**
+ * A frame of a compiled frame set in a shared region, see fgen_share().
+ */
+typedef struct fgen_shared_frame_s {
+    char name[FGEN_FRAME_NAME_LENGTH]; /**< Name of the frame, truncated if longer */
+    uint32_t data_off;                 /**< Offset of the frame data from the start of the set */
+    uint16_t data_len;                 /**< Total length of frame */
+    uint16_t tsc_off;                  /**< Offset to the Timestamp */
+    uint16_t seq_off;                  /**< Offset to the Sequence, 0 if the frame has none */
+    proto_t l2;                        /**< Information about L2 header */
+    proto_t l3;                        /**< Information about L3 header */
+    proto_t l4;                        /**< Information about L4 header */
+} fgen_shared_frame_t;
+
+/**
+ * A compiled frame set, all offsets are from the start of the set so any process can use the
+ * set at the address its mapping of the region is at.
+ */
+typedef struct fgen_shared_set_s {
+    uint32_t magic;               /**< FGEN_SHARED_MAGIC */
+    uint32_t nb_frames;           /**< Number of frames in the set */
+    uint64_t size;                /**< Size of the set in bytes */
+    fgen_shared_frame_t frames[]; /**< The frames in the order they were added */
+} fgen_shared_set_t;
+
+#define FGEN_SHARED_MAGIC 0x46475346 /**< "FGSF" */
+
+/**
+ * Memory used by a frame generator object and by the mmap regions of the process.
+ */
+typedef struct fgen_mem_stats_s {
+    uint32_t nb_frames;   /**< Number of frames */
+    uint32_t frag_pct;    /**< Percent of the frame data block not holding frame data */
+    uint64_t frame_bytes; /**< Bytes of frame data */
+    uint64_t block_bytes; /**< Size of the frame data block, frame data plus the unused space */
+    uint64_t meta_bytes;  /**< Bytes of the fgen_t and frame_t structures, names and text strings */
+    mmap_stats_t mmap;    /**< Allocation stats of the mmap regions per page size and NUMA node */
+} fgen_mem_stats_t;
+
+/**
+ * Return a pointer to the data of a frame in a shared frame set.
+ *
+ * @param set
+ *   The fgen_shared_set_t pointer returned by fgen_shared_set().
+ * @param idx
+ *   Index of the frame, less than set->nb_frames.
+ * @return
+ *   Pointer to the frame data.
+ */
+static inline const void *
+fgen_shared_data(const fgen_shared_set_t *set, uint32_t idx)
+{
+    return (const char *)set + set->frames[idx].data_off;
+}
+
 /**
  * Return the packet data length.
  *
@@ -191,6 +338,8 @@ enum {
  * @param flags
  *   Flags used for debugging the frame generator object.
  *   FGEN_VERBOSE, FGEN_DUMP_DATA, ...
+ *   FGEN_ADD_FCS appends the FCS to each frame, for backends sending the raw frame with the CRC,
+ *   a frame longer than ETH_FRAME_LEN is then rejected instead of truncated.
  * @return
  *   NULL on error or Pointer to fgen_t structure on success.
  */
@@ -281,6 +430,297 @@ FGEN_API fgen_decode_t *fgen_decode_create(void);
  */
 FGEN_API int fgen_decode(fgen_decode_t *dc, void *data, uint16_t len, opt_type_t opt);
 
+/**
+ * Set the decode flags used by the next fgen_decode() calls.
+ *
+ * With FGEN_DECODE_ROUNDTRIP the text only contains fields the encoder accepts and decoding
+ * must start at FGEN_ETHER_TYPE. Lengths and checksums are regenerated by the encoder, so a
+ * layer with a length or checksum the encoder would not produce is emitted as Raw(hex=...) data.
+ * Frames must be ETH_ZLEN to ETH_FRAME_LEN bytes long. With FGEN_DECODE_FCS the frames end with
+ * the 4 byte FCS, which is left out of the text and allowed on top of ETH_FRAME_LEN, and the text
+ * encodes back exactly with a fgen_t created with FGEN_ADD_FCS.
+ *
+ * @param dc
+ *   The fgen_decode_t structure pointer.
+ * @param flags
+ *   The FGEN_DECODE_* flags to use.
+ * @return
+ *   -1 on error or 0 on success.
+ */
+FGEN_API int fgen_decode_set_flags(fgen_decode_t *dc, uint32_t flags);
+
+/**
+ * Set the number of encapsulation levels fgen_decode() follows.
+ *
+ * VXLAN, VXLAN-GPE, GRE, GTP-U, MPLS and IP in IP tunnels are decoded into the inner frame,
+ * the data after the last allowed tunnel header is decoded as payload.
+ *
+ * @param dc
+ *   The fgen_decode_t structure pointer.
+ * @param depth
+ *   The number of levels 1 to FGEN_DECODE_MAX_LEVELS, 1 does not follow tunnels.
+ * @return
+ *   -1 on error or 0 on success.
+ */
+FGEN_API int fgen_decode_set_depth(fgen_decode_t *dc, int depth);
+
+/**
+ * Return the number of encapsulation levels found by the last fgen_decode() call.
+ *
+ * @param dc
+ *   The fgen_decode_t structure pointer.
+ * @return
+ *   -1 on error or the number of levels.
+ */
+FGEN_API int fgen_decode_levels(fgen_decode_t *dc);
+
+/**
+ * Return the header offsets of one encapsulation level found by the last fgen_decode() call.
+ *
+ * @param dc
+ *   The fgen_decode_t structure pointer.
+ * @param level
+ *   The level to return, 0 is the outer frame.
+ * @param off
+ *   The location to place the offsets.
+ * @return
+ *   -1 on error or 0 on success.
+ */
+FGEN_API int fgen_decode_offsets(fgen_decode_t *dc, int level, fgen_decode_offsets_t *off);
+
+/**
+ * Setup the one line summary decode used by fgen_decode_summary().
+ *
+ * The format is text with the field names ts, proto, src, sport, dst, dport, len and flags,
+ * each field is padded to a fixed width and any other text is copied as is. The format is
+ * compiled once and the lines are collected in an output buffer, which is written to the file
+ * descriptor when it is nearly full or fgen_decode_flush() is called. The summary and emit modes
+ * share one output buffer, the last one setup selects the file descriptor.
+ *
+ * @param dc
+ *   The fgen_decode_t structure pointer.
+ * @param fmt
+ *   The summary line format or NULL for FGEN_DECODE_SUMMARY_FMT.
+ * @param fd
+ *   The file descriptor to write the summary lines.
+ * @param buf_size
+ *   The size of the output buffer or zero for FGEN_DECODE_OUT_BUF_SIZE.
+ * @return
+ *   -1 on error or 0 on success.
+ */
+FGEN_API int fgen_decode_set_summary(fgen_decode_t *dc, const char *fmt, int fd, uint32_t buf_size);
+
+/**
+ * Decode a frame into one summary line in the output buffer.
+ *
+ * The addresses, ports and protocol are taken from the innermost IP header found.
+ *
+ * @param dc
+ *   The fgen_decode_t structure pointer, setup with fgen_decode_set_summary().
+ * @param data
+ *   The frame data pointer, must start with the Ethernet header.
+ * @param len
+ *   The length of the data to decode.
+ * @param ts
+ *   The timestamp of the frame in nanoseconds.
+ * @return
+ *   -1 on error or length of the summary line.
+ */
+FGEN_API int fgen_decode_summary(fgen_decode_t *dc, void *data, uint16_t len, uint64_t ts);
+
+/**
+ * Setup the JSON Lines or CBOR emitter used by fgen_decode_emit().
+ *
+ * Each frame is written as one record with the timestamp, the frame length and an array of the
+ * headers found. A header has its type, encapsulation level, offset and fields. A JSON record is
+ * one line and a CBOR record is an indefinite length map in a CBOR sequence (RFC 8742), with
+ * the MAC and IP addresses as byte strings. The record is streamed into the output buffer and
+ * is never built in memory.
+ *
+ * @param dc
+ *   The fgen_decode_t structure pointer.
+ * @param type
+ *   The format to emit, FGEN_EMIT_JSON or FGEN_EMIT_CBOR.
+ * @param fd
+ *   The file descriptor to write the records.
+ * @param buf_size
+ *   The size of the output buffer or zero for FGEN_DECODE_OUT_BUF_SIZE.
+ * @return
+ *   -1 on error or 0 on success.
+ */
+FGEN_API int fgen_decode_set_emit(fgen_decode_t *dc, fgen_emit_t type, int fd, uint32_t buf_size);
+
+/**
+ * Decode a frame and emit one JSON or CBOR record into the output buffer.
+ *
+ * @param dc
+ *   The fgen_decode_t structure pointer, setup with fgen_decode_set_emit().
+ * @param data
+ *   The frame data pointer, must start with the Ethernet header.
+ * @param len
+ *   The length of the data to decode.
+ * @param ts
+ *   The timestamp of the frame in nanoseconds.
+ * @return
+ *   -1 on error or 0 on success.
+ */
+FGEN_API int fgen_decode_emit(fgen_decode_t *dc, void *data, uint16_t len, uint64_t ts);
+
+/**
+ * Write the summary lines or records in the output buffer to the file descriptor.
+ *
+ * @param dc
+ *   The fgen_decode_t structure pointer.
+ * @return
+ *   -1 on error or 0 on success.
+ */
+FGEN_API int fgen_decode_flush(fgen_decode_t *dc);
+
+/**
+ * Create the 64 bit fingerprint of a frame ignoring the volatile fields.
+ *
+ * The headers are found as fgen_decode() would with the same depth, the fields selected by the
+ * mask are cleared and the frame is hashed with CRC32c. Frames with the same fingerprint are
+ * almost certainly the same once the masked fields are ignored.
+ *
+ * @param dc
+ *   The fgen_decode_t structure pointer.
+ * @param data
+ *   The frame data pointer, starting at the Ethernet header.
+ * @param len
+ *   The length of the frame.
+ * @param mask
+ *   The FGEN_FP_* fields to ignore.
+ * @param fp
+ *   The location to return the fingerprint.
+ * @return
+ *   -1 on error or 0 on success.
+ */
+FGEN_API int fgen_decode_fingerprint(fgen_decode_t *dc, void *data, uint16_t len, uint32_t mask,
+                                     uint64_t *fp);
+
+/**
+ * Create a dedup table to find the unique frames in a stream.
+ *
+ * @param mask
+ *   The FGEN_FP_* fields ignored when comparing frames.
+ * @return
+ *   NULL on error or the dedup table pointer.
+ */
+FGEN_API fgen_dedup_t *fgen_dedup_create(uint32_t mask);
+
+/**
+ * Add frames to a dedup table.
+ *
+ * A frame matching an entry only updates the count, otherwise it is copied as a new exemplar.
+ * A match with a lower first index replaces the exemplar, so per thread tables can be merged in
+ * any order and still keep the first frame seen.
+ *
+ * @param dd
+ *   The fgen_dedup_t pointer.
+ * @param data
+ *   The frame data pointer, starting at the Ethernet header.
+ * @param len
+ *   The length of the frame.
+ * @param count
+ *   The number of frames represented, normally 1.
+ * @param first
+ *   The index of the frame in the stream.
+ * @return
+ *   -1 on error or the index of the entry.
+ */
+FGEN_API int fgen_dedup_add(fgen_dedup_t *dd, const void *data, uint16_t len, uint64_t count,
+                            uint64_t first);
+
+/**
+ * Return the number of entries in a dedup table.
+ *
+ * @param dd
+ *   The fgen_dedup_t pointer.
+ * @return
+ *   -1 on error or the number of entries.
+ */
+FGEN_API int fgen_dedup_count(fgen_dedup_t *dd);
+
+/**
+ * Return an entry of a dedup table, entries are in the order first added.
+ *
+ * @param dd
+ *   The fgen_dedup_t pointer.
+ * @param idx
+ *   The index of the entry, 0 to fgen_dedup_count() - 1.
+ * @param ent
+ *   The location to return the entry.
+ * @return
+ *   -1 on error or 0 on success.
+ */
+FGEN_API int fgen_dedup_entry(fgen_dedup_t *dd, int idx, fgen_dedup_entry_t *ent);
+
+/**
+ * Free a dedup table and the exemplar frames.
+ *
+ * @param dd
+ *   The fgen_dedup_t pointer.
+ */
+FGEN_API void fgen_dedup_destroy(fgen_dedup_t *dd);
+
+/**
+ * Create a compare template used to check received frames.
+ *
+ * The template headers are found as fgen_decode() would and the fields selected by the mask,
+ * e.g. FGEN_FP_TTL | FGEN_FP_CKSUM | FGEN_FP_TSC, are ignored by fgen_compare(). More bytes can
+ * be ignored with fgen_compare_ignore().
+ *
+ * @param data
+ *   The template frame data, normally fbuf_mtod() of a frame_t.
+ * @param len
+ *   The length of the template frame.
+ * @param mask
+ *   The FGEN_FP_* fields to ignore.
+ * @return
+ *   NULL on error or the compare template pointer.
+ */
+FGEN_API fgen_compare_t *fgen_compare_create(const void *data, uint16_t len, uint32_t mask);
+
+/**
+ * Ignore a range of bytes in the template, e.g. a field changed by the device under test.
+ *
+ * @param cmp
+ *   The fgen_compare_t pointer.
+ * @param off
+ *   The offset of the first byte to ignore.
+ * @param len
+ *   The number of bytes to ignore.
+ * @return
+ *   -1 on error or 0 on success.
+ */
+FGEN_API int fgen_compare_ignore(fgen_compare_t *cmp, uint16_t off, uint16_t len);
+
+/**
+ * Compare a frame to the template.
+ *
+ * @param cmp
+ *   The fgen_compare_t pointer.
+ * @param data
+ *   The frame data pointer.
+ * @param len
+ *   The length of the frame, a different length from the template is a difference.
+ * @param res
+ *   If not NULL the first difference is returned when the frames differ.
+ * @return
+ *   -1 on error, 0 if the frame matches or 1 if the frame differs.
+ */
+FGEN_API int fgen_compare(fgen_compare_t *cmp, const void *data, uint16_t len,
+                          fgen_compare_result_t *res);
+
+/**
+ * Free a compare template.
+ *
+ * @param cmp
+ *   The fgen_compare_t pointer.
+ */
+FGEN_API void fgen_compare_destroy(fgen_compare_t *cmp);
+
 /**
  * Free the unparse information.
  *
@@ -302,6 +742,9 @@ FGEN_API const char *fgen_decode_text(fgen_decode_t *dc);
 /**
  * Decode a raw hex dump like string into a binary format.
  *
+ * Hex digit pairs can be split by white space or ':', '-' and ',' characters, see
+ * fgen_hex_parse(). The text offset of an invalid character is logged on error.
+ *
  * @param text
  *   The raw hex dump text string, must be NULL terminated.
  * @param buffer
@@ -347,6 +790,48 @@ FGEN_API frame_t *fgen_find_frame(fgen_t *fg, const char *name);
  */
 FGEN_API frame_t *fgen_next_frame(fgen_t *fg, frame_t *prev);
 
+/**
+ * Return the memory used by the frames of a frame generator object and by the mmap regions.
+ *
+ * The metadata bytes are the sizes of the heap blocks as reported by malloc_usable_size(), the
+ * stats are a snapshot and not updated as frames are added.
+ *
+ * @param fg
+ *   The fgen_t pointer returned from fgen_create() or NULL for only the mmap stats.
+ * @param stats
+ *   The fgen_mem_stats_t structure to fill in.
+ * @return
+ *   0 on success or -1 on error
+ */
+FGEN_API int fgen_mem_stats(fgen_t *fg, fgen_mem_stats_t *stats);
+
+/**
+ * Compile the frames into a shared region other processes can map read-only.
+ *
+ * The region is published once the frames are copied, see mmap_shared_create() for the names
+ * and page sizes.
+ *
+ * @param fg
+ *   The fgen_t pointer returned from fgen_create().
+ * @param name
+ *   Name of the shared region or NULL for an anonymous memfd.
+ * @param hugepage
+ *   Type of hugepage memory to allocate or non-hugepage memory.
+ * @return
+ *   The mmap_t pointer of the region or NULL on error
+ */
+FGEN_API mmap_t *fgen_share(fgen_t *fg, const char *name, mmap_type_t hugepage);
+
+/**
+ * Return the frame set in a shared region.
+ *
+ * @param mm
+ *   The mmap_t pointer from fgen_share(), mmap_shared_attach() or mmap_shared_attach_fd().
+ * @return
+ *   The fgen_shared_set_t pointer or NULL if the region does not hold a valid frame set
+ */
+FGEN_API const fgen_shared_set_t *fgen_shared_set(mmap_t *mm);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,328 @@
+/* SPDX-License-Identifier: BSD-3-Clause
+ * Copyright(c) 2023-2025 Intel Corporation
+ */
+
+#include <stdint.h>        // for uint64_t, uint32_t, uint16_t, uint8_t
+#include <stdbool.h>
+#include <stdlib.h>        // for calloc, realloc, free
+#include <string.h>        // for memcpy, memset
+#include <stddef.h>        // for offsetof
+#if defined(__SSE4_2__)
+#include <nmmintrin.h>        // for _mm_crc32_u64
+#endif
+
+#include <fgen_common.h>
+#include <fgen_log.h>
+#include <net/fgen_ip.h>
+#include <net/fgen_udp.h>
+#include <net/fgen_tcp.h>
+#include <crc32.h>
+#include <salloc.h>
+
+#include "fgen.h"
+#include "decode.h"
+
+/*
+ * Frame fingerprints and the dedup table. The volatile fields of a frame are cleared by a byte
+ * mask built from the headers found by the decoder, the masked frame is hashed with two CRC32c
+ * lanes, one over the 8 byte words from the front and one from the back, to give 64 bits.
+ */
+
+#define FP_SEED_FRONT 0x9E3779B9 /**< Seed of the CRC32c lane over the words from the front */
+#define FP_SEED_BACK  0x85EBCA6B /**< Seed of the CRC32c lane over the words from the back */
+
+#define DEDUP_MIN_ENTRIES 1024 /**< Initial number of entries in a dedup table */
+
+typedef struct dedup_entry_s {
+    uint64_t fp;     /**< Fingerprint of the exemplar */
+    uint64_t count;  /**< Number of frames matching the exemplar */
+    uint64_t first;  /**< Index of the first frame seen */
+    offset_t off;    /**< Offset of the exemplar data in the salloc memory */
+    uint16_t len;    /**< Length of the exemplar */
+} dedup_entry_t;
+
+typedef struct dedup_s {
+    uint32_t mask;          /**< FGEN_FP_* fields masked in the fingerprint */
+    uint32_t nb_entries;    /**< Number of exemplars */
+    uint32_t max_entries;   /**< Size of the entries array */
+    uint32_t idx_size;      /**< Size of the index, always a power of 2 */
+    uint32_t *idx;          /**< Open addressing index, entry number + 1 or 0 if free */
+    dedup_entry_t *entries; /**< Exemplars in the order first added */
+    salloc_t *data;         /**< Exemplar frame data */
+    decode_t *dc;           /**< Decoder used to find the headers */
+    uint8_t bytes[FGEN_MAX_FRAME_SIZE]; /**< Byte mask of the current frame */
+} dedup_t;
+
+static inline void
+_mask_clear(uint8_t *bytes, uint16_t len, uint16_t off, uint16_t n)
+{
+    if (off < len)
+        memset(&bytes[off], 0, ((off + n) <= len) ? n : len - off);
+}
+
+int
+decode_mask(decode_t *dc, uint32_t mask, uint8_t *bytes)
+{
+    uint16_t len = decode_len(dc);
+
+    memset(bytes, 0xFF, len);
+
+    for (int i = 0; i < dc->nb_layers; i++) {
+        decode_layer_t *l = &dc->layers[i];
+
+        switch (l->type) {
+        case DECODE_IPV4:
+            if (mask & FGEN_FP_IP_ID)
+                _mask_clear(bytes, len, l->off + offsetof(struct fgen_ipv4_hdr, packet_id), 2);
+            if (mask & FGEN_FP_TTL)
+                _mask_clear(bytes, len, l->off + offsetof(struct fgen_ipv4_hdr, time_to_live), 1);
+            if (mask & FGEN_FP_CKSUM)
+                _mask_clear(bytes, len, l->off + offsetof(struct fgen_ipv4_hdr, hdr_checksum), 2);
+            break;
+        case DECODE_IPV6:
+            if (mask & FGEN_FP_TTL)
+                _mask_clear(bytes, len, l->off + offsetof(struct fgen_ipv6_hdr, hop_limits), 1);
+            break;
+        case DECODE_UDP:
+            if (mask & FGEN_FP_CKSUM)
+                _mask_clear(bytes, len, l->off + offsetof(struct fgen_udp_hdr, dgram_cksum), 2);
+            break;
+        case DECODE_TCP:
+            if (mask & FGEN_FP_TCP_SEQ)
+                _mask_clear(bytes, len, l->off + offsetof(struct fgen_tcp_hdr, sent_seq), 8);
+            if (mask & FGEN_FP_CKSUM)
+                _mask_clear(bytes, len, l->off + offsetof(struct fgen_tcp_hdr, cksum), 2);
+            break;
+        case DECODE_TSC:
+            if (mask & FGEN_FP_TSC)
+                _mask_clear(bytes, len, l->off + offsetof(tsc_t, tsc_val), sizeof(uint64_t));
+            break;
+        case DECODE_SEQ:
+            if (mask & FGEN_FP_SEQ)
+                _mask_clear(bytes, len, l->off + offsetof(seq_t, seq), sizeof(uint64_t));
+            break;
+        case DECODE_PAYLOAD:
+            if (mask & FGEN_FP_PAYLOAD)
+                _mask_clear(bytes, len, l->off, l->len);
+            break;
+        default:
+            break;
+        }
+    }
+
+    return 0;
+}
+
+static inline uint32_t
+_fp_crc(uint32_t crc, uint64_t v)
+{
+#if defined(__SSE4_2__)
+    return _mm_crc32_u64(crc, v);
+#else
+    return calculate_crc32c(crc, (const unsigned char *)&v, sizeof(v));
+#endif
+}
+
+static inline uint64_t
+_fp_word(const uint8_t *data, const uint8_t *bytes, int off, int len)
+{
+    uint64_t d = 0, m = 0;
+    int n      = ((len - off) < 8) ? len - off : 8;
+
+    memcpy(&d, &data[off], n);
+    memcpy(&m, &bytes[off], n);
+
+    return d & m;
+}
+
+static uint64_t
+_fp_hash(const uint8_t *data, const uint8_t *bytes, int len)
+{
+    uint32_t front = FP_SEED_FRONT ^ len, back = FP_SEED_BACK ^ len;
+    int last       = (len - 1) & ~7;
+
+    for (int off = 0; off < len; off += 8) {
+        front = _fp_crc(front, _fp_word(data, bytes, off, len));
+        back  = _fp_crc(back, _fp_word(data, bytes, last - off, len));
+    }
+
+    return ((uint64_t)front << 32) | back;
+}
+
+int
+fgen_decode_fingerprint(fgen_decode_t *_dc, void *data, uint16_t len, uint32_t mask, uint64_t *fp)
+{
+    decode_t *dc = _dc;
+    uint8_t bytes[FGEN_MAX_FRAME_SIZE];
+
+    if (!dc || !data || !fp || len == 0 || len > FGEN_MAX_FRAME_SIZE)
+        return -1;
+
+    if (decode_headers(dc, data, len, FGEN_ETHER_TYPE) < 0 || decode_mask(dc, mask, bytes) < 0)
+        return -1;
+
+    *fp = _fp_hash(data, bytes, len);
+
+    return 0;
+}
+
+/* Compare a frame to an exemplar with the frame byte mask */
+static bool
+_dedup_match(const uint8_t *a, const uint8_t *b, const uint8_t *bytes, uint16_t len)
+{
+    for (int off = 0; off < len; off += 8) {
+        if (_fp_word(a, bytes, off, len) != _fp_word(b, bytes, off, len))
+            return false;
+    }
+    return true;
+}
+
+static int
+_dedup_grow(dedup_t *dd)
+{
+    uint32_t nsize = dd->idx_size * 2;
+    uint32_t *idx;
+    dedup_entry_t *e;
+
+    e = realloc(dd->entries, (nsize / 2) * sizeof(dedup_entry_t));
+    if (!e)
+        FGEN_ERR_RET("Unable to grow dedup entries to %u\n", nsize / 2);
+    dd->entries     = e;
+    dd->max_entries = nsize / 2;
+
+    idx = calloc(nsize, sizeof(uint32_t));
+    if (!idx)
+        FGEN_ERR_RET("Unable to grow dedup index to %u\n", nsize);
+
+    for (uint32_t i = 0; i < dd->nb_entries; i++) {
+        uint32_t h;
+
+        for (h = dd->entries[i].fp & (nsize - 1); idx[h]; h = (h + 1) & (nsize - 1))
+            ;
+        idx[h] = i + 1;
+    }
+    free(dd->idx);
+    dd->idx      = idx;
+    dd->idx_size = nsize;
+
+    return 0;
+}
+
+fgen_dedup_t *
+fgen_dedup_create(uint32_t mask)
+{
+    dedup_t *dd;
+
+    dd = calloc(1, sizeof(dedup_t));
+    if (!dd)
+        return NULL;
+
+    dd->mask        = mask;
+    dd->idx_size    = DEDUP_MIN_ENTRIES * 2;
+    dd->max_entries = DEDUP_MIN_ENTRIES;
+    dd->idx         = calloc(dd->idx_size, sizeof(uint32_t));
+    dd->entries     = calloc(dd->max_entries, sizeof(dedup_entry_t));
+    dd->data        = salloc_create(0);
+    dd->dc          = fgen_decode_create();
+    if (!dd->idx || !dd->entries || !dd->data || !dd->dc) {
+        fgen_dedup_destroy(dd);
+        return NULL;
+    }
+
+    return dd;
+}
+
+int
+fgen_dedup_add(fgen_dedup_t *_dd, const void *data, uint16_t len, uint64_t count, uint64_t first)
+{
+    dedup_t *dd = _dd;
+    dedup_entry_t *e;
+    uint64_t fp;
+    offset_t off;
+    uint32_t h;
+
+    if (!dd || !data || len == 0 || len > FGEN_MAX_FRAME_SIZE)
+        return -1;
+
+    if (decode_headers(dd->dc, (void *)(uintptr_t)data, len, FGEN_ETHER_TYPE) < 0 ||
+        decode_mask(dd->dc, dd->mask, dd->bytes) < 0)
+        return -1;
+    fp = _fp_hash(data, dd->bytes, len);
+
+    for (h = fp & (dd->idx_size - 1); dd->idx[h]; h = (h + 1) & (dd->idx_size - 1)) {
+        e = &dd->entries[dd->idx[h] - 1];
+
+        if (e->fp == fp && e->len == len &&
+            _dedup_match(data, salloc_ptr(dd->data, e->off), dd->bytes, len)) {
+            /* Keep the exemplar of the first frame seen when merging tables */
+            if (first < e->first) {
+                memcpy(salloc_ptr(dd->data, e->off), data, len);
+                e->first = first;
+            }
+            e->count += count;
+            return dd->idx[h] - 1;
+        }
+    }
+
+    if (dd->nb_entries >= dd->max_entries) {
+        if (_dedup_grow(dd) < 0)
+            return -1;
+        for (h = fp & (dd->idx_size - 1); dd->idx[h]; h = (h + 1) & (dd->idx_size - 1))
+            ;
+    }
+
+    if (salloc(dd->data, len, &off) < 0)
+        FGEN_ERR_RET("Unable to allocate %u bytes for a dedup exemplar\n", len);
+    memcpy(salloc_ptr(dd->data, off), data, len);
+
+    e        = &dd->entries[dd->nb_entries];
+    e->fp    = fp;
+    e->count = count;
+    e->first = first;
+    e->off   = off;
+    e->len   = len;
+    dd->idx[h] = ++dd->nb_entries;
+
+    return dd->nb_entries - 1;
+}
+
+int
+fgen_dedup_count(fgen_dedup_t *_dd)
+{
+    dedup_t *dd = _dd;
+
+    return (dd) ? (int)dd->nb_entries : -1;
+}
+
+int
+fgen_dedup_entry(fgen_dedup_t *_dd, int idx, fgen_dedup_entry_t *ent)
+{
+    dedup_t *dd = _dd;
+    dedup_entry_t *e;
+
+    if (!dd || !ent || idx < 0 || (uint32_t)idx >= dd->nb_entries)
+        return -1;
+
+    e          = &dd->entries[idx];
+    ent->data  = salloc_ptr(dd->data, e->off);
+    ent->len   = e->len;
+    ent->fp    = e->fp;
+    ent->count = e->count;
+    ent->first = e->first;
+
+    return 0;
+}
+
+void
+fgen_dedup_destroy(fgen_dedup_t *_dd)
+{
+    dedup_t *dd = _dd;
+
+    if (dd) {
+        fgen_decode_destroy(dd->dc);
+        salloc_destroy(dd->data);
+        free(dd->entries);
+        free(dd->idx);
+        free(dd);
+    }
+}
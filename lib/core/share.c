@@ -0,0 +1,95 @@
+/* SPDX-License-Identifier: BSD-3-Clause
+ * Copyright(c) 2023-2025 Intel Corporation
+ */
+
+#include <stdint.h>        // for uint32_t, uint64_t
+#include <stdio.h>         // for snprintf
+#include <string.h>        // for memcpy
+#include <sys/queue.h>     // for TAILQ_FOREACH
+
+#include <fgen_common.h>
+#include <fgen_log.h>
+#include <fgen_mmap.h>
+
+#include "fgen.h"
+
+/*
+ * Compile the frames into one block: the set header and frame table followed by the frame data,
+ * each frame cache line aligned. The offsets are from the start of the block, so processes which
+ * map the region at different addresses use the same set without fixing up pointers.
+ */
+
+mmap_t *
+fgen_share(fgen_t *fg, const char *name, mmap_type_t hugepage)
+{
+    fgen_shared_set_t *set;
+    frame_t *f;
+    mmap_t *mm;
+    uint64_t size;
+    uint32_t i;
+
+    if (!fg || fgen_fcnt(fg) == 0)
+        FGEN_NULL_RET("No frames to share\n");
+
+    size = FGEN_CACHE_LINE_ROUNDUP(sizeof(*set) + fgen_fcnt(fg) * sizeof(fgen_shared_frame_t));
+    TAILQ_FOREACH (f, &fg->head, next)
+        size += FGEN_CACHE_LINE_ROUNDUP(fbuf_data_len(f));
+    if (size > UINT32_MAX)
+        FGEN_NULL_RET("Frame set of %'lu bytes is too large\n", size);
+
+    mm = mmap_shared_create(name, 1, (uint32_t)size, hugepage);
+    if (!mm)
+        FGEN_NULL_RET("Failed to create shared region for %u frames\n", fgen_fcnt(fg));
+
+    set            = mmap_addr(mm);
+    set->magic     = FGEN_SHARED_MAGIC;
+    set->nb_frames = fgen_fcnt(fg);
+    set->size      = size;
+
+    size = FGEN_CACHE_LINE_ROUNDUP(sizeof(*set) + fgen_fcnt(fg) * sizeof(fgen_shared_frame_t));
+    i    = 0;
+    TAILQ_FOREACH (f, &fg->head, next) {
+        fgen_shared_frame_t *sf = &set->frames[i++];
+
+        snprintf(sf->name, sizeof(sf->name), "%s", f->name);
+        sf->data_off = size;
+        sf->data_len = fbuf_data_len(f);
+        sf->tsc_off  = f->tsc_off;
+        sf->seq_off  = f->seq_off;
+        sf->l2       = f->l2;
+        sf->l3       = f->l3;
+        sf->l4       = f->l4;
+        memcpy(FGEN_PTR_ADD(set, size), fbuf_mtod(f, void *), sf->data_len);
+
+        size += FGEN_CACHE_LINE_ROUNDUP(sf->data_len);
+    }
+
+    if (mmap_shared_publish(mm) < 0) {
+        mmap_free(mm);
+        if (name)
+            mmap_shared_unlink(name);
+        FGEN_NULL_RET("Failed to publish the frame set\n");
+    }
+
+    return mm;
+}
+
+const fgen_shared_set_t *
+fgen_shared_set(mmap_t *mm)
+{
+    const fgen_shared_set_t *set = mmap_addr(mm);
+    size_t sz                    = mmap_size(mm, NULL, NULL);
+
+    if (!set || sz < sizeof(*set) || set->magic != FGEN_SHARED_MAGIC || set->size > sz ||
+        sizeof(*set) + (uint64_t)set->nb_frames * sizeof(fgen_shared_frame_t) > set->size)
+        FGEN_NULL_RET("Region does not hold a frame set\n");
+
+    for (uint32_t i = 0; i < set->nb_frames; i++) {
+        const fgen_shared_frame_t *sf = &set->frames[i];
+
+        if ((uint64_t)sf->data_off + sf->data_len > set->size)
+            FGEN_NULL_RET("Frame %u of the set is out of range\n", i);
+    }
+
+    return set;
+}
@@ -0,0 +1,442 @@
+/* SPDX-License-Identifier: BSD-3-Clause
+ * Copyright(c) 2023-2025 Intel Corporation
+ */
+
+#include <stdint.h>        // for uint32_t, uint16_t, uint8_t, uint64_t
+#include <stdbool.h>
+#include <stdlib.h>        // for calloc, free
+#include <string.h>        // for memcpy, memset, strlen
+#include <ctype.h>         // for isalnum
+#include <netinet/in.h>        // for ntohs, IPPROTO_*
+#include <arpa/inet.h>         // for inet_ntop
+#include <net/ethernet.h>      // for ether_header
+
+#include <fgen_common.h>
+#include <fgen_log.h>
+#include <net/fgen_ether.h>
+#include <net/fgen_ip.h>
+#include <net/fgen_udp.h>
+#include <net/fgen_tcp.h>
+
+#include "fgen.h"
+#include "decode.h"
+
+/*
+ * Summary decode mode, one fixed width line per frame. The format string is compiled once into
+ * a list of field and literal operations, each line is formatted by hand into the decoder
+ * output buffer which is written to the file descriptor only when it is nearly full.
+ */
+
+#define SUM_MAX_OPS   32  /**< Max number of fields and literals in a format */
+#define SUM_MAX_FMT   256 /**< Max length of a format string */
+#define SUM_FIELD_LEN 64  /**< Max length of one formatted field */
+
+enum {
+    SUM_LITERAL, /**< Text copied from the format string */
+    SUM_TS,      /**< Timestamp in seconds and microseconds */
+    SUM_PROTO,   /**< L4 protocol name, or the ethertype without an IP header */
+    SUM_SRC,     /**< Source IP address */
+    SUM_SPORT,   /**< Source port */
+    SUM_DST,     /**< Destination IP address */
+    SUM_DPORT,   /**< Destination port */
+    SUM_LEN,     /**< Frame length */
+    SUM_FLAGS,   /**< TCP flags */
+};
+
+typedef struct sum_field_s {
+    const char *name; /**< Name of the field in the format string */
+    uint8_t type;     /**< SUM_* field type */
+    uint8_t width;    /**< Fixed width of the field */
+    bool right;       /**< Right align the field in its width */
+} sum_field_t;
+
+// clang-format off
+static const sum_field_t sum_fields[] = {
+    {"ts",    SUM_TS,    17, true},
+    {"proto", SUM_PROTO, 6,  false},
+    {"src",   SUM_SRC,   15, true},
+    {"sport", SUM_SPORT, 5,  false},
+    {"dst",   SUM_DST,   15, true},
+    {"dport", SUM_DPORT, 5,  false},
+    {"len",   SUM_LEN,   5,  false},
+    {"flags", SUM_FLAGS, 8,  false},
+};
+// clang-format on
+
+typedef struct sum_op_s {
+    uint8_t type;  /**< SUM_* operation type */
+    uint8_t width; /**< Fixed width of a field */
+    bool right;    /**< Right align the field */
+    uint16_t len;  /**< Length of a literal */
+    uint16_t off;  /**< Offset of a literal in the format text */
+} sum_op_t;
+
+typedef struct decode_summary_s {
+    uint32_t max_line;         /**< Max length of a line with the format */
+    char *fmt;                 /**< Copy of the format text for the literals */
+    int nops;                  /**< Number of operations */
+    sum_op_t ops[SUM_MAX_OPS]; /**< Compiled format */
+} decode_summary_t;
+
+/* Header fields of the innermost level with an IP header */
+typedef struct sum_info_s {
+    int af;              /**< AF_INET, AF_INET6 or 0 without an IP header */
+    const void *src;     /**< Source address */
+    const void *dst;     /**< Destination address */
+    uint16_t ether_type; /**< Ethertype of the outer frame */
+    uint8_t proto;       /**< IP protocol */
+    bool ports;          /**< Source and destination ports are valid */
+    uint16_t sport;      /**< Source port */
+    uint16_t dport;      /**< Destination port */
+    int tcp_flags;       /**< TCP flags or -1 if not TCP */
+} sum_info_t;
+
+/* Return the sum_fields index of a field name starting at p or -1 */
+static int
+_sum_field(const char *fmt, const char *p)
+{
+    int n;
+
+    /* A field name must be a whole word */
+    if (p > fmt && isalnum(p[-1]))
+        return -1;
+
+    for (int i = 0; i < (int)fgen_countof(sum_fields); i++) {
+        n = strlen(sum_fields[i].name);
+        if (!strncmp(p, sum_fields[i].name, n) && !isalnum(p[n]))
+            return i;
+    }
+
+    return -1;
+}
+
+static int
+_sum_compile(decode_summary_t *sum, const char *fmt)
+{
+    const char *p = fmt;
+    sum_op_t *op;
+    int i;
+
+    sum->nops     = 0;
+    sum->max_line = strlen(fmt) + 1;
+    while (*p) {
+        if (sum->nops >= SUM_MAX_OPS)
+            FGEN_ERR_RET("Summary format '%s' has more than %d fields\n", fmt, SUM_MAX_OPS);
+        op = &sum->ops[sum->nops++];
+
+        i = _sum_field(fmt, p);
+        if (i >= 0) {
+            op->type  = sum_fields[i].type;
+            op->width = sum_fields[i].width;
+            op->right = sum_fields[i].right;
+            p += strlen(sum_fields[i].name);
+            sum->max_line += SUM_FIELD_LEN;
+            continue;
+        }
+
+        /* Literal text up to the next field name */
+        op->type = SUM_LITERAL;
+        op->off  = p - fmt;
+        do {
+            p++;
+        } while (*p && _sum_field(fmt, p) < 0);
+        op->len = (p - fmt) - op->off;
+    }
+
+    return 0;
+}
+
+static void
+_sum_info(decode_t *dc, sum_info_t *si)
+{
+    fgen_decode_offsets_t *off = NULL;
+    struct fgen_ipv4_hdr *ip4;
+    struct fgen_ipv6_hdr *ip6;
+    struct fgen_udp_hdr *udp;
+    struct fgen_tcp_hdr *tcp;
+    struct ether_header *eth;
+
+    memset(si, 0, sizeof(*si));
+    si->tcp_flags = -1;
+
+    if (dc->offs[0].l2 >= 0) {
+        eth            = decode_mtod_offset(dc, struct ether_header *, dc->offs[0].l2);
+        si->ether_type = ntohs(eth->ether_type);
+    }
+
+    for (int l = dc->level; l >= 0; l--) {
+        if (dc->offs[l].l3 >= 0) {
+            off = &dc->offs[l];
+            break;
+        }
+    }
+    if (!off)
+        return;
+
+    ip4 = decode_mtod_offset(dc, struct fgen_ipv4_hdr *, off->l3);
+    if ((ip4->version_ihl >> 4) == 4) {
+        si->af    = AF_INET;
+        si->src   = &ip4->src_addr;
+        si->dst   = &ip4->dst_addr;
+        si->proto = ip4->next_proto_id;
+    } else {
+        ip6       = (struct fgen_ipv6_hdr *)ip4;
+        si->af    = AF_INET6;
+        si->src   = ip6->src_addr;
+        si->dst   = ip6->dst_addr;
+        si->proto = ip6->proto;
+    }
+
+    if (off->l4 < 0)
+        return;
+
+    /* The ports are in the same place for UDP and TCP */
+    udp       = decode_mtod_offset(dc, struct fgen_udp_hdr *, off->l4);
+    si->ports = true;
+    si->sport = ntohs(udp->src_port);
+    si->dport = ntohs(udp->dst_port);
+
+    if (si->proto == IPPROTO_TCP) {
+        tcp           = (struct fgen_tcp_hdr *)udp;
+        si->tcp_flags = tcp->tcp_flags;
+    }
+}
+
+static inline char *
+_sum_u64(char *p, uint64_t v, int digits)
+{
+    char tmp[24];
+    int n = 0;
+
+    do {
+        tmp[n++] = '0' + (v % 10);
+        v /= 10;
+    } while (v || n < digits);
+
+    while (n)
+        *p++ = tmp[--n];
+
+    return p;
+}
+
+static char *
+_sum_addr(char *p, int af, const void *addr)
+{
+    const uint8_t *a = addr;
+
+    if (af == AF_INET) {
+        for (int i = 0; i < 4; i++) {
+            if (i)
+                *p++ = '.';
+            p = _sum_u64(p, a[i], 1);
+        }
+    } else if (af == AF_INET6) {
+        inet_ntop(AF_INET6, addr, p, INET6_ADDRSTRLEN);
+        p += strlen(p);
+    } else
+        *p++ = '-';
+
+    return p;
+}
+
+/* tcpdump style flags, '.' is the ACK flag */
+static char *
+_sum_tcp_flags(char *p, int flags)
+{
+    static const char names[] = "FSRP.UEW";
+
+    if (flags < 0)
+        return p;
+
+    *p++ = '[';
+    for (int i = 1; i < 8; i++) {
+        if (flags & (1 << i))
+            *p++ = names[i];
+    }
+    if (flags & 1)
+        *p++ = names[0];
+    *p++ = ']';
+
+    return p;
+}
+
+static char *
+_sum_proto(char *p, sum_info_t *si)
+{
+    const char *name = NULL;
+    int n;
+
+    if (!si->af) {
+        memcpy(p, "0x", 2);
+        p += 2;
+        for (int s = 12; s >= 0; s -= 4)
+            *p++ = "0123456789abcdef"[(si->ether_type >> s) & 0xF];
+        return p;
+    }
+
+    switch (si->proto) {
+    case IPPROTO_TCP:
+        name = FGEN_TCP_STR;
+        break;
+    case IPPROTO_UDP:
+        name = FGEN_UDP_STR;
+        break;
+    case IPPROTO_ICMP:
+        name = "ICMP";
+        break;
+    case IPPROTO_ICMPV6:
+        name = "ICMP6";
+        break;
+    case IPPROTO_GRE:
+        name = "GRE";
+        break;
+    default:
+        return _sum_u64(p, si->proto, 1);
+    }
+
+    n = strlen(name);
+    memcpy(p, name, n);
+
+    return p + n;
+}
+
+/* Format one line into buf and return the length */
+static int
+_sum_format(decode_t *dc, char *buf, uint64_t ts)
+{
+    decode_summary_t *sum = dc->sum;
+    char fld[SUM_FIELD_LEN];
+    sum_info_t si;
+    char *p = buf, *e;
+    int n, pad;
+
+    _sum_info(dc, &si);
+
+    for (int i = 0; i < sum->nops; i++) {
+        sum_op_t *op = &sum->ops[i];
+
+        e = fld;
+        switch (op->type) {
+        case SUM_LITERAL:
+            memcpy(p, &sum->fmt[op->off], op->len);
+            p += op->len;
+            continue;
+        case SUM_TS:
+            e    = _sum_u64(e, ts / 1000000000UL, 1);
+            *e++ = '.';
+            e    = _sum_u64(e, (ts % 1000000000UL) / 1000, 6);
+            break;
+        case SUM_PROTO:
+            e = _sum_proto(e, &si);
+            break;
+        case SUM_SRC:
+            e = _sum_addr(e, si.af, si.src);
+            break;
+        case SUM_DST:
+            e = _sum_addr(e, si.af, si.dst);
+            break;
+        case SUM_SPORT:
+        case SUM_DPORT:
+            if (si.ports)
+                e = _sum_u64(e, (op->type == SUM_SPORT) ? si.sport : si.dport, 1);
+            else
+                *e++ = '-';
+            break;
+        case SUM_LEN:
+            e = _sum_u64(e, decode_len(dc), 1);
+            break;
+        case SUM_FLAGS:
+            e = _sum_tcp_flags(e, si.tcp_flags);
+            break;
+        default:
+            break;
+        }
+
+        n   = e - fld;
+        pad = (op->width > n) ? op->width - n : 0;
+        if (op->right) {
+            memset(p, ' ', pad);
+            p += pad;
+        }
+        memcpy(p, fld, n);
+        p += n;
+        if (!op->right) {
+            memset(p, ' ', pad);
+            p += pad;
+        }
+    }
+
+    /* Padding of the last fields is not needed */
+    while (p > buf && p[-1] == ' ')
+        p--;
+    *p++ = '\n';
+
+    return p - buf;
+}
+
+void
+decode_summary_free(decode_t *dc)
+{
+    decode_summary_t *sum = dc->sum;
+
+    if (sum) {
+        free(sum->fmt);
+        free(sum);
+        dc->sum = NULL;
+    }
+}
+
+int
+fgen_decode_set_summary(fgen_decode_t *_dc, const char *fmt, int fd, uint32_t buf_size)
+{
+    decode_t *dc = _dc;
+    decode_summary_t *sum;
+
+    if (!dc)
+        return -1;
+
+    decode_summary_free(dc);
+
+    if (!fmt)
+        fmt = FGEN_DECODE_SUMMARY_FMT;
+    if (strlen(fmt) >= SUM_MAX_FMT)
+        FGEN_ERR_RET("Summary format is longer than %d\n", SUM_MAX_FMT);
+
+    sum = calloc(1, sizeof(decode_summary_t));
+    if (!sum)
+        FGEN_ERR_RET("Unable to allocate summary\n");
+
+    sum->fmt = strdup(fmt);
+    if (!sum->fmt || _sum_compile(sum, fmt) < 0 || decode_out_open(dc, fd, buf_size) < 0 ||
+        dc->out.size < sum->max_line) {
+        free(sum->fmt);
+        free(sum);
+        FGEN_ERR_RET("Unable to setup summary format '%s'\n", fmt);
+    }
+    dc->sum = sum;
+
+    return 0;
+}
+
+int
+fgen_decode_summary(fgen_decode_t *_dc, void *data, uint16_t len, uint64_t ts)
+{
+    decode_t *dc = _dc;
+    char *buf;
+    int n;
+
+    if (!dc || !dc->sum || !dc->out.buf || !data || len == 0)
+        return -1;
+
+    if (decode_headers(dc, data, len, FGEN_ETHER_TYPE) < 0)
+        return -1;
+
+    buf = decode_out_reserve(&dc->out, dc->sum->max_line);
+    if (!buf)
+        return -1;
+
+    n = _sum_format(dc, buf, ts);
+    dc->out.used += n;
+
+    return n;
+}
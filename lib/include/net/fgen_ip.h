@@ -15,6 +15,7 @@
  */
 
 #include <stdint.h>
+#include <stddef.h>
 #include <sys/types.h>
 #include <netinet/in.h>
 #include <netinet/ip.h>
@@ -357,6 +358,210 @@ fgen_ipv4_udptcp_cksum_verify(const struct fgen_ipv4_hdr *ipv4_hdr, const void *
     return 0;
 }
 
+/*
+ * Incremental checksum update, RFC 1624 eqn 3: HC' = ~(~HC + ~m + m')
+ *
+ * A field change is turned into a delta of ~m + m' once, then the delta is applied to any number
+ * of checksums covering the field. All values are taken as stored in the packet, the one's
+ * complement sum does not depend on the byte order as long as all the words use the same one.
+ * A changed field must start at an even offset from the start of the data covered by the
+ * checksum, which holds for all the IPv4, IPv6, UDP and TCP header fields.
+ */
+
+/**
+ * Compute the checksum delta of a 16 bit field change.
+ *
+ * @param old
+ *   The old value of the field as stored in the packet.
+ * @param val
+ *   The new value of the field as stored in the packet.
+ * @return
+ *   The delta to pass to fgen_cksum_apply().
+ */
+static inline uint32_t
+fgen_cksum_delta16(uint16_t old, uint16_t val)
+{
+    return (uint32_t)(uint16_t)~old + val;
+}
+
+/**
+ * Compute the checksum delta of a 32 bit field change, like an IPv4 address.
+ *
+ * @param old
+ *   The old value of the field as stored in the packet.
+ * @param val
+ *   The new value of the field as stored in the packet.
+ * @return
+ *   The delta to pass to fgen_cksum_apply().
+ */
+static inline uint32_t
+fgen_cksum_delta32(uint32_t old, uint32_t val)
+{
+    old = ~old;
+    return (old & 0xffff) + (old >> 16) + (val & 0xffff) + (val >> 16);
+}
+
+/**
+ * Compute the checksum delta of a change to an arbitrary span of the packet.
+ *
+ * @param old
+ *   Pointer to the old data of the span.
+ * @param val
+ *   Pointer to the new data of the span.
+ * @param len
+ *   Length of the span in bytes.
+ * @return
+ *   The delta to pass to fgen_cksum_apply().
+ */
+static inline uint32_t
+fgen_cksum_delta_span(const void *old, const void *val, size_t len)
+{
+    return (uint32_t)(uint16_t)~fgen_raw_cksum(old, len) + fgen_raw_cksum(val, len);
+}
+
+/**
+ * Compute the checksum delta of an IPv6 address change.
+ *
+ * @param old
+ *   The old 16 byte IPv6 address.
+ * @param val
+ *   The new 16 byte IPv6 address.
+ * @return
+ *   The delta to pass to fgen_cksum_apply().
+ */
+static inline uint32_t
+fgen_cksum_delta_ipv6(const uint8_t *old, const uint8_t *val)
+{
+    return fgen_cksum_delta_span(old, val, 16);
+}
+
+/**
+ * Add two checksum deltas, to update a checksum for several field changes at once.
+ *
+ * @param a
+ *   The first delta.
+ * @param b
+ *   The second delta.
+ * @return
+ *   The combined delta.
+ */
+static inline uint32_t
+fgen_cksum_delta_add(uint32_t a, uint32_t b)
+{
+    return (uint32_t)__fgen_raw_cksum_reduce(a) + __fgen_raw_cksum_reduce(b);
+}
+
+/**
+ * Apply a checksum delta to a complemented checksum.
+ *
+ * @param cksum
+ *   The checksum as stored in the packet.
+ * @param delta
+ *   The delta from one of the fgen_cksum_delta*() routines.
+ * @return
+ *   The updated checksum to store in the packet.
+ */
+static inline uint16_t
+fgen_cksum_apply(uint16_t cksum, uint32_t delta)
+{
+    return (uint16_t)~__fgen_raw_cksum_reduce((uint16_t)~cksum + __fgen_raw_cksum_reduce(delta));
+}
+
+/**
+ * Apply one checksum delta to the checksum at the same offset in an array of packets.
+ *
+ * @param pkts
+ *   Array of pointers to the packet data.
+ * @param n
+ *   Number of packets in the array.
+ * @param off
+ *   Offset of the 16 bit checksum in each packet.
+ * @param delta
+ *   The delta from one of the fgen_cksum_delta*() routines.
+ */
+static inline void
+fgen_cksum_apply_bulk(void *const *pkts, uint16_t n, uint16_t off, uint32_t delta)
+{
+    typedef uint16_t __attribute__((__may_alias__)) u16_p;
+
+    delta = __fgen_raw_cksum_reduce(delta);
+    for (uint16_t i = 0; i < n; i++) {
+        u16_p *cksum = (u16_p *)((uint8_t *)pkts[i] + off);
+
+        *cksum = fgen_cksum_apply(*cksum, delta);
+    }
+}
+
+/**
+ * Update the IPv4 header checksum for a 16 bit header field change.
+ *
+ * @param ipv4_hdr
+ *   The pointer to the contiguous IPv4 header.
+ * @param old
+ *   The old value of the field as stored in the packet.
+ * @param val
+ *   The new value of the field as stored in the packet.
+ */
+static inline void
+fgen_ipv4_cksum_update16(struct fgen_ipv4_hdr *ipv4_hdr, uint16_t old, uint16_t val)
+{
+    ipv4_hdr->hdr_checksum = fgen_cksum_apply(ipv4_hdr->hdr_checksum, fgen_cksum_delta16(old, val));
+}
+
+/**
+ * Update the IPv4 header checksum for a 32 bit header field change, like an address.
+ *
+ * @param ipv4_hdr
+ *   The pointer to the contiguous IPv4 header.
+ * @param old
+ *   The old value of the field as stored in the packet.
+ * @param val
+ *   The new value of the field as stored in the packet.
+ */
+static inline void
+fgen_ipv4_cksum_update32(struct fgen_ipv4_hdr *ipv4_hdr, uint32_t old, uint32_t val)
+{
+    ipv4_hdr->hdr_checksum = fgen_cksum_apply(ipv4_hdr->hdr_checksum, fgen_cksum_delta32(old, val));
+}
+
+/**
+ * Update the IPv4 header checksum of an array of packets with one delta.
+ *
+ * @param pkts
+ *   Array of pointers to the packet data.
+ * @param n
+ *   Number of packets in the array.
+ * @param l3_off
+ *   Offset of the IPv4 header in each packet.
+ * @param delta
+ *   The delta from one of the fgen_cksum_delta*() routines.
+ */
+static inline void
+fgen_ipv4_cksum_update_bulk(void *const *pkts, uint16_t n, uint16_t l3_off, uint32_t delta)
+{
+    fgen_cksum_apply_bulk(pkts, n, l3_off + offsetof(struct fgen_ipv4_hdr, hdr_checksum), delta);
+}
+
+/**
+ * Set the TTL of an IPv4 header and update the header checksum.
+ *
+ * @param ipv4_hdr
+ *   The pointer to the contiguous IPv4 header.
+ * @param ttl
+ *   The new time to live.
+ */
+static inline void
+fgen_ipv4_set_ttl(struct fgen_ipv4_hdr *ipv4_hdr, uint8_t ttl)
+{
+    /* The TTL shares a 16 bit word with the protocol */
+    uint8_t old[2] = {ipv4_hdr->time_to_live, ipv4_hdr->next_proto_id};
+    uint8_t val[2] = {ttl, ipv4_hdr->next_proto_id};
+
+    ipv4_hdr->time_to_live = ttl;
+    ipv4_hdr->hdr_checksum =
+        fgen_cksum_apply(ipv4_hdr->hdr_checksum, fgen_cksum_delta_span(old, val, sizeof(old)));
+}
+
 /**
  * IPv6 Header
  */
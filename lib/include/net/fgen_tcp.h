@@ -15,8 +15,10 @@
  */
 
 #include <stdint.h>
+#include <stddef.h>
 
 #include <fgen_byteorder.h>
+#include <net/fgen_ip.h>
 
 #ifdef __cplusplus
 extern "C" {
@@ -49,6 +51,41 @@ struct fgen_tcp_hdr {
 #define TCP_SYN_FLAG 0x02 /**< Synchronize sequence numbers */
 #define TCP_FIN_FLAG 0x01 /**< No more data from sender */
 
+/**
+ * Update the TCP checksum with a checksum delta.
+ *
+ * The delta covers the pseudo-header, so a change of an IP address or length is applied here
+ * as well as to the IPv4 header checksum.
+ *
+ * @param tcp_hdr
+ *   The pointer to the TCP header.
+ * @param delta
+ *   The delta from one of the fgen_cksum_delta*() routines.
+ */
+static inline void
+fgen_tcp_cksum_update(struct fgen_tcp_hdr *tcp_hdr, uint32_t delta)
+{
+    tcp_hdr->cksum = fgen_cksum_apply(tcp_hdr->cksum, delta);
+}
+
+/**
+ * Update the TCP checksum of an array of packets with one delta.
+ *
+ * @param pkts
+ *   Array of pointers to the packet data.
+ * @param n
+ *   Number of packets in the array.
+ * @param l4_off
+ *   Offset of the TCP header in each packet.
+ * @param delta
+ *   The delta from one of the fgen_cksum_delta*() routines.
+ */
+static inline void
+fgen_tcp_cksum_update_bulk(void *const *pkts, uint16_t n, uint16_t l4_off, uint32_t delta)
+{
+    fgen_cksum_apply_bulk(pkts, n, l4_off + offsetof(struct fgen_tcp_hdr, cksum), delta);
+}
+
 #ifdef __cplusplus
 }
 #endif
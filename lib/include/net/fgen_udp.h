@@ -15,8 +15,10 @@
  */
 
 #include <stdint.h>
+#include <stddef.h>
 
 #include <fgen_byteorder.h>
+#include <net/fgen_ip.h>
 
 #ifdef __cplusplus
 extern "C" {
@@ -32,6 +34,50 @@ struct fgen_udp_hdr {
     fgen_be16_t dgram_cksum; /**< UDP datagram checksum */
 } __attribute__((__packed__));
 
+/**
+ * Update the UDP checksum with a checksum delta.
+ *
+ * A zero checksum means no checksum and is left alone, a zero result is stored as all ones.
+ * The delta covers the pseudo-header, so a change of an IP address or length is applied here
+ * as well as to the IPv4 header checksum.
+ *
+ * @param udp_hdr
+ *   The pointer to the UDP header.
+ * @param delta
+ *   The delta from one of the fgen_cksum_delta*() routines.
+ */
+static inline void
+fgen_udp_cksum_update(struct fgen_udp_hdr *udp_hdr, uint32_t delta)
+{
+    uint16_t cksum;
+
+    if (udp_hdr->dgram_cksum == 0)
+        return;
+
+    cksum                = fgen_cksum_apply(udp_hdr->dgram_cksum, delta);
+    udp_hdr->dgram_cksum = (cksum == 0) ? 0xffff : cksum;
+}
+
+/**
+ * Update the UDP checksum of an array of packets with one delta.
+ *
+ * @param pkts
+ *   Array of pointers to the packet data.
+ * @param n
+ *   Number of packets in the array.
+ * @param l4_off
+ *   Offset of the UDP header in each packet.
+ * @param delta
+ *   The delta from one of the fgen_cksum_delta*() routines.
+ */
+static inline void
+fgen_udp_cksum_update_bulk(void *const *pkts, uint16_t n, uint16_t l4_off, uint32_t delta)
+{
+    delta = __fgen_raw_cksum_reduce(delta);
+    for (uint16_t i = 0; i < n; i++)
+        fgen_udp_cksum_update((struct fgen_udp_hdr *)((uint8_t *)pkts[i] + l4_off), delta);
+}
+
 #ifdef __cplusplus
 }
 #endif
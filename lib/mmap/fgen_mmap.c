@@ -14,11 +14,18 @@
 #include <strings.h>           // for strcasecmp
 #include <unistd.h>            // for getpagesize
 #include <stdint.h>            // for uint64_t, uint32_t
-#include <stdlib.h>            // for free, calloc
+#include <stdlib.h>            // for free, calloc, strtoull
+#include <stdio.h>             // for fopen, fgets, snprintf
+#include <limits.h>            // for PATH_MAX
+#include <pthread.h>           // for pthread_mutex_lock, PTHREAD_MUTEX_INITIALIZER
+#ifdef FGEN_HAS_LIBNUMA
+#include <numaif.h>            // for mbind, get_mempolicy, MPOL_BIND, MPOL_F_NODE
+#endif
 
 #include "mmap_private.h"        // for mmap_data
 #include "fgen_mmap.h"            // for mmap_sizes_t, MMAP_HUGEPAGE_4KB, MMAP_HUGE...
 #include "fgen_log.h"
+#include "fgen_system.h"        // for fgen_socket_id_self, fgen_device_socket_id
 
 #ifdef __clang__
 /* clang doesn't have -Wclobbered */
@@ -27,22 +34,37 @@
 #pragma GCC diagnostic ignored "-Wclobbered"
 #endif
 
+#define HUGEPAGE_SYSFS      "/sys/kernel/mm/hugepages/hugepages-%lukB/%s"
+#define HUGEPAGE_NODE_SYSFS "/sys/devices/system/node/node%d/hugepages/hugepages-%lukB/%s"
+#define THP_SYSFS           "/sys/kernel/mm/transparent_hugepage/enabled"
+#define THP_SIZE            (2 * 1024 * 1024)
+
+#ifndef MADV_POPULATE_WRITE
+#define MADV_POPULATE_WRITE 23 /* Older headers, a kernel without it returns EINVAL */
+#endif
+
 static mmap_stats_t mmap_stats;
 static mmap_type_t mmap_default_type = MMAP_HUGEPAGE_4KB;
+static pthread_mutex_t mmap_lock     = PTHREAD_MUTEX_INITIALIZER; /* stats and SIGBUS handler */
 
-static sigjmp_buf huge_jmpenv;
+static __thread sigjmp_buf huge_jmpenv;
+static __thread volatile sig_atomic_t huge_armed;
 static struct sigaction old_sigbus_action;
 static bool restore_old_sigbus;
 
 /*
- * The following SIGBUS signal handling is used when a mapping to a 1GB or 2MB page succeeds but
- * access to the page is denied. When a SIGBUS occurs, an attempt is made to fallback to a
- * smaller page size.
+ * The following SIGBUS signal handling is used on kernels without MADV_POPULATE_WRITE, when a
+ * mapping to a 1GB or 2MB page succeeds but access to the page is denied. When a SIGBUS occurs,
+ * an attempt is made to fallback to a smaller page size. The handler is installed under
+ * mmap_lock and the jump buffer is per thread. A SIGBUS of another thread restores the previous
+ * handler, which then gets the signal when the faulting instruction runs again.
  */
 static void
 sigbus_handler(int signum __fgen_unused)
 {
-    siglongjmp(huge_jmpenv, -1);
+    if (huge_armed)
+        siglongjmp(huge_jmpenv, -1);
+    sigaction(SIGBUS, &old_sigbus_action, NULL);
 }
 
 static void
@@ -86,6 +108,16 @@ static struct {
     // clang-format on
 };
 
+static void
+mmap_stats_init(void)
+{
+    mmap_stats.sizes[MMAP_HUGEPAGE_4KB].page_sz = getpagesize();
+    mmap_stats.sizes[MMAP_HUGEPAGE_2MB].page_sz = (2 * 1024 * 1024);
+    mmap_stats.sizes[MMAP_HUGEPAGE_1GB].page_sz = (1024 * 1024 * 1024);
+    mmap_stats.inited                           = 1;
+}
+FGEN_INIT(mmap_stats_init);
+
 static int
 pagesz_flags(uint64_t page_sz)
 {
@@ -137,43 +169,326 @@ mmap_set_default_by_name(const char *name)
     mmap_set_default(mmap_type_by_name(name));
 }
 
+/* Bind the pages of the region to mm->socket, the pages must not have been touched yet */
+static void
+__bind_mem(struct mmap_data *mm, void *va)
+{
+#ifdef FGEN_HAS_LIBNUMA
+    unsigned long nodemask = 1UL << mm->socket;
+
+    if (mbind(va, mm->sz, MPOL_BIND, &nodemask, MMAP_MAX_NODES + 1, 0))
+        FGEN_WARN("Failed to bind memory to socket %d: %s\n", mm->socket, strerror(errno));
+#else
+    FGEN_SET_USED(va);
+    FGEN_WARN("No libnuma, socket %d is ignored\n", mm->socket);
+#endif
+}
+
+/* Read a number from a sysfs or cgroup file, "max" reads as UINT64_MAX */
+static int
+__read_u64(const char *path, uint64_t *val)
+{
+    char buf[64], *end;
+    int ret = -1;
+    FILE *f;
+
+    f = fopen(path, "r");
+    if (!f)
+        return -1;
+
+    if (fgets(buf, sizeof(buf), f)) {
+        if (!strncmp(buf, "max", 3)) {
+            *val = UINT64_MAX;
+            ret  = 0;
+        } else {
+            *val = strtoull(buf, &end, 10);
+            ret  = (end != buf) ? 0 : -1;
+        }
+    }
+    fclose(f);
+
+    return ret;
+}
+
+/* Return the bytes of hugepages of a size the hugetlb cgroup of this process can still use */
+static uint64_t
+__cgroup_hugetlb_room(mmap_type_t typ)
+{
+    char line[PATH_MAX], path[PATH_MAX + 64];
+    const char *name = mmap_types[typ].name;
+    uint64_t room = UINT64_MAX, limit, usage;
+    FILE *f;
+
+    f = fopen("/proc/self/cgroup", "r");
+    if (!f)
+        return room;
+
+    /* Lines are "id:controllers:path", cgroup v2 has no controllers */
+    while (fgets(line, sizeof(line), f)) {
+        char *ctl, *cg;
+
+        ctl = strchr(line, ':');
+        cg  = ctl ? strchr(++ctl, ':') : NULL;
+        if (!cg)
+            continue;
+        *cg++                 = '\0';
+        cg[strcspn(cg, "\n")] = '\0';
+
+        if (ctl[0] == '\0') {
+            snprintf(path, sizeof(path), "/sys/fs/cgroup%s/hugetlb.%s.max", cg, name);
+            if (__read_u64(path, &limit))
+                continue;
+            snprintf(path, sizeof(path), "/sys/fs/cgroup%s/hugetlb.%s.current", cg, name);
+        } else if (!strcmp(ctl, "hugetlb")) {
+            snprintf(path, sizeof(path), "/sys/fs/cgroup/hugetlb%s/hugetlb.%s.limit_in_bytes", cg,
+                     name);
+            if (__read_u64(path, &limit))
+                continue;
+            snprintf(path, sizeof(path), "/sys/fs/cgroup/hugetlb%s/hugetlb.%s.usage_in_bytes", cg,
+                     name);
+        } else
+            continue;
+
+        if (__read_u64(path, &usage))
+            usage = 0;
+        room = FGEN_MIN(room, (limit > usage) ? limit - usage : 0);
+    }
+    fclose(f);
+
+    return room;
+}
+
+/*
+ * Check the free hugepages of the pool, of the node of a bound region and the room left in the
+ * hugetlb cgroup before mapping, the kernel only finds out a page can not be backed at fault time.
+ */
+static bool
+__huge_available(struct mmap_data *mm, mmap_type_t typ, uint64_t sz)
+{
+    uint64_t page_sz = mmap_stats.sizes[typ].page_sz;
+    uint64_t need    = sz / page_sz, nfree, resv = 0;
+    const char *name = mmap_types[typ].name;
+    char path[PATH_MAX];
+
+    snprintf(path, sizeof(path), HUGEPAGE_SYSFS, page_sz / 1024, "free_hugepages");
+    if (__read_u64(path, &nfree)) {
+        FGEN_WARN("No %s hugepages on this system\n", name);
+        return false;
+    }
+    snprintf(path, sizeof(path), HUGEPAGE_SYSFS, page_sz / 1024, "resv_hugepages");
+    if (__read_u64(path, &resv) || resv > nfree)
+        resv = 0;
+    nfree -= resv;
+
+    if (mm->socket >= 0) {
+        uint64_t node_free;
+
+        snprintf(path, sizeof(path), HUGEPAGE_NODE_SYSFS, mm->socket, page_sz / 1024,
+                 "free_hugepages");
+        if (__read_u64(path, &node_free) == 0)
+            nfree = FGEN_MIN(nfree, node_free);
+    }
+
+    if (nfree < need) {
+        FGEN_WARN("Need %'lu %s hugepages, %'lu are free\n", need, name, nfree);
+        return false;
+    }
+    if (__cgroup_hugetlb_room(typ) < sz) {
+        FGEN_WARN("Need %'lu bytes of %s hugepages, over the hugetlb cgroup limit\n", sz, name);
+        return false;
+    }
+
+    return true;
+}
+
+static bool
+__thp_enabled(void)
+{
+    char buf[128] = {0};
+    FILE *f;
+
+    f = fopen(THP_SYSFS, "r");
+    if (!f)
+        return false;
+    if (!fgets(buf, sizeof(buf), f))
+        buf[0] = '\0';
+    fclose(f);
+
+    return strstr(buf, "[always]") || strstr(buf, "[madvise]");
+}
+
+/* Fault in every page under the SIGBUS handler, the region is new so a zero is written back */
+static int
+__touch_mem(struct mmap_data *mm)
+{
+    int ret = 0;
+
+    pthread_mutex_lock(&mmap_lock);
+    start_sigbus_handler();
+    if (sigsetjmp(huge_jmpenv, 1) == 0) {
+        huge_armed = 1;
+        for (size_t off = 0; off < mm->sz; off += mm->align)
+            *(volatile int *)FGEN_PTR_ADD(mm->addr, off) = 0;
+    } else
+        ret = -1;
+    huge_armed = 0;
+    stop_sigbus_handler();
+    pthread_mutex_unlock(&mmap_lock);
+
+    if (ret)
+        errno = EFAULT;
+    return ret;
+}
+
+/*
+ * Fault in the pages of a region mapped without MAP_POPULATE. MADV_POPULATE_WRITE returns an
+ * error for a hugepage the kernel can not back, on older kernels the pages are touched.
+ */
+static int
+__populate_mem(struct mmap_data *mm)
+{
+    if (mmap_prefault_enabled(mm->sz)) {
+        int ret = mmap_prefault(mm, mm->addr);
+
+        if (ret <= 0)
+            return ret;
+    }
+
+    if (madvise(mm->addr, mm->sz, MADV_POPULATE_WRITE) == 0)
+        return 0;
+    if (errno != EINVAL)
+        return -1;
+
+    return __touch_mem(mm);
+}
+
 static void *
-__alloc_mem(struct mmap_data *mm, mmap_type_t typ)
+__alloc_mem(struct mmap_data *mm, mmap_type_t typ, bool thp)
 {
-    int flags = MAP_SHARED | MAP_ANONYMOUS | MAP_POPULATE;
-    uint64_t len;
+    int flags = MAP_ANONYMOUS;
+    uint64_t len, map_sz;
+    void *va;
 
     mm->typ   = typ;
+    mm->thp   = thp;
     mm->align = mmap_stats.sizes[typ].page_sz;
 
     len    = (uint64_t)mm->bufcnt * (uint64_t)mm->bufsz;
-    mm->sz = FGEN_ALIGN_CEIL(len, mm->align);
+    mm->sz = FGEN_ALIGN_CEIL(len, thp ? (uint64_t)THP_SIZE : (uint64_t)mm->align);
 
-    flags |= pagesz_flags(mmap_stats.sizes[typ].page_sz);
+    /* THP needs private memory, shared anonymous memory is shmem with its own THP setting */
+    flags |= thp ? MAP_PRIVATE : (MAP_SHARED | pagesz_flags(mm->align));
 
-    /* map the segment, and populate page tables, the kernel fills
-     * this segment with zeros if it's a new page.
+    /* A hugetlb region is populated after mmap() to get an error for a page that can not be
+     * backed, a bound or THP region after its madvise() calls, a large region by the prefault
+     * workers and the others by the kernel.
      */
-    return mmap(NULL, mm->sz, PROT_READ | PROT_WRITE, flags, -1, 0);
+    mm->populate = (typ != MMAP_HUGEPAGE_4KB || thp || mm->socket != MMAP_SOCKET_ANY ||
+                    mmap_prefault_enabled(mm->sz));
+    if (!mm->populate)
+        flags |= MAP_POPULATE;
+
+    /* A THP region is mapped THP_SIZE larger and trimmed to start on a THP_SIZE boundary */
+    map_sz = thp ? mm->sz + THP_SIZE : mm->sz;
+
+    /* map the segment, the kernel fills this segment with zeros if it's a new page. */
+    va = mmap(NULL, map_sz, PROT_READ | PROT_WRITE, flags, -1, 0);
+    if (va == MAP_FAILED)
+        return va;
+
+    if (thp) {
+        void *start = FGEN_PTR_ALIGN_CEIL(va, THP_SIZE);
+        size_t head = FGEN_PTR_DIFF(start, va);
+
+        if (head)
+            munmap(va, head);
+        munmap(FGEN_PTR_ADD(start, mm->sz), THP_SIZE - head);
+        va = start;
+
+        if (madvise(va, mm->sz, MADV_HUGEPAGE))
+            FGEN_WARN("madvise(MADV_HUGEPAGE) failed: %s\n", strerror(errno));
+    }
+
+    if (mm->socket != MMAP_SOCKET_ANY)
+        __bind_mem(mm, va);
+
+    mm->addr = va;
+    if (mm->populate && __populate_mem(mm) < 0) {
+        int err = errno;
+
+        munmap(va, mm->sz);
+        mm->addr = NULL;
+        errno    = err;
+        return MAP_FAILED;
+    }
+
+    return va;
+}
+
+/* Return the NUMA node of the first page of the region or MMAP_SOCKET_ANY */
+static int
+__mem_socket(struct mmap_data *mm)
+{
+#ifdef FGEN_HAS_LIBNUMA
+    int node = MMAP_SOCKET_ANY;
+
+    if (get_mempolicy(&node, NULL, 0, mm->addr, MPOL_F_NODE | MPOL_F_ADDR) == 0 && node >= 0 &&
+        node < MMAP_MAX_NODES)
+        return node;
+#else
+    FGEN_SET_USED(mm);
+#endif
+    return MMAP_SOCKET_ANY;
 }
 
 mmap_t *
 mmap_alloc(uint32_t bufcnt, uint32_t bufsz, mmap_type_t typ)
 {
-    struct mmap_data *mm;
-    void *va;
+    return mmap_alloc_socket(bufcnt, bufsz, typ, MMAP_SOCKET_ANY);
+}
 
-    if (mmap_stats.inited == 0) {
-        mmap_stats.inited = 1;
+mmap_t *
+mmap_alloc_netdev(uint32_t bufcnt, uint32_t bufsz, mmap_type_t typ, char *netdev)
+{
+    int socket = MMAP_SOCKET_ANY;
 
-        mmap_stats.sizes[MMAP_HUGEPAGE_4KB].page_sz = getpagesize();
-        mmap_stats.sizes[MMAP_HUGEPAGE_2MB].page_sz = (2 * 1024 * 1024);
-        mmap_stats.sizes[MMAP_HUGEPAGE_1GB].page_sz = (1024 * 1024 * 1024);
+    if (netdev) {
+        /* A device without a NUMA node reports -1, which is out of range as a uint16_t */
+        socket = fgen_device_socket_id(netdev);
+        if (socket >= fgen_max_numa_nodes())
+            socket = MMAP_SOCKET_ANY;
     }
 
+    return mmap_alloc_socket(bufcnt, bufsz, typ, socket);
+}
+
+mmap_t *
+mmap_alloc_socket(uint32_t bufcnt, uint32_t bufsz, mmap_type_t typ, int socket)
+{
+    // clang-format off
+    static const struct {
+        mmap_type_t typ;
+        bool thp;
+    } steps[] = {
+        { MMAP_HUGEPAGE_1GB, false },
+        { MMAP_HUGEPAGE_2MB, false },
+        { MMAP_HUGEPAGE_4KB, true },
+        { MMAP_HUGEPAGE_4KB, false }
+    };
+    // clang-format on
+    struct mmap_data *mm;
+    uint64_t len;
+    void *va = MAP_FAILED;
+    int first;
+
     if (typ < MMAP_HUGEPAGE_4KB || typ >= MMAP_HUGEPAGE_CNT)
         typ = MMAP_HUGEPAGE_4KB;
 
+    if (socket == MMAP_SOCKET_SELF)
+        socket = (int)fgen_socket_id_self();
+    if (socket < MMAP_SOCKET_ANY || socket >= MMAP_MAX_NODES)
+        FGEN_NULL_RET("Socket %d is invalid\n", socket);
+
     mm = calloc(1, sizeof(struct mmap_data));
     if (!mm)
         FGEN_NULL_RET("Failed to allocate mmap_data structure\n");
@@ -183,86 +498,45 @@ mmap_alloc(uint32_t bufcnt, uint32_t bufsz, mmap_type_t typ)
 
     mm->bufcnt = bufcnt;
     mm->bufsz  = bufsz;
+    mm->socket = socket;
+    len        = (uint64_t)bufcnt * (uint64_t)bufsz;
 
-retry:
-    /* Try the requested size and if not available, degrade to the next available size */
-    switch (typ) {
-    case MMAP_HUGEPAGE_1GB:
-        va = __alloc_mem(mm, MMAP_HUGEPAGE_1GB);
-        if (va != MAP_FAILED)
-            break;
-        FGEN_WARN("Failed to allocate %s hugepages, trying %s pages\n",
-                 mmap_types[MMAP_HUGEPAGE_1GB].name, mmap_types[MMAP_HUGEPAGE_2MB].name);
-        /* fall through */
-
-    case MMAP_HUGEPAGE_2MB:
-        va = __alloc_mem(mm, MMAP_HUGEPAGE_2MB);
-        if (va != MAP_FAILED)
-            break;
-        FGEN_WARN("Failed to allocate %s hugepages, trying %s pages\n",
-                 mmap_types[MMAP_HUGEPAGE_2MB].name, mmap_types[MMAP_HUGEPAGE_4KB].name);
-        /* fall through */
-
-    default:
-    case MMAP_HUGEPAGE_4KB:
-        va = __alloc_mem(mm, MMAP_HUGEPAGE_4KB);
+    /* Try the requested size and if not available, degrade to hugetlb pages of the next size,
+     * then to transparent hugepages and last to 4KB pages.
+     */
+    first = (typ == MMAP_HUGEPAGE_1GB) ? 0 : (typ == MMAP_HUGEPAGE_2MB) ? 1 : 3;
+    for (int i = first; i < fgen_countof(steps) && va == MAP_FAILED; i++) {
+        mmap_type_t t    = steps[i].typ;
+        const char *name = steps[i].thp ? "THP" : mmap_types[t].name;
+
+        if (steps[i].thp && !__thp_enabled())
+            continue;
+        if (t != MMAP_HUGEPAGE_4KB &&
+            !__huge_available(mm, t, FGEN_ALIGN_CEIL(len, mmap_stats.sizes[t].page_sz)))
+            continue;
+
+        va = __alloc_mem(mm, t, steps[i].thp);
         if (va == MAP_FAILED)
-            FGEN_ERR_GOTO(leave, "Failed to allocate %s pages for %'ld bytes:\n    Error: %s\n",
-                         mmap_types[MMAP_HUGEPAGE_4KB].name,
-                         ((uint64_t)mm->bufcnt * (uint64_t)mm->bufsz), strerror(errno));
-        break;
+            FGEN_WARN("Failed to allocate %s pages for %'lu bytes: %s\n", name, len,
+                      strerror(errno));
     }
-
-    mm->addr = va;
-
-    /* In linux, hugetlb limitations, like cgroup, are
-     * enforced at fault time instead of mmap(), even
-     * with the option of MAP_POPULATE. Kernel will send
-     * a SIGBUS signal. To avoid to be killed, save stack
-     * environment here, if SIGBUS happens, we can jump
-     * back here.
-     */
-    if (sigsetjmp(huge_jmpenv, 1)) {
-        stop_sigbus_handler();
-
-        /* Unmap previous failing region before trying a new one */
-        if (munmap(mm->addr, mm->sz))
-            FGEN_ERR_GOTO(leave, "munmap(%p, %ld) failed: %s\n", mm->addr, mm->sz, strerror(errno));
-
-        mm->addr = NULL;
-
-        switch (mm->typ) {
-        case MMAP_HUGEPAGE_1GB:
-            FGEN_WARN("Failed to allocate %s hugepages, trying %s pages\n",
-                     mmap_types[MMAP_HUGEPAGE_1GB].name, mmap_types[MMAP_HUGEPAGE_2MB].name);
-            typ = MMAP_HUGEPAGE_2MB;
-            break;
-        case MMAP_HUGEPAGE_2MB:
-            FGEN_WARN("Failed to allocate %s hugepages, trying %s pages\n",
-                     mmap_types[MMAP_HUGEPAGE_2MB].name, mmap_types[MMAP_HUGEPAGE_4KB].name);
-            typ = MMAP_HUGEPAGE_4KB;
-            break;
-        case MMAP_HUGEPAGE_4KB:
-        default:
-            FGEN_ERR_GOTO(leave, "Failed to allocate %s pages for %'ld bytes\n",
-                         mmap_types[MMAP_HUGEPAGE_4KB].name,
-                         (uint64_t)mm->bufcnt * (uint64_t)mm->bufsz);
-        }
-
-        goto retry;
+    if (va == MAP_FAILED)
+        FGEN_ERR_GOTO(leave, "Failed to allocate memory for %'lu bytes\n", len);
+
+    /* Record where the pages landed, a bound region on a node out of pages falls back */
+    socket = __mem_socket(mm);
+    if (mm->socket != MMAP_SOCKET_ANY && socket != mm->socket)
+        FGEN_WARN("Memory bound to socket %d is on socket %d\n", mm->socket, socket);
+    mm->socket = socket;
+
+    pthread_mutex_lock(&mmap_lock);
+    mmap_stats.sizes[mm->typ].allocated += mm->sz;
+    mmap_stats.sizes[mm->typ].num_allocated++;
+    if (mm->socket >= 0) {
+        mmap_stats.nodes[mm->socket].allocated += mm->sz;
+        mmap_stats.nodes[mm->socket].num_allocated++;
     }
-
-    /* we need to trigger a write to the page to enforce page fault and
-     * ensure that page is accessible to us, but we can't overwrite value
-     * that is already there, so read the old value, and write it back.
-     * kernel populates the page with zeroes initially.
-     */
-    start_sigbus_handler();
-    *(volatile int *)va = *(volatile int *)va;
-    stop_sigbus_handler();
-
-    mmap_stats.sizes[typ].allocated += mm->sz;
-    mmap_stats.sizes[typ].num_allocated++;
+    pthread_mutex_unlock(&mmap_lock);
 
     return (mmap_t *)mm;
 
@@ -282,16 +556,26 @@ mmap_free(mmap_t *_mm)
     if (mm->typ < MMAP_HUGEPAGE_4KB || mm->typ >= MMAP_HUGEPAGE_CNT)
         FGEN_ERR_RET("mmap type is invalid %d\n", mm->typ);
 
-    if (mm->addr && mm->sz) {
+    if (mm->shared) {
+        if (mmap_shared_release(mm))
+            return -1;
+    } else if (mm->addr && mm->sz) {
         if (munmap(mm->addr, mm->sz))
             /* Do not free mm if munmap fails so application can handle it */
             FGEN_ERR_RET("munmap(%p, %ld) failed: %s\n", mm->addr, mm->sz, strerror(errno));
         else {
             mmap_sizes_t *ss;
 
+            pthread_mutex_lock(&mmap_lock);
             ss = &mmap_stats.sizes[mm->typ];
             ss->freed += mm->sz;
             ss->num_freed++;
+
+            if (mm->socket >= 0) {
+                mmap_stats.nodes[mm->socket].freed += mm->sz;
+                mmap_stats.nodes[mm->socket].num_freed++;
+            }
+            pthread_mutex_unlock(&mmap_lock);
         }
     }
 
@@ -316,6 +600,46 @@ mmap_addr(mmap_t *_mm)
     return mmap_addr_at_offset(_mm, 0);
 }
 
+int
+mmap_socket(mmap_t *_mm)
+{
+    struct mmap_data *mm = _mm;
+
+    return mm ? mm->socket : MMAP_SOCKET_ANY;
+}
+
+int
+mmap_node_stats(int socket, mmap_node_stats_t *stats)
+{
+    if (socket < 0 || socket >= MMAP_MAX_NODES || !stats)
+        return -1;
+
+    pthread_mutex_lock(&mmap_lock);
+    *stats = mmap_stats.nodes[socket];
+    pthread_mutex_unlock(&mmap_lock);
+    return 0;
+}
+
+int
+mmap_stats_get(mmap_stats_t *stats)
+{
+    if (!stats)
+        return -1;
+
+    pthread_mutex_lock(&mmap_lock);
+    *stats = mmap_stats;
+    pthread_mutex_unlock(&mmap_lock);
+    return 0;
+}
+
+bool
+mmap_thp(mmap_t *_mm)
+{
+    struct mmap_data *mm = _mm;
+
+    return mm ? mm->thp : false;
+}
+
 size_t
 mmap_size(mmap_t *_mm, uint32_t *bufcnt, uint32_t *bufsz)
 {
@@ -12,6 +12,7 @@
  * Allocate memory using MMAP anonymous memory using hugepages.
  */
 
+#include <stdbool.h>       // for bool
 #include <stddef.h>        // for size_t
 #include <stdint.h>        // for uint64_t, uint8_t
 
@@ -33,27 +34,56 @@ typedef enum {
 
 #define MMAP_HUGEPAGE_DEFAULT MMAP_HUGEPAGE_4KB
 
+#define MMAP_MAX_NODES   64 /**< Max number of NUMA nodes, with allocation stats per node */
+#define MMAP_SOCKET_ANY  -1 /**< No NUMA policy, pages are placed on the node of first touch */
+#define MMAP_SOCKET_SELF -2 /**< Bind the pages to the node of the calling lcore */
+
 /**
  * A set of stats for mmap allocation/free and other stats
  */
 typedef struct {
     uint64_t page_sz;       /**< Page size to allocate in bytes */
-    uint64_t num_allocated; /**< Number of allocated memory */
-    uint64_t num_freed;     /**< Number of freed memory */
-    uint64_t allocated;     /**< Number of times memory has been allocated */
-    uint64_t freed;         /**< Number of times memory has been freed */
+    uint64_t num_allocated; /**< Number of times memory has been allocated */
+    uint64_t num_freed;     /**< Number of times memory has been freed */
+    uint64_t allocated;     /**< Number of bytes allocated */
+    uint64_t freed;         /**< Number of bytes freed */
 } mmap_sizes_t;
 
 /**
- * Stats per HUGEPAGE type
+ * Stats per NUMA node
+ */
+typedef struct {
+    uint64_t num_allocated; /**< Number of allocated memory regions */
+    uint64_t num_freed;     /**< Number of freed memory regions */
+    uint64_t allocated;     /**< Number of bytes allocated */
+    uint64_t freed;         /**< Number of bytes freed */
+} mmap_node_stats_t;
+
+/**
+ * Stats per HUGEPAGE type and NUMA node
  */
 typedef struct {
-    uint8_t inited;                        /**< Value to detect if stats have been allocated */
-    mmap_sizes_t sizes[MMAP_HUGEPAGE_CNT]; /**< Stats for each page size */
+    uint8_t inited;                          /**< Value to detect if stats have been allocated */
+    mmap_sizes_t sizes[MMAP_HUGEPAGE_CNT];   /**< Stats for each page size */
+    mmap_node_stats_t nodes[MMAP_MAX_NODES]; /**< Stats for each NUMA node */
 } mmap_stats_t;
 
 typedef void mmap_t; /**< Opaque pointer to internal mmap data */
 
+#define MMAP_PREFAULT_MIN (64 * 1024 * 1024) /**< Smallest region prefaulted in parallel */
+
+/**
+ * Progress callback of a parallel prefault, called about every 100ms on the allocating thread.
+ *
+ * @param done
+ *   Number of bytes faulted in so far.
+ * @param total
+ *   Size of the region in bytes.
+ * @param arg
+ *   The argument given to mmap_set_prefault().
+ */
+typedef void (*mmap_progress_t)(size_t done, size_t total, void *arg);
+
 /**
  * Allocate memory on the correct socket and use hugepages if set.
  *
@@ -68,6 +98,43 @@ typedef void mmap_t; /**< Opaque pointer to internal mmap data */
  */
 FGEN_API mmap_t *mmap_alloc(uint32_t bufcnt, uint32_t bufsz, mmap_type_t hugepage);
 
+/**
+ * Allocate memory with the pages bound to a NUMA node and use hugepages if set.
+ *
+ * The NUMA policy is set before the pages are touched, so no page is placed on the node of the
+ * calling thread first. Without libnuma the socket_id is ignored.
+ *
+ * @param bufcnt
+ *   Number of buffers in the memory pool
+ * @param bufsz
+ *   The size of the buffers in the memory pool
+ * @param hugepage
+ *   Type of hugepage memory to allocate or non-hugepage memory.
+ * @param socket_id
+ *   The NUMA node, MMAP_SOCKET_SELF for the node of the calling lcore or MMAP_SOCKET_ANY.
+ * @return
+ *   The mmap_t structure pointer of the memory allocated or NULL on error
+ */
+FGEN_API mmap_t *mmap_alloc_socket(uint32_t bufcnt, uint32_t bufsz, mmap_type_t hugepage,
+                                   int socket_id);
+
+/**
+ * Allocate memory on the NUMA node of a network device and use hugepages if set.
+ *
+ * @param bufcnt
+ *   Number of buffers in the memory pool
+ * @param bufsz
+ *   The size of the buffers in the memory pool
+ * @param hugepage
+ *   Type of hugepage memory to allocate or non-hugepage memory.
+ * @param netdev
+ *   The netdev name string, the memory is not bound if the device has no NUMA node.
+ * @return
+ *   The mmap_t structure pointer of the memory allocated or NULL on error
+ */
+FGEN_API mmap_t *mmap_alloc_netdev(uint32_t bufcnt, uint32_t bufsz, mmap_type_t hugepage,
+                                   char *netdev);
+
 /**
  * Free the memory allocated
  *
@@ -116,6 +183,128 @@ FGEN_API void *mmap_addr(mmap_t *mm);
  */
 FGEN_API size_t mmap_size(mmap_t *mm, uint32_t *bufcnt, uint32_t *bufsz);
 
+/**
+ * Create a shared memory region other processes can map read-only.
+ *
+ * A named region is a file "fgen.<name>" in /dev/shm for 4KB pages or in a mounted hugetlbfs
+ * of the page size for hugepages. Without a name the region is an anonymous memfd, its file
+ * descriptor is passed to the other processes with fork() or SCM_RIGHTS. If the page size is
+ * not available the next smaller page size is used, as with mmap_alloc().
+ *
+ * The region is not visible to mmap_shared_attach() until mmap_shared_publish() is called.
+ *
+ * @param name
+ *   Name of the region or NULL for an anonymous memfd.
+ * @param bufcnt
+ *   Number of buffers in the memory region
+ * @param bufsz
+ *   The size of the buffers in the memory region
+ * @param hugepage
+ *   Type of hugepage memory to allocate or non-hugepage memory.
+ * @return
+ *   The mmap_t structure pointer of the region or NULL on error
+ */
+FGEN_API mmap_t *mmap_shared_create(const char *name, uint32_t bufcnt, uint32_t bufsz,
+                                    mmap_type_t hugepage);
+
+/**
+ * Mark a shared region as filled in, an anonymous memfd is also sealed against writes from new
+ * mappings and size changes.
+ *
+ * @param mm
+ *   The mmap_t pointer returned by mmap_shared_create()
+ * @return
+ *   0 on success or -1 on error
+ */
+FGEN_API int mmap_shared_publish(mmap_t *mm);
+
+/**
+ * Map a published shared region read-only by name.
+ *
+ * @param name
+ *   Name of the region given to mmap_shared_create()
+ * @return
+ *   The mmap_t structure pointer of the region or NULL on error, free it with mmap_free()
+ */
+FGEN_API mmap_t *mmap_shared_attach(const char *name);
+
+/**
+ * Map a published shared region read-only from a file descriptor.
+ *
+ * @param fd
+ *   File descriptor of the region, see mmap_fd(). The descriptor is duplicated.
+ * @return
+ *   The mmap_t structure pointer of the region or NULL on error, free it with mmap_free()
+ */
+FGEN_API mmap_t *mmap_shared_attach_fd(int fd);
+
+/**
+ * Remove the name of a shared region, the mapped regions stay valid until freed.
+ *
+ * @param name
+ *   Name of the region given to mmap_shared_create()
+ * @return
+ *   0 on success or -1 if the region was not found
+ */
+FGEN_API int mmap_shared_unlink(const char *name);
+
+/**
+ * Return the file descriptor of a shared region
+ *
+ * @param mm
+ *   The mmap_t pointer
+ * @return
+ *   The file descriptor or -1 if the region is not shared
+ */
+FGEN_API int mmap_fd(mmap_t *mm);
+
+/**
+ * Return the NUMA node of the memory region
+ *
+ * @param mm
+ *   The mmap_t pointer
+ * @return
+ *   The NUMA node of the first page or MMAP_SOCKET_ANY if not known
+ */
+FGEN_API int mmap_socket(mmap_t *mm);
+
+/**
+ * Test if a region uses transparent hugepages
+ *
+ * When the hugetlb pages of the requested size and of the smaller sizes are not available, a
+ * region is allocated as private 4KB pages with madvise(MADV_HUGEPAGE), if THP is enabled.
+ *
+ * @param mm
+ *   The mmap_t pointer
+ * @return
+ *   true if the region uses transparent hugepages
+ */
+FGEN_API bool mmap_thp(mmap_t *mm);
+
+/**
+ * Return a copy of the allocation stats of all page sizes and NUMA nodes
+ *
+ * The bytes in use of a page size or node are the allocated bytes minus the freed bytes.
+ *
+ * @param stats
+ *   The mmap_stats_t structure to fill in
+ * @return
+ *   0 on success or -1 if stats is NULL
+ */
+FGEN_API int mmap_stats_get(mmap_stats_t *stats);
+
+/**
+ * Return the allocation stats of a NUMA node
+ *
+ * @param socket_id
+ *   The NUMA node
+ * @param stats
+ *   The location to copy the stats to.
+ * @return
+ *   0 on success or -1 if the node is invalid
+ */
+FGEN_API int mmap_node_stats(int socket_id, mmap_node_stats_t *stats);
+
 /**
  * Find a memory hugepage type value by hugepage name
  *
@@ -137,6 +326,33 @@ FGEN_API mmap_type_t mmap_type_by_name(const char *htype);
  */
 FGEN_API const char *mmap_name_by_type(mmap_type_t typ);
 
+/**
+ * Prefault the following allocations in parallel
+ *
+ * Regions of at least MMAP_PREFAULT_MIN bytes are mapped without MAP_POPULATE and the pages are
+ * faulted in by worker threads, each on its own chunk of the region. The workers of a region
+ * bound to a NUMA node run on the lcores of that node. Needs MADV_POPULATE_WRITE (Linux 5.14),
+ * else the pages are faulted in by the allocating thread.
+ *
+ * @param nb_threads
+ *   Number of worker threads, 0 or 1 to fault in the pages in mmap().
+ * @param fn
+ *   Progress callback or NULL.
+ * @param arg
+ *   Argument passed to the progress callback.
+ */
+FGEN_API void mmap_set_prefault(uint32_t nb_threads, mmap_progress_t fn, void *arg);
+
+/**
+ * Return the time taken to fault in the pages of a region in parallel
+ *
+ * @param mm
+ *   The mmap_t pointer
+ * @return
+ *   The time in nanoseconds or 0 if the region was not prefaulted in parallel
+ */
+FGEN_API uint64_t mmap_prefault_ns(mmap_t *mm);
+
 /**
  * Set the default memory type for allocations
  *
@@ -0,0 +1,363 @@
+/* SPDX-License-Identifier: BSD-3-Clause
+ * Copyright (c) 2023-2025 Intel Corporation
+ */
+
+#include <stdbool.h>        // for bool, false, true
+#include <stdint.h>         // for uint32_t, uint64_t, uintptr_t
+#include <stdlib.h>         // for posix_memalign, free
+#include <string.h>         // for memcpy, memset
+#include <sched.h>          // for sched_yield
+#include <pthread.h>        // for pthread_key_create, pthread_once, pthread_setspecific
+#include <fgen_common.h>    // for FGEN_PTR_ADD, FGEN_PTR_DIFF, __fgen_cache_aligned
+#include <fgen_atomic.h>    // for FGEN_ATOMIC, FGEN_MEMORY_ORDER
+
+#include "fgen_mpool.h"
+#include "fgen_log.h"
+
+/*
+ * The free buffers are held in a ring of pointers with free running head and tail indexes for
+ * the producers and the consumers, the same scheme as the DPDK rte_ring. A thread reserves slots
+ * by moving the head with a compare and swap, copies the pointers and then waits for the threads
+ * ahead of it to move the tail before it moves the tail itself. The ring size is a power of 2 at
+ * least bufcnt, so a put of buffers taken from the pool always finds room.
+ */
+typedef struct {
+    FGEN_ATOMIC(uint_least32_t) head; /**< Next slot to reserve */
+    FGEN_ATOMIC(uint_least32_t) tail; /**< Slots before tail are done */
+} __fgen_cache_aligned mpool_headtail_t;
+
+typedef struct {
+    uint32_t len;                    /**< Number of buffers in the cache */
+    void *objs[MPOOL_CACHE_MAX * 3]; /**< Cached buffers, the last one is the most recent */
+} __fgen_cache_aligned mpool_cache_t;
+
+struct mpool_s {
+    mmap_t *mm;        /**< Memory region of the buffers */
+    void *base;        /**< Address of buffer 0 */
+    uint32_t bufcnt;   /**< Number of buffers in the pool */
+    uint32_t bufsz;    /**< Size of each buffer */
+    uint32_t cache_sz; /**< Number of buffers a thread cache refills to */
+    uint32_t mask;     /**< Ring size - 1 */
+    mpool_cache_t *caches[MPOOL_MAX_THREADS]; /**< Thread caches, allocated on first use */
+    mpool_headtail_t prod;                    /**< Producer indexes */
+    mpool_headtail_t cons;                    /**< Consumer indexes */
+    void *ring[] __fgen_cache_aligned;        /**< Ring of free buffer pointers */
+};
+
+/*
+ * A thread takes the lowest free cache slot on its first get or put and a thread specific key
+ * gives the slot back when the thread exits, so the caches of a pool outlive the threads and a
+ * new thread takes over the buffers left in the cache of its slot.
+ */
+#define MPOOL_ID_WORDS (MPOOL_MAX_THREADS / 64)
+
+static FGEN_ATOMIC(uint_least64_t) mpool_thread_ids[MPOOL_ID_WORDS]; /**< Bitmap of used slots */
+static pthread_once_t mpool_thread_once = PTHREAD_ONCE_INIT;
+static pthread_key_t mpool_thread_key;
+static __thread int mpool_thread_id = -1;
+
+/* The structures are cache aligned, which calloc() does not give */
+static void *
+zalloc_aligned(size_t sz)
+{
+    void *p;
+
+    if (posix_memalign(&p, FGEN_CACHE_LINE_SIZE, sz))
+        return NULL;
+    return memset(p, 0, sz);
+}
+
+static void
+ring_update_tail(mpool_headtail_t *ht, uint32_t old, uint32_t new)
+{
+    /* Wait for the threads which reserved slots before us, acquire to pass on their stores */
+    while (atomic_load_explicit(&ht->tail, FGEN_MEMORY_ORDER(acquire)) != old)
+        sched_yield();
+    atomic_store_explicit(&ht->tail, new, FGEN_MEMORY_ORDER(release));
+}
+
+static bool
+ring_enqueue(mpool_t *mp, void *const *objs, uint32_t n)
+{
+    uint_least32_t head, tail;
+
+    head = atomic_load_explicit(&mp->prod.head, FGEN_MEMORY_ORDER(relaxed));
+    do {
+        tail = atomic_load_explicit(&mp->cons.tail, FGEN_MEMORY_ORDER(acquire));
+        if (n > (mp->mask + 1) - (uint32_t)(head - tail))
+            return false;
+    } while (!atomic_compare_exchange_weak_explicit(&mp->prod.head, &head, head + n,
+                                                    FGEN_MEMORY_ORDER(relaxed),
+                                                    FGEN_MEMORY_ORDER(relaxed)));
+
+    for (uint32_t i = 0; i < n; i++)
+        mp->ring[(head + i) & mp->mask] = objs[i];
+
+    ring_update_tail(&mp->prod, head, head + n);
+    return true;
+}
+
+static bool
+ring_dequeue(mpool_t *mp, void **objs, uint32_t n)
+{
+    uint_least32_t head, tail;
+
+    head = atomic_load_explicit(&mp->cons.head, FGEN_MEMORY_ORDER(relaxed));
+    do {
+        tail = atomic_load_explicit(&mp->prod.tail, FGEN_MEMORY_ORDER(acquire));
+        if (n > (uint32_t)(tail - head))
+            return false;
+    } while (!atomic_compare_exchange_weak_explicit(&mp->cons.head, &head, head + n,
+                                                    FGEN_MEMORY_ORDER(relaxed),
+                                                    FGEN_MEMORY_ORDER(relaxed)));
+
+    for (uint32_t i = 0; i < n; i++)
+        objs[i] = mp->ring[(head + i) & mp->mask];
+
+    ring_update_tail(&mp->cons, head, head + n);
+    return true;
+}
+
+/* Thread exit destructor, release to pass the stores to the cache on to the next owner */
+static void
+thread_id_free(void *arg)
+{
+    int id = (int)((uintptr_t)arg - 1);
+
+    /* Gets and puts from the later destructors of the thread go to the ring */
+    mpool_thread_id = MPOOL_MAX_THREADS;
+    atomic_fetch_and_explicit(&mpool_thread_ids[id / 64], ~(UINT64_C(1) << (id % 64)),
+                              FGEN_MEMORY_ORDER(release));
+}
+
+static void
+thread_key_create(void)
+{
+    if (pthread_key_create(&mpool_thread_key, thread_id_free))
+        FGEN_ERR("Failed to create the thread key, cache slots are not reused\n");
+}
+
+/* Take the lowest free cache slot, -1 if all MPOOL_MAX_THREADS slots are used */
+static int
+thread_id_alloc(void)
+{
+    pthread_once(&mpool_thread_once, thread_key_create);
+
+    for (int w = 0; w < MPOOL_ID_WORDS; w++) {
+        uint_least64_t used;
+
+        used = atomic_load_explicit(&mpool_thread_ids[w], FGEN_MEMORY_ORDER(relaxed));
+
+        while (~used) {
+            uint_least64_t bit = UINT64_C(1) << __builtin_ctzll(~used);
+            int id             = (w * 64) + __builtin_ctzll(~used);
+
+            if (!atomic_compare_exchange_weak_explicit(&mpool_thread_ids[w], &used, used | bit,
+                                                       FGEN_MEMORY_ORDER(acquire),
+                                                       FGEN_MEMORY_ORDER(relaxed)))
+                continue;
+
+            pthread_setspecific(mpool_thread_key, (void *)(uintptr_t)(id + 1));
+            return id;
+        }
+    }
+    return -1;
+}
+
+/* Return the cache of the calling thread, NULL if caching is off or out of thread slots */
+static mpool_cache_t *
+thread_cache(mpool_t *mp)
+{
+    int id = mpool_thread_id;
+
+    if (mp->cache_sz == 0)
+        return NULL;
+
+    /* A thread without a slot tries again on each call, a slot is freed when a thread exits */
+    if (id < 0) {
+        id = thread_id_alloc();
+        if (id < 0)
+            return NULL;
+        mpool_thread_id = id;
+    }
+    if (id >= MPOOL_MAX_THREADS)
+        return NULL;
+
+    if (!mp->caches[id])
+        mp->caches[id] = zalloc_aligned(sizeof(mpool_cache_t));
+    return mp->caches[id];
+}
+
+mpool_t *
+mpool_create(uint32_t bufcnt, uint32_t bufsz, uint32_t cache_sz, mmap_type_t hugepage)
+{
+    mpool_t *mp;
+    uint32_t ring_sz;
+
+    if (!bufcnt || !bufsz || bufcnt > (1U << 31))
+        FGEN_NULL_RET("bufcnt %u or bufsz %u is invalid\n", bufcnt, bufsz);
+    if (cache_sz > MPOOL_CACHE_MAX)
+        FGEN_NULL_RET("cache size %u is greater than %u\n", cache_sz, MPOOL_CACHE_MAX);
+
+    if (cache_sz == 0)
+        cache_sz = MPOOL_CACHE_DEFAULT;
+    /* A few full caches must not hold all the buffers of a small pool */
+    if (cache_sz > bufcnt / 8)
+        cache_sz = bufcnt / 8;
+
+    ring_sz = fgen_align32pow2(bufcnt);
+
+    mp = zalloc_aligned(sizeof(mpool_t) + (ring_sz * sizeof(void *)));
+    if (!mp)
+        FGEN_NULL_RET("Failed to allocate mpool_t structure\n");
+
+    mp->mm = mmap_alloc(bufcnt, bufsz, hugepage);
+    if (!mp->mm)
+        FGEN_ERR_GOTO(leave, "Failed to allocate %u buffers of %u bytes\n", bufcnt, bufsz);
+
+    mp->base     = mmap_addr(mp->mm);
+    mp->bufcnt   = bufcnt;
+    mp->bufsz    = bufsz;
+    mp->cache_sz = cache_sz;
+    mp->mask     = ring_sz - 1;
+
+    for (uint32_t i = 0; i < bufcnt; i++)
+        mp->ring[i] = FGEN_PTR_ADD(mp->base, (uint64_t)i * bufsz);
+    atomic_init(&mp->prod.head, bufcnt);
+    atomic_init(&mp->prod.tail, bufcnt);
+    atomic_init(&mp->cons.head, 0);
+    atomic_init(&mp->cons.tail, 0);
+
+    return mp;
+
+leave:
+    free(mp);
+    return NULL;
+}
+
+void
+mpool_destroy(mpool_t *mp)
+{
+    if (!mp)
+        return;
+
+    for (int i = 0; i < MPOOL_MAX_THREADS; i++)
+        free(mp->caches[i]);
+    mmap_free(mp->mm);
+    free(mp);
+}
+
+int
+mpool_get_bulk(mpool_t *mp, void **bufs, uint32_t n)
+{
+    mpool_cache_t *c;
+
+    if (!mp || !bufs)
+        return -1;
+
+    c = thread_cache(mp);
+    if (!c || n > mp->cache_sz)
+        return ring_dequeue(mp, bufs, n) ? 0 : -1;
+
+    if (c->len < n) {
+        /* Refill the cache to cache_sz after taking n, or take the n from the ring */
+        uint32_t fill = mp->cache_sz + n - c->len;
+
+        if (ring_dequeue(mp, &c->objs[c->len], fill))
+            c->len += fill;
+        else
+            return ring_dequeue(mp, bufs, n) ? 0 : -1;
+    }
+
+    for (uint32_t i = 0; i < n; i++)
+        bufs[i] = c->objs[--c->len];
+
+    return 0;
+}
+
+void
+mpool_put_bulk(mpool_t *mp, void *const *bufs, uint32_t n)
+{
+    mpool_cache_t *c;
+
+    if (!mp || !bufs)
+        return;
+
+    c = thread_cache(mp);
+    if (!c || n > mp->cache_sz) {
+        if (!ring_enqueue(mp, bufs, n))
+            FGEN_ERR("Pool ring is full, %u buffers not from this pool\n", n);
+        return;
+    }
+
+    memcpy(&c->objs[c->len], bufs, n * sizeof(void *));
+    c->len += n;
+
+    /* Move the buffers above cache_sz to the ring */
+    if (c->len >= mp->cache_sz * 2) {
+        if (!ring_enqueue(mp, &c->objs[mp->cache_sz], c->len - mp->cache_sz))
+            FGEN_ERR("Pool ring is full, buffers not from this pool\n");
+        c->len = mp->cache_sz;
+    }
+}
+
+void
+mpool_cache_flush(mpool_t *mp)
+{
+    mpool_cache_t *c;
+
+    if (!mp)
+        return;
+
+    c = thread_cache(mp);
+    if (c && c->len) {
+        if (!ring_enqueue(mp, c->objs, c->len))
+            FGEN_ERR("Pool ring is full, buffers not from this pool\n");
+        c->len = 0;
+    }
+}
+
+uint32_t
+mpool_avail(mpool_t *mp)
+{
+    uint32_t cnt;
+
+    if (!mp)
+        return 0;
+
+    cnt = atomic_load_explicit(&mp->prod.tail, FGEN_MEMORY_ORDER(acquire)) -
+          atomic_load_explicit(&mp->cons.tail, FGEN_MEMORY_ORDER(acquire));
+    for (int i = 0; i < MPOOL_MAX_THREADS; i++)
+        if (mp->caches[i])
+            cnt += mp->caches[i]->len;
+
+    return cnt;
+}
+
+int64_t
+mpool_index(mpool_t *mp, const void *buf)
+{
+    uint64_t off;
+
+    if (!mp || (uintptr_t)buf < (uintptr_t)mp->base)
+        return -1;
+
+    off = FGEN_PTR_DIFF(buf, mp->base) / mp->bufsz;
+
+    return (off < mp->bufcnt) ? (int64_t)off : -1;
+}
+
+void *
+mpool_buf_at(mpool_t *mp, uint32_t idx)
+{
+    if (!mp || idx >= mp->bufcnt)
+        return NULL;
+
+    return FGEN_PTR_ADD(mp->base, (uint64_t)idx * mp->bufsz);
+}
+
+mmap_t *
+mpool_mmap(mpool_t *mp)
+{
+    return mp ? mp->mm : NULL;
+}
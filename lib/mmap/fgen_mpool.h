@@ -0,0 +1,175 @@
+/* SPDX-License-Identifier: BSD-3-Clause
+ * Copyright (c) 2023-2025 Intel Corporation
+ */
+
+#ifndef _FGEN_MPOOL_H_
+#define _FGEN_MPOOL_H_
+
+/**
+ * @file
+ * FGEN fixed size buffer pool
+ *
+ * The buffers of a pool are carved out of one mmap_alloc() region, buffer i is at the offset
+ * i * bufsz, which allows the region to be registered as an AF_XDP or AF_PACKET UMEM. The free
+ * buffers are kept in a lock-free multi-producer/multi-consumer ring and each thread has a small
+ * cache in front of the ring, so most get/put calls touch no shared cache lines.
+ */
+
+#include <stddef.h>        // for size_t
+#include <stdint.h>        // for uint32_t
+
+#include <fgen_common.h>
+#include <fgen_mmap.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define MPOOL_CACHE_MAX     512 /**< Max number of buffers in a thread cache */
+#define MPOOL_CACHE_DEFAULT 64  /**< Cache size used when the cache size is not given */
+#define MPOOL_MAX_THREADS   128 /**< Number of live threads with a cache, the others use the ring */
+
+typedef struct mpool_s mpool_t; /**< Opaque pointer to internal pool data */
+
+/**
+ * Create a pool of fixed size buffers.
+ *
+ * @param bufcnt
+ *   Number of buffers in the pool.
+ * @param bufsz
+ *   The size of each buffer in bytes.
+ * @param cache_sz
+ *   Number of buffers cached per thread, 0 for the default and at most MPOOL_CACHE_MAX.
+ * @param hugepage
+ *   Type of hugepage memory to allocate or non-hugepage memory.
+ * @return
+ *   The mpool_t pointer or NULL on error
+ */
+FGEN_API mpool_t *mpool_create(uint32_t bufcnt, uint32_t bufsz, uint32_t cache_sz,
+                               mmap_type_t hugepage);
+
+/**
+ * Free the pool and its memory region, the buffers must not be used after this call.
+ *
+ * @param mp
+ *   The mpool_t pointer, can be NULL.
+ */
+FGEN_API void mpool_destroy(mpool_t *mp);
+
+/**
+ * Get a number of buffers from the pool, all of them or none.
+ *
+ * @param mp
+ *   The mpool_t pointer
+ * @param bufs
+ *   Array to place the buffer pointers.
+ * @param n
+ *   Number of buffers to get.
+ * @return
+ *   0 on success or -1 if not enough buffers are free
+ */
+FGEN_API int mpool_get_bulk(mpool_t *mp, void **bufs, uint32_t n);
+
+/**
+ * Return a number of buffers to the pool.
+ *
+ * @param mp
+ *   The mpool_t pointer
+ * @param bufs
+ *   Array of buffer pointers taken from this pool.
+ * @param n
+ *   Number of buffers to return.
+ */
+FGEN_API void mpool_put_bulk(mpool_t *mp, void *const *bufs, uint32_t n);
+
+/**
+ * Get one buffer from the pool.
+ *
+ * @param mp
+ *   The mpool_t pointer
+ * @return
+ *   The buffer pointer or NULL if the pool is empty
+ */
+static inline void *
+mpool_get(mpool_t *mp)
+{
+    void *buf;
+
+    return (mpool_get_bulk(mp, &buf, 1) == 0) ? buf : NULL;
+}
+
+/**
+ * Return one buffer to the pool.
+ *
+ * @param mp
+ *   The mpool_t pointer
+ * @param buf
+ *   The buffer pointer taken from this pool.
+ */
+static inline void
+mpool_put(mpool_t *mp, void *buf)
+{
+    mpool_put_bulk(mp, &buf, 1);
+}
+
+/**
+ * Move the buffers in the cache of the calling thread back to the ring.
+ *
+ * A thread using the pool calls this before it exits, else its cached buffers are lost.
+ *
+ * @param mp
+ *   The mpool_t pointer
+ */
+FGEN_API void mpool_cache_flush(mpool_t *mp);
+
+/**
+ * Return the number of free buffers, the ring and all the thread caches.
+ *
+ * The value is only exact when no other thread is using the pool.
+ *
+ * @param mp
+ *   The mpool_t pointer
+ * @return
+ *   The number of free buffers
+ */
+FGEN_API uint32_t mpool_avail(mpool_t *mp);
+
+/**
+ * Return the index of a buffer in the pool, the UMEM frame number.
+ *
+ * @param mp
+ *   The mpool_t pointer
+ * @param buf
+ *   A pointer into a buffer of the pool.
+ * @return
+ *   The buffer index or -1 if buf is not in the pool
+ */
+FGEN_API int64_t mpool_index(mpool_t *mp, const void *buf);
+
+/**
+ * Return the buffer at an index in the pool.
+ *
+ * @param mp
+ *   The mpool_t pointer
+ * @param idx
+ *   The buffer index.
+ * @return
+ *   The buffer pointer or NULL if idx is out of range
+ */
+FGEN_API void *mpool_buf_at(mpool_t *mp, uint32_t idx);
+
+/**
+ * Return the memory region backing the pool.
+ *
+ * @param mp
+ *   The mpool_t pointer
+ * @return
+ *   The mmap_t pointer of the region or NULL on error
+ */
+FGEN_API mmap_t *mpool_mmap(mpool_t *mp);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _FGEN_MPOOL_H_ */
@@ -0,0 +1,220 @@
+/* SPDX-License-Identifier: BSD-3-Clause
+ * Copyright (c) 2023-2025 Intel Corporation
+ */
+
+#include <stdbool.h>           // for bool, false, true
+#include <stdint.h>            // for uint64_t, uint32_t
+#include <errno.h>             // for errno, EINVAL
+#include <pthread.h>           // for pthread_create, pthread_join, pthread_attr_t
+#include <sched.h>             // for cpu_set_t, CPU_SET, CPU_ZERO
+#include <string.h>            // for strerror
+#include <sys/mman.h>          // for madvise, MADV_POPULATE_WRITE
+#include <time.h>              // for clock_gettime, timespec
+#include <fgen_common.h>       // for FGEN_PTR_ADD, FGEN_MIN
+#include <fgen_atomic.h>       // for FGEN_ATOMIC, FGEN_MEMORY_ORDER
+
+#include "mmap_private.h"        // for mmap_data
+#include "fgen_mmap.h"
+#include "fgen_log.h"
+#include "fgen_system.h"        // for fgen_max_lcores, fgen_socket_id
+
+/*
+ * A region is cut into one chunk of whole pages per worker and each worker faults in its chunk
+ * with MADV_POPULATE_WRITE a slice at a time. The madvise() call returns an error where a touch
+ * of a hugepage the kernel can not back would raise SIGBUS, which can not be recovered from in a
+ * worker thread, so a failure is passed back to mmap_alloc() to try a smaller page size.
+ */
+
+#define PREFAULT_MAX_THREADS 64                 /**< Max number of worker threads */
+#define PREFAULT_SLICE       (16 * 1024 * 1024) /**< Bytes faulted in between progress updates */
+#define PREFAULT_POLL_NS     (100 * 1000 * 1000) /**< Time between progress updates */
+
+#ifndef MADV_POPULATE_WRITE
+#define MADV_POPULATE_WRITE 23 /* Older headers, a kernel without it returns EINVAL */
+#endif
+
+static uint32_t prefault_threads;
+static mmap_progress_t prefault_fn;
+static void *prefault_arg;
+
+typedef struct {
+    pthread_mutex_t lock;             /**< Protects nb_finished */
+    pthread_cond_t cond;              /**< Signaled when a worker finishes */
+    uint32_t nb_finished;             /**< Number of workers finished */
+    FGEN_ATOMIC(uint_least64_t) done; /**< Bytes faulted in by all the workers */
+    FGEN_ATOMIC(int_least32_t) err;   /**< First errno of the workers */
+} prefault_state_t;
+
+typedef struct {
+    void *va;                /**< Start of the chunk */
+    size_t len;              /**< Length of the chunk */
+    size_t slice;            /**< Bytes faulted in per madvise() call */
+    prefault_state_t *state; /**< State shared by the workers */
+} prefault_chunk_t;
+
+void
+mmap_set_prefault(uint32_t nb_threads, mmap_progress_t fn, void *arg)
+{
+    prefault_threads = FGEN_MIN(nb_threads, (uint32_t)PREFAULT_MAX_THREADS);
+    prefault_fn      = fn;
+    prefault_arg     = arg;
+}
+
+bool
+mmap_prefault_enabled(size_t sz)
+{
+    return prefault_threads > 1 && sz >= MMAP_PREFAULT_MIN;
+}
+
+static void *
+prefault_worker(void *arg)
+{
+    prefault_chunk_t *c = arg;
+    prefault_state_t *s = c->state;
+
+    for (size_t off = 0; off < c->len; off += c->slice) {
+        size_t n = FGEN_MIN(c->slice, c->len - off);
+
+        if (atomic_load_explicit(&s->err, FGEN_MEMORY_ORDER(relaxed)))
+            break;
+        if (madvise(FGEN_PTR_ADD(c->va, off), n, MADV_POPULATE_WRITE)) {
+            atomic_store_explicit(&s->err, errno, FGEN_MEMORY_ORDER(relaxed));
+            break;
+        }
+        atomic_fetch_add_explicit(&s->done, n, FGEN_MEMORY_ORDER(relaxed));
+    }
+
+    pthread_mutex_lock(&s->lock);
+    s->nb_finished++;
+    pthread_cond_signal(&s->cond);
+    pthread_mutex_unlock(&s->lock);
+
+    return NULL;
+}
+
+/* Run the workers of a bound region on the lcores of its node, else anywhere */
+static void
+prefault_attr(pthread_attr_t *attr, int socket)
+{
+    cpu_set_t cpus;
+    int cnt = 0;
+
+    pthread_attr_init(attr);
+    if (socket < 0)
+        return;
+
+    CPU_ZERO(&cpus);
+    for (unsigned lcore = 0; lcore < fgen_max_lcores() && lcore < CPU_SETSIZE; lcore++) {
+        if ((int)fgen_socket_id(lcore) == socket) {
+            CPU_SET(lcore, &cpus);
+            cnt++;
+        }
+    }
+    if (cnt && pthread_attr_setaffinity_np(attr, sizeof(cpus), &cpus))
+        FGEN_WARN("Failed to set prefault affinity to socket %d\n", socket);
+}
+
+static uint64_t
+prefault_now_ns(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+int
+mmap_prefault(struct mmap_data *mm, void *va)
+{
+    prefault_state_t s = {.nb_finished = 0};
+    prefault_chunk_t chunks[PREFAULT_MAX_THREADS];
+    pthread_t tids[PREFAULT_MAX_THREADS];
+    bool started[PREFAULT_MAX_THREADS] = {false};
+    uint64_t pages, per, start;
+    uint32_t nb;
+    pthread_attr_t attr;
+    pthread_condattr_t cattr;
+    struct timespec ts;
+
+    pages = mm->sz / mm->align;
+    nb    = (uint32_t)FGEN_MIN((uint64_t)prefault_threads, pages);
+    per   = (pages + nb - 1) / nb;
+    nb    = (uint32_t)((pages + per - 1) / per);
+
+    atomic_init(&s.done, 0);
+    atomic_init(&s.err, 0);
+    pthread_mutex_init(&s.lock, NULL);
+    pthread_condattr_init(&cattr);
+    pthread_condattr_setclock(&cattr, CLOCK_MONOTONIC);
+    pthread_cond_init(&s.cond, &cattr);
+    pthread_condattr_destroy(&cattr);
+
+    start = prefault_now_ns();
+    prefault_attr(&attr, mm->socket);
+
+    for (uint32_t i = 0; i < nb; i++) {
+        prefault_chunk_t *c = &chunks[i];
+        size_t off          = (size_t)(i * per) * mm->align;
+
+        c->va          = FGEN_PTR_ADD(va, off);
+        c->len         = FGEN_MIN((size_t)per * mm->align, mm->sz - off);
+        c->slice       = FGEN_MAX((size_t)PREFAULT_SLICE, (size_t)mm->align);
+        c->state       = &s;
+
+        started[i] = (pthread_create(&tids[i], &attr, prefault_worker, c) == 0);
+    }
+    pthread_attr_destroy(&attr);
+
+    /* A chunk without a worker is faulted in by this thread */
+    for (uint32_t i = 0; i < nb; i++)
+        if (!started[i])
+            prefault_worker(&chunks[i]);
+
+    /* Wake up when the last worker finishes or every PREFAULT_POLL_NS to report the progress */
+    pthread_mutex_lock(&s.lock);
+    while (s.nb_finished < nb) {
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        ts.tv_nsec += PREFAULT_POLL_NS;
+        if (ts.tv_nsec >= 1000000000L) {
+            ts.tv_sec++;
+            ts.tv_nsec -= 1000000000L;
+        }
+        if (pthread_cond_timedwait(&s.cond, &s.lock, &ts) == ETIMEDOUT && prefault_fn) {
+            pthread_mutex_unlock(&s.lock);
+            prefault_fn(atomic_load(&s.done), mm->sz, prefault_arg);
+            pthread_mutex_lock(&s.lock);
+        }
+    }
+    pthread_mutex_unlock(&s.lock);
+
+    for (uint32_t i = 0; i < nb; i++)
+        if (started[i])
+            pthread_join(tids[i], NULL);
+    pthread_cond_destroy(&s.cond);
+    pthread_mutex_destroy(&s.lock);
+
+    if (atomic_load(&s.err) == EINVAL && atomic_load(&s.done) == 0) {
+        FGEN_WARN("MADV_POPULATE_WRITE not supported, prefault with one thread\n");
+        return 1;
+    }
+    if (atomic_load(&s.err)) {
+        errno = atomic_load(&s.err);
+        return -1;
+    }
+
+    mm->prefault_ns = prefault_now_ns() - start;
+    if (prefault_fn)
+        prefault_fn(mm->sz, mm->sz, prefault_arg);
+    FGEN_INFO("Prefaulted %'lu bytes with %u threads in %'lu us\n", (uint64_t)mm->sz, nb,
+              mm->prefault_ns / 1000);
+
+    return 0;
+}
+
+uint64_t
+mmap_prefault_ns(mmap_t *_mm)
+{
+    struct mmap_data *mm = _mm;
+
+    return mm ? mm->prefault_ns : 0;
+}
@@ -0,0 +1,336 @@
+/* SPDX-License-Identifier: BSD-3-Clause
+ * Copyright (c) 2023-2025 Intel Corporation
+ */
+
+// IWYU pragma: no_include <bits/mman-map-flags-generic.h>
+
+#include <stdbool.h>           // for bool, false, true
+#include <stdio.h>             // for snprintf, fopen, fgets, sscanf
+#include <stdlib.h>            // for calloc, free, strtoull
+#include <string.h>            // for strerror, strstr
+#include <errno.h>             // for errno, EEXIST
+#include <fcntl.h>             // for open, fcntl, O_RDWR, F_ADD_SEALS
+#include <limits.h>            // for PATH_MAX
+#include <unistd.h>            // for close, ftruncate, unlink, getpagesize, dup
+#include <sys/mman.h>          // for mmap, munmap, memfd_create, MFD_HUGETLB
+#include <sys/stat.h>          // for fstat
+#include <fgen_common.h>       // for fgen_log2_u64, FGEN_ALIGN_CEIL, FGEN_PTR_ADD
+#include <fgen_atomic.h>       // for FGEN_ATOMIC, FGEN_MEMORY_ORDER
+
+#include "mmap_private.h"        // for mmap_data
+#include "fgen_mmap.h"
+#include "fgen_log.h"
+
+/*
+ * A shared region starts with a header holding the buffer layout and a ready flag, the buffers
+ * follow it. The creator sets ready with a release store once the buffers are filled in and the
+ * attaching processes check it, so a region is never used half written.
+ */
+
+#define SHARED_MAGIC  0x46474d53 /* "FGMS" */
+#define SHARED_PREFIX "fgen."
+#define SHARED_SHM    "/dev/shm"
+
+typedef struct {
+    uint32_t magic;                    /**< SHARED_MAGIC */
+    uint32_t typ;                      /**< mmap_type_t of the region */
+    uint32_t bufcnt;                   /**< Number of buffers in the region */
+    uint32_t bufsz;                    /**< Size of each buffer */
+    FGEN_ATOMIC(uint_least32_t) ready; /**< Set by mmap_shared_publish() */
+} __fgen_cache_aligned shared_hdr_t;
+
+static uint64_t
+page_size(mmap_type_t typ)
+{
+    switch (typ) {
+    case MMAP_HUGEPAGE_1GB:
+        return 1024 * 1024 * 1024;
+    case MMAP_HUGEPAGE_2MB:
+        return 2 * 1024 * 1024;
+    default:
+        return getpagesize();
+    }
+}
+
+/* Find the hugetlbfs mount of a page size, a mount without a pagesize option is taken as 2MB */
+static int
+hugetlbfs_dir(mmap_type_t typ, char *dir, size_t len)
+{
+    char line[PATH_MAX + 128], mnt[PATH_MAX], fs[32], opts[256];
+    int ret = -1;
+    FILE *f;
+
+    f = fopen("/proc/mounts", "r");
+    if (!f)
+        return -1;
+
+    while (ret < 0 && fgets(line, sizeof(line), f)) {
+        uint64_t sz = 2 * 1024 * 1024;
+        char *p, *end;
+
+        if (sscanf(line, "%*s %4095s %31s %255s", mnt, fs, opts) != 3 || strcmp(fs, "hugetlbfs"))
+            continue;
+
+        p = strstr(opts, "pagesize=");
+        if (p) {
+            sz = strtoull(p + 9, &end, 10);
+            switch (*end) {
+            case 'G':
+                sz <<= 30;
+                break;
+            case 'M':
+                sz <<= 20;
+                break;
+            case 'K':
+                sz <<= 10;
+                break;
+            }
+        }
+        if (sz == page_size(typ) && snprintf(dir, len, "%s", mnt) < (int)len)
+            ret = 0;
+    }
+    fclose(f);
+
+    return ret;
+}
+
+static int
+shared_path(const char *name, mmap_type_t typ, char *path, size_t len)
+{
+    char dir[PATH_MAX];
+    int n;
+
+    if (typ == MMAP_HUGEPAGE_4KB)
+        snprintf(dir, sizeof(dir), "%s", SHARED_SHM);
+    else if (hugetlbfs_dir(typ, dir, sizeof(dir)) < 0)
+        return -1;
+
+    n = snprintf(path, len, "%s/" SHARED_PREFIX "%s", dir, name);
+
+    return (n > 0 && (size_t)n < len) ? 0 : -1;
+}
+
+/* Map a region file and set up its mmap_data, the file descriptor is owned by the region */
+static struct mmap_data *
+shared_map(int fd, size_t map_sz, mmap_type_t typ, bool readonly)
+{
+    struct mmap_data *mm;
+    int prot = readonly ? PROT_READ : PROT_READ | PROT_WRITE;
+    void *va;
+
+    va = mmap(NULL, map_sz, prot, MAP_SHARED | MAP_POPULATE, fd, 0);
+    if (va == MAP_FAILED)
+        return NULL;
+
+    mm = calloc(1, sizeof(struct mmap_data));
+    if (!mm) {
+        munmap(va, map_sz);
+        return NULL;
+    }
+
+    mm->shared   = true;
+    mm->readonly = readonly;
+    mm->fd       = fd;
+    mm->base     = va;
+    mm->map_sz   = map_sz;
+    mm->addr     = FGEN_PTR_ADD(va, sizeof(shared_hdr_t));
+    mm->sz       = map_sz - sizeof(shared_hdr_t);
+    mm->typ      = typ;
+    mm->align    = page_size(typ);
+    mm->socket   = MMAP_SOCKET_ANY;
+
+    return mm;
+}
+
+mmap_t *
+mmap_shared_create(const char *name, uint32_t bufcnt, uint32_t bufsz, mmap_type_t typ)
+{
+    char path[PATH_MAX];
+    struct mmap_data *mm;
+    shared_hdr_t *hdr;
+    size_t map_sz;
+    int fd;
+
+    if (!bufcnt || !bufsz)
+        FGEN_NULL_RET("bufcnt %u * bufsz %u is zero\n", bufcnt, bufsz);
+    if (typ < MMAP_HUGEPAGE_4KB || typ >= MMAP_HUGEPAGE_CNT)
+        typ = MMAP_HUGEPAGE_4KB;
+
+    /* Try the requested page size and degrade to the next smaller size */
+    for (int t = typ; t >= MMAP_HUGEPAGE_4KB; t--) {
+        const char *tname = mmap_name_by_type(t);
+
+        map_sz = FGEN_ALIGN_CEIL(sizeof(shared_hdr_t) + (uint64_t)bufcnt * bufsz, page_size(t));
+
+        if (name) {
+            if (shared_path(name, t, path, sizeof(path)) < 0) {
+                FGEN_WARN("No hugetlbfs mounted for %s pages\n", tname);
+                continue;
+            }
+            fd = open(path, O_RDWR | O_CREAT | O_EXCL, 0644);
+            if (fd < 0 && errno == EEXIST)
+                FGEN_NULL_RET("Shared region %s already exists\n", path);
+        } else {
+            unsigned flags = MFD_ALLOW_SEALING;
+
+            /* The memfd hugepage size bits are the same as the mmap ones */
+            if (t != MMAP_HUGEPAGE_4KB)
+                flags |= MFD_HUGETLB | (fgen_log2_u64(page_size(t)) << MAP_HUGE_SHIFT);
+            fd = memfd_create(SHARED_PREFIX "anon", flags);
+        }
+        if (fd < 0) {
+            FGEN_WARN("Failed to create %s shared region: %s\n", tname, strerror(errno));
+            continue;
+        }
+
+        mm = NULL;
+        if (ftruncate(fd, map_sz) == 0)
+            mm = shared_map(fd, map_sz, t, false);
+        if (!mm) {
+            FGEN_WARN("Failed to map %s shared region: %s\n", tname, strerror(errno));
+            close(fd);
+            if (name)
+                unlink(path);
+            continue;
+        }
+
+        mm->memfd  = (name == NULL);
+        mm->bufcnt = bufcnt;
+        mm->bufsz  = bufsz;
+
+        hdr         = mm->base;
+        hdr->magic  = SHARED_MAGIC;
+        hdr->typ    = t;
+        hdr->bufcnt = bufcnt;
+        hdr->bufsz  = bufsz;
+        atomic_store_explicit(&hdr->ready, 0, FGEN_MEMORY_ORDER(relaxed));
+
+        return (mmap_t *)mm;
+    }
+
+    FGEN_NULL_RET("Failed to create shared region of %'lu bytes\n", (uint64_t)bufcnt * bufsz);
+}
+
+int
+mmap_shared_publish(mmap_t *_mm)
+{
+    struct mmap_data *mm = _mm;
+    shared_hdr_t *hdr;
+
+    if (!mm || !mm->shared || mm->readonly)
+        FGEN_ERR_RET("Region is not a shared region created by this process\n");
+
+    hdr = mm->base;
+    atomic_store_explicit(&hdr->ready, 1, FGEN_MEMORY_ORDER(release));
+
+    if (mm->memfd) {
+        int seals = F_SEAL_SHRINK | F_SEAL_GROW | F_SEAL_SEAL;
+
+#ifdef F_SEAL_FUTURE_WRITE
+        seals |= F_SEAL_FUTURE_WRITE;
+#endif
+        if (fcntl(mm->fd, F_ADD_SEALS, seals) < 0)
+            FGEN_WARN("Failed to seal shared region: %s\n", strerror(errno));
+    }
+
+    return 0;
+}
+
+mmap_t *
+mmap_shared_attach_fd(int fd)
+{
+    struct mmap_data *mm;
+    shared_hdr_t *hdr;
+    struct stat st;
+
+    fd = dup(fd);
+    if (fd < 0)
+        FGEN_NULL_RET("Failed to dup shared region fd: %s\n", strerror(errno));
+
+    if (fstat(fd, &st) < 0 || (size_t)st.st_size < sizeof(shared_hdr_t))
+        FGEN_ERR_GOTO(err, "Shared region file is invalid\n");
+
+    mm = shared_map(fd, st.st_size, MMAP_HUGEPAGE_4KB, true);
+    if (!mm)
+        FGEN_ERR_GOTO(err, "Failed to map shared region: %s\n", strerror(errno));
+
+    hdr = mm->base;
+    if (hdr->magic != SHARED_MAGIC || hdr->typ >= MMAP_HUGEPAGE_CNT ||
+        !atomic_load_explicit(&hdr->ready, FGEN_MEMORY_ORDER(acquire))) {
+        mmap_shared_release(mm);
+        free(mm);
+        FGEN_NULL_RET("Shared region is not a published region\n");
+    }
+
+    mm->typ    = hdr->typ;
+    mm->align  = page_size(mm->typ);
+    mm->bufcnt = hdr->bufcnt;
+    mm->bufsz  = hdr->bufsz;
+
+    return (mmap_t *)mm;
+
+err:
+    close(fd);
+    return NULL;
+}
+
+mmap_t *
+mmap_shared_attach(const char *name)
+{
+    char path[PATH_MAX];
+    mmap_t *mm;
+    int fd;
+
+    if (!name)
+        FGEN_NULL_RET("Shared region name is NULL\n");
+
+    for (int t = MMAP_HUGEPAGE_CNT - 1; t >= MMAP_HUGEPAGE_4KB; t--) {
+        if (shared_path(name, t, path, sizeof(path)) < 0)
+            continue;
+
+        fd = open(path, O_RDONLY);
+        if (fd < 0)
+            continue;
+
+        mm = mmap_shared_attach_fd(fd);
+        close(fd);
+        return mm;
+    }
+
+    FGEN_NULL_RET("Shared region %s not found\n", name);
+}
+
+int
+mmap_shared_unlink(const char *name)
+{
+    char path[PATH_MAX];
+    int ret = -1;
+
+    if (!name)
+        return -1;
+
+    for (int t = MMAP_HUGEPAGE_4KB; t < MMAP_HUGEPAGE_CNT; t++) {
+        if (shared_path(name, t, path, sizeof(path)) == 0 && unlink(path) == 0)
+            ret = 0;
+    }
+
+    return ret;
+}
+
+int
+mmap_fd(mmap_t *_mm)
+{
+    struct mmap_data *mm = _mm;
+
+    return (mm && mm->shared) ? mm->fd : -1;
+}
+
+int
+mmap_shared_release(struct mmap_data *mm)
+{
+    if (munmap(mm->base, mm->map_sz))
+        FGEN_ERR_RET("munmap(%p, %ld) failed: %s\n", mm->base, mm->map_sz, strerror(errno));
+
+    close(mm->fd);
+    return 0;
+}
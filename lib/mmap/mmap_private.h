@@ -5,6 +5,7 @@
 #ifndef _MMAP_PRIVATE_H_
 #define _MMAP_PRIVATE_H_
 
+#include <stdbool.h>       // for bool
 #include <stddef.h>        // for size_t
 #include <stdint.h>        // for uint64_t, uint8_t
 
@@ -22,14 +23,57 @@ extern "C" {
 #endif
 
 struct mmap_data {
-    uint32_t bufcnt; /**< Number of buffers in the pool */
-    uint32_t bufsz;  /**< Size of each buffer in the pool */
-    size_t sz;       /**< Real size of the memory region  (bufcnt * bufsz) */
-    void *addr;      /**< Address of the memory region */
-    mmap_type_t typ; /**< Type of memory allocated */
-    unsigned align;  /**< Alignment value */
+    uint32_t bufcnt;      /**< Number of buffers in the pool */
+    uint32_t bufsz;       /**< Size of each buffer in the pool */
+    size_t sz;            /**< Real size of the memory region  (bufcnt * bufsz) */
+    void *addr;           /**< Address of the memory region */
+    mmap_type_t typ;      /**< Type of memory allocated */
+    unsigned align;       /**< Alignment value */
+    int socket;           /**< NUMA node of the memory or MMAP_SOCKET_ANY */
+    bool populate;        /**< Pages were not faulted in by mmap() */
+    bool thp;             /**< 4KB pages with transparent hugepages */
+    uint64_t prefault_ns; /**< Time taken by the prefault workers */
+    bool shared;          /**< Region is a shared file mapping, see fgen_shared.c */
+    bool memfd;           /**< Shared region is an anonymous memfd */
+    bool readonly;        /**< Shared region is attached read-only */
+    int fd;               /**< File descriptor of a shared region */
+    void *base;           /**< Address of the shared mapping, the header is before addr */
+    size_t map_sz;        /**< Size of the shared mapping */
 };
 
+/**
+ * Test if a region is prefaulted in parallel, see mmap_set_prefault().
+ *
+ * @param sz
+ *   Size of the region in bytes.
+ * @return
+ *   true if the region is to be mapped without MAP_POPULATE and passed to mmap_prefault()
+ */
+bool mmap_prefault_enabled(size_t sz);
+
+/**
+ * Fault in the pages of a region with the prefault worker threads.
+ *
+ * @param mm
+ *   The mmap_data of the region, sz, align and socket are set.
+ * @param va
+ *   Address of the region.
+ * @return
+ *   0 on success, 1 if not supported by the kernel or -1 with errno set if a page could not be
+ *   faulted in
+ */
+int mmap_prefault(struct mmap_data *mm, void *va);
+
+/**
+ * Unmap a shared region and close its file, the mmap_data is not freed.
+ *
+ * @param mm
+ *   The mmap_data of a region with shared set.
+ * @return
+ *   0 on success or -1 on error
+ */
+int mmap_shared_release(struct mmap_data *mm);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,383 @@
+/* SPDX-License-Identifier: BSD-3-Clause
+ * Copyright (c) 2019-2025 Intel Corporation
+ */
+
+#include <stdint.h>        // for uint8_t, uint16_t, uint32_t, uint64_t
+#include <stdbool.h>
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#include <fgen_common.h>
+#include <net/fgen_ether.h>
+#include <net/fgen_ip.h>
+#include <net/fgen_udp.h>
+#include "cksum.h"
+#include "cksum_priv.h"
+
+#define SSE_BLOCK          16
+#define CKSUM_SCALAR_CHUNK 65536 /**< Bytes per scalar sum, even so the words line up */
+#define CKSUM_VERIFY_CHUNK 64    /**< Frames verified per call of fgen_cksum_burst() */
+#define CKSUM_UDP_HDR_LEN  8     /**< Length of the UDP header */
+#define CKSUM_TCP_HDR_LEN  20    /**< Minimum length of the TCP header */
+
+static const cksum_ops_t *cksum_ops;
+
+#if defined(__SSE2__)
+/* Add the low and high 16 bit words of each 32 bit lane of a block to the lanes of acc */
+static inline __m128i
+cksum_add_sse(__m128i acc, const uint8_t *p)
+{
+    const __m128i lo16 = _mm_set1_epi32(0xFFFF);
+    __m128i v          = _mm_loadu_si128((const __m128i *)(const void *)p);
+
+    acc = _mm_add_epi32(acc, _mm_and_si128(v, lo16));
+    return _mm_add_epi32(acc, _mm_srli_epi32(v, 16));
+}
+
+/* Widen the 32 bit lanes and add them to the 64 bit lanes of total */
+static inline __m128i
+cksum_flush_sse(__m128i total, __m128i acc)
+{
+    const __m128i zero = _mm_setzero_si128();
+
+    total = _mm_add_epi64(total, _mm_unpacklo_epi32(acc, zero));
+    return _mm_add_epi64(total, _mm_unpackhi_epi32(acc, zero));
+}
+
+static inline uint64_t
+cksum_total_sse(__m128i total)
+{
+    uint64_t t[2] __fgen_aligned(16);
+
+    _mm_store_si128((__m128i *)(void *)t, total);
+    return t[0] + t[1];
+}
+
+static uint64_t
+cksum_sse(const uint8_t *buf, size_t blocks)
+{
+    __m128i total = _mm_setzero_si128();
+
+    while (blocks) {
+        size_t n    = (blocks < CKSUM_FLUSH_BLOCKS) ? blocks : CKSUM_FLUSH_BLOCKS;
+        __m128i acc = _mm_setzero_si128();
+
+        for (blocks -= n; n; n--, buf += SSE_BLOCK)
+            acc = cksum_add_sse(acc, buf);
+        total = cksum_flush_sse(total, acc);
+    }
+
+    return cksum_total_sse(total);
+}
+
+static void
+cksum_sse_x4(const uint8_t *const *bufs, size_t blocks, uint64_t *sums)
+{
+    const uint8_t *p[CKSUM_LANES] = {bufs[0], bufs[1], bufs[2], bufs[3]};
+    __m128i total[CKSUM_LANES];
+
+    for (int i = 0; i < CKSUM_LANES; i++)
+        total[i] = _mm_setzero_si128();
+
+    while (blocks) {
+        size_t n = (blocks < CKSUM_FLUSH_BLOCKS) ? blocks : CKSUM_FLUSH_BLOCKS;
+        __m128i a0 = _mm_setzero_si128(), a1 = a0, a2 = a0, a3 = a0;
+
+        for (blocks -= n; n; n--) {
+            a0 = cksum_add_sse(a0, p[0]);
+            a1 = cksum_add_sse(a1, p[1]);
+            a2 = cksum_add_sse(a2, p[2]);
+            a3 = cksum_add_sse(a3, p[3]);
+            p[0] += SSE_BLOCK;
+            p[1] += SSE_BLOCK;
+            p[2] += SSE_BLOCK;
+            p[3] += SSE_BLOCK;
+        }
+        total[0] = cksum_flush_sse(total[0], a0);
+        total[1] = cksum_flush_sse(total[1], a1);
+        total[2] = cksum_flush_sse(total[2], a2);
+        total[3] = cksum_flush_sse(total[3], a3);
+    }
+
+    for (int i = 0; i < CKSUM_LANES; i++)
+        sums[i] += cksum_total_sse(total[i]);
+}
+
+static const cksum_ops_t cksum_sse_ops = {
+    .name   = "sse2",
+    .block  = SSE_BLOCK,
+    .sum    = cksum_sse,
+    .sum_x4 = cksum_sse_x4,
+};
+#endif
+
+FGEN_INIT(cksum_init)
+{
+#if defined(CC_AVX512_SUPPORT)
+    if (__builtin_cpu_supports("avx512f")) {
+        cksum_ops = &cksum_avx512_ops;
+        return;
+    }
+#endif
+#if defined(CC_AVX2_SUPPORT)
+    if (__builtin_cpu_supports("avx2")) {
+        cksum_ops = &cksum_avx2_ops;
+        return;
+    }
+#endif
+#if defined(__SSE2__)
+    cksum_ops = &cksum_sse_ops;
+#endif
+}
+
+/* Add the words after the whole blocks, the offset is always even so the words line up */
+static inline uint64_t
+cksum_tail(const uint8_t *buf, size_t off, size_t len)
+{
+    return __fgen_raw_cksum(buf + off, len - off, 0);
+}
+
+uint32_t
+fgen_cksum_sum(const void *buf, size_t len, uint32_t sum)
+{
+    const uint8_t *p = buf;
+    uint64_t total   = sum;
+    size_t blocks;
+
+    /* The scalar sum is 32 bits, add it in chunks small enough not to overflow */
+    if (!cksum_ops) {
+        for (size_t off = 0; off < len; off += CKSUM_SCALAR_CHUNK) {
+            size_t n = ((len - off) < CKSUM_SCALAR_CHUNK) ? len - off : CKSUM_SCALAR_CHUNK;
+
+            total += __fgen_raw_cksum(p + off, n, 0);
+        }
+        return cksum_fold64(total);
+    }
+
+    blocks = len / cksum_ops->block;
+    total += cksum_ops->sum(p, blocks);
+    total += cksum_tail(p, blocks * cksum_ops->block, len);
+
+    return cksum_fold64(total);
+}
+
+/* Sum the layer 4 data, long enough data with the vector version */
+static inline uint16_t
+cksum_l4_sum(const void *l4_hdr, size_t len)
+{
+    uint32_t sum;
+
+    if (len >= FGEN_CKSUM_VECTOR_MIN)
+        sum = fgen_cksum_sum(l4_hdr, len, 0);
+    else
+        sum = __fgen_raw_cksum(l4_hdr, len, 0);
+    return __fgen_raw_cksum_reduce(sum);
+}
+
+uint16_t
+fgen_cksum_ipv4_udptcp(const struct fgen_ipv4_hdr *ipv4_hdr, const void *l4_hdr)
+{
+    uint32_t l3_len    = be16toh(ipv4_hdr->total_length);
+    uint8_t ip_hdr_len = fgen_ipv4_hdr_len(ipv4_hdr);
+    uint16_t cksum     = 0;
+
+    if (l3_len >= ip_hdr_len)
+        cksum = __fgen_raw_cksum_reduce((uint32_t)cksum_l4_sum(l4_hdr, l3_len - ip_hdr_len) +
+                                        fgen_ipv4_phdr_cksum(ipv4_hdr));
+
+    /* Per RFC 768 a computed UDP checksum of zero is sent as all ones */
+    cksum = ~cksum;
+    if (cksum == 0 && ipv4_hdr->next_proto_id == IPPROTO_UDP)
+        cksum = 0xffff;
+
+    return cksum;
+}
+
+uint16_t
+fgen_cksum_ipv6_udptcp(const struct fgen_ipv6_hdr *ipv6_hdr, const void *l4_hdr)
+{
+    uint16_t cksum;
+
+    cksum = __fgen_raw_cksum_reduce((uint32_t)cksum_l4_sum(l4_hdr, be16toh(ipv6_hdr->payload_len)) +
+                                    fgen_ipv6_phdr_cksum(ipv6_hdr, 0));
+
+    cksum = ~cksum;
+    if (cksum == 0)
+        cksum = 0xffff;
+
+    return cksum;
+}
+
+void
+fgen_cksum_burst(const void *const *bufs, const uint16_t *lens, uint16_t *cksums, uint16_t n)
+{
+    uint16_t i = 0;
+
+    if (!bufs || !lens || !cksums)
+        return;
+
+    if (cksum_ops) {
+        size_t bs = cksum_ops->block;
+
+        for (; (n - i) >= CKSUM_LANES; i += CKSUM_LANES) {
+            const uint8_t *const *p = (const uint8_t *const *)&bufs[i];
+            uint64_t sums[CKSUM_LANES] = {0};
+            uint16_t min               = lens[i];
+
+            for (int j = 1; j < CKSUM_LANES; j++)
+                min = (lens[i + j] < min) ? lens[i + j] : min;
+
+            /* Sum the blocks all buffers have together, then the rest of each buffer */
+            cksum_ops->sum_x4(p, min / bs, sums);
+            for (int j = 0; j < CKSUM_LANES; j++) {
+                size_t done = (min / bs) * bs, blocks = (lens[i + j] - done) / bs;
+
+                sums[j] += cksum_ops->sum(p[j] + done, blocks);
+                sums[j] += cksum_tail(p[j], done + (blocks * bs), lens[i + j]);
+                cksums[i + j] = __fgen_raw_cksum_reduce(cksum_fold64(sums[j]));
+            }
+        }
+    }
+
+    for (; i < n; i++)
+        cksums[i] = __fgen_raw_cksum_reduce(fgen_cksum_sum(bufs[i], lens[i], 0));
+}
+
+static inline uint16_t
+cksum_rd16(const uint8_t *p)
+{
+    return (uint16_t)((p[0] << 8) | p[1]);
+}
+
+/*
+ * Find the L4 header of a frame and verify the IPv4 header checksum. Return true with the L4
+ * header, its length and the pseudo-header sum when there is a UDP or TCP checksum to verify.
+ */
+static bool
+cksum_frame_parse(const uint8_t *p, uint16_t len, fgen_cksum_status_t *st, const void **l4,
+                  uint16_t *l4_len, uint32_t *sum)
+{
+    uint32_t off = sizeof(struct fgen_ether_hdr), end;
+    uint16_t type;
+    uint8_t proto;
+
+    st->ip = st->l4 = FGEN_CKSUM_NONE;
+    if (len < off)
+        return false;
+
+    type = cksum_rd16(p + off - sizeof(uint16_t));
+    while (type == FGEN_ETHER_TYPE_VLAN || type == FGEN_ETHER_TYPE_QINQ) {
+        off += sizeof(struct fgen_vlan_hdr);
+        if (len < off)
+            return false;
+        type = cksum_rd16(p + off - sizeof(uint16_t));
+    }
+
+    if (type == FGEN_ETHER_TYPE_IPV4) {
+        const struct fgen_ipv4_hdr *ip = (const struct fgen_ipv4_hdr *)(p + off);
+        uint16_t hlen;
+
+        if (len < off + sizeof(*ip))
+            return false;
+        hlen = fgen_ipv4_hdr_len(ip);
+        end  = off + be16toh(ip->total_length);
+        if (hlen < sizeof(*ip) || len < off + hlen)
+            return false;
+
+        st->ip = (__fgen_raw_cksum_reduce(__fgen_raw_cksum(ip, hlen, 0)) == 0xFFFF)
+                     ? FGEN_CKSUM_GOOD
+                     : FGEN_CKSUM_BAD;
+
+        /* Only the first fragment has the L4 header and the checksum covers all fragments */
+        if (end < off + hlen || len < end ||
+            (ip->fragment_offset & htobe16(FGEN_IPV4_HDR_MF_FLAG | FGEN_IPV4_HDR_OFFSET_MASK)))
+            return false;
+
+        proto = ip->next_proto_id;
+        *sum  = __fgen_raw_cksum(&ip->src_addr, 2 * sizeof(ip->src_addr), 0);
+        off += hlen;
+    } else if (type == FGEN_ETHER_TYPE_IPV6) {
+        const struct fgen_ipv6_hdr *ip6 = (const struct fgen_ipv6_hdr *)(p + off);
+        size_t ext_len;
+        int next;
+
+        if (len < off + sizeof(*ip6))
+            return false;
+        off += sizeof(*ip6);
+        end = off + be16toh(ip6->payload_len);
+        if (len < end)
+            return false;
+
+        proto = ip6->proto;
+        while ((off + 2) <= end && (next = fgen_ipv6_get_next_ext(p + off, proto, &ext_len)) >= 0) {
+            if (proto == IPPROTO_FRAGMENT || (off + ext_len) > end)
+                return false;
+            proto = next;
+            off += ext_len;
+        }
+        *sum = __fgen_raw_cksum(ip6->src_addr, sizeof(ip6->src_addr) * 2, 0);
+    } else
+        return false;
+
+    *l4_len = end - off;
+    *l4     = p + off;
+
+    if (proto == IPPROTO_UDP) {
+        if (*l4_len < CKSUM_UDP_HDR_LEN)
+            return false;
+        /* A zero UDP checksum is no checksum for IPv4 and not allowed for IPv6 */
+        if (((const struct fgen_udp_hdr *)*l4)->dgram_cksum == 0) {
+            if (type == FGEN_ETHER_TYPE_IPV6)
+                st->l4 = FGEN_CKSUM_BAD;
+            return false;
+        }
+    } else if (proto != IPPROTO_TCP || *l4_len < CKSUM_TCP_HDR_LEN)
+        return false;
+
+    *sum += htobe16(proto) + htobe16(*l4_len);
+
+    return true;
+}
+
+int
+fgen_cksum_verify_burst(const void *const *frames, const uint16_t *lens, uint16_t n,
+                        fgen_cksum_status_t *status)
+{
+    const void *l4[CKSUM_VERIFY_CHUNK];
+    uint16_t l4_len[CKSUM_VERIFY_CHUNK], cksums[CKSUM_VERIFY_CHUNK], idx[CKSUM_VERIFY_CHUNK];
+    uint32_t sums[CKSUM_VERIFY_CHUNK];
+    int bad = 0;
+
+    if (!frames || !lens || !status)
+        return -1;
+
+    for (uint16_t i = 0; i < n;) {
+        uint16_t cnt = 0;
+
+        for (; i < n && cnt < CKSUM_VERIFY_CHUNK; i++) {
+            if (cksum_frame_parse(frames[i], lens[i], &status[i], &l4[cnt], &l4_len[cnt],
+                                  &sums[cnt]))
+                idx[cnt++] = i;
+        }
+
+        /* Sum the L4 headers and data of the frames together, then add the pseudo-headers */
+        fgen_cksum_burst(l4, l4_len, cksums, cnt);
+        for (uint16_t j = 0; j < cnt; j++) {
+            uint16_t sum = __fgen_raw_cksum_reduce(sums[j] + cksums[j]);
+
+            status[idx[j]].l4 = (sum == 0xFFFF) ? FGEN_CKSUM_GOOD : FGEN_CKSUM_BAD;
+        }
+    }
+
+    for (uint16_t i = 0; i < n; i++)
+        bad += (status[i].ip == FGEN_CKSUM_BAD || status[i].l4 == FGEN_CKSUM_BAD);
+
+    return bad;
+}
+
+const char *
+fgen_cksum_impl(void)
+{
+    return (cksum_ops) ? cksum_ops->name : "scalar";
+}
@@ -0,0 +1,140 @@
+/* SPDX-License-Identifier: BSD-3-Clause
+ * Copyright (c) 2019-2025 Intel Corporation
+ */
+
+#ifndef _FGEN_CKSUM_H_
+#define _FGEN_CKSUM_H_
+
+/**
+ * @file
+ *
+ * Vector versions of the Internet one's complement sum.
+ *
+ * The sums are the same as __fgen_raw_cksum() in net/fgen_ip.h, the 16 bit words of the buffer
+ * are added in host byte order. SSE2, AVX2 and AVX-512 versions are used when the CPU supports
+ * them. The inline checksums of net/fgen_ip.h stay scalar so the net headers do not need this
+ * library, the encoder uses fgen_cksum_ipv4_udptcp() and fgen_cksum_ipv6_udptcp() instead.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <fgen_common.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+struct fgen_ipv4_hdr;
+struct fgen_ipv6_hdr;
+
+#define FGEN_CKSUM_VECTOR_MIN 128 /**< Shorter buffers are faster with the inline scalar sum */
+
+/**
+ * Add the 16 bit words of a buffer to a sum.
+ *
+ * @param buf
+ *   Pointer to the buffer.
+ * @param len
+ *   Length of the buffer in bytes, an odd byte at the end is added as a word padded with zero.
+ * @param sum
+ *   Initial value of the sum.
+ * @return
+ *   The sum folded to 32 bits, reduce it with __fgen_raw_cksum_reduce().
+ */
+FGEN_API uint32_t fgen_cksum_sum(const void *buf, size_t len, uint32_t sum);
+
+/**
+ * Process the IPv4 UDP or TCP checksum, same as fgen_ipv4_udptcp_cksum() in net/fgen_ip.h.
+ *
+ * The layer 4 data of FGEN_CKSUM_VECTOR_MIN bytes or more is summed with fgen_cksum_sum().
+ * The layer 4 checksum must be set to 0 in the packet by the caller.
+ *
+ * @param ipv4_hdr
+ *   The pointer to the contiguous IPv4 header.
+ * @param l4_hdr
+ *   The pointer to the beginning of the L4 header.
+ * @return
+ *   The complemented checksum to set in the packet.
+ */
+FGEN_API uint16_t fgen_cksum_ipv4_udptcp(const struct fgen_ipv4_hdr *ipv4_hdr,
+                                         const void *l4_hdr);
+
+/**
+ * Process the IPv6 UDP or TCP checksum, same as fgen_ipv6_udptcp_cksum() in net/fgen_ip.h.
+ *
+ * The layer 4 data of FGEN_CKSUM_VECTOR_MIN bytes or more is summed with fgen_cksum_sum().
+ * The layer 4 checksum must be set to 0 in the packet by the caller.
+ *
+ * @param ipv6_hdr
+ *   The pointer to the contiguous IPv6 header.
+ * @param l4_hdr
+ *   The pointer to the beginning of the L4 header.
+ * @return
+ *   The complemented checksum to set in the packet.
+ */
+FGEN_API uint16_t fgen_cksum_ipv6_udptcp(const struct fgen_ipv6_hdr *ipv6_hdr,
+                                         const void *l4_hdr);
+
+/**
+ * Compute the non-complemented checksum of a burst of buffers.
+ *
+ * Groups of four buffers are summed together in the same loop, hiding the load latency of each
+ * buffer behind the others.
+ *
+ * @param bufs
+ *   The array of buffer pointers.
+ * @param lens
+ *   The array of buffer lengths in bytes.
+ * @param cksums
+ *   The array to return the non-complemented checksum of each buffer, as fgen_raw_cksum().
+ * @param n
+ *   The number of buffers.
+ */
+FGEN_API void fgen_cksum_burst(const void *const *bufs, const uint16_t *lens, uint16_t *cksums,
+                               uint16_t n);
+
+enum {
+    FGEN_CKSUM_NONE = 0, /**< No checksum to verify or the headers are not supported */
+    FGEN_CKSUM_GOOD = 1, /**< The checksum is correct */
+    FGEN_CKSUM_BAD  = 2, /**< The checksum is wrong */
+};
+
+typedef struct fgen_cksum_status_s {
+    uint8_t ip; /**< FGEN_CKSUM_* of the IPv4 header checksum */
+    uint8_t l4; /**< FGEN_CKSUM_* of the UDP or TCP checksum */
+} fgen_cksum_status_t;
+
+/**
+ * Verify the IPv4 header and the UDP or TCP checksums of a burst of Ethernet frames.
+ *
+ * VLAN tags and IPv6 extension headers are skipped. Fragments, truncated frames and other L4
+ * protocols are FGEN_CKSUM_NONE. The L4 checksums are summed with fgen_cksum_burst().
+ *
+ * @param frames
+ *   The array of frame pointers, starting with the Ethernet header.
+ * @param lens
+ *   The array of frame lengths in bytes.
+ * @param n
+ *   The number of frames.
+ * @param status
+ *   The array to return the checksum status of each frame.
+ * @return
+ *   -1 on error or the number of frames with a bad checksum.
+ */
+FGEN_API int fgen_cksum_verify_burst(const void *const *frames, const uint16_t *lens, uint16_t n,
+                                     fgen_cksum_status_t *status);
+
+/**
+ * Return the name of the checksum version in use.
+ *
+ * @return
+ *   "avx512", "avx2", "sse2" or "scalar".
+ */
+FGEN_API const char *fgen_cksum_impl(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _FGEN_CKSUM_H_ */
@@ -0,0 +1,96 @@
+/* SPDX-License-Identifier: BSD-3-Clause
+ * Copyright (c) 2019-2025 Intel Corporation
+ */
+
+#include <stdint.h>        // for uint8_t, uint64_t
+#include <immintrin.h>
+
+#include <fgen_common.h>
+#include "cksum_priv.h"
+
+#define AVX2_BLOCK 32
+
+/* Add the low and high 16 bit words of each 32 bit lane of a block to the lanes of acc */
+static inline __m256i
+cksum_add_avx2(__m256i acc, const uint8_t *p)
+{
+    const __m256i lo16 = _mm256_set1_epi32(0xFFFF);
+    __m256i v          = _mm256_loadu_si256((const __m256i *)(const void *)p);
+
+    acc = _mm256_add_epi32(acc, _mm256_and_si256(v, lo16));
+    return _mm256_add_epi32(acc, _mm256_srli_epi32(v, 16));
+}
+
+/* Widen the 32 bit lanes and add them to the 64 bit lanes of total */
+static inline __m256i
+cksum_flush_avx2(__m256i total, __m256i acc)
+{
+    total = _mm256_add_epi64(total, _mm256_cvtepu32_epi64(_mm256_castsi256_si128(acc)));
+    return _mm256_add_epi64(total, _mm256_cvtepu32_epi64(_mm256_extracti128_si256(acc, 1)));
+}
+
+static inline uint64_t
+cksum_total_avx2(__m256i total)
+{
+    uint64_t t[4] __fgen_aligned(32);
+
+    _mm256_store_si256((__m256i *)(void *)t, total);
+    return t[0] + t[1] + t[2] + t[3];
+}
+
+static uint64_t
+cksum_avx2(const uint8_t *buf, size_t blocks)
+{
+    __m256i total = _mm256_setzero_si256();
+
+    while (blocks) {
+        size_t n    = (blocks < CKSUM_FLUSH_BLOCKS) ? blocks : CKSUM_FLUSH_BLOCKS;
+        __m256i acc = _mm256_setzero_si256();
+
+        for (blocks -= n; n; n--, buf += AVX2_BLOCK)
+            acc = cksum_add_avx2(acc, buf);
+        total = cksum_flush_avx2(total, acc);
+    }
+
+    return cksum_total_avx2(total);
+}
+
+static void
+cksum_avx2_x4(const uint8_t *const *bufs, size_t blocks, uint64_t *sums)
+{
+    const uint8_t *p[CKSUM_LANES] = {bufs[0], bufs[1], bufs[2], bufs[3]};
+    __m256i total[CKSUM_LANES];
+
+    for (int i = 0; i < CKSUM_LANES; i++)
+        total[i] = _mm256_setzero_si256();
+
+    while (blocks) {
+        size_t n = (blocks < CKSUM_FLUSH_BLOCKS) ? blocks : CKSUM_FLUSH_BLOCKS;
+        __m256i a0 = _mm256_setzero_si256(), a1 = a0, a2 = a0, a3 = a0;
+
+        for (blocks -= n; n; n--) {
+            a0 = cksum_add_avx2(a0, p[0]);
+            a1 = cksum_add_avx2(a1, p[1]);
+            a2 = cksum_add_avx2(a2, p[2]);
+            a3 = cksum_add_avx2(a3, p[3]);
+            p[0] += AVX2_BLOCK;
+            p[1] += AVX2_BLOCK;
+            p[2] += AVX2_BLOCK;
+            p[3] += AVX2_BLOCK;
+        }
+        total[0] = cksum_flush_avx2(total[0], a0);
+        total[1] = cksum_flush_avx2(total[1], a1);
+        total[2] = cksum_flush_avx2(total[2], a2);
+        total[3] = cksum_flush_avx2(total[3], a3);
+    }
+
+    for (int i = 0; i < CKSUM_LANES; i++)
+        sums[i] += cksum_total_avx2(total[i]);
+}
+
+const cksum_ops_t cksum_avx2_ops = {
+    .name   = "avx2",
+    .block  = AVX2_BLOCK,
+    .sum    = cksum_avx2,
+    .sum_x4 = cksum_avx2_x4,
+};
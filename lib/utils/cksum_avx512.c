@@ -0,0 +1,95 @@
+/* SPDX-License-Identifier: BSD-3-Clause
+ * Copyright (c) 2019-2025 Intel Corporation
+ */
+
+#include <stdint.h>        // for uint8_t, uint64_t
+#include <immintrin.h>
+
+#include <fgen_common.h>
+#include "cksum_priv.h"
+
+#define AVX512_BLOCK 64
+
+/* Same as the AVX2 version in cksum_avx2.c with 64 byte blocks */
+
+/* Add the low and high 16 bit words of each 32 bit lane of a block to the lanes of acc */
+static inline __m512i
+cksum_add_avx512(__m512i acc, const uint8_t *p)
+{
+    const __m512i lo16 = _mm512_set1_epi32(0xFFFF);
+    __m512i v          = _mm512_loadu_si512((const void *)p);
+
+    acc = _mm512_add_epi32(acc, _mm512_and_si512(v, lo16));
+    return _mm512_add_epi32(acc, _mm512_srli_epi32(v, 16));
+}
+
+/* Widen the 32 bit lanes and add them to the 64 bit lanes of total */
+static inline __m512i
+cksum_flush_avx512(__m512i total, __m512i acc)
+{
+    total = _mm512_add_epi64(total, _mm512_cvtepu32_epi64(_mm512_castsi512_si256(acc)));
+    return _mm512_add_epi64(total, _mm512_cvtepu32_epi64(_mm512_extracti64x4_epi64(acc, 1)));
+}
+
+static inline uint64_t
+cksum_total_avx512(__m512i total)
+{
+    return (uint64_t)_mm512_reduce_add_epi64(total);
+}
+
+static uint64_t
+cksum_avx512(const uint8_t *buf, size_t blocks)
+{
+    __m512i total = _mm512_setzero_si512();
+
+    while (blocks) {
+        size_t n    = (blocks < CKSUM_FLUSH_BLOCKS) ? blocks : CKSUM_FLUSH_BLOCKS;
+        __m512i acc = _mm512_setzero_si512();
+
+        for (blocks -= n; n; n--, buf += AVX512_BLOCK)
+            acc = cksum_add_avx512(acc, buf);
+        total = cksum_flush_avx512(total, acc);
+    }
+
+    return cksum_total_avx512(total);
+}
+
+static void
+cksum_avx512_x4(const uint8_t *const *bufs, size_t blocks, uint64_t *sums)
+{
+    const uint8_t *p[CKSUM_LANES] = {bufs[0], bufs[1], bufs[2], bufs[3]};
+    __m512i total[CKSUM_LANES];
+
+    for (int i = 0; i < CKSUM_LANES; i++)
+        total[i] = _mm512_setzero_si512();
+
+    while (blocks) {
+        size_t n = (blocks < CKSUM_FLUSH_BLOCKS) ? blocks : CKSUM_FLUSH_BLOCKS;
+        __m512i a0 = _mm512_setzero_si512(), a1 = a0, a2 = a0, a3 = a0;
+
+        for (blocks -= n; n; n--) {
+            a0 = cksum_add_avx512(a0, p[0]);
+            a1 = cksum_add_avx512(a1, p[1]);
+            a2 = cksum_add_avx512(a2, p[2]);
+            a3 = cksum_add_avx512(a3, p[3]);
+            p[0] += AVX512_BLOCK;
+            p[1] += AVX512_BLOCK;
+            p[2] += AVX512_BLOCK;
+            p[3] += AVX512_BLOCK;
+        }
+        total[0] = cksum_flush_avx512(total[0], a0);
+        total[1] = cksum_flush_avx512(total[1], a1);
+        total[2] = cksum_flush_avx512(total[2], a2);
+        total[3] = cksum_flush_avx512(total[3], a3);
+    }
+
+    for (int i = 0; i < CKSUM_LANES; i++)
+        sums[i] += cksum_total_avx512(total[i]);
+}
+
+const cksum_ops_t cksum_avx512_ops = {
+    .name   = "avx512",
+    .block  = AVX512_BLOCK,
+    .sum    = cksum_avx512,
+    .sum_x4 = cksum_avx512_x4,
+};
@@ -0,0 +1,55 @@
+/* SPDX-License-Identifier: BSD-3-Clause
+ * Copyright (c) 2019-2025 Intel Corporation
+ */
+
+#ifndef _FGEN_CKSUM_PRIV_H_
+#define _FGEN_CKSUM_PRIV_H_
+
+/**
+ * @file
+ *
+ * Vector kernels of the one's complement sum.
+ *
+ * A kernel adds the 16 bit words of whole blocks into 32 bit lanes, the low and high word of
+ * each lane are added separately. A lane grows by at most 0x1FFFE per block, so the lanes are
+ * moved into 64 bit totals every CKSUM_FLUSH_BLOCKS blocks before they can overflow.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define CKSUM_FLUSH_BLOCKS 16384 /**< Blocks added into the 32 bit lanes between flushes */
+#define CKSUM_LANES        4     /**< Number of buffers summed together by the x4 kernels */
+
+typedef struct cksum_ops_s {
+    const char *name; /**< Name of the version */
+    size_t block;     /**< Number of bytes in a block */
+    /** Return the sum of the words in the first blocks of a buffer */
+    uint64_t (*sum)(const uint8_t *buf, size_t blocks);
+    /** Add the sum of the words in the first blocks of four buffers to sums */
+    void (*sum_x4)(const uint8_t *const *bufs, size_t blocks, uint64_t *sums);
+} cksum_ops_t;
+
+/**
+ * Fold a 64 bit sum to 32 bits, 2^32 is 1 in one's complement arithmetic.
+ */
+static inline uint32_t
+cksum_fold64(uint64_t sum)
+{
+    sum = (sum & 0xFFFFFFFF) + (sum >> 32);
+    sum = (sum & 0xFFFFFFFF) + (sum >> 32);
+    return (uint32_t)sum;
+}
+
+extern const cksum_ops_t cksum_avx2_ops;   /**< AVX2 kernels, 32 byte blocks */
+extern const cksum_ops_t cksum_avx512_ops; /**< AVX-512 kernels, 64 byte blocks */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _FGEN_CKSUM_PRIV_H_ */
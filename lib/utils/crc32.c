@@ -42,7 +42,13 @@
  * CRC32 code derived from work by Gary S. Brown.
  */
 
+#include <stdbool.h>
+#include <string.h>        // for memcpy
+#include <endian.h>        // for htole32
+
+#include <fgen_common.h>
 #include "crc32.h"
+#include "crc32_priv.h"
 
 const uint32_t crc32_tab[] = {
     0x00000000, 0x77073096, 0xee0e612c, 0x990951ba, 0x076dc419, 0x706af48f, 0xe963a535, 0x9e6495a3,
@@ -646,17 +652,116 @@ multitable_crc32c(uint32_t crc32c, const unsigned char *buffer, unsigned int len
     return (crc32c_sb8_64_bit(crc32c, buffer, length, to_even_word));
 }
 
+uint32_t
+table_crc32c(uint32_t crc32c, const unsigned char *buffer, unsigned int length)
+{
+    if (length < 4)
+        return (singletable_crc32c(crc32c, buffer, length));
+
+    return (multitable_crc32c(crc32c, buffer, length));
+}
+
+static bool crc32c_sse42;
+
 uint32_t
 calculate_crc32c(uint32_t crc32c, const unsigned char *buffer, unsigned int length)
 {
-#ifdef USE_SSE42_CRC32
-    if ((cpu_feature2 & CPUID2_SSE42) != 0) {
+#if defined(CC_SSE42_SUPPORT)
+    if (crc32c_sse42)
         return (sse42_crc32c(crc32c, buffer, length));
-    } else
 #endif
-        if (length < 4) {
-        return (singletable_crc32c(crc32c, buffer, length));
-    } else {
-        return (multitable_crc32c(crc32c, buffer, length));
+    return (table_crc32c(crc32c, buffer, length));
+}
+
+static const crc32_ops_t *crc32_ops;
+
+FGEN_INIT(crc32_init)
+{
+#if defined(CC_SSE42_SUPPORT)
+    crc32c_sse42 = __builtin_cpu_supports("sse4.2");
+#endif
+
+#if defined(CC_VPCLMUL_SUPPORT)
+    if (__builtin_cpu_supports("avx512f") && __builtin_cpu_supports("vpclmulqdq")) {
+        crc32_ops = &crc32_vpclmul_ops;
+        return;
+    }
+#endif
+#if defined(CC_PCLMUL_SUPPORT)
+    if (__builtin_cpu_supports("pclmul") && __builtin_cpu_supports("sse4.1"))
+        crc32_ops = &crc32_clmul_ops;
+#endif
+}
+
+uint32_t
+fgen_crc32_update(uint32_t crc, const void *buf, size_t size)
+{
+    const uint8_t *p = buf;
+    size_t n         = size & ~(size_t)15;
+
+    if (crc32_ops && n >= CRC32_CLMUL_MIN) {
+        crc = crc32_ops->fold(crc, p, n);
+        p += n;
+        size -= n;
     }
+
+    return crc32_raw(p, size, crc);
+}
+
+uint32_t
+fgen_crc32_eth(const void *buf, size_t size)
+{
+    return fgen_crc32_update(~0U, buf, size) ^ ~0U;
+}
+
+size_t
+fgen_crc32_fcs_append(void *buf, size_t size)
+{
+    uint32_t fcs = htole32(fgen_crc32_eth(buf, size));
+
+    memcpy((uint8_t *)buf + size, &fcs, sizeof(fcs));
+
+    return size + sizeof(fcs);
+}
+
+void
+fgen_crc32c_bulk(const void *const *bufs, const uint16_t *lens, uint16_t n, uint32_t *out)
+{
+    uint16_t i = 0;
+
+    if (!bufs || !lens || !out)
+        return;
+
+#if defined(CC_SSE42_SUPPORT)
+    if (crc32c_sse42) {
+        for (; (n - i) >= CRC32C_LANES; i += CRC32C_LANES) {
+            const unsigned char *const *p = (const unsigned char *const *)&bufs[i];
+            uint32_t crcs[CRC32C_LANES]   = {~0U, ~0U, ~0U, ~0U};
+            uint16_t min                  = lens[i];
+
+            for (int j = 1; j < CRC32C_LANES; j++)
+                min = (lens[i + j] < min) ? lens[i + j] : min;
+
+            /* Add the bytes all buffers have together, then the rest of each buffer */
+            sse42_crc32c_x4(p, min, crcs);
+            for (int j = 0; j < CRC32C_LANES; j++)
+                out[i + j] = ~sse42_crc32c(crcs[j], p[j] + min, lens[i + j] - min);
+        }
+    }
+#endif
+
+    for (; i < n; i++)
+        out[i] = ~calculate_crc32c(~0U, bufs[i], lens[i]);
+}
+
+const char *
+fgen_crc32c_impl(void)
+{
+    return (crc32c_sse42) ? "sse4.2" : "table";
+}
+
+const char *
+fgen_crc32_impl(void)
+{
+    return (crc32_ops) ? crc32_ops->name : "table";
 }
@@ -40,6 +40,8 @@
 #include <sys/types.h>
 #include <stddef.h>        // for size_t
 
+#include <fgen_common.h>
+
 extern const uint32_t crc32_tab[];
 
 #define rounddown(x, y)  (((x) / (y)) * (y))
@@ -65,8 +67,102 @@ crc32(const void *buf, size_t size)
     return (crc ^ ~0U);
 }
 
+/**
+ * Add data to a raw CRC-32C register, with the SSE4.2 crc32 instruction when the CPU has it.
+ *
+ * @param crc32c
+ *   The raw CRC-32C register, ~0U to start.
+ * @param buffer
+ *   Pointer to the data.
+ * @param length
+ *   Length of the data in bytes.
+ * @return
+ *   The raw CRC-32C register.
+ */
 uint32_t calculate_crc32c(uint32_t crc32c, const unsigned char *buffer, unsigned int length);
 
+/**
+ * Add data to a raw CRC-32C register with the lookup tables only, same as calculate_crc32c().
+ */
+uint32_t table_crc32c(uint32_t crc32c, const unsigned char *buffer, unsigned int length);
+
 uint32_t sse42_crc32c(uint32_t, const unsigned char *, unsigned);
 
+#define FGEN_ETHER_FCS_LEN 4 /**< Length of the Ethernet frame check sequence */
+
+/**
+ * Add data to a raw Ethernet CRC32 register, same as crc32_raw().
+ *
+ * Data of 64 bytes or more is folded with carry-less multiply when the CPU supports PCLMULQDQ
+ * or VPCLMULQDQ, the bytes after the last 16 byte block use the table.
+ *
+ * @param crc
+ *   The raw CRC register, ~0U to start.
+ * @param buf
+ *   Pointer to the data.
+ * @param size
+ *   Length of the data in bytes.
+ * @return
+ *   The raw CRC register.
+ */
+FGEN_API uint32_t fgen_crc32_update(uint32_t crc, const void *buf, size_t size);
+
+/**
+ * Compute the Ethernet CRC32 of a buffer, same as crc32().
+ *
+ * @param buf
+ *   Pointer to the data.
+ * @param size
+ *   Length of the data in bytes.
+ * @return
+ *   The CRC32, stored in little endian byte order as the Ethernet FCS.
+ */
+FGEN_API uint32_t fgen_crc32_eth(const void *buf, size_t size);
+
+/**
+ * Append the Ethernet FCS to a frame.
+ *
+ * @param buf
+ *   Pointer to the frame, with FGEN_ETHER_FCS_LEN bytes of room after the data.
+ * @param size
+ *   Length of the frame in bytes without the FCS.
+ * @return
+ *   The length of the frame with the FCS.
+ */
+FGEN_API size_t fgen_crc32_fcs_append(void *buf, size_t size);
+
+/**
+ * Compute the CRC-32C of a burst of buffers, like SCTP packets.
+ *
+ * Groups of four buffers are added together in the same loop, the crc32 instruction latency of
+ * each buffer is hidden behind the others.
+ *
+ * @param bufs
+ *   The array of buffer pointers.
+ * @param lens
+ *   The array of buffer lengths in bytes.
+ * @param n
+ *   The number of buffers.
+ * @param out
+ *   The array to return the CRC-32C of each buffer, started with ~0U and complemented.
+ */
+FGEN_API void fgen_crc32c_bulk(const void *const *bufs, const uint16_t *lens, uint16_t n,
+                               uint32_t *out);
+
+/**
+ * Return the name of the CRC-32C version in use.
+ *
+ * @return
+ *   "sse4.2" or "table".
+ */
+FGEN_API const char *fgen_crc32c_impl(void);
+
+/**
+ * Return the name of the Ethernet CRC32 version in use.
+ *
+ * @return
+ *   "vpclmulqdq", "pclmulqdq" or "table".
+ */
+FGEN_API const char *fgen_crc32_impl(void);
+
 #endif /* _CRC32_H_ */
@@ -0,0 +1,20 @@
+/* SPDX-License-Identifier: BSD-3-Clause
+ * Copyright (c) 2019-2025 Intel Corporation
+ */
+
+#include <stdint.h>        // for uint8_t, uint32_t
+#include <immintrin.h>
+
+#define CRC32_CLMUL_KERNEL
+#include "crc32_priv.h"
+
+static uint32_t
+crc32_clmul(uint32_t crc, const uint8_t *buf, size_t len)
+{
+    return crc32_clmul_fold(crc, buf, len);
+}
+
+const crc32_ops_t crc32_clmul_ops = {
+    .name = "pclmulqdq",
+    .fold = crc32_clmul,
+};
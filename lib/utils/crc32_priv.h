@@ -0,0 +1,161 @@
+/* SPDX-License-Identifier: BSD-3-Clause
+ * Copyright (c) 2019-2025 Intel Corporation
+ */
+
+#ifndef _FGEN_CRC32_PRIV_H_
+#define _FGEN_CRC32_PRIV_H_
+
+/**
+ * @file
+ *
+ * Carry-less multiply kernels of the Ethernet CRC32, reflected polynomial 0x04C11DB7.
+ *
+ * The data is folded 128 bits at a time as in the Intel paper "Fast CRC Computation for Generic
+ * Polynomials Using PCLMULQDQ Instruction". A 128 bit lane is moved forward by D bits with two
+ * multiplies by the constants x^(D+32) and x^(D-32) mod P, the folded lane is then reduced to
+ * 32 bits with a Barrett reduction. The constants are bit reflected and shifted left by one.
+ *
+ * The CRC-32C kernels in crc32_sse42.c use the SSE4.2 crc32 instruction.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define CRC32_CLMUL_MIN 64 /**< Shortest data folded, shorter data is faster with the table */
+
+typedef struct crc32_ops_s {
+    const char *name; /**< Name of the version */
+    /** Fold a multiple of 16 bytes, at least CRC32_CLMUL_MIN, into the raw CRC register */
+    uint32_t (*fold)(uint32_t crc, const uint8_t *buf, size_t len);
+} crc32_ops_t;
+
+extern const crc32_ops_t crc32_clmul_ops;   /**< PCLMULQDQ kernel, 4 x 128 bit lanes */
+extern const crc32_ops_t crc32_vpclmul_ops; /**< VPCLMULQDQ kernel, 4 x 512 bit lanes */
+
+#define CRC32C_LANES 4 /**< Number of buffers in the CRC-32C multi-buffer kernel */
+
+/**
+ * Add the first len bytes of CRC32C_LANES buffers to their raw CRC-32C registers.
+ *
+ * @param bufs
+ *   The CRC32C_LANES buffer pointers.
+ * @param len
+ *   Number of bytes to add from each buffer.
+ * @param crcs
+ *   The CRC32C_LANES raw CRC-32C registers, updated in place.
+ */
+void sse42_crc32c_x4(const unsigned char *const *bufs, size_t len, uint32_t *crcs);
+
+/*
+ * The folding helpers below are only seen by the carry-less multiply kernels, which define
+ * CRC32_CLMUL_KERNEL and include <immintrin.h> first. The other files keep the intrinsics out.
+ */
+#if defined(CRC32_CLMUL_KERNEL) && defined(__PCLMUL__)
+// clang-format off
+#define CRC32_K_544  0x154442bd4ULL /**< x^(512+32) mod P, fold by 64 bytes */
+#define CRC32_K_480  0x1c6e41596ULL /**< x^(512-32) mod P */
+#define CRC32_K_160  0x1751997d0ULL /**< x^(128+32) mod P, fold by 16 bytes */
+#define CRC32_K_96   0x0ccaa009eULL /**< x^(128-32) mod P */
+#define CRC32_K_64   0x163cd6124ULL /**< x^64 mod P, fold 64 bits to 32 bits */
+#define CRC32_POLY   0x1db710641ULL /**< P */
+#define CRC32_MU     0x1f7011641ULL /**< x^64 / P, Barrett constant */
+// clang-format on
+
+/* Fold lane a forward by the distance of the constants in k and add the lane b */
+static inline __m128i
+crc32_fold_128(__m128i a, __m128i b, __m128i k)
+{
+    __m128i lo = _mm_clmulepi64_si128(a, k, 0x00);
+    __m128i hi = _mm_clmulepi64_si128(a, k, 0x11);
+
+    return _mm_xor_si128(_mm_xor_si128(lo, hi), b);
+}
+
+/**
+ * Fold four lanes holding the data up to buf, then the 16 byte blocks at buf, into the CRC.
+ *
+ * @param x1, x2, x3, x4
+ *   The lanes holding the last 64 bytes folded, x1 is the first.
+ * @param buf
+ *   The data after the lanes.
+ * @param len
+ *   Length of the data after the lanes, a multiple of 16.
+ * @return
+ *   The raw CRC register.
+ */
+static inline uint32_t
+crc32_clmul_finish(__m128i x1, __m128i x2, __m128i x3, __m128i x4, const uint8_t *buf, size_t len)
+{
+    const __m128i mask32 = _mm_setr_epi32(~0, 0, ~0, 0);
+    __m128i k            = _mm_set_epi64x(CRC32_K_96, CRC32_K_160);
+    __m128i t;
+
+    x1 = crc32_fold_128(x1, x2, k);
+    x1 = crc32_fold_128(x1, x3, k);
+    x1 = crc32_fold_128(x1, x4, k);
+
+    for (; len >= 16; len -= 16, buf += 16)
+        x1 = crc32_fold_128(x1, _mm_loadu_si128((const __m128i *)(const void *)buf), k);
+
+    /* Fold 128 bits to 64 bits */
+    t  = _mm_clmulepi64_si128(x1, k, 0x10);
+    x1 = _mm_xor_si128(_mm_srli_si128(x1, 8), t);
+
+    k  = _mm_set_epi64x(0, CRC32_K_64);
+    t  = _mm_srli_si128(x1, 4);
+    x1 = _mm_clmulepi64_si128(_mm_and_si128(x1, mask32), k, 0x00);
+    x1 = _mm_xor_si128(x1, t);
+
+    /* Barrett reduction to 32 bits */
+    k  = _mm_set_epi64x(CRC32_MU, CRC32_POLY);
+    t  = _mm_clmulepi64_si128(_mm_and_si128(x1, mask32), k, 0x10);
+    t  = _mm_clmulepi64_si128(_mm_and_si128(t, mask32), k, 0x00);
+    x1 = _mm_xor_si128(x1, t);
+
+    return (uint32_t)_mm_extract_epi32(x1, 1);
+}
+
+/**
+ * Fold data into the CRC with four 128 bit lanes.
+ *
+ * @param crc
+ *   The raw CRC register.
+ * @param buf
+ *   The data to add to the CRC.
+ * @param len
+ *   Length of the data, a multiple of 16 and at least CRC32_CLMUL_MIN.
+ * @return
+ *   The raw CRC register.
+ */
+static inline uint32_t
+crc32_clmul_fold(uint32_t crc, const uint8_t *buf, size_t len)
+{
+    const __m128i *p = (const __m128i *)(const void *)buf;
+    __m128i k        = _mm_set_epi64x(CRC32_K_480, CRC32_K_544);
+    __m128i x1, x2, x3, x4;
+
+    x1 = _mm_xor_si128(_mm_loadu_si128(&p[0]), _mm_cvtsi32_si128((int)crc));
+    x2 = _mm_loadu_si128(&p[1]);
+    x3 = _mm_loadu_si128(&p[2]);
+    x4 = _mm_loadu_si128(&p[3]);
+
+    for (p += 4, len -= 64; len >= 64; p += 4, len -= 64) {
+        x1 = crc32_fold_128(x1, _mm_loadu_si128(&p[0]), k);
+        x2 = crc32_fold_128(x2, _mm_loadu_si128(&p[1]), k);
+        x3 = crc32_fold_128(x3, _mm_loadu_si128(&p[2]), k);
+        x4 = crc32_fold_128(x4, _mm_loadu_si128(&p[3]), k);
+    }
+
+    return crc32_clmul_finish(x1, x2, x3, x4, (const uint8_t *)p, len);
+}
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _FGEN_CRC32_PRIV_H_ */
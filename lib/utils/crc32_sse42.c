@@ -21,25 +21,21 @@
  *
  * Mark Adler
  * madler@alumni.caltech.edu
+ *
+ * Altered for fgen: built in userspace with the tables set up by a constructor, and a
+ * multi-buffer version for bursts of small packets was added.
  */
 
-#include <sys/cdefs.h>
-__FBSDID("$FreeBSD$");
-
-/**
- * This file is compiled in userspace in order to run ATF unit tests.
- */
-#ifdef USERSPACE_TESTING
 #include <stdint.h>
-#include <stdlib.h>
-#else
-#include <sys/param.h>
-#include <sys/systm.h>
-#include <sys/kernel.h>
-#endif
+#include <stddef.h>
+#include <string.h>
+
+#include <fgen_common.h>
+#include "crc32.h"
+#include "crc32_priv.h"
 
 static __inline uint32_t
-_mm_crc32_u8(uint32_t x, uint8_t y)
+crc32c_u8(uint32_t x, uint8_t y)
 {
     /**
      * clang (at least 3.9.[0-1]) pessimizes "rm" (y) and "m" (y)
@@ -55,14 +51,14 @@ _mm_crc32_u8(uint32_t x, uint8_t y)
 
 #ifdef __amd64__
 static __inline uint64_t
-_mm_crc32_u64(uint64_t x, uint64_t y)
+crc32c_u64(uint64_t x, uint64_t y)
 {
     __asm("crc32q %1,%0" : "+r"(x) : "r"(y));
     return (x);
 }
 #else
 static __inline uint32_t
-_mm_crc32_u32(uint32_t x, uint32_t y)
+crc32c_u32(uint32_t x, uint32_t y)
 {
     __asm("crc32l %1,%0" : "+r"(x) : "r"(y));
     return (x);
@@ -202,27 +198,17 @@ crc32c_shift(uint32_t zeros[][256], uint32_t crc)
 /**
  * Initialize tables for shifting crcs.
  */
-static void
-#ifdef USERSPACE_TESTING
-    __attribute__((__constructor__))
-#endif
-    crc32c_init_hw(void)
+FGEN_INIT(crc32c_init_hw)
 {
     crc32c_zeros(crc32c_long, LONG);
     crc32c_zeros(crc32c_2long, 2 * LONG);
     crc32c_zeros(crc32c_short, SHORT);
     crc32c_zeros(crc32c_2short, 2 * SHORT);
 }
-#ifdef _KERNEL
-SYSINIT(crc32c_sse42, SI_SUB_LOCK, SI_ORDER_ANY, crc32c_init_hw, NULL);
-#endif
 
 /**
  * Compute CRC-32C using the Intel hardware instruction.
  */
-#ifdef USERSPACE_TESTING
-uint32_t sse42_crc32c(uint32_t, const unsigned char *, unsigned);
-#endif
 uint32_t
 sse42_crc32c(uint32_t crc, const unsigned char *buf, unsigned len)
 {
@@ -243,7 +229,7 @@ sse42_crc32c(uint32_t crc, const unsigned char *buf, unsigned len)
 
     /* Compute the crc to bring the data pointer to an aligned boundary. */
     while (len && ((uintptr_t)next & (align - 1)) != 0) {
-        crc0 = _mm_crc32_u8(crc0, *next);
+        crc0 = crc32c_u8(crc0, *next);
         next++;
         len--;
     }
@@ -263,13 +249,13 @@ sse42_crc32c(uint32_t crc, const unsigned char *buf, unsigned len)
         end  = next + LONG;
         do {
 #ifdef __amd64__
-            crc0 = _mm_crc32_u64(crc0, *(const uint64_t *)next);
-            crc1 = _mm_crc32_u64(crc1, *(const uint64_t *)(next + LONG));
-            crc2 = _mm_crc32_u64(crc2, *(const uint64_t *)(next + (LONG * 2)));
+            crc0 = crc32c_u64(crc0, *(const uint64_t *)next);
+            crc1 = crc32c_u64(crc1, *(const uint64_t *)(next + LONG));
+            crc2 = crc32c_u64(crc2, *(const uint64_t *)(next + (LONG * 2)));
 #else
-            crc0 = _mm_crc32_u32(crc0, *(const uint32_t *)next);
-            crc1 = _mm_crc32_u32(crc1, *(const uint32_t *)(next + LONG));
-            crc2 = _mm_crc32_u32(crc2, *(const uint32_t *)(next + (LONG * 2)));
+            crc0 = crc32c_u32(crc0, *(const uint32_t *)next);
+            crc1 = crc32c_u32(crc1, *(const uint32_t *)(next + LONG));
+            crc2 = crc32c_u32(crc2, *(const uint32_t *)(next + (LONG * 2)));
 #endif
             next += align;
         } while (next < end);
@@ -337,13 +323,13 @@ sse42_crc32c(uint32_t crc, const unsigned char *buf, unsigned len)
         end  = next + SHORT;
         do {
 #ifdef __amd64__
-            crc0 = _mm_crc32_u64(crc0, *(const uint64_t *)next);
-            crc1 = _mm_crc32_u64(crc1, *(const uint64_t *)(next + SHORT));
-            crc2 = _mm_crc32_u64(crc2, *(const uint64_t *)(next + (SHORT * 2)));
+            crc0 = crc32c_u64(crc0, *(const uint64_t *)next);
+            crc1 = crc32c_u64(crc1, *(const uint64_t *)(next + SHORT));
+            crc2 = crc32c_u64(crc2, *(const uint64_t *)(next + (SHORT * 2)));
 #else
-            crc0 = _mm_crc32_u32(crc0, *(const uint32_t *)next);
-            crc1 = _mm_crc32_u32(crc1, *(const uint32_t *)(next + SHORT));
-            crc2 = _mm_crc32_u32(crc2, *(const uint32_t *)(next + (SHORT * 2)));
+            crc0 = crc32c_u32(crc0, *(const uint32_t *)next);
+            crc1 = crc32c_u32(crc1, *(const uint32_t *)(next + SHORT));
+            crc2 = crc32c_u32(crc2, *(const uint32_t *)(next + (SHORT * 2)));
 #endif
             next += align;
         } while (next < end);
@@ -360,9 +346,9 @@ sse42_crc32c(uint32_t crc, const unsigned char *buf, unsigned len)
     end = next + (len - (len & (align - 1)));
     while (next < end) {
 #ifdef __amd64__
-        crc0 = _mm_crc32_u64(crc0, *(const uint64_t *)next);
+        crc0 = crc32c_u64(crc0, *(const uint64_t *)next);
 #else
-        crc0 = _mm_crc32_u32(crc0, *(const uint32_t *)next);
+        crc0 = crc32c_u32(crc0, *(const uint32_t *)next);
 #endif
         next += align;
     }
@@ -370,10 +356,59 @@ sse42_crc32c(uint32_t crc, const unsigned char *buf, unsigned len)
 
     /* Compute the crc for any trailing bytes. */
     while (len) {
-        crc0 = _mm_crc32_u8(crc0, *next);
+        crc0 = crc32c_u8(crc0, *next);
         next++;
         len--;
     }
 
     return ((uint32_t)crc0);
 }
+
+/**
+ * Compute CRC-32C on the first len bytes of CRC32C_LANES buffers together.  A
+ * short packet is too small for the three-way blocking above, so the chains of
+ * independent packets are interleaved instead to hide the crc32 latency.
+ */
+void
+sse42_crc32c_x4(const unsigned char *const *bufs, size_t len, uint32_t *crcs)
+{
+    const unsigned char *p0 = bufs[0], *p1 = bufs[1], *p2 = bufs[2], *p3 = bufs[3];
+#ifdef __amd64__
+    uint64_t crc0 = crcs[0], crc1 = crcs[1], crc2 = crcs[2], crc3 = crcs[3];
+    uint64_t v0, v1, v2, v3;
+#else
+    uint32_t crc0 = crcs[0], crc1 = crcs[1], crc2 = crcs[2], crc3 = crcs[3];
+    uint32_t v0, v1, v2, v3;
+#endif
+    size_t off;
+
+    for (off = 0; (len - off) >= sizeof(v0); off += sizeof(v0)) {
+        memcpy(&v0, p0 + off, sizeof(v0));
+        memcpy(&v1, p1 + off, sizeof(v1));
+        memcpy(&v2, p2 + off, sizeof(v2));
+        memcpy(&v3, p3 + off, sizeof(v3));
+#ifdef __amd64__
+        crc0 = crc32c_u64(crc0, v0);
+        crc1 = crc32c_u64(crc1, v1);
+        crc2 = crc32c_u64(crc2, v2);
+        crc3 = crc32c_u64(crc3, v3);
+#else
+        crc0 = crc32c_u32(crc0, v0);
+        crc1 = crc32c_u32(crc1, v1);
+        crc2 = crc32c_u32(crc2, v2);
+        crc3 = crc32c_u32(crc3, v3);
+#endif
+    }
+
+    for (; off < len; off++) {
+        crc0 = crc32c_u8(crc0, p0[off]);
+        crc1 = crc32c_u8(crc1, p1[off]);
+        crc2 = crc32c_u8(crc2, p2[off]);
+        crc3 = crc32c_u8(crc3, p3[off]);
+    }
+
+    crcs[0] = (uint32_t)crc0;
+    crcs[1] = (uint32_t)crc1;
+    crcs[2] = (uint32_t)crc2;
+    crcs[3] = (uint32_t)crc3;
+}
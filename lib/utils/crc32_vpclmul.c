@@ -0,0 +1,68 @@
+/* SPDX-License-Identifier: BSD-3-Clause
+ * Copyright (c) 2019-2025 Intel Corporation
+ */
+
+#include <stdint.h>        // for uint8_t, uint32_t
+#include <immintrin.h>
+
+#define CRC32_CLMUL_KERNEL
+#include "crc32_priv.h"
+
+/*
+ * Same folding as crc32_clmul_fold() with four 512 bit lanes, each holding four 128 bit lanes,
+ * 256 bytes are folded per loop. The lanes are folded into one and its four 128 bit lanes are
+ * finished by the 128 bit version.
+ */
+
+#define VPCLMUL_BLOCK 256
+
+#define CRC32_K_2080 0x11542778aULL /**< x^(2048+32) mod P, fold by 256 bytes */
+#define CRC32_K_2016 0x1322d1430ULL /**< x^(2048-32) mod P */
+
+/* Fold lane a forward by the distance of the constants in k and add the lane b */
+static inline __m512i
+crc32_fold_512(__m512i a, __m512i b, __m512i k)
+{
+    __m512i lo = _mm512_clmulepi64_epi128(a, k, 0x00);
+    __m512i hi = _mm512_clmulepi64_epi128(a, k, 0x11);
+
+    return _mm512_ternarylogic_epi64(lo, hi, b, 0x96);
+}
+
+static uint32_t
+crc32_vpclmul(uint32_t crc, const uint8_t *buf, size_t len)
+{
+    __m512i k, z0, z1, z2, z3;
+
+    if (len < VPCLMUL_BLOCK)
+        return crc32_clmul_fold(crc, buf, len);
+
+    z0 = _mm512_xor_si512(_mm512_loadu_si512(buf),
+                          _mm512_zextsi128_si512(_mm_cvtsi32_si128((int)crc)));
+    z1 = _mm512_loadu_si512(buf + 64);
+    z2 = _mm512_loadu_si512(buf + 128);
+    z3 = _mm512_loadu_si512(buf + 192);
+
+    k = _mm512_broadcast_i32x4(_mm_set_epi64x(CRC32_K_2016, CRC32_K_2080));
+    for (buf += VPCLMUL_BLOCK, len -= VPCLMUL_BLOCK; len >= VPCLMUL_BLOCK;
+         buf += VPCLMUL_BLOCK, len -= VPCLMUL_BLOCK) {
+        z0 = crc32_fold_512(z0, _mm512_loadu_si512(buf), k);
+        z1 = crc32_fold_512(z1, _mm512_loadu_si512(buf + 64), k);
+        z2 = crc32_fold_512(z2, _mm512_loadu_si512(buf + 128), k);
+        z3 = crc32_fold_512(z3, _mm512_loadu_si512(buf + 192), k);
+    }
+
+    k  = _mm512_broadcast_i32x4(_mm_set_epi64x(CRC32_K_480, CRC32_K_544));
+    z1 = crc32_fold_512(z0, z1, k);
+    z2 = crc32_fold_512(z1, z2, k);
+    z3 = crc32_fold_512(z2, z3, k);
+
+    return crc32_clmul_finish(_mm512_extracti32x4_epi32(z3, 0), _mm512_extracti32x4_epi32(z3, 1),
+                              _mm512_extracti32x4_epi32(z3, 2), _mm512_extracti32x4_epi32(z3, 3),
+                              buf, len);
+}
+
+const crc32_ops_t crc32_vpclmul_ops = {
+    .name = "vpclmulqdq",
+    .fold = crc32_vpclmul,
+};
@@ -0,0 +1,224 @@
+/* SPDX-License-Identifier: BSD-3-Clause
+ * Copyright (c) 2019-2025 Intel Corporation
+ */
+
+#include <stdint.h>          // for uint64_t, uint32_t, UINT64_MAX
+#include <stdlib.h>          // for calloc, free
+#include <string.h>          // for memset
+#include <fgen_common.h>     // for FGEN_MIN, FGEN_MAX
+#include <fgen_atomic.h>     // for FGEN_ATOMIC, FGEN_MEMORY_ORDER
+
+#include <fgen_log.h>
+#include "hdrhist.h"
+
+/*
+ * Bucket i < 2^p holds the value i. Above that a value v with its top bit at bit b is shifted
+ * right by s = b - p + 1, which leaves the top p bits of v in [2^(p-1), 2^p), and is counted in
+ * bucket (s << (p - 1)) + (v >> s). The buckets of each shift follow the ones of the shift before
+ * with no gaps, the last one is for the values with bit 63 set.
+ *
+ * The writer updates the counters with relaxed loads and stores, there are no atomic read modify
+ * write instructions in hdrhist_record(). A reader sums the buckets first and then walks them to
+ * a percentile, the counts only grow so the walk always reaches the target of the sum.
+ */
+struct hdrhist_s {
+    uint32_t precision;                   /**< Significant bits of a value kept */
+    uint32_t nb_buckets;                  /**< Number of buckets */
+    FGEN_ATOMIC(uint_least64_t) count;    /**< Number of values recorded */
+    FGEN_ATOMIC(uint_least64_t) sum;      /**< Sum of the values recorded */
+    FGEN_ATOMIC(uint_least64_t) min;      /**< Smallest value recorded, UINT64_MAX if none */
+    FGEN_ATOMIC(uint_least64_t) max;      /**< Largest value recorded */
+    FGEN_ATOMIC(uint_least64_t) counts[]; /**< Count of each bucket */
+};
+
+#define LOAD(x)     atomic_load_explicit(&(x), FGEN_MEMORY_ORDER(relaxed))
+#define STORE(x, v) atomic_store_explicit(&(x), (v), FGEN_MEMORY_ORDER(relaxed))
+
+static inline uint32_t
+hist_index(uint32_t p, uint64_t val)
+{
+    uint32_t shift;
+
+    if (val < (1ULL << p))
+        return (uint32_t)val;
+
+    shift = (63 - __builtin_clzll(val)) - p + 1;
+    return (shift << (p - 1)) + (uint32_t)(val >> shift);
+}
+
+/* The largest value counted in a bucket */
+static inline uint64_t
+hist_highest(uint32_t p, uint32_t idx)
+{
+    uint32_t shift;
+
+    if (idx < (1U << p))
+        return idx;
+
+    shift = (idx >> (p - 1)) - 1;
+    return ((uint64_t)(idx - (shift << (p - 1))) << shift) + ((1ULL << shift) - 1);
+}
+
+hdrhist_t *
+hdrhist_create(uint32_t precision)
+{
+    hdrhist_t *h;
+    uint32_t nb;
+
+    if (precision == 0)
+        precision = HDRHIST_PRECISION_DEFAULT;
+    if (precision < HDRHIST_PRECISION_MIN || precision > HDRHIST_PRECISION_MAX)
+        FGEN_NULL_RET("precision %u is not %d to %d\n", precision, HDRHIST_PRECISION_MIN,
+                      HDRHIST_PRECISION_MAX);
+
+    nb = hist_index(precision, UINT64_MAX) + 1;
+
+    h = calloc(1, sizeof(hdrhist_t) + (nb * sizeof(h->counts[0])));
+    if (!h)
+        FGEN_NULL_RET("Failed to allocate histogram of %u buckets\n", nb);
+
+    h->precision  = precision;
+    h->nb_buckets = nb;
+    STORE(h->min, UINT64_MAX);
+
+    return h;
+}
+
+void
+hdrhist_destroy(hdrhist_t *h)
+{
+    free(h);
+}
+
+void
+hdrhist_record(hdrhist_t *h, uint64_t val)
+{
+    uint32_t idx = hist_index(h->precision, val);
+
+    STORE(h->counts[idx], LOAD(h->counts[idx]) + 1);
+    STORE(h->sum, LOAD(h->sum) + val);
+    if (val < LOAD(h->min))
+        STORE(h->min, val);
+    if (val > LOAD(h->max))
+        STORE(h->max, val);
+    STORE(h->count, LOAD(h->count) + 1);
+}
+
+void
+hdrhist_reset(hdrhist_t *h)
+{
+    if (!h)
+        return;
+
+    for (uint32_t i = 0; i < h->nb_buckets; i++)
+        STORE(h->counts[i], 0);
+    STORE(h->count, 0);
+    STORE(h->sum, 0);
+    STORE(h->min, UINT64_MAX);
+    STORE(h->max, 0);
+}
+
+int
+hdrhist_merge(hdrhist_t *dst, const hdrhist_t *src)
+{
+    uint64_t min, max;
+
+    if (!dst || !src || dst->precision != src->precision)
+        FGEN_ERR_RET("Histograms are NULL or of different precision\n");
+
+    for (uint32_t i = 0; i < src->nb_buckets; i++) {
+        uint64_t n = LOAD(src->counts[i]);
+
+        if (n)
+            STORE(dst->counts[i], LOAD(dst->counts[i]) + n);
+    }
+    min = LOAD(src->min);
+    max = LOAD(src->max);
+    STORE(dst->sum, LOAD(dst->sum) + LOAD(src->sum));
+    STORE(dst->min, FGEN_MIN(LOAD(dst->min), min));
+    STORE(dst->max, FGEN_MAX(LOAD(dst->max), max));
+    STORE(dst->count, LOAD(dst->count) + LOAD(src->count));
+
+    return 0;
+}
+
+static uint64_t
+hist_total(const hdrhist_t *h)
+{
+    uint64_t total = 0;
+
+    for (uint32_t i = 0; i < h->nb_buckets; i++)
+        total += LOAD(h->counts[i]);
+
+    return total;
+}
+
+/* Walk the buckets to the target count of each percentile, pcts are in increasing order */
+static void
+hist_percentiles(const hdrhist_t *h, uint64_t total, const double *pcts, uint64_t *vals, int n)
+{
+    uint64_t min  = LOAD(h->min);
+    uint64_t max  = LOAD(h->max);
+    uint64_t seen = 0;
+    uint32_t idx  = 0;
+
+    for (int k = 0; k < n; k++) {
+        double pct      = FGEN_MIN(FGEN_MAX(pcts[k], 0.0), 100.0);
+        uint64_t target = (uint64_t)((pct / 100.0) * (double)total + 0.5);
+
+        if (target == 0)
+            target = 1;
+        while (idx < h->nb_buckets) {
+            seen += LOAD(h->counts[idx]);
+            if (seen >= target)
+                break;
+            idx++;
+        }
+        /* The top of the bucket, within the values seen */
+        vals[k] = FGEN_MAX(FGEN_MIN(hist_highest(h->precision, idx), max), min);
+        if (idx < h->nb_buckets)
+            seen -= LOAD(h->counts[idx]);
+    }
+}
+
+uint64_t
+hdrhist_percentile(const hdrhist_t *h, double pct)
+{
+    uint64_t total, val;
+
+    if (!h || (total = hist_total(h)) == 0)
+        return 0;
+
+    hist_percentiles(h, total, &pct, &val, 1);
+
+    return val;
+}
+
+int
+hdrhist_summary(const hdrhist_t *h, hdrhist_summary_t *s)
+{
+    const double pcts[] = {50.0, 99.0, 99.9};
+    uint64_t vals[FGEN_DIM(pcts)];
+    uint64_t count;
+
+    if (!h || !s)
+        FGEN_ERR_RET("Histogram or summary is NULL\n");
+
+    memset(s, 0, sizeof(*s));
+
+    s->count = hist_total(h);
+    if (s->count == 0)
+        return 0;
+
+    hist_percentiles(h, s->count, pcts, vals, FGEN_DIM(pcts));
+
+    count   = LOAD(h->count);
+    s->min  = LOAD(h->min);
+    s->max  = LOAD(h->max);
+    s->avg  = count ? LOAD(h->sum) / count : 0;
+    s->p50  = vals[0];
+    s->p99  = vals[1];
+    s->p999 = vals[2];
+
+    return 0;
+}
@@ -0,0 +1,120 @@
+/* SPDX-License-Identifier: BSD-3-Clause
+ * Copyright (c) 2019-2025 Intel Corporation
+ */
+
+#ifndef _FGEN_HDRHIST_H_
+#define _FGEN_HDRHIST_H_
+
+/**
+ * @file
+ *
+ * High dynamic range histogram of 64 bit values, e.g. latencies in TSC cycles.
+ *
+ * Values below 2^precision have a bucket each, above that each power of 2 range is split into
+ * 2^(precision - 1) buckets, so a value is counted with a relative error below 2^(1 - precision)
+ * over the whole 64 bit range. A histogram has one writer, other threads may read it while it is
+ * being written to and see a count at most a few values behind.
+ */
+
+#include <stdint.h>
+
+#include <fgen_common.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define HDRHIST_PRECISION_MIN     2
+#define HDRHIST_PRECISION_MAX     16
+#define HDRHIST_PRECISION_DEFAULT 7 /**< Values are kept within 1.6% */
+
+typedef struct hdrhist_s hdrhist_t; /**< Opaque pointer to internal histogram data */
+
+typedef struct hdrhist_summary_s {
+    uint64_t count; /**< Number of values recorded */
+    uint64_t min;   /**< Smallest value recorded */
+    uint64_t max;   /**< Largest value recorded */
+    uint64_t avg;   /**< Average of the values recorded */
+    uint64_t p50;   /**< 50th percentile */
+    uint64_t p99;   /**< 99th percentile */
+    uint64_t p999;  /**< 99.9th percentile */
+} hdrhist_summary_t;
+
+/**
+ * Create a histogram.
+ *
+ * @param precision
+ *   Number of significant bits of a value kept, HDRHIST_PRECISION_MIN to HDRHIST_PRECISION_MAX
+ *   or 0 for HDRHIST_PRECISION_DEFAULT.
+ * @return
+ *   The hdrhist_t pointer or NULL on error
+ */
+FGEN_API hdrhist_t *hdrhist_create(uint32_t precision);
+
+/**
+ * Free a histogram.
+ *
+ * @param h
+ *   The hdrhist_t pointer, can be NULL.
+ */
+FGEN_API void hdrhist_destroy(hdrhist_t *h);
+
+/**
+ * Record a value, only called by the one writer of the histogram.
+ *
+ * @param h
+ *   The hdrhist_t pointer
+ * @param val
+ *   The value to count.
+ */
+FGEN_API void hdrhist_record(hdrhist_t *h, uint64_t val);
+
+/**
+ * Clear the counts of a histogram, only called by the writer or while there is no writer.
+ *
+ * @param h
+ *   The hdrhist_t pointer
+ */
+FGEN_API void hdrhist_reset(hdrhist_t *h);
+
+/**
+ * Add the counts of a histogram to another of the same precision.
+ *
+ * @param dst
+ *   The hdrhist_t pointer to add the counts to, not written to by another thread.
+ * @param src
+ *   The hdrhist_t pointer to add the counts from.
+ * @return
+ *   0 on success or -1 on error
+ */
+FGEN_API int hdrhist_merge(hdrhist_t *dst, const hdrhist_t *src);
+
+/**
+ * Return the value at a percentile of the values recorded.
+ *
+ * @param h
+ *   The hdrhist_t pointer
+ * @param pct
+ *   The percentile 0.0 to 100.0.
+ * @return
+ *   The largest value counted in the bucket of the percentile, 0 if no values are recorded
+ */
+FGEN_API uint64_t hdrhist_percentile(const hdrhist_t *h, double pct);
+
+/**
+ * Return the count, min, max, average and the 50, 99 and 99.9 percentiles of a histogram.
+ *
+ * @param h
+ *   The hdrhist_t pointer
+ * @param s
+ *   The hdrhist_summary_t to fill in, all zero if no values are recorded.
+ * @return
+ *   0 on success or -1 on error
+ */
+FGEN_API int hdrhist_summary(const hdrhist_t *h, hdrhist_summary_t *s);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _FGEN_HDRHIST_H_ */
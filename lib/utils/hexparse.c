@@ -0,0 +1,131 @@
+/* SPDX-License-Identifier: BSD-3-Clause
+ * Copyright (c) 2019-2025 Intel Corporation
+ */
+
+#include <stdint.h>        // for uint8_t, uint32_t
+#include <string.h>        // for strlen
+#if defined(__SSSE3__)
+#include <immintrin.h>
+#endif
+
+#include <fgen_common.h>
+#include "hexparse.h"
+#include "hexparse_priv.h"
+
+#define SSE_BLOCK 16
+
+typedef int (*hexparse_fn_t)(hexparse_t *hp, int pos, int end);
+
+static hexparse_fn_t hexparse_vector;
+
+#if defined(__SSSE3__)
+/*
+ * Classify 16 characters at a time into hex digits and separators. A block of only digits is
+ * converted with a multiply-add of the digit pairs, any other block pairs up the digits from
+ * the digit bit mask. A block with an invalid character is handed to the scalar parser to find
+ * the exact error position.
+ */
+static int
+hexparse_sse(hexparse_t *hp, int pos, int end)
+{
+    const __m128i zero9  = _mm_set1_epi8('0' - 1);
+    const __m128i nine1  = _mm_set1_epi8('9' + 1);
+    const __m128i a1     = _mm_set1_epi8('a' - 1);
+    const __m128i f1     = _mm_set1_epi8('f' + 1);
+    const __m128i lcase  = _mm_set1_epi8(0x20);
+    const __m128i ws_lo  = _mm_set1_epi8('\t' - 1);
+    const __m128i ws_hi  = _mm_set1_epi8('\r' + 1);
+    const __m128i space  = _mm_set1_epi8(' ');
+    const __m128i colon  = _mm_set1_epi8(':');
+    const __m128i dash   = _mm_set1_epi8('-');
+    const __m128i comma  = _mm_set1_epi8(',');
+    const __m128i dec_o  = _mm_set1_epi8('0');
+    const __m128i alp_o  = _mm_set1_epi8('a' - 10);
+    const __m128i pairs  = _mm_set1_epi16(0x0110);
+    uint8_t vals[SSE_BLOCK] __fgen_aligned(16);
+
+    for (; (end - pos) >= SSE_BLOCK; pos += SSE_BLOCK) {
+        __m128i v = _mm_loadu_si128((const __m128i *)(const void *)&hp->text[pos]);
+        __m128i l = _mm_or_si128(v, lcase);
+        __m128i dec, alp, sep, val;
+        uint32_t dmask, smask;
+
+        dec = _mm_and_si128(_mm_cmpgt_epi8(v, zero9), _mm_cmpgt_epi8(nine1, v));
+        alp = _mm_and_si128(_mm_cmpgt_epi8(l, a1), _mm_cmpgt_epi8(f1, l));
+        sep = _mm_and_si128(_mm_cmpgt_epi8(v, ws_lo), _mm_cmpgt_epi8(ws_hi, v));
+        sep = _mm_or_si128(sep, _mm_cmpeq_epi8(v, space));
+        sep = _mm_or_si128(sep, _mm_cmpeq_epi8(v, colon));
+        sep = _mm_or_si128(sep, _mm_cmpeq_epi8(v, dash));
+        sep = _mm_or_si128(sep, _mm_cmpeq_epi8(v, comma));
+
+        val = _mm_or_si128(_mm_and_si128(dec, _mm_sub_epi8(v, dec_o)),
+                           _mm_and_si128(alp, _mm_sub_epi8(l, alp_o)));
+
+        dmask = _mm_movemask_epi8(_mm_or_si128(dec, alp));
+        smask = _mm_movemask_epi8(sep);
+
+        if ((dmask | smask) != 0xFFFF) {
+            if (hexparse_scalar(hp, pos, pos + SSE_BLOCK) < 0)
+                return -1;
+            continue;
+        }
+
+        if (dmask == 0xFFFF && hp->pending < 0 && (hp->cnt + (SSE_BLOCK / 2)) <= hp->len) {
+            /* (hi * 16) + lo for each pair, then narrow to bytes */
+            __m128i b = _mm_maddubs_epi16(val, pairs);
+
+            _mm_storel_epi64((__m128i *)(void *)&hp->buf[hp->cnt], _mm_packus_epi16(b, b));
+            hp->cnt += SSE_BLOCK / 2;
+            continue;
+        }
+
+        _mm_store_si128((__m128i *)(void *)vals, val);
+        if (hexparse_pairs(hp, pos, dmask, SSE_BLOCK, vals) < 0)
+            return -1;
+    }
+
+    return pos;
+}
+#endif
+
+FGEN_INIT(hexparse_init)
+{
+#if defined(CC_AVX2_SUPPORT)
+    if (__builtin_cpu_supports("avx2")) {
+        hexparse_vector = hexparse_avx2;
+        return;
+    }
+#endif
+#if defined(__SSSE3__)
+    hexparse_vector = hexparse_sse;
+#endif
+}
+
+int
+fgen_hex_parse(const char *text, uint8_t *buf, int len, int *err_pos)
+{
+    hexparse_t hp = {.text = text, .buf = buf, .len = len, .pending = -1, .err_pos = -1};
+    int end, pos = 0;
+
+    if (!text || !buf || len <= 0)
+        return -1;
+
+    end = strlen(text);
+
+    if (hexparse_vector)
+        pos = hexparse_vector(&hp, pos, end);
+    if (pos >= 0)
+        pos = hexparse_scalar(&hp, pos, end);
+
+    /* The last digit must complete a pair */
+    if (pos >= 0 && hp.pending >= 0)
+        pos = hexparse_error(&hp, hp.pending_pos);
+
+    if (pos < 0) {
+        if (err_pos)
+            *err_pos = hp.err_pos;
+        return -1;
+    }
+
+    return hp.cnt;
+}
@@ -0,0 +1,48 @@
+/* SPDX-License-Identifier: BSD-3-Clause
+ * Copyright (c) 2019-2025 Intel Corporation
+ */
+
+#ifndef _FGEN_HEXPARSE_H_
+#define _FGEN_HEXPARSE_H_
+
+/**
+ * @file
+ *
+ * Convert a hex dump text string into binary data.
+ *
+ * The text is a list of hex digit pairs, each pair is one byte. Pairs can be written back to
+ * back or split by white space or the ':', '-' and ',' separators, e.g. "3c fd fe", "3C:FD:FE",
+ * or "3cfdfe". A separator can not split a pair. SSE and AVX2 versions are used when the CPU
+ * supports them.
+ */
+
+#include <stdint.h>
+
+#include <fgen_common.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Convert a hex dump text string into binary data.
+ *
+ * @param text
+ *   The hex dump text, must be NULL terminated.
+ * @param buf
+ *   The buffer to place the converted bytes.
+ * @param len
+ *   The length of the buffer in bytes.
+ * @param err_pos
+ *   If not NULL the offset into text of the first invalid character, unpaired digit or the
+ *   first byte that does not fit in the buffer is returned on error.
+ * @return
+ *   -1 on error or the number of bytes placed in the buffer.
+ */
+FGEN_API int fgen_hex_parse(const char *text, uint8_t *buf, int len, int *err_pos);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _FGEN_HEXPARSE_H_ */
@@ -0,0 +1,75 @@
+/* SPDX-License-Identifier: BSD-3-Clause
+ * Copyright (c) 2019-2025 Intel Corporation
+ */
+
+#include <stdint.h>        // for uint8_t, uint32_t
+#include <immintrin.h>
+
+#include <fgen_common.h>
+#include "hexparse_priv.h"
+
+#define AVX2_BLOCK 32
+
+/* Same as the SSE version in hexparse.c with 32 character blocks */
+int
+hexparse_avx2(hexparse_t *hp, int pos, int end)
+{
+    const __m256i zero9 = _mm256_set1_epi8('0' - 1);
+    const __m256i nine1 = _mm256_set1_epi8('9' + 1);
+    const __m256i a1    = _mm256_set1_epi8('a' - 1);
+    const __m256i f1    = _mm256_set1_epi8('f' + 1);
+    const __m256i lcase = _mm256_set1_epi8(0x20);
+    const __m256i ws_lo = _mm256_set1_epi8('\t' - 1);
+    const __m256i ws_hi = _mm256_set1_epi8('\r' + 1);
+    const __m256i space = _mm256_set1_epi8(' ');
+    const __m256i colon = _mm256_set1_epi8(':');
+    const __m256i dash  = _mm256_set1_epi8('-');
+    const __m256i comma = _mm256_set1_epi8(',');
+    const __m256i dec_o = _mm256_set1_epi8('0');
+    const __m256i alp_o = _mm256_set1_epi8('a' - 10);
+    const __m256i pairs = _mm256_set1_epi16(0x0110);
+    uint8_t vals[AVX2_BLOCK] __fgen_aligned(32);
+
+    for (; (end - pos) >= AVX2_BLOCK; pos += AVX2_BLOCK) {
+        __m256i v = _mm256_loadu_si256((const __m256i *)(const void *)&hp->text[pos]);
+        __m256i l = _mm256_or_si256(v, lcase);
+        __m256i dec, alp, sep, val;
+        uint32_t dmask, smask;
+
+        dec = _mm256_and_si256(_mm256_cmpgt_epi8(v, zero9), _mm256_cmpgt_epi8(nine1, v));
+        alp = _mm256_and_si256(_mm256_cmpgt_epi8(l, a1), _mm256_cmpgt_epi8(f1, l));
+        sep = _mm256_and_si256(_mm256_cmpgt_epi8(v, ws_lo), _mm256_cmpgt_epi8(ws_hi, v));
+        sep = _mm256_or_si256(sep, _mm256_cmpeq_epi8(v, space));
+        sep = _mm256_or_si256(sep, _mm256_cmpeq_epi8(v, colon));
+        sep = _mm256_or_si256(sep, _mm256_cmpeq_epi8(v, dash));
+        sep = _mm256_or_si256(sep, _mm256_cmpeq_epi8(v, comma));
+
+        val = _mm256_or_si256(_mm256_and_si256(dec, _mm256_sub_epi8(v, dec_o)),
+                              _mm256_and_si256(alp, _mm256_sub_epi8(l, alp_o)));
+
+        dmask = (uint32_t)_mm256_movemask_epi8(_mm256_or_si256(dec, alp));
+        smask = (uint32_t)_mm256_movemask_epi8(sep);
+
+        if ((dmask | smask) != 0xFFFFFFFF) {
+            if (hexparse_scalar(hp, pos, pos + AVX2_BLOCK) < 0)
+                return -1;
+            continue;
+        }
+
+        if (dmask == 0xFFFFFFFF && hp->pending < 0 && (hp->cnt + (AVX2_BLOCK / 2)) <= hp->len) {
+            __m256i b = _mm256_maddubs_epi16(val, pairs);
+
+            /* packus works per 128-bit lane, move the two valid quad words together */
+            b = _mm256_permute4x64_epi64(_mm256_packus_epi16(b, b), 0x08);
+            _mm_storeu_si128((__m128i *)(void *)&hp->buf[hp->cnt], _mm256_castsi256_si128(b));
+            hp->cnt += AVX2_BLOCK / 2;
+            continue;
+        }
+
+        _mm256_store_si256((__m256i *)(void *)vals, val);
+        if (hexparse_pairs(hp, pos, dmask, AVX2_BLOCK, vals) < 0)
+            return -1;
+    }
+
+    return pos;
+}
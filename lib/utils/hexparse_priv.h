@@ -0,0 +1,152 @@
+/* SPDX-License-Identifier: BSD-3-Clause
+ * Copyright (c) 2019-2025 Intel Corporation
+ */
+
+#ifndef _FGEN_HEXPARSE_PRIV_H_
+#define _FGEN_HEXPARSE_PRIV_H_
+
+/**
+ * @file
+ *
+ * Internal state and helpers shared by the scalar and vector hex parsers.
+ */
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct hexparse_s {
+    const char *text; /**< Start of the text, used for error offsets */
+    uint8_t *buf;     /**< Output buffer */
+    int len;          /**< Length of the output buffer */
+    int cnt;          /**< Number of bytes in the output buffer */
+    int pending;      /**< Value of the first digit of an unfinished pair or -1 */
+    int pending_pos;  /**< Text offset of the pending digit */
+    int err_pos;      /**< Text offset of the error */
+} hexparse_t;
+
+static inline int
+hexparse_error(hexparse_t *hp, int pos)
+{
+    hp->err_pos = pos;
+    return -1;
+}
+
+static inline int
+hexparse_digit(char c)
+{
+    if (c >= '0' && c <= '9')
+        return c - '0';
+    c |= 0x20;
+    if (c >= 'a' && c <= 'f')
+        return c - 'a' + 10;
+    return -1;
+}
+
+static inline int
+hexparse_separator(char c)
+{
+    return c == ' ' || (c >= '\t' && c <= '\r') || c == ':' || c == '-' || c == ',';
+}
+
+/**
+ * Parse the text from pos to end one character at a time.
+ *
+ * @return
+ *   -1 on error or end.
+ */
+static inline int
+hexparse_scalar(hexparse_t *hp, int pos, int end)
+{
+    for (; pos < end; pos++) {
+        char c = hp->text[pos];
+        int v  = hexparse_digit(c);
+
+        if (v < 0) {
+            if (!hexparse_separator(c))
+                return hexparse_error(hp, pos);
+            if (hp->pending >= 0)
+                return hexparse_error(hp, hp->pending_pos);
+            continue;
+        }
+
+        if (hp->pending < 0) {
+            hp->pending     = v;
+            hp->pending_pos = pos;
+            continue;
+        }
+
+        if (hp->cnt >= hp->len)
+            return hexparse_error(hp, hp->pending_pos);
+        hp->buf[hp->cnt++] = (hp->pending << 4) | v;
+        hp->pending        = -1;
+    }
+
+    return end;
+}
+
+/**
+ * Pair up the digits of a block of text from the classification done by a vector parser.
+ *
+ * @param pos
+ *   Text offset of the first character in the block.
+ * @param dmask
+ *   Bit mask of the hex digit characters in the block.
+ * @param nbits
+ *   Number of characters in the block.
+ * @param vals
+ *   The digit value of each character in the block.
+ * @return
+ *   -1 on error or 0 on success.
+ */
+static inline int
+hexparse_pairs(hexparse_t *hp, int pos, uint32_t dmask, int nbits, const uint8_t *vals)
+{
+    int i;
+
+    /* A digit left over from the previous block must pair with the first character */
+    if (hp->pending >= 0) {
+        if (!(dmask & 1))
+            return hexparse_error(hp, hp->pending_pos);
+        if (hp->cnt >= hp->len)
+            return hexparse_error(hp, hp->pending_pos);
+        hp->buf[hp->cnt++] = (hp->pending << 4) | vals[0];
+        hp->pending        = -1;
+        dmask &= ~1u;
+    }
+
+    while (dmask) {
+        i = __builtin_ctz(dmask);
+
+        if (i == (nbits - 1)) {
+            hp->pending     = vals[i];
+            hp->pending_pos = pos + i;
+            break;
+        }
+        if (!(dmask & (2u << i)))
+            return hexparse_error(hp, pos + i);
+        if (hp->cnt >= hp->len)
+            return hexparse_error(hp, pos + i);
+
+        hp->buf[hp->cnt++] = (vals[i] << 4) | vals[i + 1];
+        dmask &= ~(3u << i);
+    }
+
+    return 0;
+}
+
+/**
+ * AVX2 version of the parser, processes 32 character blocks from pos.
+ *
+ * @return
+ *   -1 on error or the text offset of the first character not processed.
+ */
+int hexparse_avx2(hexparse_t *hp, int pos, int end);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _FGEN_HEXPARSE_PRIV_H_ */
@@ -0,0 +1,77 @@
+/* SPDX-License-Identifier: BSD-3-Clause
+ * Copyright (c) 2019-2025 Intel Corporation
+ */
+
+#include <stdint.h>        // for uint8_t, uint32_t
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#include <fgen_common.h>
+#include "maskcmp.h"
+#include "maskcmp_priv.h"
+
+#define SSE_BLOCK 16
+
+typedef int (*maskcmp_fn_t)(const uint8_t *a, const uint8_t *b, const uint8_t *m, int *pos,
+                            int len);
+
+static maskcmp_fn_t maskcmp_vector;
+
+#if defined(__SSE2__)
+/*
+ * XOR 16 bytes of each buffer, clear the bits not in the mask and compare the result to zero.
+ * The byte mask of the compare gives the first differing byte of the block.
+ */
+static int
+maskcmp_sse(const uint8_t *a, const uint8_t *b, const uint8_t *m, int *pos, int len)
+{
+    const __m128i zero = _mm_setzero_si128();
+    int p              = *pos;
+
+    for (; (len - p) >= SSE_BLOCK; p += SSE_BLOCK) {
+        __m128i va = _mm_loadu_si128((const __m128i *)(const void *)&a[p]);
+        __m128i vb = _mm_loadu_si128((const __m128i *)(const void *)&b[p]);
+        __m128i vm = _mm_loadu_si128((const __m128i *)(const void *)&m[p]);
+        __m128i x  = _mm_and_si128(_mm_xor_si128(va, vb), vm);
+        uint32_t eq;
+
+        eq = (uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(x, zero));
+        if (eq != 0xFFFF)
+            return p + __builtin_ctz(~eq);
+    }
+    *pos = p;
+
+    return -1;
+}
+#endif
+
+FGEN_INIT(maskcmp_init)
+{
+#if defined(CC_AVX2_SUPPORT)
+    if (__builtin_cpu_supports("avx2")) {
+        maskcmp_vector = maskcmp_avx2;
+        return;
+    }
+#endif
+#if defined(__SSE2__)
+    maskcmp_vector = maskcmp_sse;
+#endif
+}
+
+int
+fgen_mask_cmp(const void *a, const void *b, const void *mask, int len)
+{
+    int pos = 0, ret;
+
+    if (!a || !b || !mask || len <= 0)
+        return -1;
+
+    if (maskcmp_vector) {
+        ret = maskcmp_vector(a, b, mask, &pos, len);
+        if (ret >= 0)
+            return ret;
+    }
+
+    return maskcmp_scalar(a, b, mask, pos, len);
+}
@@ -0,0 +1,46 @@
+/* SPDX-License-Identifier: BSD-3-Clause
+ * Copyright (c) 2019-2025 Intel Corporation
+ */
+
+#ifndef _FGEN_MASKCMP_H_
+#define _FGEN_MASKCMP_H_
+
+/**
+ * @file
+ *
+ * Compare two buffers under a byte mask.
+ *
+ * The buffers are XORed, the result is ANDed with the mask and the offset of the first non-zero
+ * byte is returned. A mask byte of 0xFF compares all bits of a byte, 0x00 ignores the byte.
+ * SSE2 and AVX2 versions are used when the CPU supports them.
+ */
+
+#include <stdint.h>
+
+#include <fgen_common.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Find the first byte that differs between two buffers under a mask.
+ *
+ * @param a
+ *   The first buffer.
+ * @param b
+ *   The second buffer.
+ * @param mask
+ *   The byte mask of the bits to compare.
+ * @param len
+ *   The number of bytes in each buffer, only len bytes are read from each buffer.
+ * @return
+ *   -1 if the buffers are the same under the mask or the offset of the first differing byte.
+ */
+FGEN_API int fgen_mask_cmp(const void *a, const void *b, const void *mask, int len);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _FGEN_MASKCMP_H_ */
@@ -0,0 +1,34 @@
+/* SPDX-License-Identifier: BSD-3-Clause
+ * Copyright (c) 2019-2025 Intel Corporation
+ */
+
+#include <stdint.h>        // for uint8_t, uint32_t
+#include <immintrin.h>
+
+#include <fgen_common.h>
+#include "maskcmp_priv.h"
+
+#define AVX2_BLOCK 32
+
+/* Same as the SSE2 version in maskcmp.c with 32 byte blocks */
+int
+maskcmp_avx2(const uint8_t *a, const uint8_t *b, const uint8_t *m, int *pos, int len)
+{
+    const __m256i zero = _mm256_setzero_si256();
+    int p              = *pos;
+
+    for (; (len - p) >= AVX2_BLOCK; p += AVX2_BLOCK) {
+        __m256i va = _mm256_loadu_si256((const __m256i *)(const void *)&a[p]);
+        __m256i vb = _mm256_loadu_si256((const __m256i *)(const void *)&b[p]);
+        __m256i vm = _mm256_loadu_si256((const __m256i *)(const void *)&m[p]);
+        __m256i x  = _mm256_and_si256(_mm256_xor_si256(va, vb), vm);
+        uint32_t eq;
+
+        eq = (uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(x, zero));
+        if (eq != 0xFFFFFFFF)
+            return p + __builtin_ctz(~eq);
+    }
+    *pos = p;
+
+    return -1;
+}
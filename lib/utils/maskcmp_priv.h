@@ -0,0 +1,50 @@
+/* SPDX-License-Identifier: BSD-3-Clause
+ * Copyright (c) 2019-2025 Intel Corporation
+ */
+
+#ifndef _FGEN_MASKCMP_PRIV_H_
+#define _FGEN_MASKCMP_PRIV_H_
+
+/**
+ * @file
+ *
+ * Helpers shared by the scalar and vector masked compares.
+ */
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Compare the bytes from pos to len one at a time.
+ *
+ * @return
+ *   -1 if the bytes are the same under the mask or the offset of the first differing byte.
+ */
+static inline int
+maskcmp_scalar(const uint8_t *a, const uint8_t *b, const uint8_t *m, int pos, int len)
+{
+    for (; pos < len; pos++) {
+        if ((a[pos] ^ b[pos]) & m[pos])
+            return pos;
+    }
+    return -1;
+}
+
+/**
+ * AVX2 version of the compare, processes 32 byte blocks from pos.
+ *
+ * @param pos
+ *   The location of the offset to start, updated to the first byte not processed.
+ * @return
+ *   -1 if the blocks are the same under the mask or the offset of the first differing byte.
+ */
+int maskcmp_avx2(const uint8_t *a, const uint8_t *b, const uint8_t *m, int *pos, int len);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _FGEN_MASKCMP_PRIV_H_ */
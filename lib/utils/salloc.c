@@ -11,7 +11,7 @@
 #include "salloc.h"
 
 salloc_t *
-salloc_create(uint64_t size)
+salloc_create(size_t size)
 {
     salloc_t *salloc;
 
@@ -43,19 +43,45 @@ salloc_destroy(salloc_t *salloc)
 }
 
 int
-salloc(salloc_t *salloc, uint64_t size, offset_t *offset)
+salloc_reserve(salloc_t *salloc, size_t size)
+{
+    uint64_t nsize;
+    void *p;
+
+    if (!salloc)
+        return -1;
+
+    if (salloc->ptr && size <= salloc_unused(salloc))
+        return 0;
+
+    /* Grow the block by doubling to keep the number of realloc() calls small */
+    nsize = (salloc->size) ? salloc->size : DEFAULT_SALLOC_BLOCK_SIZE;
+    while ((nsize - salloc->used) < size)
+        nsize *= 2;
+
+    p = realloc(salloc->ptr, nsize);
+    if (!p)
+        FGEN_ERR_RET("salloc for %zu bytes\n", size);
+
+    /* Clear the new space, as salloc_create() returns a zeroed block */
+    memset((char *)p + salloc->size, 0, nsize - salloc->size);
+    salloc->ptr  = p;
+    salloc->size = nsize;
+
+    return 0;
+}
+
+int
+salloc(salloc_t *salloc, size_t size, offset_t *offset)
 {
     if (!salloc || !offset)
         return -1;
     if (size == 0)
         return -1;
 
-    if (!salloc->ptr || (size > salloc_unused(salloc))) {
-        salloc->ptr = realloc(salloc->ptr, size);
-        if (!salloc->ptr)
-            FGEN_ERR_RET("salloc for %ld bytes", size);
-        salloc->size += size;
-    }
+    if (salloc_reserve(salloc, size) < 0)
+        return -1;
+
     *offset = salloc->used;
     salloc->used += size;
 
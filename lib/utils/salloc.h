@@ -86,6 +86,19 @@ FGEN_API void salloc_destroy(salloc_t *salloc);
  */
 FGEN_API int salloc(salloc_t *salloc, size_t size, offset_t *offset);
 
+/**
+ * @brief Make sure at least size bytes are unused in the memory block without allocating them.
+ *
+ * The memory block may be moved by the resize, which means pointers returned by
+ * salloc_ptr() before this call are no longer valid. The next salloc() call of size
+ * bytes or less returns the offset salloc_t.used had when this function returned.
+ *
+ * @param salloc A pointer to the salloc_t structure
+ * @param size The number of unused bytes required in the memory block
+ * @return int 0 on success, negative value on failure
+ */
+FGEN_API int salloc_reserve(salloc_t *salloc, size_t size);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,191 @@
+/* SPDX-License-Identifier: BSD-3-Clause
+ * Copyright (c) 2019-2025 Intel Corporation
+ */
+
+#include <stdint.h>          // for uint64_t, uint32_t
+#include <stdlib.h>          // for calloc, free
+#include <string.h>          // for memset
+#include <fgen_common.h>     // for FGEN_MIN, fgen_align32pow2
+#include <fgen_atomic.h>     // for FGEN_ATOMIC, FGEN_MEMORY_ORDER
+
+#include <fgen_log.h>
+#include "seqtrack.h"
+
+/*
+ * Bit (seq & mask) of the bitmap of a stream is set when seq was received, for the window of
+ * numbers before next. Moving next forward clears the bits of the numbers skipped, at most the
+ * whole bitmap, so a gap costs the same as a packet a window ahead.
+ *
+ * The counters are written with relaxed loads and stores by the one writer, as in hdrhist.c.
+ */
+enum { CNT_IN_ORDER, CNT_LOST, CNT_LATE, CNT_DUP, CNT_MAX };
+
+typedef struct {
+    uint64_t next;                            /**< Next sequence number expected */
+    uint64_t first;                           /**< First sequence number received */
+    uint32_t started;                         /**< A packet of the stream was received */
+    FGEN_ATOMIC(uint_least64_t) cnt[CNT_MAX]; /**< Counts of the stream */
+} seqtrack_stream_t;
+
+struct seqtrack_s {
+    uint32_t nb_streams;                        /**< Number of streams */
+    uint32_t nb_words;                          /**< 64 bit words of the bitmap of a stream */
+    uint64_t mask;                              /**< Window - 1 */
+    FGEN_ATOMIC(uint_least64_t) total[CNT_MAX]; /**< Counts of all the streams */
+    seqtrack_stream_t *streams;                 /**< State of each stream */
+    uint64_t *bits;                             /**< Bitmaps of the streams, nb_words each */
+};
+
+#define LOAD(x)     atomic_load_explicit(&(x), FGEN_MEMORY_ORDER(relaxed))
+#define STORE(x, v) atomic_store_explicit(&(x), (v), FGEN_MEMORY_ORDER(relaxed))
+
+static inline void
+_count(seqtrack_t *t, seqtrack_stream_t *s, int cnt, int64_t n)
+{
+    STORE(s->cnt[cnt], LOAD(s->cnt[cnt]) + n);
+    STORE(t->total[cnt], LOAD(t->total[cnt]) + n);
+}
+
+/* Clear the bits of count numbers from a number, count is at most the window */
+static inline void
+_bits_clear(uint64_t *bits, uint64_t mask, uint64_t from, uint64_t count)
+{
+    while (count) {
+        uint64_t pos = from & mask;
+        uint32_t bit = pos & 63;
+        uint64_t n   = FGEN_MIN(count, (uint64_t)(64 - bit));
+        uint64_t m   = (n == 64) ? ~0ULL : (((1ULL << n) - 1) << bit);
+
+        bits[pos >> 6] &= ~m;
+        from += n;
+        count -= n;
+    }
+}
+
+seqtrack_t *
+seqtrack_create(uint32_t nb_streams, uint32_t window)
+{
+    seqtrack_t *t;
+
+    if (window == 0)
+        window = SEQTRACK_WINDOW_DEFAULT;
+    if (!nb_streams || window > SEQTRACK_WINDOW_MAX)
+        FGEN_NULL_RET("nb_streams %u or window %u is invalid\n", nb_streams, window);
+    window = fgen_align32pow2(FGEN_MAX(window, 64U));
+
+    t = calloc(1, sizeof(seqtrack_t));
+    if (!t)
+        FGEN_NULL_RET("Failed to allocate seqtrack_t structure\n");
+
+    t->nb_streams = nb_streams;
+    t->nb_words   = window / 64;
+    t->mask       = window - 1;
+    t->streams    = calloc(nb_streams, sizeof(seqtrack_stream_t));
+    t->bits       = calloc((size_t)nb_streams * t->nb_words, sizeof(uint64_t));
+    if (!t->streams || !t->bits) {
+        seqtrack_destroy(t);
+        FGEN_NULL_RET("Failed to allocate %u streams of a %u window\n", nb_streams, window);
+    }
+
+    return t;
+}
+
+void
+seqtrack_destroy(seqtrack_t *t)
+{
+    if (!t)
+        return;
+
+    free(t->streams);
+    free(t->bits);
+    free(t);
+}
+
+int
+seqtrack_check(seqtrack_t *t, uint32_t stream, uint64_t seq)
+{
+    seqtrack_stream_t *s;
+    uint64_t *bits, bit, gap;
+
+    if (stream >= t->nb_streams)
+        return -1;
+
+    s    = &t->streams[stream];
+    bits = &t->bits[(size_t)stream * t->nb_words];
+    bit  = 1ULL << (seq & 63);
+
+    if (!s->started || seq >= s->next) {
+        gap = s->started ? seq - s->next : 0;
+
+        if (gap > t->mask)
+            memset(bits, 0, t->nb_words * sizeof(uint64_t));
+        else if (gap)
+            _bits_clear(bits, t->mask, s->next, gap);
+        if (!s->started) {
+            s->first   = seq;
+            s->started = 1;
+        }
+        bits[(seq & t->mask) >> 6] |= bit;
+        s->next = seq + 1;
+
+        if (gap)
+            _count(t, s, CNT_LOST, gap);
+        _count(t, s, CNT_IN_ORDER, 1);
+        return SEQTRACK_IN_ORDER;
+    }
+
+    /* Behind the next expected number, too old to be in the window is late */
+    if ((s->next - seq) <= (t->mask + 1)) {
+        uint64_t *w = &bits[(seq & t->mask) >> 6];
+
+        if (*w & bit) {
+            _count(t, s, CNT_DUP, 1);
+            return SEQTRACK_DUP;
+        }
+        *w |= bit;
+
+        /* Numbers before the first one received were never counted as lost */
+        if (seq > s->first)
+            _count(t, s, CNT_LOST, -1);
+    }
+    _count(t, s, CNT_LATE, 1);
+
+    return SEQTRACK_LATE;
+}
+
+uint32_t
+seqtrack_streams(const seqtrack_t *t)
+{
+    return t ? t->nb_streams : 0;
+}
+
+static void
+_counts(const FGEN_ATOMIC(uint_least64_t) *cnt, seqtrack_counts_t *c)
+{
+    c->in_order = LOAD(cnt[CNT_IN_ORDER]);
+    c->lost     = LOAD(cnt[CNT_LOST]);
+    c->late     = LOAD(cnt[CNT_LATE]);
+    c->dup      = LOAD(cnt[CNT_DUP]);
+}
+
+int
+seqtrack_counts(const seqtrack_t *t, seqtrack_counts_t *c)
+{
+    if (!t || !c)
+        FGEN_ERR_RET("Tracker or counts is NULL\n");
+
+    _counts(t->total, c);
+
+    return 0;
+}
+
+int
+seqtrack_stream_counts(const seqtrack_t *t, uint32_t stream, seqtrack_counts_t *c)
+{
+    if (!t || !c || stream >= t->nb_streams)
+        FGEN_ERR_RET("Tracker or counts is NULL or stream %u is invalid\n", stream);
+
+    _counts(t->streams[stream].cnt, c);
+
+    return 0;
+}
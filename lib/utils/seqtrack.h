@@ -0,0 +1,126 @@
+/* SPDX-License-Identifier: BSD-3-Clause
+ * Copyright (c) 2019-2025 Intel Corporation
+ */
+
+#ifndef _FGEN_SEQTRACK_H_
+#define _FGEN_SEQTRACK_H_
+
+/**
+ * @file
+ *
+ * Loss, reorder and duplicate detection of the sequence numbers of a set of streams.
+ *
+ * Each stream keeps the next sequence number expected and a bitmap of the last window numbers
+ * before it. A number ahead of the next expected counts the numbers skipped as lost, a number
+ * behind it found in the bitmap is a duplicate and one not found is late and is taken back off
+ * the lost count. A number older than the window can not be told from a duplicate and is counted
+ * as late only. The work per packet is a few words of the bitmap, not the size of a gap.
+ *
+ * A tracker has one writer, other threads may read the counts while it is being written to.
+ */
+
+#include <stdint.h>
+
+#include <fgen_common.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define SEQTRACK_WINDOW_DEFAULT 256   /**< Window in sequence numbers used for a window of 0 */
+#define SEQTRACK_WINDOW_MAX     65536 /**< Max window in sequence numbers */
+
+typedef enum {
+    SEQTRACK_IN_ORDER, /**< The next number expected or a number ahead of it */
+    SEQTRACK_LATE,     /**< A number behind the next expected not seen before */
+    SEQTRACK_DUP,      /**< A number seen before */
+} seqtrack_class_t;
+
+typedef struct seqtrack_s seqtrack_t; /**< Opaque pointer to internal tracker data */
+
+typedef struct seqtrack_counts_s {
+    uint64_t in_order; /**< Packets at or ahead of the next expected number */
+    uint64_t lost;     /**< Numbers skipped and not received since */
+    uint64_t late;     /**< Packets behind the next expected number, reordered */
+    uint64_t dup;      /**< Packets with a number received before */
+} seqtrack_counts_t;
+
+/**
+ * Create a tracker for a number of streams.
+ *
+ * @param nb_streams
+ *   Number of streams, the stream IDs are 0 to nb_streams - 1.
+ * @param window
+ *   Number of sequence numbers behind the next expected one a packet is checked against, rounded
+ *   up to a power of 2 of at least 64, at most SEQTRACK_WINDOW_MAX or 0 for the default.
+ * @return
+ *   The seqtrack_t pointer or NULL on error
+ */
+FGEN_API seqtrack_t *seqtrack_create(uint32_t nb_streams, uint32_t window);
+
+/**
+ * Free a tracker.
+ *
+ * @param t
+ *   The seqtrack_t pointer, can be NULL.
+ */
+FGEN_API void seqtrack_destroy(seqtrack_t *t);
+
+/**
+ * Check the sequence number of a packet and count it, only called by the one writer.
+ *
+ * The first packet of a stream sets the next number expected, the numbers before it are not
+ * counted as lost.
+ *
+ * @param t
+ *   The seqtrack_t pointer
+ * @param stream
+ *   The stream ID of the packet.
+ * @param seq
+ *   The sequence number of the packet.
+ * @return
+ *   The seqtrack_class_t of the packet or -1 if the stream ID is out of range
+ */
+FGEN_API int seqtrack_check(seqtrack_t *t, uint32_t stream, uint64_t seq);
+
+/**
+ * Return the number of streams of a tracker.
+ *
+ * @param t
+ *   The seqtrack_t pointer
+ * @return
+ *   The number of streams or 0 if t is NULL
+ */
+FGEN_API uint32_t seqtrack_streams(const seqtrack_t *t);
+
+/**
+ * Return the counts of all the streams of a tracker.
+ *
+ * @param t
+ *   The seqtrack_t pointer
+ * @param c
+ *   The seqtrack_counts_t to fill in.
+ * @return
+ *   0 on success or -1 on error
+ */
+FGEN_API int seqtrack_counts(const seqtrack_t *t, seqtrack_counts_t *c);
+
+/**
+ * Return the counts of one stream of a tracker.
+ *
+ * @param t
+ *   The seqtrack_t pointer
+ * @param stream
+ *   The stream ID.
+ * @param c
+ *   The seqtrack_counts_t to fill in.
+ * @return
+ *   0 on success or -1 on error
+ */
+FGEN_API int seqtrack_stream_counts(const seqtrack_t *t, uint32_t stream, seqtrack_counts_t *c);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _FGEN_SEQTRACK_H_ */
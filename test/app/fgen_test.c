@@ -5,6 +5,8 @@
 #include <stdio.h>             // for size_t, EOF, NULL
 #include <getopt.h>            // for getopt_long, option
 #include <fgen_mmap.h>         // for MMAP_HUGEPAGE_4KB, MMAP_HUGEPAGE_2MB
+#include <fgen_mpool.h>        // for mpool_create, mpool_get_bulk, mpool_put_bulk
+#include <pthread.h>           // for pthread_create, pthread_join
 #include <tst_info.h>          // for tst_cleanup, tst_error, tst_end, tst_s...
 #include <unistd.h>            // for getpagesize
 #include <sys/stat.h>          // for chmod
@@ -19,6 +21,14 @@
 #include <fgen.h>
 #include <fgen_strings.h>
 #include <fgen_version.h>
+#include <fgen_system.h>
+#include <hexparse.h>
+#include <cksum.h>
+#include <crc32.h>
+#include <hdrhist.h>
+#include <seqtrack.h>
+#include <net/fgen_ip.h>
+#include <net/fgen_udp.h>
 
 #include "fgen_test.h"
 
@@ -66,6 +76,12 @@ static const char *default_strings[] = {
         "IPv4(dst=1.2.3.4)/"
         "TCP(sport=0x5678)/"
         "TSC()",
+    "Frame5 := Ether(dst=00:01:02:03:04:05)/"
+        "IPv6(dst=2001:db8::1, src=2001:db8::2, hops=32)/"
+        "TCP(sport=80, dport=1024, seq=100, ack=200, flags=0x18)/"
+        "Payload(size=96, fill=0x5a)",
+    "Frame6 := Ether(dst=ff:ff:ff:ff:ff:ff, type=0x0806)/"
+        "Raw(hex=0001080006040001000102030405c0a80001000000000000c0a80002)",
 };
 
 static const char *pkt_data_string = {
@@ -85,7 +101,7 @@ add_file(char *filename)
 {
     if (info->fgen_file_cnt > MAX_FGEN_FILES)
         return -1;
-    info->fgen_files[info->fgen_file_cnt++] = strdupa(filename);
+    info->fgen_files[info->fgen_file_cnt++] = strdup(filename);
 
     return 0;
 }
@@ -95,7 +111,7 @@ add_string(char *str)
 {
     if (info->fgen_string_cnt > MAX_FGEN_STRINGS)
         return -1;
-    info->fgen_strings[info->fgen_string_cnt++] = strdupa(str);
+    info->fgen_strings[info->fgen_string_cnt++] = strdup(str);
 
     return 0;
 }
@@ -114,6 +130,1149 @@ _open_pcap(void)
     return 0;
 }
 
+/* Parse the same bytes written in different hex dump formats and check the error positions */
+static int
+fgen_hex_test(void)
+{
+    uint8_t expect[256], buf[256];
+    char text[1024], *p;
+    int n, pos, ret = 0;
+
+    for (int i = 0; i < (int)sizeof(expect); i++)
+        expect[i] = (uint8_t)(i * 7 + 3);
+
+    /* Back to back, spaced and colon separated with line breaks */
+    for (int fmt = 0; fmt < 3; fmt++) {
+        p = text;
+        for (int i = 0; i < (int)sizeof(expect); i++) {
+            p += sprintf(p, (fmt == 2) ? "%02X" : "%02x", expect[i]);
+            if (fmt == 1)
+                *p++ = ((i % 16) == 15) ? '\n' : ' ';
+            else if (fmt == 2 && i < (int)sizeof(expect) - 1)
+                *p++ = ((i % 16) == 15) ? '\n' : ':';
+        }
+        *p = '\0';
+
+        n = fgen_decode_string(text, buf, sizeof(buf));
+        if (n != (int)sizeof(expect) || memcmp(buf, expect, n)) {
+            tst_error("Hex format %d parsed %d bytes\n", fmt, n);
+            ret = -1;
+        }
+    }
+
+    /* Invalid character, unpaired digit at the end of a block and a buffer that is too short */
+    memset(text, '0', 40);
+    text[40] = '\0';
+    text[33] = 'x';
+    if (fgen_hex_parse(text, buf, sizeof(buf), &pos) >= 0 || pos != 33) {
+        tst_error("Invalid character position %d != 33\n", pos);
+        ret = -1;
+    }
+    text[33] = '0';
+    text[31] = ' ';
+    if (fgen_hex_parse(text, buf, sizeof(buf), &pos) >= 0 || pos != 30) {
+        tst_error("Unpaired digit position %d != 30\n", pos);
+        ret = -1;
+    }
+    text[31] = '0';
+    if (fgen_hex_parse(text, buf, 10, &pos) >= 0 || pos != 20) {
+        tst_error("Buffer too short position %d != 20\n", pos);
+        ret = -1;
+    }
+
+    if (ret == 0)
+        tst_ok("Hex dump parsing\n");
+    return ret;
+}
+
+/* Decode each frame in round-trip mode and make sure the text encodes to the same bytes */
+static int
+fgen_roundtrip(fgen_t *fg)
+{
+    fgen_t *rt        = NULL;
+    fgen_decode_t *dc = NULL;
+    char name[FGEN_FRAME_NAME_LENGTH];
+    frame_t *f, *r;
+    int ret = -1;
+
+    /* Frames with the FCS are decoded without it and encoded back with it */
+    rt = fgen_create(fg->flags & FGEN_ADD_FCS);
+    dc = fgen_decode_create();
+    if (!rt || !dc ||
+        fgen_decode_set_flags(dc, FGEN_DECODE_ROUNDTRIP |
+                                      ((fg->flags & FGEN_ADD_FCS) ? FGEN_DECODE_FCS : 0)) < 0)
+        FGEN_ERR_GOTO(leave, "Failed to create round-trip objects\n");
+
+    TAILQ_FOREACH (f, &fg->head, next) {
+        if (fgen_decode(dc, fbuf_mtod(f, void *), fbuf_data_len(f), FGEN_ETHER_TYPE) < 0)
+            FGEN_ERR_GOTO(leave, "Round-trip decode of %s failed\n", f->name);
+
+        snprintf(name, sizeof(name), "%s-rt", f->name);
+        if (fgen_add_frame(rt, name, fgen_decode_text(dc)) < 0)
+            FGEN_ERR_GOTO(leave, "Round-trip encode of %s failed\n", f->name);
+
+        r = fgen_find_frame(rt, name);
+        if (!r || fbuf_data_len(r) != fbuf_data_len(f) ||
+            memcmp(fbuf_mtod(r, void *), fbuf_mtod(f, void *), fbuf_data_len(f))) {
+            fgen_print_string(name, fgen_decode_text(dc));
+            FGEN_ERR_GOTO(leave, "Round-trip frame %s does not match\n", f->name);
+        }
+        if (info->verbose)
+            fgen_print_string(name, fgen_decode_text(dc));
+    }
+    ret = 0;
+
+leave:
+    fgen_decode_destroy(dc);
+    fgen_destroy(rt);
+    return ret;
+}
+
+/* Decode tunneled frames and check the header offsets of each encapsulation level */
+static int
+fgen_tunnel_test(void)
+{
+    // clang-format off
+    static const struct {
+        const char *text;
+        const char *tunnel;
+        fgen_decode_offsets_t offs[2];
+    } tests[] = {
+        {"Ether(dst=00:01:02:03:04:05)/IPv4(dst=1.2.3.4)/UDP()/Vxlan()/"
+            "Ether(dst=00:11:22:33:44:55)/IPv4(dst=10.0.0.1)/UDP(sport=1, dport=2)/"
+            "Payload(append=32)",
+         FGEN_VxLAN_STR "(flags=0x8,vni=1000)", {{0, 14, 34, 42}, {50, 64, 84, -1}}},
+        {"Ether(dst=00:01:02:03:04:05)/IPv4(dst=1.2.3.4)/UDP(sport=2152, dport=2152)/"
+            "Raw(hex=30ff0024000003e8)/IPv4(dst=10.0.0.2)/UDP(sport=1, dport=2)/"
+            "Payload(append=16)",
+         "GTPU(type=0xff,teid=1000)", {{0, 14, 34, 42}, {-1, 50, 70, -1}}},
+        /* The destination port wins over a source port naming an earlier tunnel in the table */
+        {"Ether(dst=00:01:02:03:04:05)/IPv4(dst=1.2.3.4)/UDP(sport=4789, dport=2152)/"
+            "Raw(hex=30ff0024000003e8)/IPv4(dst=10.0.0.2)/UDP(sport=1, dport=2)/"
+            "Payload(append=16)",
+         "GTPU(type=0xff,teid=1000)", {{0, 14, 34, 42}, {-1, 50, 70, -1}}},
+    };
+    static const char *gre_unknown = "Ether(dst=00:01:02:03:04:05)/IPv4(dst=1.2.3.4, proto=47)/"
+                                     "Raw(hex=00001234)/Payload(append=16)";
+    // clang-format on
+    fgen_t *fg        = NULL;
+    fgen_decode_t *dc = NULL;
+    fgen_decode_offsets_t off;
+    frame_t *f;
+    char name[32];
+    int ret = -1;
+
+    fg = fgen_create(0);
+    dc = fgen_decode_create();
+    if (!fg || !dc)
+        FGEN_ERR_GOTO(leave, "Failed to create tunnel test objects\n");
+
+    for (int i = 0; i < (int)fgen_countof(tests); i++) {
+        snprintf(name, sizeof(name), "Tunnel%d", i);
+        if (fgen_add_frame(fg, name, tests[i].text) < 0)
+            FGEN_ERR_GOTO(leave, "Failed to encode %s\n", name);
+        f = fgen_find_frame(fg, name);
+        if (!f || fgen_decode(dc, fbuf_mtod(f, void *), fbuf_data_len(f), FGEN_ETHER_TYPE) < 0)
+            FGEN_ERR_GOTO(leave, "Failed to decode %s\n", name);
+        if (info->verbose)
+            fgen_print_string(name, fgen_decode_text(dc));
+
+        if (!strstr(fgen_decode_text(dc), tests[i].tunnel))
+            FGEN_ERR_GOTO(leave, "%s tunnel '%s' not decoded\n", name, tests[i].tunnel);
+        if (fgen_decode_levels(dc) != 2)
+            FGEN_ERR_GOTO(leave, "%s found %d levels\n", name, fgen_decode_levels(dc));
+
+        for (int l = 0; l < 2; l++) {
+            if (fgen_decode_offsets(dc, l, &off) < 0 ||
+                memcmp(&off, &tests[i].offs[l], sizeof(off)))
+                FGEN_ERR_GOTO(leave, "%s level %d offsets %d/%d/%d/%d\n", name, l, off.l2,
+                              off.l3, off.l4, off.tunnel);
+        }
+
+        /* With a depth of one the tunnel data is decoded as payload */
+        if (fgen_decode_set_depth(dc, 1) < 0 ||
+            fgen_decode(dc, fbuf_mtod(f, void *), fbuf_data_len(f), FGEN_ETHER_TYPE) < 0 ||
+            fgen_decode_levels(dc) != 1 || fgen_decode_set_depth(dc, FGEN_DECODE_MAX_LEVELS) < 0)
+            FGEN_ERR_GOTO(leave, "%s decode depth of one failed\n", name);
+    }
+
+    /* A GRE protocol without a decoder is payload and does not start a level */
+    if (fgen_add_frame(fg, "GreUnknown", gre_unknown) < 0 ||
+        !(f = fgen_find_frame(fg, "GreUnknown")) ||
+        fgen_decode(dc, fbuf_mtod(f, void *), fbuf_data_len(f), FGEN_ETHER_TYPE) < 0)
+        FGEN_ERR_GOTO(leave, "Failed to decode the GRE frame\n");
+    if (!strstr(fgen_decode_text(dc), "proto=0x1234") || fgen_decode_levels(dc) != 1)
+        FGEN_ERR_GOTO(leave, "GRE of an unknown protocol found %d levels in '%s'\n",
+                      fgen_decode_levels(dc), fgen_decode_text(dc));
+    ret = 0;
+
+leave:
+    if (ret < 0)
+        tst_error("Tunnel decode failed\n");
+    else
+        tst_ok("Tunnel decode of %d frames\n", (int)fgen_countof(tests));
+    fgen_decode_destroy(dc);
+    fgen_destroy(fg);
+    return ret;
+}
+
+/* Decode frames into summary lines through a pipe and check the text */
+static int
+fgen_summary_test(void)
+{
+    // clang-format off
+    static const struct {
+        const char *text;
+        const char *line;
+    } tests[] = {
+        {"Ether(dst=00:01:02:03:04:05)/IPv4(dst=10.0.0.2, src=10.0.0.1)/"
+            "TCP(sport=80, dport=1024, flags=0x12)/Payload(append=16)",
+         "         1.000002 TCP           10.0.0.1:80    >        10.0.0.2:1024  70    [S.]\n"},
+        {"Ether(dst=00:01:02:03:04:05)/IPv4(dst=1.2.3.4)/UDP()/Vxlan()/"
+            "Ether(dst=00:11:22:33:44:55)/IPv4(dst=10.0.0.1, src=10.0.0.9)/UDP(sport=1, dport=2)/"
+            "Payload(append=32)",
+         "         2.000004 UDP           10.0.0.9:1     >        10.0.0.1:2     124\n"},
+    };
+    // clang-format on
+    fgen_t *fg        = NULL;
+    fgen_decode_t *dc = NULL;
+    int fds[2]        = {-1, -1};
+    char name[32], lines[1024] = {0}, *p = lines;
+    frame_t *f;
+    int ret = -1;
+
+    fg = fgen_create(0);
+    dc = fgen_decode_create();
+    if (!fg || !dc || pipe(fds) < 0)
+        FGEN_ERR_GOTO(leave, "Failed to create summary test objects\n");
+    if (fgen_decode_set_summary(dc, NULL, fds[1], 0) < 0)
+        FGEN_ERR_GOTO(leave, "Failed to setup the summary format\n");
+
+    for (int i = 0; i < (int)fgen_countof(tests); i++) {
+        snprintf(name, sizeof(name), "Summary%d", i);
+        if (fgen_add_frame(fg, name, tests[i].text) < 0 || !(f = fgen_find_frame(fg, name)))
+            FGEN_ERR_GOTO(leave, "Failed to encode %s\n", name);
+        if (fgen_decode_summary(dc, fbuf_mtod(f, void *), fbuf_data_len(f),
+                                (i + 1) * 1000002000UL) < 0)
+            FGEN_ERR_GOTO(leave, "Failed to decode %s\n", name);
+    }
+    if (fgen_decode_flush(dc) < 0 || read(fds[0], lines, sizeof(lines) - 1) <= 0)
+        FGEN_ERR_GOTO(leave, "Failed to read the summary lines\n");
+    if (info->verbose)
+        fgen_printf("%s", lines);
+
+    for (int i = 0; i < (int)fgen_countof(tests); i++) {
+        if (strncmp(p, tests[i].line, strlen(tests[i].line)))
+            FGEN_ERR_GOTO(leave, "Summary line %d does not match\n%s", i, p);
+        p += strlen(tests[i].line);
+    }
+    ret = 0;
+
+leave:
+    if (ret < 0)
+        tst_error("Summary decode failed\n");
+    else
+        tst_ok("Summary decode of %d frames\n", (int)fgen_countof(tests));
+    fgen_decode_destroy(dc);
+    fgen_destroy(fg);
+    if (fds[0] >= 0) {
+        close(fds[0]);
+        close(fds[1]);
+    }
+    return ret;
+}
+
+/* Emit a frame as JSON and CBOR through a pipe and check the output */
+static int
+fgen_emit_test(void)
+{
+    // clang-format off
+    static const char *text =
+        "Ether(dst=00:01:02:03:04:05)/IPv4(dst=10.0.0.2, src=10.0.0.1)/"
+        "TCP(sport=80, dport=1024, flags=0x12)/Payload(append=16)";
+    static const char *json =
+        "{\"ts\":123456789,\"len\":70,\"levels\":1,\"layers\":["
+        "{\"type\":\"Ether\",\"level\":0,\"off\":0,\"hlen\":14,"
+            "\"dst\":\"00:01:02:03:04:05\",\"src\":\"00:00:00:00:00:00\",\"ethertype\":2048},"
+        "{\"type\":\"IPv4\",\"level\":0,\"off\":14,\"hlen\":20,\"src\":\"10.0.0.1\","
+            "\"dst\":\"10.0.0.2\",\"ihl\":5,\"tos\":0,\"len\":56,\"id\":1,\"frag\":0,\"ttl\":64,"
+            "\"proto\":6,\"cksum\":26301},"
+        "{\"type\":\"TCP\",\"level\":0,\"off\":34,\"hlen\":20,\"sport\":80,\"dport\":1024,"
+            "\"seq\":0,\"ack\":0,\"doff\":5,\"flags\":18,\"win\":8192,\"cksum\":20039,\"urp\":0},"
+        "{\"type\":\"Payload\",\"level\":0,\"off\":54,\"hlen\":16}]}\n";
+    // clang-format on
+    fgen_t *fg        = NULL;
+    fgen_decode_t *dc = NULL;
+    int fds[2]        = {-1, -1};
+    uint8_t out[1024] = {0};
+    frame_t *f;
+    int n, ret = -1;
+
+    fg = fgen_create(0);
+    dc = fgen_decode_create();
+    if (!fg || !dc || pipe(fds) < 0)
+        FGEN_ERR_GOTO(leave, "Failed to create emit test objects\n");
+    if (fgen_add_frame(fg, "Emit", text) < 0 || !(f = fgen_find_frame(fg, "Emit")))
+        FGEN_ERR_GOTO(leave, "Failed to encode the emit frame\n");
+
+    if (fgen_decode_set_emit(dc, FGEN_EMIT_JSON, fds[1], 0) < 0 ||
+        fgen_decode_emit(dc, fbuf_mtod(f, void *), fbuf_data_len(f), 123456789) < 0 ||
+        fgen_decode_flush(dc) < 0 || read(fds[0], out, sizeof(out) - 1) <= 0)
+        FGEN_ERR_GOTO(leave, "Failed to emit JSON\n");
+    if (strcmp((char *)out, json))
+        FGEN_ERR_GOTO(leave, "JSON record does not match\n%s", out);
+
+    /* A CBOR record is one indefinite length map */
+    if (fgen_decode_set_emit(dc, FGEN_EMIT_CBOR, fds[1], 0) < 0 ||
+        fgen_decode_emit(dc, fbuf_mtod(f, void *), fbuf_data_len(f), 123456789) < 0 ||
+        fgen_decode_flush(dc) < 0 || (n = read(fds[0], out, sizeof(out))) <= 0)
+        FGEN_ERR_GOTO(leave, "Failed to emit CBOR\n");
+    if (out[0] != 0xBF || out[n - 1] != 0xFF || n >= (int)strlen(json))
+        FGEN_ERR_GOTO(leave, "CBOR record of %d bytes is not valid\n", n);
+    ret = 0;
+
+leave:
+    if (ret < 0)
+        tst_error("Emit decode failed\n");
+    else
+        tst_ok("Emit decode of JSON and CBOR\n");
+    fgen_decode_destroy(dc);
+    fgen_destroy(fg);
+    if (fds[0] >= 0) {
+        close(fds[0]);
+        close(fds[1]);
+    }
+    return ret;
+}
+
+/* Fingerprint frames differing only in volatile fields and dedup them */
+static int
+fgen_fprint_test(void)
+{
+    // clang-format off
+    static const char *texts[] = {
+        "Ether(dst=00:01:02:03:04:05)/IPv4(dst=10.0.0.2, src=10.0.0.1, id=1)/"
+            "TCP(sport=80, dport=1024, seq=1)/Payload(append=16)",
+        "Ether(dst=00:01:02:03:04:05)/IPv4(dst=10.0.0.2, src=10.0.0.1, id=7)/"
+            "TCP(sport=80, dport=1024, seq=99)/Payload(append=16)",
+        "Ether(dst=00:01:02:03:04:05)/IPv4(dst=10.0.0.3, src=10.0.0.1, id=1)/"
+            "TCP(sport=80, dport=1024, seq=1)/Payload(append=16)",
+        "Ether(dst=00:01:02:03:04:05)/IPv4(dst=10.0.0.2, src=10.0.0.1, id=9)/"
+            "TCP(sport=80, dport=1024, seq=5)/Payload(append=16)",
+    };
+    // clang-format on
+    fgen_t *fg        = NULL;
+    fgen_decode_t *dc = NULL;
+    fgen_dedup_t *dd  = NULL;
+    fgen_dedup_entry_t e0, e1;
+    uint64_t fp[fgen_countof(texts)];
+    char name[32];
+    frame_t *f;
+    int ret = -1;
+
+    fg = fgen_create(0);
+    dc = fgen_decode_create();
+    dd = fgen_dedup_create(FGEN_FP_DEFAULT);
+    if (!fg || !dc || !dd)
+        FGEN_ERR_GOTO(leave, "Failed to create fingerprint test objects\n");
+
+    for (int i = 0; i < (int)fgen_countof(texts); i++) {
+        snprintf(name, sizeof(name), "Fprint%d", i);
+        if (fgen_add_frame(fg, name, texts[i]) < 0 || !(f = fgen_find_frame(fg, name)))
+            FGEN_ERR_GOTO(leave, "Failed to encode %s\n", name);
+        if (fgen_decode_fingerprint(dc, fbuf_mtod(f, void *), fbuf_data_len(f), FGEN_FP_DEFAULT,
+                                    &fp[i]) < 0 ||
+            fgen_dedup_add(dd, fbuf_mtod(f, void *), fbuf_data_len(f), 1, i) < 0)
+            FGEN_ERR_GOTO(leave, "Failed to fingerprint %s\n", name);
+    }
+    if (fp[0] != fp[1] || fp[0] != fp[3] || fp[0] == fp[2])
+        FGEN_ERR_GOTO(leave, "Fingerprints %lx %lx %lx %lx do not match\n", fp[0], fp[1], fp[2],
+                      fp[3]);
+
+    if (fgen_dedup_count(dd) != 2 || fgen_dedup_entry(dd, 0, &e0) < 0 ||
+        fgen_dedup_entry(dd, 1, &e1) < 0)
+        FGEN_ERR_GOTO(leave, "Dedup found %d entries\n", fgen_dedup_count(dd));
+    if (e0.count != 3 || e0.first != 0 || e0.fp != fp[0] || e1.count != 1 || e1.first != 2)
+        FGEN_ERR_GOTO(leave, "Dedup entries do not match\n");
+    ret = 0;
+
+leave:
+    if (ret < 0)
+        tst_error("Fingerprint and dedup failed\n");
+    else
+        tst_ok("Fingerprint and dedup of %d frames\n", (int)fgen_countof(texts));
+    fgen_dedup_destroy(dd);
+    fgen_decode_destroy(dc);
+    fgen_destroy(fg);
+    return ret;
+}
+
+/* Compare changed copies of a frame to the frame template */
+static int
+fgen_compare_test(void)
+{
+    // clang-format off
+    static const char *text =
+        "Ether(dst=00:01:02:03:04:05)/IPv4(dst=10.0.0.2, src=10.0.0.1)/UDP(sport=1, dport=2)/"
+        "Payload(append=64)";
+    static const struct {
+        int offset;        /* Byte to change or -1 to shorten the frame */
+        int ret;           /* Expected return of fgen_compare() */
+        const char *layer; /* Expected layer of the difference */
+        const char *field; /* Expected field of the difference */
+    } tests[] = {
+        {22, 0, NULL, NULL},            /* IPv4 TTL */
+        {25, 0, NULL, NULL},            /* IPv4 checksum */
+        {33, 1, FGEN_IPv4_STR, "dst"},
+        {36, 1, FGEN_UDP_STR, "dport"},
+        {100, 1, FGEN_PAYLOAD_STR, "data"},
+        {-1, 1, FGEN_PAYLOAD_STR, "len"},
+    };
+    // clang-format on
+    fgen_t *fg          = NULL;
+    fgen_compare_t *cmp = NULL;
+    fgen_compare_result_t res;
+    uint8_t buf[FGEN_MAX_FRAME_SIZE];
+    uint16_t len;
+    frame_t *f;
+    int r, ret = -1;
+
+    fg = fgen_create(0);
+    if (!fg || fgen_add_frame(fg, "Compare", text) < 0 || !(f = fgen_find_frame(fg, "Compare")))
+        FGEN_ERR_GOTO(leave, "Failed to encode the compare frame\n");
+
+    cmp = fgen_compare_create(fbuf_mtod(f, void *), fbuf_data_len(f), FGEN_FP_TTL | FGEN_FP_CKSUM);
+    if (!cmp)
+        FGEN_ERR_GOTO(leave, "Failed to create the compare template\n");
+
+    for (int i = 0; i < (int)fgen_countof(tests); i++) {
+        len = fbuf_data_len(f);
+        memcpy(buf, fbuf_mtod(f, void *), len);
+        if (tests[i].offset < 0)
+            len--;
+        else
+            buf[tests[i].offset] ^= 0x5A;
+
+        r = fgen_compare(cmp, buf, len, &res);
+        if (r != tests[i].ret)
+            FGEN_ERR_GOTO(leave, "Compare %d returned %d\n", i, r);
+        if (r && (strcmp(res.layer, tests[i].layer) || strcmp(res.field, tests[i].field)))
+            FGEN_ERR_GOTO(leave, "Compare %d found %s.%s at %d\n", i, res.layer, res.field,
+                          res.offset);
+    }
+    ret = 0;
+
+leave:
+    if (ret < 0)
+        tst_error("Frame compare failed\n");
+    else
+        tst_ok("Frame compare of %d frames\n", (int)fgen_countof(tests));
+    fgen_compare_destroy(cmp);
+    fgen_destroy(fg);
+    return ret;
+}
+
+/* Check the vector checksums against the scalar sum for odd lengths and alignments */
+static int
+fgen_cksum_test(void)
+{
+    static const uint16_t lens[] = {127, 128, 255, 1500, 1514, 4093, 9000};
+    static uint8_t buf[fgen_countof(lens)][9000 + 8];
+    const void *bufs[fgen_countof(lens)];
+    uint16_t cksums[fgen_countof(lens)], expect;
+    int n = (int)fgen_countof(lens);
+
+    for (int i = 0; i < n; i++) {
+        for (int j = 0; j < lens[i] + (i & 7); j++)
+            buf[i][j] = (uint8_t)((i * 131) + (j * 7) + (j >> 8));
+        bufs[i] = &buf[i][i & 7];
+    }
+    fgen_cksum_burst(bufs, lens, cksums, n);
+
+    for (int i = 0; i < n; i++) {
+        expect = __fgen_raw_cksum_reduce(__fgen_raw_cksum(bufs[i], lens[i], 0));
+
+        if (fgen_raw_cksum(bufs[i], lens[i]) != expect || cksums[i] != expect) {
+            tst_error("Checksum of %u bytes is %04x/%04x not %04x\n", lens[i],
+                      fgen_raw_cksum(bufs[i], lens[i]), cksums[i], expect);
+            return -1;
+        }
+    }
+
+    /* The L4 checksums of the library match the inline scalar ones of net/fgen_ip.h */
+    for (int i = 0; i < n; i++) {
+        struct fgen_ipv4_hdr *ip  = (struct fgen_ipv4_hdr *)buf[i];
+        struct fgen_ipv6_hdr *ip6 = (struct fgen_ipv6_hdr *)buf[i];
+
+        memset(ip, 0, sizeof(*ip));
+        ip->version_ihl   = 0x45;
+        ip->next_proto_id = IPPROTO_UDP;
+        ip->total_length  = htons(lens[i]);
+        if (fgen_cksum_ipv4_udptcp(ip, ip + 1) != fgen_ipv4_udptcp_cksum(ip, ip + 1)) {
+            tst_error("IPv4 L4 checksum of %u bytes is %04x not %04x\n", lens[i],
+                      fgen_cksum_ipv4_udptcp(ip, ip + 1), fgen_ipv4_udptcp_cksum(ip, ip + 1));
+            return -1;
+        }
+
+        ip6->proto       = IPPROTO_TCP;
+        ip6->payload_len = htons(lens[i] - sizeof(*ip6));
+        if (fgen_cksum_ipv6_udptcp(ip6, ip6 + 1) != fgen_ipv6_udptcp_cksum(ip6, ip6 + 1)) {
+            tst_error("IPv6 L4 checksum of %u bytes is %04x not %04x\n", lens[i],
+                      fgen_cksum_ipv6_udptcp(ip6, ip6 + 1), fgen_ipv6_udptcp_cksum(ip6, ip6 + 1));
+            return -1;
+        }
+    }
+    tst_ok("Checksum %s of %d buffers\n", fgen_cksum_impl(), n);
+
+    return 0;
+}
+
+/* Check the incremental checksum updates against a full checksum of the changed headers */
+static int
+fgen_cksum_update_test(void)
+{
+    struct {
+        struct fgen_ipv4_hdr ip;
+        struct fgen_udp_hdr udp;
+        uint8_t data[22];
+    } __fgen_packed pkt[4];
+    void *pkts[fgen_countof(pkt)];
+    struct fgen_ipv4_hdr ip;
+    struct fgen_udp_hdr udp;
+    uint32_t addr = htobe32(FGEN_IPV4(198, 18, 1, 1)), delta;
+    int n         = (int)fgen_countof(pkt);
+
+    for (int i = 0; i < n; i++) {
+        memset(&pkt[i], 0, sizeof(pkt[i]));
+        pkt[i].ip.version_ihl   = FGEN_IPV4_VHL_DEF;
+        pkt[i].ip.total_length  = htobe16(sizeof(pkt[i]));
+        pkt[i].ip.packet_id     = htobe16(i * 977);
+        pkt[i].ip.time_to_live  = 64;
+        pkt[i].ip.next_proto_id = IPPROTO_UDP;
+        pkt[i].ip.src_addr      = htobe32(FGEN_IPV4(10, 0, 0, 1));
+        pkt[i].ip.dst_addr      = htobe32(FGEN_IPV4(10, 0, 1, i));
+        pkt[i].udp.src_port     = htobe16(5000 + i);
+        pkt[i].udp.dst_port     = htobe16(5678);
+        pkt[i].udp.dgram_len    = htobe16(sizeof(pkt[i]) - sizeof(pkt[i].ip));
+        for (int j = 0; j < (int)sizeof(pkt[i].data); j++)
+            pkt[i].data[j] = (uint8_t)(i + j * 13);
+        pkt[i].ip.hdr_checksum = fgen_ipv4_cksum(&pkt[i].ip);
+        pkt[i].udp.dgram_cksum = fgen_ipv4_udptcp_cksum(&pkt[i].ip, &pkt[i].udp);
+        pkts[i]                = &pkt[i];
+    }
+
+    /* Rewrite the source address of all packets with one delta, then a port and the TTL */
+    delta = fgen_cksum_delta32(pkt[0].ip.src_addr, addr);
+    for (int i = 0; i < n; i++)
+        pkt[i].ip.src_addr = addr;
+    fgen_ipv4_cksum_update_bulk(pkts, n, 0, delta);
+    fgen_udp_cksum_update_bulk(pkts, n, sizeof(struct fgen_ipv4_hdr), delta);
+
+    fgen_udp_cksum_update(&pkt[1].udp, fgen_cksum_delta16(pkt[1].udp.dst_port, htobe16(53)));
+    pkt[1].udp.dst_port = htobe16(53);
+    fgen_ipv4_set_ttl(&pkt[2].ip, 1);
+
+    for (int i = 0; i < n; i++) {
+        ip  = pkt[i].ip;
+        udp = pkt[i].udp;
+
+        pkt[i].ip.hdr_checksum = 0;
+        pkt[i].udp.dgram_cksum = 0;
+        if (fgen_ipv4_cksum(&pkt[i].ip) != ip.hdr_checksum ||
+            fgen_ipv4_udptcp_cksum(&pkt[i].ip, &pkt[i].udp) != udp.dgram_cksum) {
+            tst_error("Incremental checksum of packet %d is %04x/%04x not %04x/%04x\n", i,
+                      ip.hdr_checksum, udp.dgram_cksum, fgen_ipv4_cksum(&pkt[i].ip),
+                      fgen_ipv4_udptcp_cksum(&pkt[i].ip, &pkt[i].udp));
+            return -1;
+        }
+    }
+    tst_ok("Incremental checksum update of %d packets\n", n);
+
+    return 0;
+}
+
+/* Check the burst checksum verifier on encoded frames, then with a corrupt byte */
+static int
+fgen_cksum_verify_test(void)
+{
+    // clang-format off
+    static const char *texts[] = {
+        "Ether(dst=00:01:02:03:04:05)/IPv4(dst=10.0.0.2, src=10.0.0.1)/UDP()/Payload(size=300)",
+        "Ether(dst=00:01:02:03:04:05)/Dot1q(vlan=0x322)/IPv4(dst=10.0.0.2)/TCP()/"
+            "Payload(size=1024)",
+        "Ether(dst=00:01:02:03:04:05)/IPv6(dst=2001:db8::1, src=2001:db8::2)/UDP()/"
+            "Payload(size=200)",
+        "Ether(dst=00:01:02:03:04:05)/IPv6(dst=2001:db8::1, src=2001:db8::2)/TCP()/"
+            "Payload(size=128)",
+    };
+    // clang-format on
+    static uint8_t data[fgen_countof(texts)][FGEN_ETHER_MTU];
+    const void *frames[fgen_countof(texts)];
+    uint16_t lens[fgen_countof(texts)];
+    fgen_cksum_status_t st[fgen_countof(texts)];
+    int n     = (int)fgen_countof(texts);
+    fgen_t *fg = NULL;
+    char name[32];
+    frame_t *f;
+    int ret = -1;
+
+    fg = fgen_create(0);
+    if (!fg)
+        FGEN_ERR_GOTO(leave, "Failed to create checksum verify test object\n");
+
+    for (int i = 0; i < n; i++) {
+        snprintf(name, sizeof(name), "verify-%d", i);
+        if (fgen_add_frame(fg, name, texts[i]) < 0 || !(f = fgen_find_frame(fg, name)))
+            FGEN_ERR_GOTO(leave, "Failed to add checksum verify frame %d\n", i);
+        memcpy(data[i], fbuf_mtod(f, void *), fbuf_data_len(f));
+        frames[i] = data[i];
+        lens[i]   = fbuf_data_len(f);
+    }
+
+    if (fgen_cksum_verify_burst(frames, lens, n, st) != 0 || st[0].ip != FGEN_CKSUM_GOOD ||
+        st[2].ip != FGEN_CKSUM_NONE)
+        FGEN_ERR_GOTO(leave, "Encoded frames have bad checksums\n");
+    for (int i = 0; i < n; i++) {
+        if (st[i].l4 != FGEN_CKSUM_GOOD)
+            FGEN_ERR_GOTO(leave, "Frame %d L4 checksum status %u\n", i, st[i].l4);
+    }
+
+    /* Corrupt the IPv4 TTL of the first frame and the last payload byte of the others */
+    data[0][14 + 8] ^= 0x01;
+    for (int i = 1; i < n; i++)
+        data[i][lens[i] - 1] ^= 0x80;
+    if (fgen_cksum_verify_burst(frames, lens, n, st) != n || st[0].ip != FGEN_CKSUM_BAD ||
+        st[0].l4 != FGEN_CKSUM_GOOD)
+        FGEN_ERR_GOTO(leave, "Corrupt frames not found\n");
+    ret = 0;
+
+leave:
+    if (ret < 0)
+        tst_error("Checksum verify failed\n");
+    else
+        tst_ok("Checksum verify of %d frames\n", n);
+    fgen_destroy(fg);
+    return ret;
+}
+
+/* Check the FCS appended to the frames against the table CRC32 */
+static int
+fgen_fcs_test(void)
+{
+    // clang-format off
+    static const char *texts[] = {
+        "Ether(dst=00:01:02:03:04:05)/IPv4(dst=10.0.0.2, src=10.0.0.1)/UDP()/Payload(size=64)",
+        "Ether(dst=00:01:02:03:04:05)/IPv4(dst=10.0.0.2, src=10.0.0.1)/UDP()/Payload(size=1518)",
+    };
+    // clang-format on
+    static const uint16_t lens[] = {60 + FGEN_ETHER_FCS_LEN, 1514 + FGEN_ETHER_FCS_LEN};
+    fgen_t *fg = NULL;
+    char name[32];
+    frame_t *f;
+    uint32_t fcs;
+    int ret = -1;
+
+    fg = fgen_create(FGEN_ADD_FCS);
+    if (!fg)
+        FGEN_ERR_GOTO(leave, "Failed to create FCS test object\n");
+
+    for (int i = 0; i < (int)fgen_countof(texts); i++) {
+        snprintf(name, sizeof(name), "fcs-%d", i);
+        if (fgen_add_frame(fg, name, texts[i]) < 0 || !(f = fgen_find_frame(fg, name)))
+            FGEN_ERR_GOTO(leave, "Failed to add FCS frame %d\n", i);
+
+        memcpy(&fcs, fbuf_mtod_offset(f, uint8_t *, lens[i] - FGEN_ETHER_FCS_LEN), sizeof(fcs));
+        if (fbuf_data_len(f) != lens[i] ||
+            le32toh(fcs) != crc32(fbuf_mtod(f, void *), lens[i] - FGEN_ETHER_FCS_LEN))
+            FGEN_ERR_GOTO(leave, "FCS frame %d of %u bytes has FCS %08x\n", i, fbuf_data_len(f),
+                          le32toh(fcs));
+    }
+
+    /* The maximum size frame with its FCS decodes and encodes back */
+    if (fgen_roundtrip(fg) < 0)
+        FGEN_ERR_GOTO(leave, "Round-trip of the FCS frames failed\n");
+
+    /* A frame longer than an Ethernet frame is rejected, not cut to size before the FCS */
+    if (fgen_add_frame(fg, "fcs-long", "Ether()/IPv4()/UDP()/Payload(append=1500)") == 0)
+        FGEN_ERR_GOTO(leave, "FCS frame of 1542 bytes was not rejected\n");
+    ret = 0;
+
+leave:
+    if (ret < 0)
+        tst_error("FCS append failed\n");
+    else
+        tst_ok("FCS %s of %d frames\n", fgen_crc32_impl(), (int)fgen_countof(texts));
+    fgen_destroy(fg);
+    return ret;
+}
+
+/* Check the CRC-32C of a burst against the single buffer CRC-32C */
+static int
+fgen_crc32c_test(void)
+{
+    static const uint16_t lens[] = {0, 7, 64, 100, 128, 200, 255, 1500};
+    static const unsigned char check[] = "123456789";
+    static uint8_t buf[fgen_countof(lens)][1500 + 8];
+    const void *bufs[fgen_countof(lens)];
+    uint32_t out[fgen_countof(lens)], expect;
+    int n = (int)fgen_countof(lens);
+
+    /* The check value of the CRC-32C catalogue, the table is the reference for the kernels */
+    expect = ~table_crc32c(~0U, check, 9);
+    out[0] = ~calculate_crc32c(~0U, check, 9);
+    if (expect != 0xE3069283 || out[0] != expect) {
+        tst_error("CRC-32C of \"%s\" is %08x table %08x not e3069283\n", check, out[0], expect);
+        return -1;
+    }
+
+    for (int i = 0; i < n; i++) {
+        for (int j = 0; j < lens[i] + (i & 7); j++)
+            buf[i][j] = (uint8_t)((i * 29) + (j * 11));
+        bufs[i] = &buf[i][i & 7];
+    }
+    fgen_crc32c_bulk(bufs, lens, n, out);
+
+    for (int i = 0; i < n; i++) {
+        expect = ~table_crc32c(~0U, bufs[i], lens[i]);
+
+        if (out[i] != expect) {
+            tst_error("CRC-32C of %u bytes is %08x not %08x\n", lens[i], out[i], expect);
+            return -1;
+        }
+    }
+    tst_ok("CRC-32C %s of %d buffers\n", fgen_crc32c_impl(), n);
+
+    return 0;
+}
+
+/* Share the default frames by name and by memfd, then check the frames of read-only mappings */
+static int
+fgen_share_test(void)
+{
+    char name[32];
+    mmap_t *mm[2] = {NULL}, *ro = NULL;
+    fgen_t *fg;
+    int ret = -1;
+
+    snprintf(name, sizeof(name), "fgen_test.%d", getpid());
+
+    fg = fgen_create(0);
+    if (!fg || fgen_load_strings(fg, (char **)(uintptr_t)default_strings,
+                                 fgen_countof(default_strings)) < 0)
+        FGEN_ERR_GOTO(leave, "Failed to load the default frames\n");
+
+    mm[0] = fgen_share(fg, name, MMAP_HUGEPAGE_4KB);
+    mm[1] = fgen_share(fg, NULL, MMAP_HUGEPAGE_4KB);
+    if (!mm[0] || !mm[1])
+        FGEN_ERR_GOTO(leave, "Failed to share %d frames\n", fgen_fcnt(fg));
+
+    for (int i = 0; i < 2; i++) {
+        const fgen_shared_set_t *set;
+        frame_t *f;
+        uint32_t idx = 0;
+
+        ro  = (i == 0) ? mmap_shared_attach(name) : mmap_shared_attach_fd(mmap_fd(mm[1]));
+        set = fgen_shared_set(ro);
+        if (!set || set->nb_frames != fgen_fcnt(fg) || mmap_addr(ro) == mmap_addr(mm[i]))
+            FGEN_ERR_GOTO(leave, "Shared frame set %d is not mapped\n", i);
+        TAILQ_FOREACH (f, &fg->head, next) {
+            const fgen_shared_frame_t *sf = &set->frames[idx];
+
+            if (strcmp(sf->name, f->name) || sf->data_len != fbuf_data_len(f) ||
+                memcmp(fgen_shared_data(set, idx), fbuf_mtod(f, void *), sf->data_len))
+                FGEN_ERR_GOTO(leave, "Shared frame %s differs\n", f->name);
+            idx++;
+        }
+        mmap_free(ro);
+        ro = NULL;
+    }
+    ret = 0;
+
+leave:
+    if (ret < 0)
+        tst_error("Frame sharing failed\n");
+    else
+        tst_ok("Shared %d frames by name and by memfd\n", fgen_fcnt(fg));
+    mmap_free(ro);
+    mmap_free(mm[0]);
+    mmap_free(mm[1]);
+    mmap_shared_unlink(name);
+    fgen_destroy(fg);
+    return ret;
+}
+
+static void
+prefault_progress(size_t done, size_t total, void *arg)
+{
+    if (done == total)
+        *(size_t *)arg = done;
+}
+
+/* Fault in a region larger than MMAP_PREFAULT_MIN with worker threads */
+static int
+fgen_prefault_test(void)
+{
+    size_t last = 0;
+    uint32_t bufcnt = (MMAP_PREFAULT_MIN * 2) / 2048;
+    mmap_t *mm;
+    int ret = -1;
+
+    mmap_set_prefault(4, prefault_progress, &last);
+    mm = mmap_alloc(bufcnt, 2048, MMAP_HUGEPAGE_4KB);
+    mmap_set_prefault(0, NULL, NULL);
+    if (!mm) {
+        tst_error("Failed to allocate %u buffers\n", bufcnt);
+        return -1;
+    }
+
+    if (mmap_prefault_ns(mm) == 0 || last != mmap_size(mm, NULL, NULL))
+        tst_error("Region of %'lu bytes was not prefaulted\n", mmap_size(mm, NULL, NULL));
+    else {
+        tst_ok("Prefaulted %'lu bytes in %'lu us\n", mmap_size(mm, NULL, NULL),
+               mmap_prefault_ns(mm) / 1000);
+        ret = 0;
+    }
+    mmap_free(mm);
+
+    return ret;
+}
+
+#define FALLBACK_THREADS 4
+#define FALLBACK_SIZE    (8 * 1024 * 1024)
+
+/* Allocate a 1GB page region, which falls back to a smaller page size when none are free */
+static void *
+mmap_fallback_thread(void *arg)
+{
+    uint32_t *nb_thp = arg;
+    mmap_t *mm;
+    char *va;
+
+    mm = mmap_alloc(FALLBACK_SIZE / 2048, 2048, MMAP_HUGEPAGE_1GB);
+    if (!mm)
+        return mm;
+
+    va = mmap_addr(mm);
+    for (size_t off = 0; off < FALLBACK_SIZE; off += getpagesize())
+        va[off] = 1;
+    if (mmap_thp(mm)) {
+        if ((uintptr_t)va & (2 * 1024 * 1024 - 1))
+            va = NULL;
+        __atomic_fetch_add(nb_thp, 1, __ATOMIC_RELAXED);
+    }
+    mmap_free(mm);
+
+    return va;
+}
+
+static int
+fgen_mmap_fallback_test(void)
+{
+    pthread_t tid[FALLBACK_THREADS];
+    uint32_t nb_thp = 0;
+    int ret         = 0;
+
+    for (int i = 0; i < FALLBACK_THREADS; i++)
+        pthread_create(&tid[i], NULL, mmap_fallback_thread, &nb_thp);
+    for (int i = 0; i < FALLBACK_THREADS; i++) {
+        void *va;
+
+        pthread_join(tid[i], &va);
+        if (!va)
+            ret = -1;
+    }
+
+    if (ret)
+        tst_error("Failed to allocate a region with a page size fallback\n");
+    else
+        tst_ok("Allocated %d regions with a page size fallback, %u with THP\n", FALLBACK_THREADS,
+               nb_thp);
+
+    return ret;
+}
+
+/* Check the frame data and metadata bytes and the mmap bytes in use follow the allocations */
+static int
+fgen_mem_stats_test(void)
+{
+    fgen_mem_stats_t before, after;
+    uint64_t used_before, used_after;
+    mmap_t *mm;
+    fgen_t *fg;
+    int ret = -1;
+
+    fg = fgen_create(0);
+    if (!fg || fgen_load_strings(fg, (char **)(uintptr_t)default_strings,
+                                 fgen_countof(default_strings)) < 0)
+        FGEN_ERR_GOTO(leave, "Failed to load the default frames\n");
+
+    if (fgen_mem_stats(fg, &before) < 0)
+        FGEN_ERR_GOTO(leave, "Failed to get the memory stats of the frames\n");
+    mm = mmap_alloc(256, 2048, MMAP_HUGEPAGE_4KB);
+    if (!mm)
+        FGEN_ERR_GOTO(leave, "Failed to allocate 256 buffers\n");
+    ret = fgen_mem_stats(NULL, &after);
+    mmap_free(mm);
+    if (ret < 0)
+        FGEN_ERR_GOTO(leave, "Failed to get the memory stats\n");
+    ret = -1;
+
+    used_before = before.mmap.sizes[MMAP_HUGEPAGE_4KB].allocated -
+                  before.mmap.sizes[MMAP_HUGEPAGE_4KB].freed;
+    used_after = after.mmap.sizes[MMAP_HUGEPAGE_4KB].allocated -
+                 after.mmap.sizes[MMAP_HUGEPAGE_4KB].freed;
+
+    if (before.nb_frames != fgen_fcnt(fg) || before.frame_bytes == 0 ||
+        before.frame_bytes > before.block_bytes || before.meta_bytes < sizeof(fgen_t) ||
+        used_after != used_before + (256 * 2048))
+        FGEN_ERR_GOTO(leave, "Memory stats of %u frames are wrong\n", fgen_fcnt(fg));
+    ret = 0;
+
+leave:
+    if (ret < 0)
+        tst_error("Memory stats test failed\n");
+    else
+        tst_ok("Memory of %u frames, data %'lu of %'lu bytes, meta %'lu bytes\n",
+               before.nb_frames, before.frame_bytes, before.block_bytes, before.meta_bytes);
+    fgen_destroy(fg);
+    return ret;
+}
+
+/* Bind a region to the node of this lcore and check the pages and the node stats */
+static int
+fgen_mmap_socket_test(void)
+{
+    int socket = (int)fgen_socket_id_self();
+    mmap_node_stats_t before, after;
+    mmap_t *mm;
+
+    if (mmap_node_stats(socket, &before) < 0)
+        before.num_allocated = 0;
+
+    mm = mmap_alloc_socket(256, 2048, MMAP_HUGEPAGE_4KB, MMAP_SOCKET_SELF);
+    if (!mm) {
+        tst_error("Failed to allocate memory on socket %d\n", socket);
+        return -1;
+    }
+    if (mmap_socket(mm) != socket || mmap_node_stats(socket, &after) < 0 ||
+        after.num_allocated != before.num_allocated + 1) {
+        tst_error("Memory for socket %d is on socket %d\n", socket, mmap_socket(mm));
+        mmap_free(mm);
+        return -1;
+    }
+    mmap_free(mm);
+    tst_ok("Memory allocated on socket %d\n", socket);
+
+    return 0;
+}
+
+#define MPOOL_TEST_BUFS    4096
+#define MPOOL_TEST_THREADS 4
+
+/* Get and put random bursts, a buffer given to two threads at once ends up with a bad mark */
+static void *
+mpool_test_thread(void *arg)
+{
+    mpool_t *mp = arg;
+    void *bufs[96];
+    uintptr_t bad = 0;
+    uint32_t seed = (uint32_t)pthread_self();
+
+    for (int i = 0; i < 20000; i++) {
+        uint32_t n = 1 + ((seed = seed * 1103515245 + 12345) >> 16) % fgen_countof(bufs);
+
+        if (mpool_get_bulk(mp, bufs, n) < 0)
+            continue;
+        for (uint32_t j = 0; j < n; j++)
+            *(void **)bufs[j] = &bufs[j];
+        for (uint32_t j = 0; j < n; j++)
+            bad += (*(void **)bufs[j] != &bufs[j]);
+        mpool_put_bulk(mp, bufs, n);
+    }
+    mpool_cache_flush(mp);
+
+    return (void *)bad;
+}
+
+/* Take all the buffers of a pool once, then share the pool between threads */
+static int
+fgen_mpool_test(void)
+{
+    static void *bufs[MPOOL_TEST_BUFS];
+    pthread_t tid[MPOOL_TEST_THREADS];
+    uint8_t *seen;
+    mpool_t *mp;
+    int ret = -1;
+
+    mp   = mpool_create(MPOOL_TEST_BUFS, 2048, 0, MMAP_HUGEPAGE_4KB);
+    seen = calloc(MPOOL_TEST_BUFS, 1);
+    if (!mp || !seen)
+        FGEN_ERR_GOTO(leave, "Failed to create a pool of %d buffers\n", MPOOL_TEST_BUFS);
+
+    for (int i = 0; i < MPOOL_TEST_BUFS; i++) {
+        int64_t idx;
+
+        bufs[i] = mpool_get(mp);
+        idx     = mpool_index(mp, bufs[i]);
+        if (idx < 0 || seen[idx]++ || mpool_buf_at(mp, idx) != bufs[i])
+            FGEN_ERR_GOTO(leave, "Buffer %d at %p is not a new buffer of the pool\n", i,
+                          bufs[i]);
+    }
+    if (mpool_get(mp) != NULL)
+        FGEN_ERR_GOTO(leave, "Got a buffer from an empty pool\n");
+    mpool_put_bulk(mp, bufs, MPOOL_TEST_BUFS);
+    mpool_cache_flush(mp);
+
+    for (int i = 0; i < MPOOL_TEST_THREADS; i++)
+        pthread_create(&tid[i], NULL, mpool_test_thread, mp);
+    ret = 0;
+    for (int i = 0; i < MPOOL_TEST_THREADS; i++) {
+        void *bad;
+
+        pthread_join(tid[i], &bad);
+        if (bad)
+            ret = -1;
+    }
+    if (ret || mpool_avail(mp) != MPOOL_TEST_BUFS) {
+        ret = -1;
+        FGEN_ERR_GOTO(leave, "Pool has %u of %d buffers after %d threads\n", mpool_avail(mp),
+                      MPOOL_TEST_BUFS, MPOOL_TEST_THREADS);
+    }
+
+leave:
+    if (ret < 0)
+        tst_error("Buffer pool test failed\n");
+    else
+        tst_ok("Buffer pool of %d buffers with %d threads\n", MPOOL_TEST_BUFS,
+               MPOOL_TEST_THREADS);
+    free(seen);
+    mpool_destroy(mp);
+    return ret;
+}
+
+/* Percentiles of a uniform spread of values are within the precision of the histogram */
+static int
+fgen_hdrhist_test(void)
+{
+    const uint64_t big = 1000ULL * 1000 * 1000 * 1000;
+    hdrhist_t *h, *m, *bad;
+    hdrhist_summary_t s;
+    int ret = -1;
+
+    h = hdrhist_create(0);
+    m = hdrhist_create(0);
+    if (!h || !m)
+        FGEN_ERR_GOTO(leave, "Failed to create histograms\n");
+
+    /* A precision out of range is refused */
+    bad = hdrhist_create(1);
+    if (bad) {
+        hdrhist_destroy(bad);
+        FGEN_ERR_GOTO(leave, "Histogram created with a precision of 1\n");
+    }
+
+    for (uint64_t v = 1; v <= 100000; v++)
+        hdrhist_record(h, v);
+    if (hdrhist_summary(h, &s) < 0 || s.count != 100000 || s.min != 1 || s.max != 100000 ||
+        s.avg != 50000 || s.p50 < 50000 || s.p50 > 50000 + 50000 / 64 || s.p99 < 99000 ||
+        s.p99 > 99000 + 99000 / 64 || s.p999 < 99900 || s.p999 > 100000)
+        FGEN_ERR_GOTO(leave, "Summary count %lu min %lu max %lu avg %lu p50 %lu p99 %lu "
+                             "p99.9 %lu\n",
+                      s.count, s.min, s.max, s.avg, s.p50, s.p99, s.p999);
+
+    hdrhist_record(m, big);
+    if (hdrhist_merge(m, h) < 0 || hdrhist_percentile(m, 100.0) != big ||
+        hdrhist_percentile(m, 0.0) != 1 || hdrhist_summary(m, &s) < 0 || s.count != 100001)
+        FGEN_ERR_GOTO(leave, "Merged histogram count %lu max %lu\n", s.count, s.max);
+
+    hdrhist_reset(m);
+    if (hdrhist_summary(m, &s) < 0 || s.count || s.max || hdrhist_percentile(m, 50.0))
+        FGEN_ERR_GOTO(leave, "Histogram not empty after reset\n");
+    ret = 0;
+
+leave:
+    if (ret < 0)
+        tst_error("HDR histogram test failed\n");
+    else
+        tst_ok("HDR histogram percentiles\n");
+    hdrhist_destroy(h);
+    hdrhist_destroy(m);
+    return ret;
+}
+
+/* Encode and decode a Seq() layer, then track the loss, reorder and duplicates of two streams */
+static int
+fgen_seqtrack_test(void)
+{
+    // clang-format off
+    static const struct {
+        uint32_t stream;
+        uint64_t seq;
+        int cls;
+    } pkts[] = {
+        {0, 0, SEQTRACK_IN_ORDER}, {0, 1, SEQTRACK_IN_ORDER}, {0, 2, SEQTRACK_IN_ORDER},
+        {0, 5, SEQTRACK_IN_ORDER}, {0, 3, SEQTRACK_LATE}, {0, 3, SEQTRACK_DUP},
+        {0, 4, SEQTRACK_LATE}, {0, 1000, SEQTRACK_IN_ORDER}, {0, 10, SEQTRACK_LATE},
+        {1, 50, SEQTRACK_IN_ORDER}, {1, 49, SEQTRACK_LATE}, {2, 0, -1},
+    };
+    // clang-format on
+    const char *text = "Ether(dst=00:01:02:03:04:05)/IPv4(dst=1.2.3.4)/UDP()/"
+                       "Seq(stream=7, seq=100)/TSC()/Payload(size=64)";
+    fgen_decode_t *dc = NULL;
+    seqtrack_t *t     = NULL;
+    fgen_t *fg        = NULL;
+    seqtrack_counts_t c;
+    frame_t *f;
+    seq_t *seq;
+    int ret = -1;
+
+    fg = fgen_create(0);
+    dc = fgen_decode_create();
+    if (!fg || !dc || fgen_add_frame(fg, "Seq", text) < 0 || !(f = fgen_find_frame(fg, "Seq")))
+        FGEN_ERR_GOTO(leave, "Failed to encode a Seq() frame\n");
+
+    seq = fbuf_mtod_offset(f, seq_t *, f->seq_off);
+    if (f->seq_off != 42 || f->tsc_off != 42 + sizeof(seq_t) || seq->seqid != SEQUENCE_ID ||
+        seq->stream != 7 || seq->seq != 100)
+        FGEN_ERR_GOTO(leave, "Seq() layer at %u is not stream 7 seq 100\n", f->seq_off);
+    if (fgen_decode(dc, fbuf_mtod(f, void *), fbuf_data_len(f), FGEN_ETHER_TYPE) < 0 ||
+        !strstr(fgen_decode_text(dc), FGEN_SEQ_STR "(stream=7,seq=100)") || fgen_roundtrip(fg) < 0)
+        FGEN_ERR_GOTO(leave, "Seq() layer not decoded\n");
+
+    t = seqtrack_create(2, 64);
+    if (!t || seqtrack_streams(t) != 2)
+        FGEN_ERR_GOTO(leave, "Failed to create a sequence tracker\n");
+
+    for (int i = 0; i < (int)fgen_countof(pkts); i++) {
+        int cls = seqtrack_check(t, pkts[i].stream, pkts[i].seq);
+
+        if (cls != pkts[i].cls)
+            FGEN_ERR_GOTO(leave, "Stream %u seq %lu is %d not %d\n", pkts[i].stream,
+                          pkts[i].seq, cls, pkts[i].cls);
+    }
+
+    /* The late 3 and 4 are taken off the lost, 10 is older than the window */
+    if (seqtrack_stream_counts(t, 0, &c) < 0 || c.in_order != 5 || c.lost != 994 ||
+        c.late != 3 || c.dup != 1)
+        FGEN_ERR_GOTO(leave, "Stream 0 in order %lu lost %lu late %lu dup %lu\n", c.in_order,
+                      c.lost, c.late, c.dup);
+    if (seqtrack_counts(t, &c) < 0 || c.in_order != 6 || c.lost != 994 || c.late != 4 ||
+        c.dup != 1)
+        FGEN_ERR_GOTO(leave, "Total in order %lu lost %lu late %lu dup %lu\n", c.in_order, c.lost,
+                      c.late, c.dup);
+    ret = 0;
+
+leave:
+    if (ret < 0)
+        tst_error("Sequence tracking failed\n");
+    else
+        tst_ok("Sequence layer and tracking of %d packets\n", (int)fgen_countof(pkts));
+    seqtrack_destroy(t);
+    fgen_decode_destroy(dc);
+    fgen_destroy(fg);
+    return ret;
+}
+
 static int
 fgen_start(tst_info_t *tst __fgen_unused, bool create_pcap, int flags)
 {
@@ -163,15 +1322,20 @@ fgen_start(tst_info_t *tst __fgen_unused, bool create_pcap, int flags)
         fgen_print_string(f->name, fgen_decode_text(dc));
     }
 
-    frame_t *r = fgen_find_frame(fg, "Frame0");
-    if (!r)
-        FGEN_ERR_GOTO(leave, "Failed to find Frame0\n");
+    if (fgen_roundtrip(fg) < 0)
+        tst_error("Round-trip decode and encode failed\n");
+    else
+        tst_ok("Round-trip decode and encode of %d frames\n", fgen_fcnt(fg));
+
+    uint8_t pkt[FGEN_MAX_FRAME_SIZE];
+    int pkt_len;
 
-    if (fgen_decode_string(pkt_data_string, fbuf_mtod(r, uint8_t *), fbuf_data_len(r)) < 0)
+    pkt_len = fgen_decode_string(pkt_data_string, pkt, sizeof(pkt));
+    if (pkt_len < 0)
         goto leave;
-    if (fgen_decode(dc, fbuf_mtod(r, void *), fbuf_data_len(r), 0) < 0)
+    if (fgen_decode(dc, pkt, pkt_len, 0) < 0)
         goto leave;
-    fgen_print_string(r->name, fgen_decode_text(dc));
+    fgen_print_string("Hex data", fgen_decode_text(dc));
 
     if (create_pcap) {
         pcap_dump_close(info->pcap_dumper);
@@ -202,6 +1366,7 @@ usage(char *argv0)
     printf("  -h, --help\n");
     printf("  -V, --verbose\n");
     printf("  -D, --dump\n");
+    printf("  -F, --fcs                  # append the Ethernet FCS to each frame\n");
     printf("  -f, --fgen-file <file>     # can have multiple times\n");
     printf("  -s, --fgen-string <string> # can have multiple times\n");
     printf("  -p, --pcap <filename>      # optional <filename> will default to 'frame-generator.pcap'\n");
@@ -226,6 +1391,7 @@ main(int argc, char **argv)
         {"fgen-string", required_argument, NULL, 's'},
         {"verbose", no_argument, NULL, 'V'},
         {"dump", no_argument, NULL, 'D'},
+        {"fcs", no_argument, NULL, 'F'},
         {"help", no_argument, NULL, 'h'},
         {NULL, 0, 0, 0}
     };
@@ -244,7 +1410,7 @@ main(int argc, char **argv)
     optind  = 0;
     flags   = 0;
     info->verbose = 0;
-    while ((opt = getopt_long(argc, argvopt, "hVvDf:s:p::", lgopts, &option_index)) != EOF) {
+    while ((opt = getopt_long(argc, argvopt, "hVvDFf:s:p::", lgopts, &option_index)) != EOF) {
         switch (opt) {
         case 'f':
             if (add_file(optarg) < 0)
@@ -266,6 +1432,9 @@ main(int argc, char **argv)
         case 'D':
             flags |= FGEN_DUMP_DATA;
             break;
+        case 'F':
+            flags |= FGEN_ADD_FCS;
+            break;
         case 'v':
             info->verbose = 1;
             break;
@@ -284,7 +1453,16 @@ main(int argc, char **argv)
 
     tst = tst_start("Frame Generator (fgen)");
 
-    fgen_start(tst, create_pcap, flags);
+    if (fgen_start(tst, create_pcap, flags) < 0 || fgen_hex_test() < 0 || fgen_tunnel_test() < 0 ||
+        fgen_summary_test() < 0 || fgen_emit_test() < 0 || fgen_fprint_test() < 0 ||
+        fgen_compare_test() < 0 || fgen_cksum_test() < 0 || fgen_cksum_update_test() < 0 ||
+        fgen_fcs_test() < 0 || fgen_crc32c_test() < 0 || fgen_cksum_verify_test() < 0 ||
+        fgen_mmap_socket_test() < 0 || fgen_mpool_test() < 0 || fgen_share_test() < 0 ||
+        fgen_prefault_test() < 0 || fgen_mmap_fallback_test() < 0 || fgen_mem_stats_test() < 0 ||
+        fgen_hdrhist_test() < 0 || fgen_seqtrack_test() < 0) {
+        tst_end(tst, TST_FAILED);
+        return tst_exit_code();
+    }
 
     tst_end(tst, TST_PASSED);
 